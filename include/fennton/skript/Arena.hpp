@@ -0,0 +1,55 @@
+#ifndef FENNTON_ARENA_HPP
+#define FENNTON_ARENA_HPP
+
+#include <vector>
+#include <memory>
+#include <type_traits>
+#include <cstddef>
+
+namespace Fennton::Skript {
+    // Bump allocator owning the memory of a compilation unit, such as its syntax trees. Each
+    // allocation takes the next bytes of the current block, and nothing is freed on its own:
+    // all of it is freed at once by resetting or destroying the arena, without visiting what
+    // was allocated. Only trivially destructible objects can be allocated, as they are never
+    // destroyed.
+    class Arena {
+    private:
+        // Size of the first block. Each block is twice as large as the previous one, so that
+        // there are only a few of them however much is allocated.
+        static constexpr std::size_t firstBlockSize = 4 * 1024;
+
+        std::vector<std::unique_ptr<std::byte[]>> blocks;
+        std::size_t blockSize = 0;
+        std::byte* blockIt = nullptr;
+        std::size_t blockLeft = 0;
+        // Sum of the sizes of the blocks.
+        std::size_t capacity = 0;
+
+        // Adds a block with room for at least the specified number of bytes.
+        void grow(std::size_t size);
+    public:
+        Arena() = default;
+        Arena(Arena const&) = delete;
+        Arena& operator=(Arena const&) = delete;
+        // Moves the blocks to the new arena, leaving the other one empty.
+        Arena(Arena&& other) noexcept;
+        Arena& operator=(Arena&& other) noexcept;
+        // Returns uninitialised memory of the specified size and alignment, which must be a
+        // power of two. The memory stays valid until the arena is reset or destroyed.
+        void* Allocate(std::size_t size, std::size_t alignment);
+        // Returns uninitialised memory for count objects of the type.
+        template<typename T> T* Allocate(std::size_t count) {
+            static_assert(
+                std::is_trivially_destructible_v<T>, "Arena objects are never destroyed."
+            );
+            return static_cast<T*>(Allocate(count * sizeof(T), alignof(T)));
+        }
+        // Frees everything allocated in the arena. Its blocks are merged into one, which is
+        // kept, so that a compilation unit reusing the arena does not allocate unless it
+        // needs more memory than the previous one.
+        void Reset();
+        // Returns the number of bytes in the arena's blocks, used or not.
+        std::size_t GetCapacity() const;
+    };
+}
+#endif
@@ -0,0 +1,161 @@
+#ifndef FENNTON_AST_HPP
+#define FENNTON_AST_HPP
+
+#include <fennton/skript/Arena.hpp>
+#include <fennton/skript/Parser.hpp>
+#include <fennton/skript/Symbols.hpp>
+#include <string>
+#include <span>
+#include <cstddef>
+#include <cstdint>
+
+namespace Fennton::Skript {
+    // Index of a node in its syntax tree.
+    using NodeIndex = std::uint32_t;
+    // Index of a missing node, such as the right operand of a unary operation.
+    inline constexpr NodeIndex noNode = 0xFFFFFFFF;
+
+    // The kind of a node, which is either a leaf (a literal or a name) or an operation on the
+    // nodes of its operands.
+    enum class NodeKind : std::uint8_t {
+        // Number literals, whose payload is their index in the tree's literal table.
+        Integer,
+        Float,
+        // `#true` or `#false`, whose payload is 1 or 0.
+        Boolean,
+        // Name of a value bound outside the expression, whose payload is the id of its symbol
+        // in the global symbol table.
+        Name,
+        // Unary `-`, whose only operand is the left one.
+        Negate,
+        // `+`, `-`, `*`, `/` and `%`.
+        Add,
+        Subtract,
+        Multiply,
+        Divide,
+        Remainder,
+        // `<`, `>`, `<=`, `>=`, `==` and `!=`.
+        Less,
+        Greater,
+        LessEqual,
+        GreaterEqual,
+        Equal,
+        NotEqual
+    };
+    // Returns true if the node kind is a literal or a name, which has a payload instead of
+    // operands.
+    constexpr bool isLeaf(NodeKind kind) {
+        return kind <= NodeKind::Name;
+    }
+    // Returns true if the node kind is a binary operation.
+    constexpr bool isBinary(NodeKind kind) {
+        return kind >= NodeKind::Add;
+    }
+    // Returns true if the node kind is a comparison, whose result is a Boolean.
+    constexpr bool isComparison(NodeKind kind) {
+        return kind >= NodeKind::Less;
+    }
+    // Value of a number literal, with the type requested by its suffix if any.
+    struct Literal {
+        // The integer's value, or the bits of the float's value.
+        std::uint64_t value;
+        Tokeniser::SuffixType suffixType;
+        std::uint16_t suffixBits;
+
+        bool operator==(Literal const& other) const = default;
+    };
+    // Error in the syntax of an expression, thrown at the token at fault.
+    class SyntaxException : public Tokeniser::Exception {
+    public:
+        using Exception::Exception;
+    };
+    // Syntax tree of an expression, stored as separate tightly packed arrays (structure of
+    // arrays) of node kinds, source spans and the 32-bit indices of the nodes' operands, all
+    // in an arena. Operands are always added before the operations on them, so the nodes are
+    // in post-order: a single forward loop over the arrays visits every operand before its
+    // operation, and the root is the last node. The tree does not own its arrays, which are
+    // freed with the arena.
+    class Ast {
+    private:
+        Tokeniser::Span* spans = nullptr;
+        // Index of each node's left and right operands, or its payload and noNode for leaves.
+        NodeIndex* lefts = nullptr;
+        NodeIndex* rights = nullptr;
+        Literal* literals = nullptr;
+        NodeKind* kinds = nullptr;
+        std::uint32_t size = 0;
+        std::uint32_t literalCount = 0;
+        // Numbers of nodes and literals which the arrays have room for.
+        std::uint32_t capacity = 0;
+        std::uint32_t literalCapacity = 0;
+
+        // Appends a node and returns its index. Throws std::length_error if the tree is full.
+        NodeIndex append(NodeKind kind, Tokeniser::Span span, NodeIndex left, NodeIndex right);
+    public:
+        // Constructs an empty tree, which cannot have any node.
+        Ast() = default;
+        // Constructs an empty tree with room for capacity nodes and literalCapacity number
+        // literals in the arena. Trees never grow, as parsing an expression never makes more
+        // nodes than it has tokens, or more literals than it has number tokens.
+        Ast(Arena& arena, std::size_t capacity, std::size_t literalCapacity);
+        // Returns the number of nodes.
+        std::size_t Size() const;
+        bool Empty() const;
+        // Returns the index of the root, which is the last node, or noNode if the tree is
+        // empty.
+        NodeIndex GetRoot() const;
+        NodeKind GetKind(NodeIndex index) const;
+        // Returns the range of the source which the node was parsed from, including the
+        // parentheses around its operands (but not around itself).
+        Tokeniser::Span GetSpan(NodeIndex index) const;
+        // Returns the index of the node's left (or only) operand.
+        NodeIndex GetLeft(NodeIndex index) const;
+        // Returns the index of the node's right operand, or noNode if it has at most one.
+        NodeIndex GetRight(NodeIndex index) const;
+        // Returns the payload of the leaf at the index.
+        std::uint32_t GetPayload(NodeIndex index) const;
+        // Returns the value of the number literal at the index.
+        Literal const& GetLiteral(NodeIndex index) const;
+        // Returns the value of the Boolean literal at the index.
+        bool GetBoolean(NodeIndex index) const;
+        // Returns the symbol of the name at the index, in the global symbol table.
+        Symbol GetName(NodeIndex index) const;
+        std::span<NodeKind const> GetKinds() const;
+        std::span<NodeIndex const> GetLefts() const;
+        std::span<NodeIndex const> GetRights() const;
+        // Returns the spelling of the subtree at the index, with every operation inside
+        // parentheses (such as `(20 + (4 * 0))`), which parses back into the same subtree.
+        std::string GetSpelling(NodeIndex index) const;
+        // Returns the spelling of the whole tree, or an empty string if it is empty.
+        std::string GetSpelling() const;
+        // Appends a number literal and returns its index. Like the other Append methods, throws
+        // std::length_error if there is no room left for it.
+        NodeIndex AppendLiteral(NodeKind kind, Tokeniser::Span span, Literal const& literal);
+        NodeIndex AppendBoolean(Tokeniser::Span span, bool value);
+        NodeIndex AppendName(Tokeniser::Span span, Symbol symbol);
+        // Appends a unary operation on the node at the index and returns its index.
+        NodeIndex AppendUnary(NodeKind kind, Tokeniser::Span span, NodeIndex operand);
+        // Appends a binary operation on the nodes at the indices and returns its index.
+        NodeIndex AppendBinary(
+            NodeKind kind,
+            Tokeniser::Span span,
+            NodeIndex left,
+            NodeIndex right
+        );
+    };
+    // Parses all the tokens of the stream as a single expression, by precedence climbing,
+    // and returns its tree, whose arrays are allocated in the arena. From the loosest to the
+    // tightest, the binary operators are `==` and `!=`, then `<`, `>`, `<=` and `>=`, then
+    // `+` and `-`, then `*`, `/` and `%`, all left-associative, and unary `-` binds tighter
+    // than all of them. Throws a SyntaxException, located in the stream's source, if the
+    // tokens are not an expression.
+    Ast parseExpression(Tokeniser::TokenStream const& tokens, Arena& arena);
+    // Same as the above, but only parses the count tokens starting at the index first.
+    Ast parseExpression(
+        Tokeniser::TokenStream const& tokens,
+        std::size_t first,
+        std::size_t count,
+        Arena& arena
+    );
+}
+#endif
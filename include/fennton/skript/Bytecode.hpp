@@ -0,0 +1,319 @@
+#ifndef FENNTON_BYTECODE_HPP
+#define FENNTON_BYTECODE_HPP
+
+#include <fennton/skript/Ast.hpp>
+#include <fennton/skript/Parser.hpp>
+#include <fennton/skript/Symbols.hpp>
+#include <fennton/skript/Value.hpp>
+#include <vector>
+#include <string>
+#include <span>
+#include <optional>
+#include <concepts>
+#include <type_traits>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+namespace Fennton::Skript {
+    // Kind of the values of a type.
+    enum class TypeKind : std::uint8_t {
+        Boolean,
+        Signed,
+        Unsigned,
+        Float
+    };
+    // Static type of an expression, which the compiler picks the instructions of. Integers of
+    // fewer than 64 bits wrap around at their width, like in two's complement.
+    struct Type {
+        TypeKind kind;
+        // Width of integers (from 1 to 64) and floats (32 or 64).
+        std::uint8_t bits;
+        // Set for the types of the literals without a suffix, and of the operations on them
+        // only, which take the type of the other operand of an operation. Integers can then
+        // become floats, as in `0.5 * 2`.
+        bool isDefault = false;
+
+        bool operator==(Type const& other) const = default;
+    };
+    // Types of the values without a suffix and of Booleans.
+    inline constexpr Type defaultInteger = { TypeKind::Signed, 64, true };
+    inline constexpr Type defaultFloat = { TypeKind::Float, 64, true };
+    inline constexpr Type booleanType = { TypeKind::Boolean, 1 };
+    // Returns the spelling of the type, such as `i64`, `u8`, `f32` or `bool`.
+    std::string spellType(Type type);
+    // Returns the spelling of the bits of a register holding a value of the type, with the
+    // type's suffix unless it is a default type, such as `-20`, `255u8`, `0.5` or `#true`.
+    std::string spellValue(std::uint64_t bits, Type type);
+
+    // Operation of an instruction. Integer operations work on all 64 bits of their registers,
+    // and are followed by a wrap if their type is narrower. Greater and GreaterEqual have no
+    // operations, as they are Less and LessEqual with their operands swapped.
+    enum class Opcode : std::uint8_t {
+        // Integers (and Booleans for the equalities), wrapping around at 64 bits.
+        Add,
+        Subtract,
+        Multiply,
+        DivideSigned,
+        DivideUnsigned,
+        RemainderSigned,
+        RemainderUnsigned,
+        Negate,
+        LessSigned,
+        LessUnsigned,
+        LessEqualSigned,
+        LessEqualUnsigned,
+        Equal,
+        NotEqual,
+        // Sign-extends or zero-extends the lowest b bits of a register.
+        WrapSigned,
+        WrapUnsigned,
+        // Floats.
+        AddFloat,
+        SubtractFloat,
+        MultiplyFloat,
+        DivideFloat,
+        RemainderFloat,
+        NegateFloat,
+        LessFloat,
+        LessEqualFloat,
+        EqualFloat,
+        NotEqualFloat,
+        // Rounds a float to 32 bits.
+        RoundFloat32,
+        // Converts an integer to a float.
+        SignedToFloat,
+        UnsignedToFloat,
+        // Ends the evaluation, whose result is the register a.
+        Return
+    };
+    // Number of opcodes.
+    inline constexpr std::size_t opcodeCount = static_cast<std::size_t>(Opcode::Return) + 1;
+    // Instruction of a register machine, which writes the result of its operation on the
+    // registers a and b (unless unused) to the register dst.
+    struct Instruction {
+        Opcode op;
+        std::uint8_t dst;
+        std::uint8_t a;
+        std::uint8_t b;
+    };
+    // Returns the bits which the machine writes for the operation on the bits of its operands
+    // (where b is the bit count of wraps, and unused by unary operations), before the wrap or
+    // rounding into a narrower type. Integer divisions and remainders must not be by zero,
+    // which the machine checks first. The compiler folds operations on constants with it, so
+    // that they give the same results as when evaluated.
+    inline std::uint64_t applyOpcode(Opcode op, std::uint64_t a, std::uint64_t b) {
+        auto const _s = [](std::uint64_t bits) { return static_cast<std::int64_t>(bits); };
+        auto const _f = [](std::uint64_t bits) { return std::bit_cast<double>(bits); };
+        auto const _bits = [](double value) { return std::bit_cast<std::uint64_t>(value); };
+        switch (op) {
+            case Opcode::Add: return a + b;
+            case Opcode::Subtract: return a - b;
+            case Opcode::Multiply: return a * b;
+            // Dividing the smallest integer by -1 overflows, and wraps around to itself.
+            case Opcode::DivideSigned: return _s(b) == -1? 0 - a : std::uint64_t(_s(a) / _s(b));
+            case Opcode::DivideUnsigned: return a / b;
+            case Opcode::RemainderSigned: return _s(b) == -1? 0 : std::uint64_t(_s(a) % _s(b));
+            case Opcode::RemainderUnsigned: return a % b;
+            case Opcode::Negate: return 0 - a;
+            case Opcode::LessSigned: return _s(a) < _s(b);
+            case Opcode::LessUnsigned: return a < b;
+            case Opcode::LessEqualSigned: return _s(a) <= _s(b);
+            case Opcode::LessEqualUnsigned: return a <= b;
+            case Opcode::Equal: return a == b;
+            case Opcode::NotEqual: return a != b;
+            // Moves the sign bit of the width to the top, and shifts it back down.
+            case Opcode::WrapSigned: return std::uint64_t(_s(a << (64 - b)) >> (64 - b));
+            case Opcode::WrapUnsigned: return a & (~std::uint64_t(0) >> (64 - b));
+            case Opcode::AddFloat: return _bits(_f(a) + _f(b));
+            case Opcode::SubtractFloat: return _bits(_f(a) - _f(b));
+            case Opcode::MultiplyFloat: return _bits(_f(a) * _f(b));
+            case Opcode::DivideFloat: return _bits(_f(a) / _f(b));
+            case Opcode::RemainderFloat: return _bits(std::fmod(_f(a), _f(b)));
+            case Opcode::NegateFloat: return _bits(-_f(a));
+            case Opcode::LessFloat: return _f(a) < _f(b);
+            case Opcode::LessEqualFloat: return _f(a) <= _f(b);
+            case Opcode::EqualFloat: return _f(a) == _f(b);
+            case Opcode::NotEqualFloat: return _f(a) != _f(b);
+            case Opcode::RoundFloat32: return _bits(static_cast<float>(_f(a)));
+            case Opcode::SignedToFloat: return _bits(static_cast<double>(_s(a)));
+            case Opcode::UnsignedToFloat: return _bits(static_cast<double>(a));
+            default: return a;
+        }
+    }
+    // Name which an expression can refer to, whose value is given for each evaluation, or
+    // once when compiling if it is known then.
+    struct Binding {
+        Symbol name;
+        Type type;
+        // Value known at compile time, such as a setting, normalised like the values given to
+        // Program::Run. The compiler uses it as a constant, and ignores the value given to Run.
+        std::optional<std::uint64_t> value = std::nullopt;
+    };
+    // Kind of the elements of a column.
+    enum class ColumnKind : std::uint8_t {
+        Signed8,
+        Signed16,
+        Signed32,
+        Signed64,
+        Unsigned8,
+        Unsigned16,
+        Unsigned32,
+        Unsigned64,
+        Float32,
+        Float64,
+        Boolean
+    };
+    // Types which columns can have the elements of.
+    template<typename T> concept ColumnElement =
+        (std::integral<T> && sizeof(T) <= 8) || std::same_as<T, float> || std::same_as<T, double>;
+    // Values of a binding for each entity of a batch, such as the levels of all the entities,
+    // as an array of integers, floats or Booleans which is read in place. Integers can be of
+    // any width and signedness, but must fit in the type of their binding, like the values
+    // given to Program::Run.
+    class Column {
+    private:
+        void const* data = nullptr;
+        std::size_t size = 0;
+        ColumnKind kind = ColumnKind::Signed64;
+
+        // Returns the kind of the columns of the element type.
+        template<ColumnElement T> static constexpr ColumnKind kindOf() {
+            constexpr int _width = std::countr_zero(sizeof(T));
+            if constexpr (std::same_as<T, bool>) {
+                return ColumnKind::Boolean;
+            } else if constexpr (std::same_as<T, float>) {
+                return ColumnKind::Float32;
+            } else if constexpr (std::same_as<T, double>) {
+                return ColumnKind::Float64;
+            } else if constexpr (std::is_signed_v<T>) {
+                return static_cast<ColumnKind>(static_cast<int>(ColumnKind::Signed8) + _width);
+            } else {
+                return static_cast<ColumnKind>(static_cast<int>(ColumnKind::Unsigned8) + _width);
+            }
+        }
+    public:
+        // Constructs an empty column, such as for the bindings which have a known value.
+        Column() = default;
+        // Constructs the column of the values, which must outlive it.
+        template<typename T, std::size_t Extent> requires ColumnElement<std::remove_const_t<T>>
+        Column(std::span<T, Extent> values)
+            : data(values.data()), size(values.size()), kind(kindOf<std::remove_const_t<T>>()) {}
+        ColumnKind GetKind() const;
+        std::size_t Size() const;
+        void const* GetData() const;
+    };
+    // Error in the types of an expression, or in a part of it which cannot be compiled,
+    // thrown at the node at fault.
+    class CompileException : public Tokeniser::Exception {
+    public:
+        using Exception::Exception;
+    };
+    // Error while evaluating an expression, such as a division by zero, thrown at the
+    // operation at fault.
+    class EvaluationException : public Tokeniser::Exception {
+    public:
+        using Exception::Exception;
+    };
+    // Expression compiled into bytecode for a register machine whose registers are untyped
+    // 64-bit words, as the types are known at compile time. The first registers hold the
+    // constants, followed by the inputs and the temporaries, so that instructions read
+    // constants and inputs directly. Registers are on the stack, so evaluating never
+    // allocates.
+    class Program {
+    public:
+        // Number of registers, which instructions address with 8 bits.
+        static constexpr std::size_t maxRegisters = 256;
+    private:
+        std::vector<Instruction> code;
+        // Offset in the source of the node each instruction comes from, to locate its errors.
+        std::vector<std::uint32_t> offsets;
+        std::vector<std::uint64_t> constants;
+        // Index of the binding whose value each input register holds, and its type.
+        std::vector<std::uint16_t> inputs;
+        std::vector<Type> inputTypes;
+        // Number of bindings the program was compiled with, which is the number of values
+        // needed to run it.
+        std::uint32_t bindingCount = 0;
+        std::uint32_t registerCount = 0;
+        Type resultType = defaultInteger;
+
+        // Builds the instructions.
+        friend class Compiler;
+
+        // Runs the instructions on the registers, whose constants and inputs are set, and
+        // returns the bits of the result.
+        std::uint64_t execute(std::uint64_t* registers) const;
+        // Returns the bits of the result for the values, checked like Evaluate's.
+        std::uint64_t evaluate(std::span<Value const> values) const;
+        // Returns the result as a value, boxing the integers which do not fit inline in the
+        // arena, or throwing an EvaluationException for them without one.
+        Value makeResult(std::uint64_t result, Arena* arena) const;
+    public:
+        Program() = default;
+        // Returns the type of the value returned by Run.
+        Type GetResultType() const;
+        std::span<Instruction const> GetCode() const;
+        std::span<std::uint64_t const> GetConstants() const;
+        // Returns the index of the binding of each input register, which come after the
+        // constants' registers.
+        std::span<std::uint16_t const> GetInputs() const;
+        // Returns the number of registers used by the instructions.
+        std::size_t GetRegisterCount() const;
+        // Evaluates the expression with the values of the bindings it was compiled with, in
+        // the same order, and returns the bits of its result. Each value must be normalised
+        // to its binding's type: sign-extended or zero-extended from its width. Throws an
+        // EvaluationException for integer divisions by zero, and std::invalid_argument if
+        // there are fewer values than bindings. Dispatches through computed gotos where the
+        // compiler supports them, and through a switch elsewhere.
+        std::uint64_t Run(std::span<std::uint64_t const> values = {}) const;
+        // Same as Run, but with values of any kind, for hosts which do not know the types of
+        // the bindings statically, and returns the result as a value. Throws
+        // std::invalid_argument if a value is not of the kind of its binding's type or does
+        // not fit in it, and an EvaluationException if the result is an integer which does
+        // not fit inline in a value.
+        Value Evaluate(std::span<Value const> values = {}) const;
+        // Same as Evaluate, but boxes an integer result which does not fit inline in the
+        // arena, where it lives until the arena is reset.
+        Value Evaluate(std::span<Value const> values, Arena& arena) const;
+        // Evaluates the expression for each entity of a batch, with the values of its bindings
+        // in the columns (one per binding, in the same order, each with an element per
+        // entity), and writes the bits of each entity's result to the results. Runs each
+        // instruction on a block of entities at once, with SSE2 or AVX2 for the operations
+        // they have, instead of dispatching each instruction once per entity. Throws
+        // std::invalid_argument if a column which the program reads is of the wrong kind for
+        // its binding's type or is shorter than the results, and an EvaluationException if
+        // an integer division by zero happens for any entity, leaving the results of the
+        // entities before its block.
+        void RunBatch(std::span<Column const> columns, std::span<std::uint64_t> results) const;
+        // Returns the spelling of the instructions, one per line, for debugging.
+        std::string Disassemble() const;
+    };
+    // Returns the bits of the value in a register.
+    constexpr std::uint64_t integerBits(std::int64_t value) {
+        return static_cast<std::uint64_t>(value);
+    }
+    constexpr std::uint64_t floatBits(double value) {
+        return std::bit_cast<std::uint64_t>(value);
+    }
+    constexpr std::uint64_t booleanBits(bool value) {
+        return value? 1 : 0;
+    }
+    // Compiles the tree into a program, which refers to each name through the binding of the
+    // same name. Throws a CompileException for names without a binding, operands of the
+    // wrong types, integer constants without a suffix compared with a type they do not fit
+    // in, types the machine does not support (integers of more than 64 bits or 16-bit
+    // floats), and expressions needing more than Program::maxRegisters registers.
+    // Unless fold is false, operations on constants (including the bindings with a known
+    // value) are computed at compile time with the wraps of their types, and identities
+    // such as `x + 0`, `x * 1`, `x * 0` and `-(-x)` are simplified, leaving only the
+    // instructions whose results are used. Integer divisions by zero are never folded, and
+    // still throw when evaluated.
+    Program compileExpression(
+        Ast const& ast,
+        std::span<Binding const> bindings = {},
+        bool fold = true
+    );
+}
+#endif
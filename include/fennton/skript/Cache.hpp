@@ -0,0 +1,55 @@
+#ifndef FENNTON_CACHE_HPP
+#define FENNTON_CACHE_HPP
+
+#include <fennton/utils/Memory.hpp>
+#include <fennton/skript/Parser.hpp>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <cstdint>
+
+namespace Fennton::Skript::Tokeniser {
+    // Returns the 64-bit hash of the source (XXH64 with a zero seed, reading the bytes in the
+    // machine's order), which keys the cached streams.
+    std::uint64_t hashSource(std::string_view source);
+    // Directory of token streams saved to disk, so that unchanged sources are not tokenised
+    // again on every run. Each stream is stored in its own file, named after the hash of its
+    // source, in a binary format made only of offsets (so it can be mapped at any address)
+    // and versioned, so that files from other versions or machines are ignored. Loading a
+    // stream maps its file and copies each of its arrays in one go, without tokenising the
+    // source again. Names are stored as spellings and interned again, as symbols are only
+    // valid for the process that interned them. A hit is still linear in the source: it
+    // hashes the source to find its file, copies each array once, interns each distinct name
+    // once and checks each token so that a corrupt file is never trusted, with a fixed number
+    // of allocations (the cache benchmark measures it against tokenising).
+    class TokenCache {
+    private:
+        std::filesystem::path directory;
+    public:
+        // Version of the file format, changed whenever the layout of the files or of the
+        // stream's arrays changes, or the same source is tokenised differently.
+        static constexpr std::uint32_t version = 4;
+
+        // Constructs a cache storing its files in the directory, which is created when the
+        // first stream is stored.
+        TokenCache(std::filesystem::path directory);
+        // Returns the directory named skript_cache next to the running executable.
+        static std::filesystem::path defaultDirectory();
+        std::filesystem::path const& GetDirectory() const;
+        // Returns the path of the file of the source's stream.
+        std::filesystem::path GetPath(std::string_view source) const;
+        // Returns the cached stream of the source, referring to it, or nothing if there is
+        // none or its file is invalid.
+        std::optional<TokenStream> Load(Memory::Strong<std::string const> source) const;
+        // Saves the stream to the cache, replacing any previous file atomically so that
+        // concurrent runs never read a partial file. Returns false if it could not be written,
+        // as the cache only speeds tokenising up, or if the stream has errors (which tokenise
+        // throws for, so they are never loaded).
+        bool Store(TokenStream const& stream) const;
+    };
+    // Same as tokenise, but returns the cached stream of the source if there is one, and
+    // otherwise tokenises it and stores the stream in the cache.
+    TokenStream tokenise(Memory::Strong<std::string const> source, TokenCache const& cache);
+}
+#endif
@@ -0,0 +1,91 @@
+#ifndef FENNTON_CHAR_CLASS_HPP
+#define FENNTON_CHAR_CLASS_HPP
+
+#include <array>
+#include <string_view>
+#include <cstdint>
+
+namespace Fennton::Skript::Tokeniser {
+    // Bit flags for the classes of the characters, as used by the tokeniser. In their own 
+    // namespace, as some of them share their names with token types.
+    namespace CharClass {
+        enum Flag : std::uint16_t {
+            // Binary digit (0 or 1).
+            Digit2 = 1 << 0,
+            // Octal digit (in the 01234567 set).
+            Digit8 = 1 << 1,
+            // Decimal digit (in the 0123456789 set).
+            Digit10 = 1 << 2,
+            // Lowercase hexadecimal digit (in the 0123456789abcdef set).
+            Digit16 = 1 << 3,
+            // Uppercase hexadecimal letter (in the ABCDEF set).
+            UpperHex = 1 << 4,
+            // Whitespace, as defined by the classic C locale.
+            Space = 1 << 5,
+            // Punctuation, as defined by the classic C locale, minus the `_` character.
+            Punct = 1 << 6,
+            // Control character, as defined by the classic C locale.
+            Control = 1 << 7,
+            // Character which can start a name (or a number's suffix).
+            NameStart = 1 << 8,
+            // Character which can continue a name (or a number's suffix).
+            NameContinue = 1 << 9,
+            // Character which can follow a backslash in a string literal (the escape sequences 
+            // produced by Text::escape, in the \\'"?abfnrtv0123456 set).
+            Escape = 1 << 10,
+            // Character which Text::escape replaces with an escape sequence.
+            Escaped = 1 << 11
+        };
+    }
+    // Generates the classification table for all 256 values of a char. Bytes outside the
+    // ASCII range have no class.
+    constexpr std::array<std::uint16_t, 256> makeCharClasses() {
+        std::array<std::uint16_t, 256> _table = {};
+        for (int c = 0; c < 0x20; ++c) {
+            _table[c] |= CharClass::Control;
+        }
+        _table[0x7F] |= CharClass::Control;
+        for (char c : { ' ', '\f', '\n', '\r', '\t', '\v' }) {
+            _table[static_cast<unsigned char>(c)] |= CharClass::Space;
+        }
+        for (char c : std::string_view("!\"#$%&'()*+,-./:;<=>?@[\\]^`{|}~")) {
+            _table[static_cast<unsigned char>(c)] |= CharClass::Punct;
+        }
+        for (int c = '0'; c <= '9'; ++c) {
+            _table[c] |= CharClass::Digit10 | CharClass::Digit16 | CharClass::NameContinue;
+            if (c <= '7') { _table[c] |= CharClass::Digit8; }
+            if (c <= '1') { _table[c] |= CharClass::Digit2; }
+        }
+        for (int c = 'a'; c <= 'z'; ++c) {
+            _table[c] |= CharClass::NameStart | CharClass::NameContinue;
+            if (c <= 'f') { _table[c] |= CharClass::Digit16; }
+        }
+        for (int c = 'A'; c <= 'Z'; ++c) {
+            _table[c] |= CharClass::NameStart | CharClass::NameContinue;
+            if (c <= 'F') { _table[c] |= CharClass::UpperHex; }
+        }
+        _table['_'] |= CharClass::NameStart | CharClass::NameContinue;
+        for (char c : std::string_view("\\'\"?abfnrtv0123456")) {
+            _table[static_cast<unsigned char>(c)] |= CharClass::Escape;
+        }
+        for (int c = '\0'; c <= '\r'; ++c) {
+            _table[c] |= CharClass::Escaped;
+        }
+        for (char c : { '\\', '\'', '"', '?' }) {
+            _table[static_cast<unsigned char>(c)] |= CharClass::Escaped;
+        }
+        return _table;
+    }
+    // The classes of each character, indexed by the character's value as an unsigned char.
+    inline constexpr std::array<std::uint16_t, 256> charClasses = makeCharClasses();
+
+    // Returns the classes of the character.
+    constexpr std::uint16_t classOf(char c) {
+        return charClasses[static_cast<unsigned char>(c)];
+    }
+    // Returns true if the character is in any of the classes.
+    constexpr bool hasClass(char c, std::uint16_t classes) {
+        return (classOf(c) & classes) != 0;
+    }
+}
+#endif
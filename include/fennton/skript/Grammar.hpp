@@ -0,0 +1,81 @@
+#ifndef FENNTON_GRAMMAR_HPP
+#define FENNTON_GRAMMAR_HPP
+
+#include <fennton/skript/Parser.hpp>
+#include <fennton/skript/Lexer.hpp>
+#include <fennton/skript/Operators.hpp>
+#include <array>
+#include <string_view>
+#include <cstddef>
+#include <cstdint>
+
+namespace Fennton::Skript::Tokeniser {
+    // Classes of the tokens of the grammar, which are the tags of its rules. They are numbered
+    // after the operators, so that the tag of a punctuation token is its operator.
+    enum class TokenClass : std::uint16_t {
+        Space = operatorCount,
+        Comment,
+        Name,
+        Number,
+        // String without escape sequences, which can refer to the source.
+        PlainString,
+        EscapedString,
+        // Unterminated comments and strings, and strings with invalid escape sequences.
+        Malformed
+    };
+    // Returns the tag of the token class's rules.
+    constexpr std::uint16_t tagOf(TokenClass tokenClass) {
+        return static_cast<std::uint16_t>(tokenClass);
+    }
+    // Number of the rules of the grammar which are not operators.
+    inline constexpr std::size_t grammarClassRules = 11;
+
+    // Returns the declarative grammar of the tokens, matching the same extents as the
+    // hand-written tokeniser. Numbers are matched as any of the bases' forms, with their
+    // suffixes; malformed ones are left for the number parsers to report.
+    constexpr std::array<LexerRule, grammarClassRules + operatorCount> makeGrammar() {
+        std::array<LexerRule, grammarClassRules + operatorCount> _rules = {{
+            { "[ \t\n\v\f\r]+", tagOf(TokenClass::Space) },
+            { "//[^\n]*", tagOf(TokenClass::Comment) },
+            { "/\\*([^*]|\\*+[^*/])*\\*+/", tagOf(TokenClass::Comment) },
+            { "/\\*([^*]|\\*+[^*/])*\\**", tagOf(TokenClass::Malformed) },
+            { "[A-Za-z_][A-Za-z0-9_]*", tagOf(TokenClass::Name) },
+            {
+                "(0b[01]+(\\.[01]+)*|0o[0-7]+(\\.[0-7]+)*|0[0-7]+(\\.[0-7]+)*"
+                "|[0-9]+(\\.[0-9]+)*)([A-Za-z_][A-Za-z0-9_]*('[A-Za-z_][A-Za-z0-9_]*)*)?",
+                tagOf(TokenClass::Number)
+            },
+            {
+                "0x[0-9A-Fa-f]+(\\.[0-9A-Fa-f]+)*"
+                "(\\.'[A-Za-z_][A-Za-z0-9_]*('[A-Za-z_][A-Za-z0-9_]*)*)?",
+                tagOf(TokenClass::Number)
+            },
+            { "\"[^\"\\\\]*\"", tagOf(TokenClass::PlainString) },
+            { "\"([^\"\\\\]|\\\\[\\\\'\"?abfnrtv0-6])*\"", tagOf(TokenClass::EscapedString) },
+            { "\"([^\"\\\\]|\\\\.)*\"", tagOf(TokenClass::Malformed) },
+            { "\"([^\"\\\\]|\\\\.)*\\\\?", tagOf(TokenClass::Malformed) }
+        }};
+        for (std::size_t i = 0; i < operatorCount; ++i) {
+            _rules[grammarClassRules + i] = {
+                operatorSpellings[i], static_cast<std::uint16_t>(i), true
+            };
+        }
+        return _rules;
+    }
+    // Grammar of the tokens, from which the generated lexer is built.
+    inline constexpr auto grammar = makeGrammar();
+
+    // Same as consumeSpace, but using the lexer generated from the grammar.
+    std::string_view::const_iterator lexSpace(
+        std::string_view::const_iterator start,
+        std::string_view::const_iterator end
+    );
+    // Same as tokeniseNext, but using the lexer generated from the grammar to find the token
+    // and its class. Numbers are still decoded by the number parsers, and malformed tokens
+    // are passed to tokeniseNext so that their errors are the same.
+    TokenResult lexNext(
+        std::string_view::const_iterator start,
+        std::string_view::const_iterator end
+    );
+}
+#endif
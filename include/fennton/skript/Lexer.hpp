@@ -0,0 +1,599 @@
+#ifndef FENNTON_LEXER_HPP
+#define FENNTON_LEXER_HPP
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace Fennton::Skript::Tokeniser {
+    // Rule of a declarative lexer grammar, giving its tag to the tokens matching its pattern.
+    // Patterns are regular expressions made of bytes, escapes (`\n`, `\t`, `\r`, `\v` and `\f`,
+    // or a backslash followed by any other byte to match it literally), classes (such as
+    // `[a-z_]`, or `[^"]` for their complement), `.` for any byte, groups, alternatives (`|`)
+    // and the `*`, `+` and `?` repetitions. Literal rules match their pattern exactly.
+    struct LexerRule {
+        std::string_view pattern;
+        std::uint16_t tag;
+        bool literal = false;
+    };
+    // Longest match of a lexer at the start of a text, whose length is zero if there is none.
+    struct LexerMatch {
+        std::uint16_t tag;
+        std::size_t length;
+    };
+    // Numbers of states and byte classes of a generated automaton.
+    struct LexerSizes {
+        std::size_t states;
+        std::size_t classes;
+    };
+    // Minimal deterministic automaton generated from a grammar, stored as a dense transition
+    // table indexed by state and byte class. Bytes which no rule tells apart share a class,
+    // so the table only has a column per class. Each state is a row of the table, holding the
+    // offset of the next state's row for each class (rather than its number, which would
+    // have to be multiplied on every byte) followed by the state's tag. The first row is the
+    // dead state, which never leads to a match, and the second is the start.
+    template<std::size_t StateCount, std::size_t ClassCount> class Dfa {
+    public:
+        static constexpr std::size_t stateCount = StateCount;
+        static constexpr std::size_t classCount = ClassCount;
+        static constexpr std::size_t rowSize = ClassCount + 1;
+        static_assert(StateCount * rowSize <= 0x10000, "Lexer automaton is too large.");
+
+        static constexpr std::uint16_t dead = 0;
+        static constexpr std::uint16_t start = rowSize;
+        // Tag of the states which end no match.
+        static constexpr std::uint16_t noTag = 0xFFFF;
+
+        // Class of each byte.
+        std::array<std::uint8_t, 256> classes = {};
+        // Row of each state.
+        std::array<std::uint16_t, StateCount * rowSize> rows = {};
+
+        // Returns the longest match at the start of the text, and its tag. Ties between rules
+        // are won by the first rule of the grammar.
+        constexpr LexerMatch Match(std::string_view text) const {
+            LexerMatch _match = { noTag, 0 };
+            std::size_t _row = start;
+            for (std::size_t i = 0; i < text.size(); ++i) {
+                _row = rows[_row + classes[static_cast<unsigned char>(text[i])]];
+                if (_row == dead) {
+                    break;
+                }
+                if (std::uint16_t const _tag = rows[_row + ClassCount]; _tag != noTag) {
+                    _match = { _tag, i + 1 };
+                }
+            }
+            return _match;
+        }
+    };
+
+    // Construction of the automata, only ever evaluated at compile time: the patterns are
+    // compiled into a nondeterministic automaton (Thompson's construction), which is made
+    // deterministic by the subset construction over byte classes and then minimised by
+    // refining the partition of its states (Moore's algorithm).
+    namespace LexerBuilder {
+        inline constexpr std::size_t none = static_cast<std::size_t>(-1);
+
+        // Set of bytes, as a 256-bit mask.
+        struct ByteSet {
+            std::array<std::uint64_t, 4> bits = {};
+
+            constexpr void Add(unsigned char first, unsigned char last) {
+                for (unsigned c = first; c <= last; ++c) {
+                    bits[c / 64] |= std::uint64_t(1) << (c % 64);
+                }
+            }
+            constexpr bool Has(unsigned char c) const {
+                return (bits[c / 64] >> (c % 64)) & 1;
+            }
+            constexpr bool operator==(ByteSet const&) const = default;
+            constexpr void Invert() {
+                for (std::uint64_t& _word : bits) {
+                    _word = ~_word;
+                }
+            }
+        };
+        struct NfaState {
+            std::vector<std::size_t> epsilons;
+            // Bytes leading to the target, if there is one.
+            ByteSet bytes;
+            std::size_t target = none;
+            // Index of the rule accepted by the state, if any.
+            std::size_t rule = none;
+        };
+        // Part of the automaton with a single start and a single end.
+        struct Fragment {
+            std::size_t start;
+            std::size_t end;
+        };
+        // Compiles the patterns into a nondeterministic automaton, throwing (which fails the
+        // compilation) for malformed patterns.
+        class NfaCompiler {
+        private:
+            std::string_view pattern;
+            std::size_t position = 0;
+        public:
+            std::vector<NfaState> states;
+
+            constexpr std::size_t NewState() {
+                states.emplace_back();
+                return states.size() - 1;
+            }
+            constexpr void Link(std::size_t from, std::size_t to) {
+                states[from].epsilons.push_back(to);
+            }
+            constexpr Fragment Bytes(ByteSet const& bytes) {
+                std::size_t const _start = NewState();
+                std::size_t const _end = NewState();
+                states[_start].bytes = bytes;
+                states[_start].target = _end;
+                return { _start, _end };
+            }
+            constexpr Fragment Byte(char c) {
+                ByteSet _bytes;
+                _bytes.Add(static_cast<unsigned char>(c), static_cast<unsigned char>(c));
+                return Bytes(_bytes);
+            }
+            // Returns the byte matched by the escape sequence whose backslash was consumed.
+            constexpr char Escaped() {
+                if (position == pattern.size()) {
+                    throw std::logic_error("Lexer pattern ends with a backslash.");
+                }
+                switch (char const c = pattern[position++]) {
+                    case 'n': return '\n';
+                    case 't': return '\t';
+                    case 'r': return '\r';
+                    case 'v': return '\v';
+                    case 'f': return '\f';
+                    default: return c;
+                }
+            }
+            // Parses a class whose `[` was consumed.
+            constexpr Fragment Class() {
+                ByteSet _bytes;
+                bool const _inverted = position != pattern.size() && pattern[position] == '^';
+                if (_inverted) {
+                    ++position;
+                }
+                for (;;) {
+                    if (position == pattern.size()) {
+                        throw std::logic_error("Lexer pattern has an unterminated class.");
+                    }
+                    char _first = pattern[position++];
+                    if (_first == ']') {
+                        break;
+                    }
+                    if (_first == '\\') {
+                        _first = Escaped();
+                    }
+                    char _last = _first;
+                    if (
+                        pattern.size() - position >= 2 && pattern[position] == '-'
+                        && pattern[position + 1] != ']'
+                    ) {
+                        position += 1;
+                        _last = pattern[position++];
+                        if (_last == '\\') {
+                            _last = Escaped();
+                        }
+                    }
+                    _bytes.Add(
+                        static_cast<unsigned char>(_first), static_cast<unsigned char>(_last)
+                    );
+                }
+                if (_inverted) {
+                    _bytes.Invert();
+                }
+                return Bytes(_bytes);
+            }
+            constexpr Fragment Atom() {
+                switch (char const c = pattern[position++]) {
+                    case '(': {
+                        Fragment const _group = Alternation();
+                        if (position == pattern.size() || pattern[position] != ')') {
+                            throw std::logic_error("Lexer pattern has an unterminated group.");
+                        }
+                        ++position;
+                        return _group;
+                    }
+                    case '[':
+                        return Class();
+                    case '.': {
+                        ByteSet _bytes;
+                        _bytes.Add(0, 255);
+                        return Bytes(_bytes);
+                    }
+                    case '\\':
+                        return Byte(Escaped());
+                    case '*':
+                    case '+':
+                    case '?':
+                        throw std::logic_error("Lexer pattern repeats nothing.");
+                    default:
+                        return Byte(c);
+                }
+            }
+            constexpr Fragment Repetition() {
+                Fragment _fragment = Atom();
+                while (position != pattern.size()) {
+                    char const c = pattern[position];
+                    if (c != '*' && c != '+' && c != '?') {
+                        break;
+                    }
+                    ++position;
+                    std::size_t const _start = NewState();
+                    std::size_t const _end = NewState();
+                    Link(_start, _fragment.start);
+                    Link(_fragment.end, _end);
+                    if (c != '+') {
+                        Link(_start, _end);
+                    }
+                    if (c != '?') {
+                        Link(_fragment.end, _fragment.start);
+                    }
+                    _fragment = { _start, _end };
+                }
+                return _fragment;
+            }
+            constexpr Fragment Concatenation() {
+                std::size_t const _start = NewState();
+                Fragment _fragment = { _start, _start };
+                while (
+                    position != pattern.size()
+                    && pattern[position] != '|' && pattern[position] != ')'
+                ) {
+                    Fragment const _next = Repetition();
+                    Link(_fragment.end, _next.start);
+                    _fragment.end = _next.end;
+                }
+                return _fragment;
+            }
+            constexpr Fragment Alternation() {
+                Fragment _fragment = Concatenation();
+                while (position != pattern.size() && pattern[position] == '|') {
+                    ++position;
+                    Fragment const _other = Concatenation();
+                    std::size_t const _start = NewState();
+                    std::size_t const _end = NewState();
+                    Link(_start, _fragment.start);
+                    Link(_start, _other.start);
+                    Link(_fragment.end, _end);
+                    Link(_other.end, _end);
+                    _fragment = { _start, _end };
+                }
+                return _fragment;
+            }
+            // Compiles the rule and returns its fragment, whose end accepts the rule.
+            constexpr Fragment Rule(LexerRule const& rule, std::size_t index) {
+                Fragment _fragment;
+                if (rule.literal) {
+                    std::size_t const _start = NewState();
+                    _fragment = { _start, _start };
+                    for (char c : rule.pattern) {
+                        Fragment const _next = Byte(c);
+                        Link(_fragment.end, _next.start);
+                        _fragment.end = _next.end;
+                    }
+                } else {
+                    pattern = rule.pattern;
+                    position = 0;
+                    _fragment = Alternation();
+                    if (position != pattern.size()) {
+                        throw std::logic_error("Lexer pattern has an unmatched parenthesis.");
+                    }
+                }
+                states[_fragment.end].rule = index;
+                return _fragment;
+            }
+        };
+        // Minimal automaton, before being copied into a table of its exact size.
+        struct Automaton {
+            std::array<std::uint8_t, 256> classes = {};
+            std::size_t classCount = 0;
+            std::size_t stateCount = 0;
+            std::vector<std::size_t> transitions;
+            std::vector<std::uint16_t> tags;
+        };
+        // Returns a hash of the words, to find equal sets and signatures quickly.
+        constexpr std::uint64_t hashOf(std::uint64_t const* words, std::size_t count) {
+            std::uint64_t _hash = 0;
+            for (std::size_t i = 0; i < count; ++i) {
+                // Folds the high bits back, as the bits of the sets are spread over the words.
+                _hash = (_hash ^ words[i]) * 0x9E3779B97F4A7C15;
+                _hash ^= _hash >> 32;
+            }
+            return _hash;
+        }
+        // Open-addressing hash table numbering distinct lists of words of the same width (the
+        // sets of states of the subset construction, and the signatures of the minimisation)
+        // in order of insertion. The lists are stored one after the other. Raw pointers are
+        // used throughout, as they are much cheaper than iterators to evaluate at compile
+        // time.
+        class Interner {
+        private:
+            std::size_t width;
+            std::vector<std::uint64_t> hashes;
+            // Index of the list in each slot, or none.
+            std::vector<std::size_t> slots = std::vector<std::size_t>(256, none);
+
+            constexpr bool Equals(std::size_t index, std::uint64_t const* list) const {
+                std::uint64_t const* const _words = words.data() + index * width;
+                for (std::size_t i = 0; i < width; ++i) {
+                    if (_words[i] != list[i]) {
+                        return false;
+                    }
+                }
+                return true;
+            }
+            constexpr std::size_t& SlotOf(std::uint64_t hash, std::uint64_t const* list) {
+                std::size_t const _mask = slots.size() - 1;
+                for (std::size_t i = hash & _mask;; i = (i + 1) & _mask) {
+                    std::size_t const _index = slots[i];
+                    if (_index == none || (hashes[_index] == hash && Equals(_index, list))) {
+                        return slots[i];
+                    }
+                }
+            }
+        public:
+            std::vector<std::uint64_t> words;
+
+            constexpr Interner(std::size_t width) {
+                this->width = width;
+            }
+            constexpr std::size_t Count() const {
+                return hashes.size();
+            }
+            // Returns the index of the list, adding it if it is new.
+            constexpr std::size_t Intern(std::uint64_t const* list) {
+                if (2 * (Count() + 1) > slots.size()) {
+                    slots = std::vector<std::size_t>(2 * slots.size(), none);
+                    for (std::size_t i = 0; i < Count(); ++i) {
+                        SlotOf(hashes[i], words.data() + i * width) = i;
+                    }
+                }
+                std::uint64_t const _hash = hashOf(list, width);
+                std::size_t& _slot = SlotOf(_hash, list);
+                if (_slot == none) {
+                    _slot = Count();
+                    words.insert(words.end(), list, list + width);
+                    hashes.push_back(_hash);
+                }
+                return _slot;
+            }
+        };
+        // Generates the minimal automaton of the rules.
+        constexpr Automaton build(std::span<LexerRule const> rules) {
+            if (rules.empty() || rules.size() >= 0xFFFF) {
+                throw std::logic_error("Lexer grammars must have between 1 and 65534 rules.");
+            }
+            NfaCompiler _compiler;
+            std::size_t const _nfaStart = _compiler.NewState();
+            for (std::size_t i = 0; i < rules.size(); ++i) {
+                _compiler.Link(_nfaStart, _compiler.Rule(rules[i], i).start);
+            }
+            std::vector<NfaState> const& _nfa = _compiler.states;
+            Automaton _result;
+
+            // Distinct sets of bytes of the edges, as most edges share the same few sets.
+            Interner _edges = Interner(4);
+            std::vector<std::size_t> _edgeOf = std::vector<std::size_t>(_nfa.size(), none);
+            for (std::size_t i = 0; i < _nfa.size(); ++i) {
+                if (_nfa[i].target != none) {
+                    _edgeOf[i] = _edges.Intern(_nfa[i].bytes.bits.data());
+                }
+            }
+            // Splits the bytes into the classes which no edge tells apart, by moving the bytes
+            // of each edge out of their classes into new ones, then numbering the classes
+            // left in order of their first byte.
+            std::array<std::size_t, 256> _classes = {};
+            std::size_t _classCount = 1;
+            for (std::size_t e = 0; e < _edges.Count(); ++e) {
+                // New class of the bytes of each class which are in the edge.
+                std::vector<std::size_t> _moved = std::vector<std::size_t>(_classCount, none);
+                for (std::size_t w = 0; w < 4; ++w) {
+                    for (
+                        std::uint64_t _bits = _edges.words[e * 4 + w];
+                        _bits != 0;
+                        _bits &= _bits - 1
+                    ) {
+                        std::size_t const c = w * 64 + std::countr_zero(_bits);
+                        std::size_t& _new = _moved[_classes[c]];
+                        if (_new == none) {
+                            _new = _classCount++;
+                        }
+                        _classes[c] = _new;
+                    }
+                }
+            }
+            std::vector<std::size_t> _numbers = std::vector<std::size_t>(_classCount, none);
+            _classCount = 0;
+            for (std::size_t c = 0; c < 256; ++c) {
+                std::size_t& _number = _numbers[_classes[c]];
+                if (_number == none) {
+                    _number = _classCount++;
+                }
+                _classes[c] = _number;
+            }
+            _result.classCount = _classCount;
+            // A byte of each class, to test the edges with.
+            std::vector<unsigned char> _representatives = std::vector<unsigned char>(_classCount);
+            for (std::size_t c = 0; c < 256; ++c) {
+                _result.classes[c] = static_cast<std::uint8_t>(_classes[c]);
+                _representatives[_classes[c]] = static_cast<unsigned char>(c);
+            }
+            // Classes of the bytes of each edge.
+            std::vector<std::vector<std::size_t>> _edgeClasses =
+                std::vector<std::vector<std::size_t>>(_edges.Count());
+            for (std::size_t e = 0; e < _edges.Count(); ++e) {
+                for (std::size_t c = 0; c < _classCount; ++c) {
+                    unsigned char const _byte = _representatives[c];
+                    if ((_edges.words[e * 4 + _byte / 64] >> (_byte % 64)) & 1) {
+                        _edgeClasses[e].push_back(c);
+                    }
+                }
+            }
+
+            // Only the states with an edge or accepting a rule tell the sets of states apart,
+            // so the sets are bitsets of those states only.
+            std::vector<std::size_t> _important = std::vector<std::size_t>(_nfa.size(), none);
+            std::vector<std::size_t> _states;
+            for (std::size_t i = 0; i < _nfa.size(); ++i) {
+                if (_nfa[i].target != none || _nfa[i].rule != none) {
+                    _important[i] = _states.size();
+                    _states.push_back(i);
+                }
+            }
+            std::size_t const _width = (_states.size() + 63) / 64;
+            // States reachable from each state through epsilon edges, itself included.
+            std::vector<std::uint64_t> _closures = std::vector<std::uint64_t>(_nfa.size() * _width);
+            std::vector<std::size_t> _visited = std::vector<std::size_t>(_nfa.size(), none);
+            std::vector<std::size_t> _stack;
+            for (std::size_t i = 0; i < _nfa.size(); ++i) {
+                std::uint64_t* const _closure = _closures.data() + i * _width;
+                _stack.push_back(i);
+                _visited[i] = i;
+                while (!_stack.empty()) {
+                    std::size_t const _state = _stack.back();
+                    _stack.pop_back();
+                    if (std::size_t const _bit = _important[_state]; _bit != none) {
+                        _closure[_bit / 64] |= std::uint64_t(1) << (_bit % 64);
+                    }
+                    for (std::size_t _next : _nfa[_state].epsilons) {
+                        if (_visited[_next] != i) {
+                            _visited[_next] = i;
+                            _stack.push_back(_next);
+                        }
+                    }
+                }
+            }
+
+            // Subset construction, where each state is the set of states of the
+            // nondeterministic automaton it stands for. The dead state is the empty set.
+            Interner _sets = Interner(_width);
+            std::vector<std::uint64_t> _set = std::vector<std::uint64_t>(_width);
+            _sets.Intern(_set.data());
+            _sets.Intern(_closures.data() + _nfaStart * _width);
+            std::vector<std::size_t> _transitions;
+            // Sets reached from the current set through each class.
+            std::vector<std::uint64_t> _next;
+            for (std::size_t i = 0; i < _sets.Count(); ++i) {
+                std::copy_n(_sets.words.data() + i * _width, _width, _set.data());
+                _next.assign(_classCount * _width, 0);
+                for (std::size_t w = 0; w < _width; ++w) {
+                    for (std::uint64_t _bits = _set[w]; _bits != 0; _bits &= _bits - 1) {
+                        std::size_t const _state = _states[w * 64 + std::countr_zero(_bits)];
+                        if (_nfa[_state].target == none) {
+                            continue;
+                        }
+                        std::uint64_t const* const _closure =
+                            _closures.data() + _nfa[_state].target * _width;
+                        for (std::size_t c : _edgeClasses[_edgeOf[_state]]) {
+                            std::uint64_t* const _target = _next.data() + c * _width;
+                            for (std::size_t k = 0; k < _width; ++k) {
+                                _target[k] |= _closure[k];
+                            }
+                        }
+                    }
+                }
+                for (std::size_t c = 0; c < _classCount; ++c) {
+                    _transitions.push_back(_sets.Intern(_next.data() + c * _width));
+                }
+            }
+            // Each state matches the first rule accepted by any of its states.
+            std::size_t const _stateCount = _sets.Count();
+            std::vector<std::uint64_t> _tags;
+            for (std::size_t i = 0; i < _stateCount; ++i) {
+                std::size_t _rule = none;
+                for (std::size_t w = 0; w < _width; ++w) {
+                    for (
+                        std::uint64_t _bits = _sets.words[i * _width + w];
+                        _bits != 0;
+                        _bits &= _bits - 1
+                    ) {
+                        _rule = std::min(
+                            _rule, _nfa[_states[w * 64 + std::countr_zero(_bits)]].rule
+                        );
+                    }
+                }
+                _tags.push_back(_rule == none? 0xFFFF : rules[_rule].tag);
+            }
+
+            // Minimisation, starting with the states split by tag and splitting the blocks
+            // until the states of each block lead to the same blocks. The blocks are numbered
+            // in order of their first state, so the dead state and the start keep their
+            // numbers.
+            std::vector<std::size_t> _blocks = std::vector<std::size_t>(_stateCount);
+            std::size_t _blockCount = 0;
+            {
+                Interner _tagBlocks = Interner(1);
+                for (std::size_t i = 0; i < _stateCount; ++i) {
+                    _blocks[i] = _tagBlocks.Intern(_tags.data() + i);
+                }
+                _blockCount = _tagBlocks.Count();
+            }
+            std::vector<std::uint64_t> _signature = std::vector<std::uint64_t>(_classCount + 1);
+            for (;;) {
+                Interner _signatures = Interner(_classCount + 1);
+                std::vector<std::size_t> _newBlocks = std::vector<std::size_t>(_stateCount);
+                for (std::size_t i = 0; i < _stateCount; ++i) {
+                    _signature[0] = _blocks[i];
+                    for (std::size_t c = 0; c < _classCount; ++c) {
+                        _signature[c + 1] = _blocks[_transitions[i * _classCount + c]];
+                    }
+                    _newBlocks[i] = _signatures.Intern(_signature.data());
+                }
+                bool const _stable = _signatures.Count() == _blockCount;
+                _blocks = std::move(_newBlocks);
+                _blockCount = _signatures.Count();
+                if (_stable) {
+                    break;
+                }
+            }
+            if (_blocks[1] == _blocks[0]) {
+                throw std::logic_error("Lexer grammar matches nothing.");
+            }
+            _result.stateCount = _blockCount;
+            _result.transitions = std::vector<std::size_t>(_blockCount * _classCount);
+            _result.tags = std::vector<std::uint16_t>(_blockCount);
+            for (std::size_t i = 0; i < _stateCount; ++i) {
+                _result.tags[_blocks[i]] = static_cast<std::uint16_t>(_tags[i]);
+                for (std::size_t c = 0; c < _classCount; ++c) {
+                    _result.transitions[_blocks[i] * _classCount + c] =
+                        _blocks[_transitions[i * _classCount + c]];
+                }
+            }
+            return _result;
+        }
+    }
+    // Returns the numbers of states and byte classes of the minimal automaton of the rules.
+    constexpr LexerSizes measureLexer(std::span<LexerRule const> rules) {
+        LexerBuilder::Automaton const _automaton = LexerBuilder::build(rules);
+        return { _automaton.stateCount, _automaton.classCount };
+    }
+    // Generates the minimal automaton of the grammar at compile time, so that a malformed
+    // grammar does not compile. The grammar must be a constant array of rules.
+    template<auto const& grammar> consteval auto generateLexer() {
+        constexpr LexerSizes _sizes = measureLexer(grammar);
+        using Result = Dfa<_sizes.states, _sizes.classes>;
+        LexerBuilder::Automaton const _automaton = LexerBuilder::build(grammar);
+        Result _dfa;
+        _dfa.classes = _automaton.classes;
+        for (std::size_t i = 0; i < _sizes.states; ++i) {
+            std::uint16_t* const _row = _dfa.rows.data() + i * Result::rowSize;
+            for (std::size_t c = 0; c < _sizes.classes; ++c) {
+                _row[c] = static_cast<std::uint16_t>(
+                    _automaton.transitions[i * _sizes.classes + c] * Result::rowSize
+                );
+            }
+            _row[_sizes.classes] = _automaton.tags[i];
+        }
+        return _dfa;
+    }
+}
+#endif
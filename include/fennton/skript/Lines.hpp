@@ -0,0 +1,38 @@
+#ifndef FENNTON_LINES_HPP
+#define FENNTON_LINES_HPP
+
+#include <string_view>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace Fennton::Skript {
+    // Line and column of a position in a source, both starting at 1. Columns count bytes, so 
+    // tabs and multi-byte characters are as wide as their bytes.
+    struct SourceLocation {
+        std::uint32_t line;
+        std::uint32_t column;
+
+        bool operator==(SourceLocation const& other) const = default;
+    };
+    // Offsets at which the lines of a source start, which resolve the byte offsets kept by 
+    // tokens and errors into lines and columns. It is only built when a location is actually 
+    // needed (such as for a diagnostic), so that tokens never need more than their offsets.
+    class LineTable {
+    private:
+        // Offset of the first character of each line, in increasing order, starting with 0.
+        std::vector<std::uint32_t> starts;
+    public:
+        // Builds the table of the source by finding its line breaks (`\n`) with vector scans. 
+        // Sources must be smaller than 4 GiB, as for the tokeniser.
+        LineTable(std::string_view source);
+        // Returns the number of lines, which is one more than the number of line breaks.
+        std::size_t Size() const;
+        // Returns the offset of the first character of the line, starting at 1.
+        std::uint32_t GetLineStart(std::uint32_t line) const;
+        // Returns the line and column of the offset, found by binary search. Offsets after the 
+        // start of the last line are in the last line.
+        SourceLocation Locate(std::size_t offset) const;
+    };
+}
+#endif
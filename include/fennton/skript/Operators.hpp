@@ -0,0 +1,180 @@
+#ifndef FENNTON_OPERATORS_HPP
+#define FENNTON_OPERATORS_HPP
+
+#include <array>
+#include <string_view>
+#include <cstddef>
+#include <cstdint>
+
+namespace Fennton::Skript::Tokeniser {
+    // Operators and other punctuation tokens, which are stored as this enum instead of their
+    // spelling. Named after how they are spelled rather than what they mean, as the meaning
+    // is left to the parser.
+    enum class Operator : std::uint8_t {
+        // `(`, `)`, `[`, `]`, `{` and `}`.
+        LeftParen,
+        RightParen,
+        LeftBracket,
+        RightBracket,
+        LeftBrace,
+        RightBrace,
+        // `,`, `;`, `:`, `.`, `?` and `#`.
+        Comma,
+        Semicolon,
+        Colon,
+        Dot,
+        Question,
+        Hash,
+        // `+`, `-`, `*`, `/`, `%`, `&`, `|`, `^`, `~`, `!`, `<`, `>` and `=`.
+        Plus,
+        Minus,
+        Star,
+        Slash,
+        Percent,
+        Ampersand,
+        Pipe,
+        Caret,
+        Tilde,
+        Exclamation,
+        Less,
+        Greater,
+        Assign,
+        // `==`, `!=`, `<=`, `>=`, `&&`, `||`, `->`, `<<`, `>>`, `++`, `--`, `::` and `..`.
+        Equal,
+        NotEqual,
+        LessEqual,
+        GreaterEqual,
+        LogicalAnd,
+        LogicalOr,
+        Arrow,
+        ShiftLeft,
+        ShiftRight,
+        Increment,
+        Decrement,
+        Scope,
+        Range,
+        // `+=`, `-=`, `*=`, `/=`, `%=`, `&=`, `|=` and `^=`.
+        PlusAssign,
+        MinusAssign,
+        StarAssign,
+        SlashAssign,
+        PercentAssign,
+        AmpersandAssign,
+        PipeAssign,
+        CaretAssign,
+        // `<<=`, `>>=`, `<=>` and `...`.
+        ShiftLeftAssign,
+        ShiftRightAssign,
+        Compare,
+        Ellipsis
+    };
+    // Spelling of each operator, indexed by its value.
+    inline constexpr std::array<std::string_view, 50> operatorSpellings = {
+        "(", ")", "[", "]", "{", "}",
+        ",", ";", ":", ".", "?", "#",
+        "+", "-", "*", "/", "%", "&", "|", "^", "~", "!", "<", ">", "=",
+        "==", "!=", "<=", ">=", "&&", "||", "->", "<<", ">>", "++", "--", "::", "..",
+        "+=", "-=", "*=", "/=", "%=", "&=", "|=", "^=",
+        "<<=", ">>=", "<=>", "..."
+    };
+    // Number of operators.
+    inline constexpr std::size_t operatorCount = operatorSpellings.size();
+    static_assert(static_cast<std::size_t>(Operator::Ellipsis) + 1 == operatorCount);
+
+    // Returns the spelling of the operator.
+    constexpr std::string_view spellingOf(Operator op) {
+        return operatorSpellings[static_cast<std::size_t>(op)];
+    }
+    // Operator found at the start of a text, whose length is zero if there is none.
+    struct OperatorMatch {
+        Operator op;
+        std::uint32_t length;
+    };
+    // Perfect hash table of the operators, generated at compile time. The operators are keyed
+    // by their (at most three) bytes packed into an integer, and the multiplier of the hash
+    // is searched for so that no two operators share a slot, so each lookup is a single probe
+    // and comparison. The lengths of the longest operators starting with each byte let most
+    // single-character operators be found with one lookup, and other bytes with none.
+    class OperatorTable {
+    public:
+        // Number of bits of the slot indices.
+        static constexpr std::uint32_t slotBits = 8;
+    private:
+        struct Slot {
+            std::uint32_t key = 0;
+            // Zero for empty slots.
+            std::uint8_t length = 0;
+            Operator op = {};
+        };
+        std::array<Slot, std::size_t(1) << slotBits> slots = {};
+        std::array<std::uint8_t, 256> maxLengths = {};
+        std::uint32_t multiplier = 0;
+
+        // Returns the key of the first length bytes of the text.
+        static constexpr std::uint32_t keyOf(std::string_view text, std::size_t length) {
+            std::uint32_t _key = 0;
+            for (std::size_t i = 0; i < length; ++i) {
+                _key |= std::uint32_t(static_cast<unsigned char>(text[i])) << (8 * i);
+            }
+            return _key;
+        }
+        constexpr std::size_t slotOf(std::uint32_t key) const {
+            return static_cast<std::uint32_t>(key * multiplier) >> (32 - slotBits);
+        }
+    public:
+        // Generates the table, trying multipliers until one is free of collisions.
+        consteval OperatorTable() {
+            // Odd multipliers only, from a fixed sequence, so that the table is always the same.
+            for (std::uint32_t _candidate = 0x9E3779B1;; _candidate += 2) {
+                multiplier = _candidate;
+                slots = {};
+                bool _collides = false;
+                for (std::size_t i = 0; i < operatorCount && !_collides; ++i) {
+                    std::string_view const _spelling = operatorSpellings[i];
+                    Slot& _slot = slots[slotOf(keyOf(_spelling, _spelling.size()))];
+                    _collides = _slot.length != 0;
+                    _slot = Slot{
+                        keyOf(_spelling, _spelling.size()),
+                        static_cast<std::uint8_t>(_spelling.size()),
+                        static_cast<Operator>(i)
+                    };
+                }
+                if (!_collides) {
+                    break;
+                }
+            }
+            for (std::string_view _spelling : operatorSpellings) {
+                std::uint8_t& _max = maxLengths[static_cast<unsigned char>(_spelling[0])];
+                if (_spelling.size() > _max) {
+                    _max = static_cast<std::uint8_t>(_spelling.size());
+                }
+            }
+        }
+        // Returns true if an operator starts with the character.
+        constexpr bool IsStart(char c) const {
+            return maxLengths[static_cast<unsigned char>(c)] != 0;
+        }
+        // Returns the longest operator at the start of the text (maximal munch), so that `<=`
+        // is never tokenised as `<` followed by `=`.
+        constexpr OperatorMatch Match(std::string_view text) const {
+            if (text.empty()) {
+                return { Operator{}, 0 };
+            }
+            std::size_t _length = maxLengths[static_cast<unsigned char>(text[0])];
+            if (_length > text.size()) {
+                _length = text.size();
+            }
+            for (; _length != 0; --_length) {
+                std::uint32_t const _key = keyOf(text, _length);
+                Slot const& _slot = slots[slotOf(_key)];
+                if (_slot.length == _length && _slot.key == _key) {
+                    return { _slot.op, static_cast<std::uint32_t>(_length) };
+                }
+            }
+            return { Operator{}, 0 };
+        }
+    };
+    // The table of all the operators.
+    inline constexpr OperatorTable operatorTable = OperatorTable();
+}
+#endif
@@ -1,10 +1,24 @@
-#include <deque>
+#ifndef FENNTON_PARSER_HPP
+#define FENNTON_PARSER_HPP
+
+#include <fennton/utils/Memory.hpp>
+#include <fennton/utils/Text.hpp>
+#include <fennton/skript/Symbols.hpp>
+#include <fennton/skript/CharClass.hpp>
+#include <fennton/skript/Operators.hpp>
+#include <fennton/skript/Lines.hpp>
 #include <vector>
 #include <string>
+#include <string_view>
+#include <algorithm>
 #include <optional>
 #include <variant>
 #include <memory>
+#include <mutex>
+#include <span>
+#include <iterator>
 #include <stdexcept>
+#include <limits>
 #include <cstdint>
 
 namespace Fennton::Skript {
@@ -22,8 +36,28 @@ namespace Fennton::Skript {
         };
  
         class Exception : public std::runtime_error {
+        public:
+            // Offset of errors whose position is unknown.
+            static constexpr std::size_t noOffset = std::numeric_limits<std::size_t>::max();
+        private:
+            // Character where the error is, kept until a function which knows the source 
+            // (such as tokenise) resolves it into an offset, as the functions working on 
+            // iterators do not know where the source starts.
+            char const* position = nullptr;
+            std::size_t offset = noOffset;
         public:
             using std::runtime_error::runtime_error;
+            // Constructs the exception of an error at the character pointed to by position.
+            Exception(std::string const& message, char const* position);
+            // Constructs the exception of an error whose offset in the source is already 
+            // known, such as one found in a syntax tree.
+            Exception(std::string const& message, std::size_t offset);
+            // Returns the byte offset of the error in the source, or noOffset if it is unknown, 
+            // such as for errors thrown by consumeSpace or tokeniseNext directly.
+            std::size_t GetOffset() const;
+            // Resolves the error's position into an offset in the source, if it is inside it 
+            // (or at its end).
+            void Locate(std::string_view source);
         };
         class NotImplementedException : public Exception {
         public:
@@ -32,53 +66,175 @@ namespace Fennton::Skript {
 
         class Name {
         private:
-            std::string spelling;
+            // Symbol of the spelling in the global symbol table.
+            Symbol symbol;
         public:
+            // Constructs the name with the empty spelling.
+            Name() = default;
+            // Constructs the name of a symbol of the global symbol table.
+            Name(Symbol symbol);
+            // Constructs the name by interning the spelling in the global symbol table.
+            Name(std::string_view spelling);
+            // Compares the symbols, so it never compares the spellings.
             bool operator==(Name const& other) const;
             bool operator!=(Name const& other) const;
             // Returns the token's spelling, not exactly equal to how it was spelled in the 
             // source, but which generates the same token if retokenised.
             std::string GetSpelling() const;
+            // Returns the size of the token's spelling.
+            std::size_t GetSpellingSize() const;
+            // Writes the token's spelling to the output iterator without allocating, and 
+            // returns the iterator after it.
+            template<typename OutputIt> OutputIt AppendSpelling(OutputIt out) const {
+                std::string_view _spelling = globalSymbols().GetSpelling(symbol);
+                return std::copy(_spelling.begin(), _spelling.end(), out);
+            }
+            // Appends the token's spelling to the string, growing it at most once.
+            void SpellInto(std::string& out) const;
+            Symbol GetSymbol() const;
+        };
+        // How the value of a number is stored.
+        enum class ValueKind : std::uint8_t {
+            // Number with more than two parts (such as a version), which has no single value.
+            None,
+            // Integer which fits in 64 bits.
+            Integer,
+            // Integer too large for 64 bits.
+            BigInteger,
+            // Number with two parts (an integer and a fractional part).
+            Float
+        };
+        // Type requested by the first suffix of a number, if it is `u` (unsigned integer), `i` 
+        // (signed integer) or `f` (floating point, only 16, 32 or 64) followed by a bit count, 
+        // such as in `255u8`, `1i32` or `0.5f32`.
+        enum class SuffixType : std::uint8_t {
+            None,
+            Unsigned,
+            Signed,
+            Float
         };
+        // Decoded value of a number literal.
+        class NumberValue {
+        private:
+            ValueKind kind = ValueKind::None;
+            SuffixType suffixType = SuffixType::None;
+            std::uint16_t suffixBits = 0;
+            bool fits = true;
+            std::uint64_t integer = 0;
+            double real = 0.0;
+            // Magnitude of a big integer, as 32-bit limbs from the least significant.
+            std::vector<std::uint32_t> limbs;
+
+            // Sets the suffix's type and whether the value fits in it.
+            void setSuffix(SuffixType suffixType, std::uint16_t suffixBits);
+        public:
+            // Constructs the value of a number without a single value.
+            NumberValue(SuffixType suffixType = SuffixType::None, std::uint16_t suffixBits = 0);
+            NumberValue(
+                std::uint64_t integer,
+                SuffixType suffixType = SuffixType::None,
+                std::uint16_t suffixBits = 0
+            );
+            // Constructs the value of a big integer from its limbs, starting with the least 
+            // significant. It is stored as an integer if it fits in 64 bits.
+            NumberValue(
+                std::vector<std::uint32_t>&& limbs,
+                SuffixType suffixType = SuffixType::None,
+                std::uint16_t suffixBits = 0
+            );
+            NumberValue(
+                double real,
+                SuffixType suffixType = SuffixType::None,
+                std::uint16_t suffixBits = 0
+            );
+            bool operator==(NumberValue const& other) const = default;
+            ValueKind GetKind() const;
+            SuffixType GetSuffixType() const;
+            std::uint16_t GetSuffixBits() const;
+            // Returns false if the suffix requests a type which cannot hold the value, such as 
+            // `256u8`, `1.5u8` or `1.0.0i32`. Literals are never negative, so `128i8` does not 
+            // fit either.
+            bool Fits() const;
+            // Returns the value of an integer.
+            std::uint64_t GetInteger() const;
+            // Returns the value of a float, correctly rounded, or infinity if it is too large.
+            double GetFloat() const;
+            // Returns the limbs of a big integer, starting with the least significant.
+            std::span<std::uint32_t const> GetLimbs() const;
+        };
+        // Returns the prefix which the numbers of the base are spelled with (`0b`, `0`, none or 
+        // `0x`), throwing if the base is unsupported.
+        std::string_view basePrefix(std::int32_t base);
         class Number {
         private:
-            // Contiguous string containing the number's parts and suffixes.
-            std::unique_ptr<std::string> storage;
-            // Vector instead of list because it allows random indexing and it is going 
-            // to handle the memory allocations and deallocations.
-            std::vector<std::string_view> parts;
-            // The number's suffixes.
-            std::vector<std::string_view> suffixes;
+            // Size of the buffer inside the token, which holds the text of most numbers, so 
+            // that only huge literals allocate.
+            static constexpr std::size_t inlineCapacity = 24;
+
+            // The parts separated by radixes (`.`), followed by the suffixes separated by `'`, 
+            // without the base prefix or the `.'` of base-16. The separators are enough to 
+            // find the boundaries, as parts are digits and suffixes are name characters. 
+            // Stored in the inline buffer if it fits, or else on the heap.
+            union {
+                char inlineText[inlineCapacity];
+                char* heapText;
+            };
+            std::uint32_t textSize = 0;
+            // Size of the parts and their radixes, where the suffixes start.
+            std::uint32_t partsSize = 0;
+            std::uint32_t partCount = 0;
+            std::uint32_t suffixCount = 0;
             // The number's base.
-            std::int32_t base;
-            // Moves the fields from the other object into this.
-            void moveFrom(Number&& other);
+            std::int32_t base = 10;
+            // The number's decoded value.
+            NumberValue value;
+
+            // Allocates the text's buffer (inline if it fits) and returns it.
+            char* allocateText(std::size_t size);
+            // Returns the text's buffer.
+            char const* getText() const;
+            // Returns the element at the index of the text, whose elements are separated by 
+            // the separator.
+            static std::string_view getElement(
+                std::string_view text,
+                char separator,
+                std::size_t index
+            );
         public:
-            Number(Number const&) = delete;
-            // Move constructor. The other object is left in an invalid state.
-            Number(Number&& other);
-            // Constructor with explicit storage.
+            // Constructor with an already decoded value, from the parts and suffixes joined 
+            // by their separators (as in the source, without the `.'` of base-16). Uppercase 
+            // hexadecimal digits are converted to lowercase if lowercase is true.
             Number(
-                std::unique_ptr<std::string>&& storage,
-                std::vector<std::string_view>&& parts,
-                std::vector<std::string_view>&& suffixes,
-                std::int32_t base
+                std::string_view parts,
+                std::size_t partCount,
+                std::string_view suffixes,
+                std::size_t suffixCount,
+                std::int32_t base,
+                bool lowercase,
+                NumberValue&& value
             );
-            // Construtor with the storage string built automatically.
+            // Constructor from the separate parts and suffixes, which are copied.
             Number(
                 std::vector<std::string_view> const& parts,
                 std::vector<std::string_view> const& suffixes,
                 std::int32_t base
             );
+            Number(Number const&) = delete;
+            // Move constructor, which never allocates. The other object is left empty.
+            Number(Number&& other) noexcept;
+            ~Number();
             Number& operator=(Number const&) = delete;
-            // Move assignment operator. The other object is left in an invalid state.
-            Number& operator=(Number&& other);
+            // Move assignment operator, which never allocates. The other object is left empty.
+            Number& operator=(Number&& other) noexcept;
             bool operator==(Number const& other) const;
             bool operator!=(Number const& other) const;
             // Parses the largest base-2 number token in the range [start, end), throwing if 
             // unexpected characters or character sequences are present before the number's 
             // end. Returns a pair containing the iterator after the number's end and 
-            // the number token.
+            // the number token. The start iterator must point to the first digit, after any 
+            // base prefix. A number is made of parts separated by radixes (`.`), optionally 
+            // followed by a list of suffixes separated by `'`, such as `1.5u8'a` (in base-16, 
+            // the list must be preceded by `.'`, as in `0xff.'u8`).
             static TokenResult parseBase2(
                 std::string_view::const_iterator start,
                 std::string_view::const_iterator end
@@ -101,44 +257,133 @@ namespace Fennton::Skript {
             // Returns the token's spelling, not exactly equal to how it was spelled in the 
             // source, but which generates the same token if retokenised.
             std::string GetSpelling() const;
-            std::vector<std::string_view> const& GetParts() const;
-            std::vector<std::string_view> const& GetSuffixes() const;
+            // Returns the size of the token's spelling.
+            std::size_t GetSpellingSize() const;
+            // Writes the token's spelling to the output iterator without allocating, and 
+            // returns the iterator after it.
+            template<typename OutputIt> OutputIt AppendSpelling(OutputIt out) const {
+                std::string_view _prefix = basePrefix(base);
+                out = std::copy(_prefix.begin(), _prefix.end(), out);
+                // The parts are stored with their radixes.
+                char const* _text = getText();
+                out = std::copy(_text, _text + partsSize, out);
+                // Base-16 includes letters, so an unambiguous separator is necessary before 
+                // the suffix list.
+                if (base == 16 && suffixCount != 0) {
+                    *out++ = '.';
+                    *out++ = '\'';
+                }
+                return std::copy(_text + partsSize, _text + textSize, out);
+            }
+            // Appends the token's spelling to the string, growing it at most once.
+            void SpellInto(std::string& out) const;
+            std::size_t GetPartCount() const;
+            // Returns the part at the index, which views the token's buffer.
+            std::string_view GetPart(std::size_t index) const;
+            std::size_t GetSuffixCount() const;
+            // Returns the suffix at the index, which views the token's buffer.
+            std::string_view GetSuffix(std::size_t index) const;
             std::int32_t GetBase() const;
+            NumberValue const& GetValue() const;
         };
+        // Returns the size of the string literal of the value, with the escape sequences of 
+        // Text::escape.
+        std::size_t quotedSize(std::string_view value);
+        // Writes the string literal of the value, with the escape sequences of Text::escape, 
+        // to the output iterator without allocating, and returns the iterator after it.
+        template<typename OutputIt> OutputIt appendQuoted(std::string_view value, OutputIt out) {
+            *out++ = '"';
+            for (char c : value) {
+                // Checked through the class first, as most characters are not escaped.
+                if (hasClass(c, CharClass::Escaped)) {
+                    *out++ = '\\';
+                    *out++ = Text::escapeSimpleChar(c);
+                } else {
+                    *out++ = c;
+                }
+            }
+            *out++ = '"';
+            return out;
+        }
         class String {
+        private:
+            // The string's value, with its escape sequences decoded.
+            std::string value;
         public:
+            // Constructs the empty string.
+            String() = default;
+            // Constructs the string of the value, whose escape sequences are already decoded.
+            String(std::string_view value);
             bool operator==(String const& other) const;
             bool operator!=(String const& other) const;
+            // Parses the string literal starting at start, which must be a double quote, 
+            // throwing if it has no closing quote or an invalid escape sequence. The escape 
+            // sequences are the ones produced by Text::escape: a backslash followed by one of 
+            // \\'"?abfnrtv or an octal digit from 0 to 6. Returns a pair containing the 
+            // iterator after the closing quote and the string token.
+            static TokenResult parse(
+                std::string_view::const_iterator start,
+                std::string_view::const_iterator end
+            );
             // Returns the token's spelling, not exactly equal to how it was spelled in the 
             // source, but which generates the same token if retokenised.
             std::string GetSpelling() const;
+            // Returns the size of the token's spelling.
+            std::size_t GetSpellingSize() const;
+            // Writes the token's spelling to the output iterator without allocating, and 
+            // returns the iterator after it.
+            template<typename OutputIt> OutputIt AppendSpelling(OutputIt out) const {
+                return appendQuoted(value, out);
+            }
+            // Appends the token's spelling to the string, growing it at most once.
+            void SpellInto(std::string& out) const;
+            std::string_view GetValue() const;
         };
         class Punct {
+        private:
+            Operator op = Operator::LeftParen;
         public:
+            // Constructs the `(` operator.
+            Punct() = default;
+            Punct(Operator op);
             bool operator==(Punct const& other) const;
             bool operator!=(Punct const& other) const;
-            // Returns the token's spelling, not exactly equal to how it was spelled in the 
-            // source, but which generates the same token if retokenised.
+            // Parses the longest operator starting at start (maximal munch), throwing if there 
+            // is none. Returns a pair containing the iterator after the operator and the 
+            // punctuation token.
+            static TokenResult parse(
+                std::string_view::const_iterator start,
+                std::string_view::const_iterator end
+            );
+            // Returns the token's spelling, which is exactly the operator's.
             std::string GetSpelling() const;
+            // Returns the size of the token's spelling.
+            std::size_t GetSpellingSize() const;
+            // Writes the token's spelling to the output iterator without allocating, and 
+            // returns the iterator after it.
+            template<typename OutputIt> OutputIt AppendSpelling(OutputIt out) const {
+                std::string_view const _spelling = spellingOf(op);
+                return std::copy(_spelling.begin(), _spelling.end(), out);
+            }
+            // Appends the token's spelling to the string.
+            void SpellInto(std::string& out) const;
+            Operator GetOperator() const;
         };
         class Token {
         public:
             using VariantType = std::variant<Name, Number, String, Punct>;
         private:
             VariantType var;
-            bool hasSpaceAfter;
-
-            // Moves the fields from another Token object into this.
-            void moveFrom(Token&&);
+            bool hasSpaceAfter = false;
         public:
             // static constexpr std::int32_t spaceAfterBit = 0;
 
             Token() = default;
             Token(Token const&) = delete;
-            Token(Token&&);
+            Token(Token&&) noexcept = default;
             Token(VariantType&& innerVal, bool hasSpaceAfter);
             Token& operator=(Token const& other) = delete;
-            Token& operator=(Token&& other);
+            Token& operator=(Token&& other) noexcept = default;
             // Compares two tokens for equality.
             bool operator==(Token const& other) const;
             // Compares two tokens for inequality.
@@ -146,12 +391,367 @@ namespace Fennton::Skript {
             // Returns the token's spelling, not exactly equal to how it was spelled in the 
             // source, but which generates the same token if retokenised.
             std::string GetSpelling() const;
+            // Returns the size of the token's spelling, including the space after it.
+            std::size_t GetSpellingSize() const;
+            // Writes the token's spelling to the output iterator without allocating, and 
+            // returns the iterator after it.
+            template<typename OutputIt> OutputIt AppendSpelling(OutputIt out) const {
+                out = std::visit([&](auto const& arg) { return arg.AppendSpelling(out); }, var);
+                if (hasSpaceAfter) {
+                    *out++ = ' ';
+                }
+                return out;
+            }
+            // Appends the token's spelling to the string, growing it at most once.
+            void SpellInto(std::string& out) const;
             // Returns true if there is a space between this token and the next and false if 
             // there is either no space or no token.
             bool HasSpaceAfter() const;
             // Sets the value of the hasSpaceAfter field.
             void HasSpaceAfter(bool hasSpaceAfter);
         };
+        // The kind of a token, in the same order as the alternatives of Token::VariantType,
+        // followed by the kinds without an owning token.
+        enum class Kind : std::uint8_t {
+            Name,
+            Number,
+            String,
+            Punct,
+            // Characters which could not be tokenised, only emitted when the errors are 
+            // collected as diagnostics. It has no owning token.
+            Error
+        };
+        // Range of characters in the source, from the offset of its first character.
+        struct Span {
+            std::uint32_t offset;
+            std::uint32_t length;
+
+            bool operator==(Span const& other) const = default;
+        };
+        // Kind of error found while tokenising, which also identifies its message.
+        enum class ErrorCode : std::uint8_t {
+            // Character which cannot start a token.
+            UnexpectedCharacter,
+            // Digit of a larger base, or letter directly after a number's digits.
+            InvalidDigit,
+            // Base prefix or radix not followed by a digit.
+            ExpectedDigit,
+            // Suffix separator not followed by a suffix.
+            ExpectedSuffix,
+            // Suffix of a base-16 number not preceded by `.'`.
+            UnseparatedSuffix,
+            // Multi-line comment without its `*/`.
+            UnterminatedComment,
+            // String literal without its closing quote.
+            UnterminatedString,
+            // Backslash followed by a character which has no escape sequence.
+            InvalidEscape,
+            // Bytes which are not a valid UTF-8 sequence.
+            InvalidUtf8
+        };
+        // Error collected while tokenising, instead of being thrown.
+        struct Diagnostic {
+            ErrorCode code;
+            // Characters at fault, such as an invalid digit or the opening of an unterminated 
+            // comment. Missing characters are reported as an empty range where they are 
+            // expected.
+            std::uint32_t offset;
+            std::uint32_t length;
+
+            bool operator==(Diagnostic const& other) const = default;
+        };
+        // Returns the message of the error code, which does not depend on the source.
+        std::string_view errorMessage(ErrorCode code);
+        // Payload of a number token in a stream.
+        struct NumberPayload {
+            // Set if the token's spelling is not the same as its source text, because it has 
+            // uppercase hexadecimal digits.
+            static constexpr std::uint8_t uppercaseFlag = 1 << 0;
+
+            // Offset of the number's first digit from the start of the token, after the base 
+            // prefix.
+            std::uint8_t bodyOffset;
+            std::uint8_t base;
+            std::uint8_t flags;
+            ValueKind valueKind;
+            SuffixType suffixType;
+            std::uint16_t suffixBits;
+            // The integer's value, the bits of the float's value, or the offset (lower half) 
+            // and count (upper half) of a big integer's limbs in the stream's limb table. The 
+            // limbs are stored in the order of the tokens, so equal streams have equal values.
+            std::uint64_t value;
+
+            bool operator==(NumberPayload const& other) const = default;
+        };
+        class TokenStream;
+        class TokenCache;
+        // Lightweight view of a token in a stream, which only builds the owning token when 
+        // asked to.
+        class TokenView {
+        private:
+            TokenStream const* stream;
+            std::size_t index;
+        public:
+            TokenView(TokenStream const& stream, std::size_t index);
+            // Compares the token with an owning token for equality.
+            bool operator==(Token const& other) const;
+            // Compares the token with an owning token for inequality.
+            bool operator!=(Token const& other) const;
+            std::size_t GetIndex() const;
+            Kind GetKind() const;
+            Span GetSpan() const;
+            // Returns the line and column where the token starts.
+            SourceLocation GetLocation() const;
+            // Returns the source text of the token.
+            std::string_view GetText() const;
+            // Returns true if there is a space between this token and the next and false if 
+            // there is either no space or no token.
+            bool HasSpaceAfter() const;
+            // Builds the owning token equivalent to this one.
+            Token MakeToken() const;
+            // Returns the token's spelling, not exactly equal to how it was spelled in the 
+            // source, but which generates the same token if retokenised. It is the owning 
+            // token's spelling, but built from the source without building the token.
+            std::string GetSpelling() const;
+            // Returns the size of the token's spelling, including the space after it.
+            std::size_t GetSpellingSize() const;
+            // Writes the token's spelling to the output iterator without allocating, and 
+            // returns the iterator after it.
+            template<typename OutputIt> OutputIt AppendSpelling(OutputIt out) const;
+            // Appends the token's spelling to the string, growing it at most once.
+            void SpellInto(std::string& out) const;
+        };
+        // Window of consecutive tokens of a stream, used to look ahead of a position. It is 
+        // clamped to the end of the stream, so it can be smaller than requested.
+        class TokenWindow {
+        private:
+            TokenStream const* stream;
+            std::size_t first;
+            std::size_t count;
+        public:
+            TokenWindow(TokenStream const& stream, std::size_t first, std::size_t count);
+            std::size_t Size() const;
+            // Returns the view of the token at the index relative to the window's start.
+            TokenView operator[](std::size_t index) const;
+            // Returns the kinds of the tokens in the window, for matching patterns of tokens.
+            std::span<Kind const> GetKinds() const;
+        };
+        // Tokens stored as separate tightly packed arrays (structure of arrays) of kinds, 
+        // source spans, hasSpaceAfter bits and payload indices, all referring to a 
+        // reference-counted and immutable copy of the source. No token needs its own 
+        // allocation and loops over a single property only touch the memory they need.
+        class TokenStream {
+        public:
+            // Payload index of tokens without a payload.
+            static constexpr std::uint32_t noPayload = 0xFFFFFFFF;
+
+            // Random-access iterator over the views of the tokens.
+            class Iterator {
+            public:
+                using iterator_category = std::random_access_iterator_tag;
+                using value_type = TokenView;
+                using difference_type = std::ptrdiff_t;
+                using reference = TokenView;
+                // Holds a view, so that the -> operator can point to it.
+                struct pointer {
+                    TokenView view;
+                    TokenView const* operator->() const { return &view; }
+                };
+            private:
+                TokenStream const* stream = nullptr;
+                std::size_t index = 0;
+            public:
+                Iterator() = default;
+                Iterator(TokenStream const& stream, std::size_t index);
+                TokenView operator*() const;
+                pointer operator->() const;
+                TokenView operator[](difference_type offset) const;
+                Iterator& operator++();
+                Iterator operator++(int);
+                Iterator& operator--();
+                Iterator operator--(int);
+                Iterator& operator+=(difference_type offset);
+                Iterator& operator-=(difference_type offset);
+                Iterator operator+(difference_type offset) const;
+                friend Iterator operator+(difference_type offset, Iterator const& it) {
+                    return it + offset;
+                }
+                Iterator operator-(difference_type offset) const;
+                difference_type operator-(Iterator const& other) const;
+                bool operator==(Iterator const& other) const;
+                auto operator<=>(Iterator const& other) const { return index <=> other.index; }
+            };
+        private:
+            Memory::Strong<std::string const> source;
+            std::vector<Kind> kinds;
+            std::vector<Span> spans;
+            // One bit per token, set if there is a space after it.
+            std::vector<std::uint64_t> spaceAfterBits;
+            // Index of each token's payload in the table for its kind, the id of the symbol 
+            // for names, or the operator for punctuation.
+            std::vector<std::uint32_t> payloads;
+            // Payload table for the number tokens.
+            std::vector<NumberPayload> numbers;
+            // Limbs of the big integers of the number tokens.
+            std::vector<std::uint32_t> limbs;
+            // Payload table for the string tokens with escape sequences: the span of each 
+            // one's decoded value in the arena. Strings without escape sequences have no 
+            // payload, as their value is viewed directly in the source.
+            std::vector<Span> strings;
+            // Decoded values of the strings with escape sequences, one after the other.
+            std::string stringArena;
+            // Line table of the source, built the first time a location is needed, with the 
+            // flag which guards its construction.
+            struct LazyLines {
+                std::once_flag built;
+                std::optional<LineTable> table;
+            };
+            // Allocated with the stream and shared by its copies, so that the handle itself is 
+            // never written after construction.
+            Memory::Strong<LazyLines> lines;
+
+            // Reads and writes the arrays directly.
+            friend class TokenCache;
+        public:
+            // Constructs an empty stream referring to the source.
+            TokenStream(Memory::Strong<std::string const> source);
+            // Compares two streams for equality, which requires the same tokens with the same 
+            // spans and payloads over the same source text.
+            bool operator==(TokenStream const& other) const;
+            // Compares two streams for inequality.
+            bool operator!=(TokenStream const& other) const;
+            // Returns the source text the tokens refer to.
+            std::string_view GetSource() const;
+            // Returns the buffer holding the source, which can be shared with other streams.
+            Memory::Strong<std::string const> const& GetSourceBuffer() const;
+            // Returns the number of tokens.
+            std::size_t Size() const;
+            bool Empty() const;
+            TokenView operator[](std::size_t index) const;
+            Iterator begin() const;
+            Iterator end() const;
+            // Returns the window of at most count tokens starting at the index.
+            TokenWindow Window(std::size_t index, std::size_t count) const;
+            Kind GetKind(std::size_t index) const;
+            Span GetSpan(std::size_t index) const;
+            // Returns true if there is a space between the token at the index and the next 
+            // and false if there is either no space or no token.
+            bool HasSpaceAfter(std::size_t index) const;
+            // Returns the index of the token's payload in the table for its kind, the id of 
+            // its symbol if it is a name, its operator if it is punctuation, or noPayload.
+            std::uint32_t GetPayload(std::size_t index) const;
+            // Returns the source text of the token at the index.
+            std::string_view GetText(std::size_t index) const;
+            // Returns the payload of the number token at the index.
+            NumberPayload const& GetNumber(std::size_t index) const;
+            // Returns the decoded value of the number token at the index.
+            NumberValue GetValue(std::size_t index) const;
+            // Returns the symbol of the name token at the index, in the global symbol table.
+            Symbol GetName(std::size_t index) const;
+            // Returns the value of the string token at the index, which views either the 
+            // source or the stream's arena of decoded strings.
+            std::string_view GetString(std::size_t index) const;
+            // Returns the operator of the punctuation token at the index.
+            Operator GetOperator(std::size_t index) const;
+            std::span<Kind const> GetKinds() const;
+            std::span<Span const> GetSpans() const;
+            // Builds the owning token equivalent to the token at the index. Throws for error 
+            // tokens, which have no owning token.
+            Token MakeToken(std::size_t index) const;
+            // Returns the line table of the source, building it with vector scans on the first 
+            // call (which can safely happen on several threads at once).
+            LineTable const& GetLines() const;
+            // Returns the line and column of the offset in the source.
+            SourceLocation Locate(std::size_t offset) const;
+            // Returns the line and column where the token at the index starts.
+            SourceLocation GetLocation(std::size_t index) const;
+            // Returns the size of the spelling of the token at the index, including the space 
+            // after it.
+            std::size_t GetSpellingSize(std::size_t index) const;
+            // Writes the spelling of the token at the index to the output iterator without 
+            // allocating, and returns the iterator after it.
+            template<typename OutputIt> OutputIt AppendSpelling(
+                std::size_t index,
+                OutputIt out
+            ) const;
+            // Returns the exact size of the stream's spelling.
+            std::size_t GetSpellingSize() const;
+            // Returns the spelling of all the tokens, each followed by a space if it has one 
+            // after it, which generates the same tokens if retokenised. Used to regenerate 
+            // minified and canonical scripts.
+            std::string GetSpelling() const;
+            // Appends the stream's spelling to the string, growing it at most once.
+            void SpellInto(std::string& out) const;
+            // Appends a token without a payload.
+            void Append(Kind kind, Span span);
+            // Appends a number token and its payload. For big integers, the payload's value is 
+            // set to the limbs appended to the limb table.
+            void AppendNumber(
+                Span span,
+                NumberPayload const& number,
+                std::span<std::uint32_t const> bigLimbs = {}
+            );
+            // Appends a name token and its symbol.
+            void AppendName(Span span, Symbol symbol);
+            // Appends a string token, whose span must include its quotes. Its value is only 
+            // decoded (into the arena) if it has escape sequences, which must be valid.
+            void AppendString(Span span, bool hasEscapes);
+            // Appends a punctuation token and its operator.
+            void AppendPunct(Span span, Operator op);
+            // Sets whether there is a space after the token at the index.
+            void HasSpaceAfter(std::size_t index, bool hasSpaceAfter);
+            // Appends count tokens of the other stream, starting at the index first, together 
+            // with their payloads. The spans are moved by offsetDelta characters, and must then 
+            // be valid in this stream's source.
+            void AppendRange(
+                TokenStream const& other,
+                std::size_t first,
+                std::size_t count,
+                std::int64_t offsetDelta = 0
+            );
+            // Reserves space for the specified number of tokens, and for their payloads as if 
+            // they were all numbers.
+            void Reserve(std::size_t tokenCount);
+            // Reserves space for the tokens and payloads of the other stream, and for the extra 
+            // tokens with their payloads as if they were all numbers.
+            void Reserve(TokenStream const& other, std::size_t extraTokenCount);
+        };
+        template<typename OutputIt> OutputIt TokenView::AppendSpelling(OutputIt out) const {
+            return stream->AppendSpelling(index, out);
+        }
+        template<typename OutputIt> OutputIt TokenStream::AppendSpelling(
+            std::size_t index,
+            OutputIt out
+        ) const {
+            std::string_view _text = GetText(index);
+            if (GetKind(index) == Kind::String) {
+                // Strings are spelled with the canonical escape sequences.
+                _text = std::string_view();
+                out = appendQuoted(GetString(index), out);
+            } else if (GetKind(index) == Kind::Number) {
+                NumberPayload const& _number = GetNumber(index);
+                // Numbers are spelled with the base's own prefix, as `0o10` is spelled `010`.
+                std::string_view _prefix = basePrefix(_number.base);
+                out = std::copy(_prefix.begin(), _prefix.end(), out);
+                _text.remove_prefix(_number.bodyOffset);
+                if (_number.flags & NumberPayload::uppercaseFlag) {
+                    // Hexadecimal digits are spelled in lowercase, but the suffixes (after 
+                    // `.'`) are not digits, so they are never converted.
+                    std::size_t _digitCount = std::min(_text.find(".'"), _text.size());
+                    out = std::transform(
+                        _text.begin(), _text.begin() + _digitCount, out, [](char c) {
+                            return c >= 'A' && c <= 'F'? static_cast<char>(c - 'A' + 'a') : c;
+                        }
+                    );
+                    _text.remove_prefix(_digitCount);
+                }
+            }
+            out = std::copy(_text.begin(), _text.end(), out);
+            if (HasSpaceAfter(index)) {
+                *out++ = ' ';
+            }
+            return out;
+        }
         // Returns true if the character is in the !"#$%&'()*+,-./:;<=>?@[\]^`{|}~ set (the set 
         // of punctuation defined by the classic C locale, minus the `_` character), else returns 
         // false.
@@ -175,7 +775,16 @@ namespace Fennton::Skript {
         // Returns true if the character is a control character (the set include some 
         // character classified as whitespace), else returns false.
         bool isControl(char c);
-        // Consumes whitespace, single-line comments and multi-line comments.
+        // Returns true if the character can start a name (in the [A-Za-z_] set), else returns 
+        // false. Names can also contain characters outside ASCII, which are classified by
+        // isXidStart and isXidContinue.
+        bool isNameStart(char c);
+        // Returns true if the character can continue a name (in the [A-Za-z0-9_] set), else 
+        // returns false.
+        bool isNameContinue(char c);
+        // Consumes whitespace, single-line comments (from `//` to the end of the line) and 
+        // multi-line comments (from `/*` to the first `*/`, not nested), throwing if a 
+        // multi-line comment is not terminated. Comments separate tokens like whitespace.
         std::string_view::const_iterator consumeSpace(
             std::string_view::const_iterator start,
             std::string_view::const_iterator end
@@ -185,8 +794,60 @@ namespace Fennton::Skript {
             std::string_view::const_iterator start,
             std::string_view::const_iterator end
         );
-        // Tokenises the string into a deque and returns it. The tokens do not depend on the original string, 
-        // so it is free to deallocate it.
-        std::deque<Tokeniser::Token> tokenise(std::string_view str);
+        // Tokenises the string into a stream and returns it. The tokens refer to a shared copy 
+        // of the string, which is kept alive by the stream, so they do not depend on the 
+        // original string and it is free to deallocate it. Sources must be smaller than 4 GiB, 
+        // as the spans use 32-bit offsets, and be valid UTF-8, which is checked before
+        // tokenising them.
+        TokenStream tokenise(std::string_view str);
+        // Same as the overload taking a string_view, but shares the already existing buffer 
+        // instead of copying it.
+        TokenStream tokenise(Memory::Strong<std::string const> source);
+        // Same as tokenise, but never throws for errors in the source. Each error is appended 
+        // to the diagnostics instead, together with an error token covering the malformed 
+        // token (or the run of unexpected characters), and the tokenisation resumes at the 
+        // next character which can start a token. Sources with many errors are thus about as 
+        // fast to tokenise as clean ones. Invalid UTF-8 is found before tokenising, so each of
+        // its sequences is reported first and without an error token; outside of strings and
+        // comments, they are then reported again as unexpected characters.
+        TokenStream tokenise(std::string_view str, std::vector<Diagnostic>& diagnostics);
+        // Same as the overload taking a string_view, but shares the already existing buffer 
+        // instead of copying it.
+        TokenStream tokenise(
+            Memory::Strong<std::string const> source,
+            std::vector<Diagnostic>& diagnostics
+        );
+        // Returns the stream of the previous stream's source with the length characters 
+        // starting at offset replaced by the replacement. Only the region affected by the edit 
+        // is retokenised: from just before the edit until a token starts at the same place 
+        // (relative to the end of the source) as one of the previous stream's tokens, from 
+        // which point the previous tokens are reused with their spans moved. The result is 
+        // identical to tokenising the edited source from scratch. Only the replacement (and
+        // the characters it splits) is validated as UTF-8, as the rest of the source was
+        // validated by the previous tokenisation.
+        TokenStream retokenise(
+            TokenStream const& previous,
+            std::size_t offset,
+            std::size_t length,
+            std::string_view replacement
+        );
+        // Same as tokenise, but splits the source into chunks at line breaks which are not 
+        // inside strings or comments (found by a fast pre-scan), tokenises the chunks on 
+        // threadCount threads (the hardware's concurrency if zero) and stitches the results, 
+        // which are identical to tokenise's. Sources smaller than minChunkSize bytes are 
+        // tokenised on the calling thread, as splitting them is not worth it.
+        TokenStream tokeniseParallel(
+            std::string_view str,
+            std::size_t threadCount = 0,
+            std::size_t minChunkSize = 1 << 20
+        );
+        // Same as the overload taking a string_view, but shares the already existing buffer 
+        // instead of copying it.
+        TokenStream tokeniseParallel(
+            Memory::Strong<std::string const> source,
+            std::size_t threadCount = 0,
+            std::size_t minChunkSize = 1 << 20
+        );
     };
-}
\ No newline at end of file
+}
+#endif
@@ -0,0 +1,327 @@
+#ifndef FENNTON_STATIC_HPP
+#define FENNTON_STATIC_HPP
+
+#include <fennton/skript/Parser.hpp>
+#include <fennton/skript/CharClass.hpp>
+#include <fennton/skript/Operators.hpp>
+#include <fennton/skript/Unicode.hpp>
+#include <array>
+#include <span>
+#include <string_view>
+#include <cstddef>
+#include <cstdint>
+
+namespace Fennton::Skript::Tokeniser {
+    // String literal passed as a template argument, so that it can be tokenised at compile
+    // time. Its size includes the literal's null terminator.
+    template<std::size_t N> struct StaticSource {
+        char text[N] = {};
+
+        consteval StaticSource(char const (&literal)[N]) {
+            for (std::size_t i = 0; i < N; ++i) {
+                text[i] = literal[i];
+            }
+        }
+        // Returns the literal without its null terminator.
+        constexpr std::string_view View() const {
+            return std::string_view(text, N - 1);
+        }
+    };
+    // Token of a static table.
+    struct StaticToken {
+        Kind kind;
+        Span span;
+        bool hasSpaceAfter;
+        // Operator of a punctuation token.
+        Operator op = {};
+    };
+    // Number token of a static table, split into the parts its value is decoded from. The
+    // spans are relative to the token's start.
+    struct StaticNumber {
+        std::uint8_t bodyOffset;
+        std::uint8_t base;
+        std::uint8_t flags;
+        std::uint32_t partCount;
+        Span integer;
+        Span fraction;
+        Span suffix;
+    };
+    // Sizes of the tables of a source.
+    struct StaticCounts {
+        std::size_t tokens = 0;
+        std::size_t numbers = 0;
+    };
+    // Reports the error found by the static tokeniser at the offset in the source. It is not
+    // constexpr, so that reaching it while tokenising at compile time is a compile error
+    // showing the error's code and offset. At runtime, throws the error's exception.
+    [[noreturn]] void staticError(ErrorCode code, std::string_view source, std::size_t offset);
+    // Builds the stream of the static tables, interning the names and decoding the values of
+    // the numbers (and of the strings with escape sequences) without scanning the source
+    // again.
+    TokenStream makeStaticStream(
+        std::string_view source,
+        std::span<StaticToken const> tokens,
+        std::span<StaticNumber const> numbers
+    );
+
+    // Scans the source with the same rules as tokenise, passing each token to the visitor's
+    // Add, AddNumber or AddPunct function and calling its SpaceAfter function when the last
+    // token is followed by a space and another token. Errors are reported through staticError.
+    template<typename Visitor> constexpr void scanStatic(
+        std::string_view source,
+        Visitor& visitor
+    ) {
+        std::size_t const _size = source.size();
+        std::size_t i = 0;
+        auto _at = [&](std::size_t index) {
+            return index < _size? source[index] : '\0';
+        };
+        char const* const _data = source.data();
+        // Returns the length of the character at index if it can start (or continue) a
+        // name, or 0 if it cannot or is after the end.
+        auto _nameStart = [&](std::size_t index) {
+            return index < _size? nameStartLength(_data + index, _data + _size) : 0;
+        };
+        auto _nameContinue = [&](std::size_t index) {
+            return index < _size? nameContinueLength(_data + index, _data + _size) : 0;
+        };
+        // Validated first, as by tokenise, so that invalid UTF-8 is reported before any other
+        // error.
+        char const* const _invalid = findInvalidUtf8Scalar(_data, _data + _size);
+        if (_invalid != _data + _size) {
+            staticError(
+                ErrorCode::InvalidUtf8, source, static_cast<std::size_t>(_invalid - _data)
+            );
+        }
+        // Returns the end of the whitespace and comments starting at index.
+        auto _skipSpace = [&](std::size_t index) {
+            for (;;) {
+                if (index < _size && hasClass(source[index], CharClass::Space)) {
+                    ++index;
+                } else if (_at(index) == '/' && _at(index + 1) == '/') {
+                    index = source.find('\n', index + 2);
+                    if (index == std::string_view::npos) {
+                        index = _size;
+                    }
+                } else if (_at(index) == '/' && _at(index + 1) == '*') {
+                    std::size_t const _close = source.find("*/", index + 2);
+                    if (_close == std::string_view::npos) {
+                        staticError(ErrorCode::UnterminatedComment, source, index);
+                    }
+                    index = _close + 2;
+                } else {
+                    return index;
+                }
+            }
+        };
+        i = _skipSpace(0);
+        while (i < _size) {
+            std::size_t const _start = i;
+            char const c = source[i];
+            if (std::size_t const _length = _nameStart(i); _length != 0) {
+                i += _length;
+                while (std::size_t const _next = _nameContinue(i)) {
+                    i += _next;
+                }
+                visitor.Add(Kind::Name, Span{
+                    static_cast<std::uint32_t>(_start), static_cast<std::uint32_t>(i - _start)
+                });
+            } else if (hasClass(c, CharClass::Digit10)) {
+                // Base prefix, as decoded by leadNumber.
+                std::int32_t _base = 10;
+                if (c == '0') {
+                    switch (_at(i + 1)) {
+                        case 'b': _base = 2; i += 2; break;
+                        case 'o': _base = 8; i += 2; break;
+                        case 'x': _base = 16; i += 2; break;
+                        default:
+                            if (hasClass(_at(i + 1), CharClass::Digit10)) {
+                                _base = 8;
+                                ++i;
+                            }
+                            break;
+                    }
+                }
+                std::uint16_t const _digitClass =
+                    _base == 2? CharClass::Digit2
+                    : _base == 8? CharClass::Digit8
+                    : _base == 10? CharClass::Digit10
+                    : CharClass::Digit16 | CharClass::UpperHex;
+                StaticNumber _number = {};
+                _number.bodyOffset = static_cast<std::uint8_t>(i - _start);
+                _number.base = static_cast<std::uint8_t>(_base);
+                auto _relative = [&](std::size_t from, std::size_t to) {
+                    return Span{
+                        static_cast<std::uint32_t>(from - _start),
+                        static_cast<std::uint32_t>(to - from)
+                    };
+                };
+                // Parts separated by radixes, as scanned by scanNumber.
+                for (;;) {
+                    std::size_t const _partStart = i;
+                    while (i < _size && hasClass(source[i], _digitClass)) {
+                        if (hasClass(source[i], CharClass::UpperHex)) {
+                            _number.flags |= NumberPayload::uppercaseFlag;
+                        }
+                        ++i;
+                    }
+                    if (i == _partStart) {
+                        staticError(
+                            hasClass(_at(i), CharClass::Digit10)?
+                                ErrorCode::InvalidDigit : ErrorCode::ExpectedDigit,
+                            source, i
+                        );
+                    }
+                    if (_number.partCount == 0) {
+                        _number.integer = _relative(_partStart, i);
+                    } else if (_number.partCount == 1) {
+                        _number.fraction = _relative(_partStart, i);
+                    }
+                    ++_number.partCount;
+                    if (_at(i) == '.' && hasClass(_at(i + 1), _digitClass)) {
+                        ++i;
+                        continue;
+                    }
+                    break;
+                }
+                // Suffixes, which must be preceded by ".'" in base-16.
+                bool _hasSuffixes = false;
+                if (_base == 16) {
+                    if (_at(i) == '.' && _at(i + 1) == '\'') {
+                        i += 2;
+                        _hasSuffixes = true;
+                        if (_nameStart(i) == 0) {
+                            staticError(ErrorCode::ExpectedSuffix, source, i);
+                        }
+                    }
+                } else {
+                    _hasSuffixes = _nameStart(i) != 0;
+                }
+                if (_hasSuffixes) {
+                    for (bool _first = true;; _first = false) {
+                        std::size_t const _suffixStart = i;
+                        while (std::size_t const _next = _nameContinue(i)) {
+                            i += _next;
+                        }
+                        if (_first) {
+                            _number.suffix = _relative(_suffixStart, i);
+                        }
+                        if (_at(i) != '\'') {
+                            break;
+                        }
+                        ++i;
+                        if (_nameStart(i) == 0) {
+                            staticError(ErrorCode::ExpectedSuffix, source, i);
+                        }
+                    }
+                } else if (_nameContinue(i) != 0) {
+                    staticError(
+                        _base == 16? ErrorCode::UnseparatedSuffix : ErrorCode::InvalidDigit,
+                        source, i
+                    );
+                }
+                visitor.AddNumber(Span{
+                    static_cast<std::uint32_t>(_start), static_cast<std::uint32_t>(i - _start)
+                }, _number);
+            } else if (c == '"') {
+                // String, whose escape sequences are checked here but decoded at runtime.
+                for (++i;; ++i) {
+                    if (i >= _size) {
+                        staticError(ErrorCode::UnterminatedString, source, _start);
+                    }
+                    if (source[i] == '"') {
+                        ++i;
+                        break;
+                    }
+                    if (source[i] == '\\') {
+                        if (i + 1 >= _size) {
+                            staticError(ErrorCode::UnterminatedString, source, _start);
+                        }
+                        if (!hasClass(source[i + 1], CharClass::Escape)) {
+                            staticError(ErrorCode::InvalidEscape, source, i);
+                        }
+                        ++i;
+                    }
+                }
+                visitor.Add(Kind::String, Span{
+                    static_cast<std::uint32_t>(_start), static_cast<std::uint32_t>(i - _start)
+                });
+            } else {
+                OperatorMatch const _match = operatorTable.Match(source.substr(i));
+                if (_match.length == 0) {
+                    staticError(ErrorCode::UnexpectedCharacter, source, i);
+                }
+                i += _match.length;
+                visitor.AddPunct(Span{
+                    static_cast<std::uint32_t>(_start), static_cast<std::uint32_t>(i - _start)
+                }, _match.op);
+            }
+            std::size_t const _tokenEnd = i;
+            i = _skipSpace(i);
+            // Only a space followed by another token counts, as for tokenise.
+            if (i != _tokenEnd && i != _size) {
+                visitor.SpaceAfter();
+            }
+        }
+    }
+    // Counts the tokens and numbers of the source.
+    constexpr StaticCounts countStatic(std::string_view source) {
+        struct Counter {
+            StaticCounts counts;
+
+            constexpr void Add(Kind, Span) { ++counts.tokens; }
+            constexpr void AddPunct(Span, Operator) { ++counts.tokens; }
+            constexpr void AddNumber(Span, StaticNumber const&) {
+                ++counts.tokens;
+                ++counts.numbers;
+            }
+            constexpr void SpaceAfter() {}
+        };
+        Counter _counter;
+        scanStatic(source, _counter);
+        return _counter.counts;
+    }
+    // Fixed-size token table of a source tokenised at compile time, which is turned into a
+    // stream without scanning the source.
+    template<std::size_t TokenCount, std::size_t NumberCount> struct StaticTokens {
+        std::string_view source;
+        std::array<StaticToken, TokenCount> tokens = {};
+        std::array<StaticNumber, NumberCount> numbers = {};
+
+        // Builds the stream of the tokens, referring to a copy of the source.
+        TokenStream MakeStream() const {
+            return makeStaticStream(source, tokens, numbers);
+        }
+    };
+    // Tokenises the string literal at compile time, so that a malformed literal does not
+    // compile.
+    template<StaticSource source> consteval auto tokeniseStatic() {
+        constexpr StaticCounts _counts = countStatic(source.View());
+        struct Filler {
+            StaticTokens<_counts.tokens, _counts.numbers> table;
+            std::size_t tokenCount = 0;
+            std::size_t numberCount = 0;
+
+            constexpr void Add(Kind kind, Span span) {
+                table.tokens[tokenCount++] = StaticToken{ kind, span, false };
+            }
+            constexpr void AddNumber(Span span, StaticNumber const& number) {
+                table.numbers[numberCount++] = number;
+                Add(Kind::Number, span);
+            }
+            constexpr void AddPunct(Span span, Operator op) {
+                table.tokens[tokenCount++] = StaticToken{ Kind::Punct, span, false, op };
+            }
+            constexpr void SpaceAfter() {
+                table.tokens[tokenCount - 1].hasSpaceAfter = true;
+            }
+        };
+        Filler _filler;
+        _filler.table.source = source.View();
+        scanStatic(source.View(), _filler);
+        return _filler.table;
+    }
+    // Token table of the string literal, built at compile time and stored in the binary.
+    template<StaticSource source> inline constexpr auto staticTokens = tokeniseStatic<source>();
+}
+#endif
@@ -0,0 +1,104 @@
+#ifndef FENNTON_SYMBOLS_HPP
+#define FENNTON_SYMBOLS_HPP
+
+#include <string_view>
+#include <optional>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <functional>
+#include <cstddef>
+#include <cstdint>
+
+namespace Fennton::Skript {
+    // Identity of an interned string in a symbol table. Symbols of the same table are equal
+    // if and only if their spellings are equal. The default symbol is the empty string's.
+    struct Symbol {
+        std::uint32_t id = 0;
+
+        bool operator==(Symbol const& other) const = default;
+    };
+    // Thread-safe string interner, which gives each distinct string a 32-bit symbol. The
+    // strings are copied to arena blocks which are never moved or freed before the table, so
+    // their views stay valid. Looking up a string which is already interned and getting the
+    // spelling of a symbol never lock; only adding a new string does.
+    class SymbolTable {
+    private:
+        // Interned string, with the hash used by the index.
+        struct Entry {
+            char const* data;
+            std::uint32_t size;
+            std::uint32_t hash;
+        };
+        // Open-addressing hash table from strings to symbols. Each slot packs the string's
+        // hash in its upper half and its symbol's id plus one in its lower half, or is zero
+        // if empty, so that readers can probe it without locking.
+        struct Index {
+            std::size_t mask;
+            std::unique_ptr<std::atomic<std::uint64_t>[]> slots;
+        };
+        // The entries are stored in pages which double in size, so that they never move
+        // when more are added. The first page has 2^firstPageBits entries.
+        static constexpr std::uint32_t firstPageBits = 8;
+        static constexpr std::uint32_t pageCount = 33 - firstPageBits;
+        // Size of the arena blocks. Longer strings get a block of their own.
+        static constexpr std::size_t blockSize = 64 * 1024;
+
+        std::atomic<Entry*> pages[pageCount] = {};
+        std::atomic<Index const*> index = nullptr;
+        std::atomic<std::uint32_t> count = 0;
+        // Indices replaced by larger ones, kept alive as readers might still be probing them.
+        std::vector<std::unique_ptr<Index>> indices;
+        std::vector<std::unique_ptr<char[]>> blocks;
+        char* blockIt = nullptr;
+        std::size_t blockLeft = 0;
+        // Held while adding strings.
+        std::mutex mutex;
+
+        // Page of an entry and its offset in the page.
+        struct Location {
+            std::uint32_t page;
+            std::size_t offset;
+        };
+        // Returns the location of the entry of the symbol's id.
+        static Location locate(std::uint32_t id);
+        // Returns the entry of the symbol's id, whose page must exist.
+        Entry const& entryAt(std::uint32_t id) const;
+        // Returns the symbol of the string in the index, if any.
+        std::optional<Symbol> find(
+            Index const& index,
+            std::string_view str,
+            std::uint32_t hash
+        ) const;
+        // Copies the string to the arena and returns the copy.
+        char const* store(std::string_view str);
+        // Replaces the index with one of the specified capacity, which must be a power of two.
+        void grow(std::size_t capacity);
+    public:
+        // Constructs a table with only the empty string, as the default symbol.
+        SymbolTable();
+        SymbolTable(SymbolTable const&) = delete;
+        SymbolTable& operator=(SymbolTable const&) = delete;
+        ~SymbolTable();
+        // Returns the symbol of the string, adding the string to the table if it is not
+        // already in it.
+        Symbol Intern(std::string_view str);
+        // Returns the symbol of the string if it is in the table, without adding it.
+        std::optional<Symbol> Find(std::string_view str) const;
+        // Returns the spelling of the symbol, which must come from this table. The view is
+        // valid for the table's lifetime.
+        std::string_view GetSpelling(Symbol symbol) const;
+        // Returns the number of symbols in the table.
+        std::size_t Size() const;
+    };
+    // Returns the table shared by the whole program, which the Name tokens are interned in.
+    SymbolTable& globalSymbols();
+}
+// Symbols hash as their ids, so that lookups keyed by names do not hash strings.
+template<> struct std::hash<Fennton::Skript::Symbol> {
+    std::size_t operator()(Fennton::Skript::Symbol symbol) const noexcept {
+        return std::hash<std::uint32_t>()(symbol.id);
+    }
+};
+#endif
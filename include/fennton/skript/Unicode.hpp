@@ -0,0 +1,132 @@
+#ifndef FENNTON_UNICODE_HPP
+#define FENNTON_UNICODE_HPP
+
+#include <fennton/skript/CharClass.hpp>
+#include <fennton/skript/XidTables.hpp>
+#include <cstddef>
+#include <cstdint>
+
+namespace Fennton::Skript::Tokeniser {
+    // Code point decoded from a UTF-8 sequence.
+    struct Utf8Char {
+        char32_t value;
+        // Bytes of the sequence. For an invalid sequence, those of its longest valid prefix,
+        // which is at least one byte, so that the next sequence starts after them.
+        std::uint32_t length;
+        bool valid;
+    };
+    // Decodes the UTF-8 sequence starting at it, which must be before end. Overlong
+    // sequences, surrogates and code points after U+10FFFF are invalid.
+    constexpr Utf8Char decodeUtf8(char const* it, char const* end) {
+        unsigned char const _lead = static_cast<unsigned char>(*it);
+        if (_lead < 0x80) {
+            return { _lead, 1, true };
+        }
+        std::uint32_t _length = 0;
+        char32_t _value = 0;
+        // Range of the second byte, which is narrower after some leads to exclude overlong
+        // sequences, surrogates and code points which are too large.
+        unsigned char _low = 0x80;
+        unsigned char _high = 0xBF;
+        if (_lead >= 0xC2 && _lead <= 0xDF) {
+            _length = 2;
+            _value = _lead & 0x1F;
+        } else if (_lead >= 0xE0 && _lead <= 0xEF) {
+            _length = 3;
+            _value = _lead & 0x0F;
+            if (_lead == 0xE0) {
+                _low = 0xA0;
+            } else if (_lead == 0xED) {
+                _high = 0x9F;
+            }
+        } else if (_lead >= 0xF0 && _lead <= 0xF4) {
+            _length = 4;
+            _value = _lead & 0x07;
+            if (_lead == 0xF0) {
+                _low = 0x90;
+            } else if (_lead == 0xF4) {
+                _high = 0x8F;
+            }
+        } else {
+            return { 0xFFFD, 1, false };
+        }
+        for (std::uint32_t i = 1; i < _length; ++i) {
+            if (end - it <= static_cast<std::ptrdiff_t>(i)) {
+                return { 0xFFFD, i, false };
+            }
+            unsigned char const _byte = static_cast<unsigned char>(it[i]);
+            if (_byte < _low || _byte > _high) {
+                return { 0xFFFD, i, false };
+            }
+            _value = (_value << 6) | (_byte & 0x3F);
+            _low = 0x80;
+            _high = 0xBF;
+        }
+        return { _value, _length, true };
+    }
+    // Returns a pointer to the first byte of [it, end) which is not part of a valid UTF-8
+    // sequence, or end if the whole range is valid. Decodes one sequence at a time, so that
+    // it can run at compile time.
+    constexpr char const* findInvalidUtf8Scalar(char const* it, char const* end) {
+        while (it != end) {
+            Utf8Char const _char = decodeUtf8(it, end);
+            if (!_char.valid) {
+                return it;
+            }
+            it += _char.length;
+        }
+        return end;
+    }
+    // Same as findInvalidUtf8Scalar, but skipping ASCII 16 bytes at a time with SSE2. With
+    // AVX2, runs of ASCII are skipped 128 bytes at a time, and the other bytes are validated
+    // 32 at a time (through the lookup tables of Keiser and Lemire's validator, falling back
+    // to the scalar version to locate an error).
+    char const* findInvalidUtf8(char const* it, char const* end);
+
+    // Returns true if the code point has the property, which is 0 for XID_Start and 1 for
+    // XID_Continue.
+    constexpr bool hasXidProperty(char32_t c, std::size_t property) {
+        constexpr std::size_t _words = XidTables::blockSize / 64;
+        std::size_t const _block = c / XidTables::blockSize;
+        std::size_t const _leaf =
+            _block < XidTables::blocks.size()? XidTables::blocks[_block] : XidTables::emptyLeaf;
+        std::size_t const _bit = c % XidTables::blockSize;
+        return
+            (XidTables::leaves[(_leaf * 2 + property) * _words + _bit / 64] >> (_bit % 64)) & 1
+        ;
+    }
+    // Returns true if the code point can start a Unicode identifier.
+    constexpr bool isXidStart(char32_t c) {
+        return hasXidProperty(c, 0);
+    }
+    // Returns true if the code point can continue a Unicode identifier.
+    constexpr bool isXidContinue(char32_t c) {
+        return hasXidProperty(c, 1);
+    }
+    // Returns the length of the character starting at it (which must be before end) if it
+    // can start a name, or 0 if it cannot. ASCII characters are classified by their class,
+    // and others are decoded and looked up as XID_Start.
+    constexpr std::size_t nameStartLength(char const* it, char const* end) {
+        if (static_cast<unsigned char>(*it) < 0x80) {
+            return hasClass(*it, CharClass::NameStart)? 1 : 0;
+        }
+        Utf8Char const _char = decodeUtf8(it, end);
+        return _char.valid && isXidStart(_char.value)? _char.length : 0;
+    }
+    // Same as nameStartLength, but for the characters which can continue a name.
+    constexpr std::size_t nameContinueLength(char const* it, char const* end) {
+        if (static_cast<unsigned char>(*it) < 0x80) {
+            return hasClass(*it, CharClass::NameContinue)? 1 : 0;
+        }
+        Utf8Char const _char = decodeUtf8(it, end);
+        return _char.valid && isXidContinue(_char.value)? _char.length : 0;
+    }
+    // Returns the end of the characters which can continue a name starting at it.
+    constexpr char const* skipNameContinue(char const* it, char const* end) {
+        for (std::size_t _length; it != end && (_length = nameContinueLength(it, end)) != 0;) {
+            it += _length;
+        }
+        return it;
+    }
+}
+#endif
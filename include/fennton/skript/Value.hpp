@@ -0,0 +1,179 @@
+#ifndef FENNTON_VALUE_HPP
+#define FENNTON_VALUE_HPP
+
+#include <fennton/skript/Arena.hpp>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+namespace Fennton::Skript {
+    // Kind of a runtime value.
+    enum class RuntimeKind : std::uint8_t {
+        Float,
+        Integer,
+        Boolean,
+        Pointer,
+        Nothing
+    };
+    // Runtime value in a single 64-bit word, by NaN-boxing: a float is the bits of its double,
+    // and the other kinds are stored in the 48 lowest bits of negative quiet NaNs, whose 16
+    // upper bits are the kind's tag. No float has those bits, as every NaN is stored as the
+    // same positive NaN. A value is then as large as a register of the machine, half the size
+    // of a tagged union, and its kind is found by comparing its upper bits, without a separate
+    // tag to load and branch on. The integers which do not fit in 48 bits are boxed in a cell
+    // of an arena of the caller, which must outlive the value, so that a host resetting its
+    // arena between frames does not allocate for them once it has grown.
+    class Value {
+    public:
+        // Range of the integers stored inline with 48 bits. The others are boxed.
+        static constexpr std::int64_t minInlineInteger = -(std::int64_t(1) << 47);
+        static constexpr std::int64_t maxInlineInteger = (std::int64_t(1) << 47) - 1;
+    private:
+        // Upper 16 bits of the values which are not floats, so that all floats (including the
+        // positive canonical NaN) are below the first of them. The tags of the integers follow
+        // each other, so that they are told apart from the others with a single comparison.
+        static constexpr std::uint64_t integerTag = 0xFFF9;
+        // Integers out of the inline range, whose payload is the address of their cell, and
+        // the unsigned integers above the largest signed one of 64 bits.
+        static constexpr std::uint64_t boxedIntegerTag = 0xFFFA;
+        static constexpr std::uint64_t boxedUnsignedTag = 0xFFFB;
+        static constexpr std::uint64_t booleanTag = 0xFFFC;
+        static constexpr std::uint64_t pointerTag = 0xFFFD;
+        static constexpr std::uint64_t nothingTag = 0xFFFE;
+        static constexpr std::uint64_t payloadMask = (std::uint64_t(1) << 48) - 1;
+        static constexpr std::uint64_t canonicalNaN = 0x7FF8000000000000;
+
+        std::uint64_t bits;
+
+        constexpr explicit Value(std::uint64_t bits) : bits(bits) {}
+        // Returns the value with the tag and the lowest 48 bits of the payload.
+        static constexpr Value box(std::uint64_t tag, std::uint64_t payload) {
+            return Value((tag << 48) | (payload & payloadMask));
+        }
+        // Returns the boxed integer with the tag, in a new cell of the arena.
+        static Value boxInteger(std::uint64_t tag, std::uint64_t integer, Arena& arena) {
+            std::uint64_t* const _cell = arena.Allocate<std::uint64_t>(1);
+            *_cell = integer;
+            return box(tag, static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(_cell)));
+        }
+        constexpr std::uint64_t getTag() const {
+            return bits >> 48;
+        }
+        constexpr bool isBoxed() const {
+            return getTag() - boxedIntegerTag <= boxedUnsignedTag - boxedIntegerTag;
+        }
+        std::uint64_t getBoxed() const {
+            return *reinterpret_cast<std::uint64_t const*>(
+                static_cast<std::uintptr_t>(bits & payloadMask)
+            );
+        }
+    public:
+        // Constructs nothing, the value of what has none.
+        constexpr Value() : bits(nothingTag << 48) {}
+        static constexpr Value FromFloat(double value) {
+            // NaNs can have any sign and payload, which could be read as another kind.
+            return Value(value != value? canonicalNaN : std::bit_cast<std::uint64_t>(value));
+        }
+        // Returns the integer as a value, which must fit inline.
+        static constexpr Value FromInteger(std::int64_t value) {
+            return box(integerTag, static_cast<std::uint64_t>(value));
+        }
+        // Returns the integer as a value, boxed in the arena if it does not fit inline.
+        static Value FromInteger(std::int64_t value, Arena& arena) {
+            if (!FitsInline(value)) {
+                return boxInteger(boxedIntegerTag, static_cast<std::uint64_t>(value), arena);
+            }
+            return FromInteger(value);
+        }
+        // Returns the unsigned integer as a value, like FromInteger.
+        static Value FromUnsigned(std::uint64_t value, Arena& arena) {
+            if (value > std::uint64_t(std::numeric_limits<std::int64_t>::max())) {
+                return boxInteger(boxedUnsignedTag, value, arena);
+            }
+            return FromInteger(static_cast<std::int64_t>(value), arena);
+        }
+        static constexpr Value FromBoolean(bool value) {
+            return box(booleanTag, value? 1 : 0);
+        }
+        // Returns the pointer as a value, which must fit in 48 bits, like the addresses of
+        // user space on x86-64 and AArch64. The value does not own what it points to.
+        static Value FromPointer(void const* pointer) {
+            return box(pointerTag, static_cast<std::uint64_t>(
+                reinterpret_cast<std::uintptr_t>(pointer)
+            ));
+        }
+        // Returns true if the integer is in the range of the inline integers.
+        static constexpr bool FitsInline(std::int64_t value) {
+            return value >= minInlineInteger && value <= maxInlineInteger;
+        }
+        constexpr RuntimeKind GetKind() const {
+            switch (getTag()) {
+                case integerTag:
+                case boxedIntegerTag:
+                case boxedUnsignedTag: return RuntimeKind::Integer;
+                case booleanTag: return RuntimeKind::Boolean;
+                case pointerTag: return RuntimeKind::Pointer;
+                case nothingTag: return RuntimeKind::Nothing;
+                default: return RuntimeKind::Float;
+            }
+        }
+        constexpr bool IsFloat() const {
+            return bits < (integerTag << 48);
+        }
+        constexpr bool IsInteger() const {
+            return getTag() - integerTag <= boxedUnsignedTag - integerTag;
+        }
+        // Returns true if the integer fits in 64 signed bits, as all of them do except the
+        // unsigned ones above the largest of those.
+        constexpr bool FitsSigned() const {
+            return getTag() != boxedUnsignedTag;
+        }
+        constexpr bool IsBoolean() const {
+            return getTag() == booleanTag;
+        }
+        constexpr bool IsPointer() const {
+            return getTag() == pointerTag;
+        }
+        constexpr bool IsNothing() const {
+            return getTag() == nothingTag;
+        }
+        // Returns the float, integer, Boolean or pointer in the value, which must be of that
+        // kind.
+        constexpr double GetFloat() const {
+            return std::bit_cast<double>(bits);
+        }
+        std::int64_t GetInteger() const {
+            if (getTag() != integerTag) {
+                return static_cast<std::int64_t>(getBoxed());
+            }
+            // Sign-extends the 48 bits of the payload.
+            return static_cast<std::int64_t>(bits << 16) >> 16;
+        }
+        // Returns the bits of the integer, where the negative ones wrap around like casts.
+        std::uint64_t GetUnsigned() const {
+            return static_cast<std::uint64_t>(GetInteger());
+        }
+        constexpr bool GetBoolean() const {
+            return (bits & 1) != 0;
+        }
+        void* GetPointer() const {
+            return reinterpret_cast<void*>(static_cast<std::uintptr_t>(bits & payloadMask));
+        }
+        // Returns the word storing the value.
+        constexpr std::uint64_t GetBits() const {
+            return bits;
+        }
+        // Returns true if both values have the same kind and the same bits, so NaNs are equal
+        // to themselves, and 0.0 and -0.0 are not equal. Boxed integers are compared by the
+        // bits in their cells, as equal ones can be in different cells.
+        constexpr bool operator==(Value const& other) const {
+            if (bits == other.bits) {
+                return true;
+            }
+            return isBoxed() && getTag() == other.getTag() && getBoxed() == other.getBoxed();
+        }
+    };
+    static_assert(sizeof(Value) == sizeof(std::uint64_t));
+}
+#endif
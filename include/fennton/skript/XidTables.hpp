@@ -0,0 +1,665 @@
+// Generated by src/python/XidTables.py from Unicode 14.0.0.
+
+#ifndef FENNTON_XID_TABLES_HPP
+#define FENNTON_XID_TABLES_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace Fennton::Skript::Tokeniser::XidTables {
+    // Number of code points per block.
+    inline constexpr std::size_t blockSize = 128;
+    // Leaf which has none of the properties, used for the blocks after the index.
+    inline constexpr std::uint8_t emptyLeaf = 57;
+    // Leaf of each block of code points.
+    inline constexpr std::array<std::uint8_t, 7172> blocks = {
+        0, 1, 2, 2, 2, 3, 4, 5, 2, 6, 7, 8, 9, 10, 11, 12,
+        13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28,
+        29, 30, 2, 2, 31, 32, 33, 34, 35, 2, 2, 2, 36, 37, 38, 39,
+        40, 41, 42, 43, 44, 45, 46, 47, 48, 49, 2, 50, 2, 2, 51, 52,
+        53, 54, 55, 56, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 2, 58, 59, 60, 57, 57, 57, 57,
+        61, 62, 63, 64, 57, 57, 57, 57, 2, 2, 2, 2, 2, 2, 2, 2,
+        2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+        2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+        2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 65, 2, 2, 2, 2,
+        2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+        2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+        2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+        2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+        2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+        2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+        2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+        2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+        2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+        2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+        2, 2, 2, 2, 2, 2, 2, 2, 2, 66, 2, 2, 67, 68, 69, 70,
+        71, 72, 73, 74, 75, 76, 77, 78, 2, 2, 2, 2, 2, 2, 2, 2,
+        2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+        2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+        2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+        2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+        2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 79,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 2, 2, 80, 81, 82, 83, 84, 2, 85, 86, 87, 88, 89, 90,
+        91, 92, 93, 94, 57, 95, 96, 97, 2, 98, 99, 100, 2, 2, 101, 102,
+        103, 104, 105, 106, 107, 108, 109, 110, 111, 112, 113, 57, 57, 114, 115, 116,
+        117, 118, 119, 120, 121, 122, 123, 57, 124, 125, 57, 126, 127, 128, 129, 57,
+        130, 131, 132, 133, 134, 135, 57, 57, 136, 137, 138, 139, 57, 140, 57, 141,
+        2, 2, 2, 2, 2, 2, 2, 142, 143, 2, 144, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 145,
+        2, 2, 2, 2, 2, 2, 2, 2, 146, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 2, 2, 2, 2, 147, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        2, 2, 2, 2, 148, 149, 150, 151, 57, 57, 57, 57, 152, 57, 153, 154,
+        2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+        2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+        2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 155,
+        2, 2, 2, 2, 2, 2, 2, 2, 2, 156, 56, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 157,
+        2, 2, 158, 2, 2, 159, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 160, 161, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 162, 57,
+        57, 57, 163, 164, 165, 57, 57, 57, 166, 167, 168, 2, 2, 169, 170, 171,
+        57, 57, 57, 57, 172, 173, 57, 57, 57, 57, 57, 57, 57, 57, 174, 57,
+        175, 57, 176, 57, 57, 177, 57, 57, 57, 57, 57, 57, 57, 57, 57, 178,
+        2, 179, 180, 57, 57, 57, 57, 57, 57, 57, 57, 57, 181, 182, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 183, 57, 57, 57, 57, 57, 57, 57, 57,
+        2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+        2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+        2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+        2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+        2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+        2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+        2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+        2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+        2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+        2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+        2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+        2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+        2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+        2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+        2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+        2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+        2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+        2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+        2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+        2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+        2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 184, 2, 2,
+        2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+        2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 185, 2,
+        186, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+        2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+        2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 187, 2, 2,
+        2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+        2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+        2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+        2, 2, 2, 2, 2, 2, 2, 188, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        2, 2, 2, 2, 189, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+        2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+        2, 2, 2, 2, 2, 2, 190, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+        57, 57, 191, 192,
+    };
+    // Bits of each leaf, first those of XID_Start and then those of XID_Continue, with
+    // 2 words per property.
+    inline constexpr std::array<std::uint64_t, 772> leaves = {
+        0x0000000000000000, 0x07FFFFFE07FFFFFE, 0x03FF000000000000, 0x07FFFFFE87FFFFFE,
+        0x0420040000000000, 0xFF7FFFFFFF7FFFFF, 0x04A0040000000000, 0xFF7FFFFFFF7FFFFF,
+        0xFFFFFFFFFFFFFFFF, 0xFFFFFFFFFFFFFFFF, 0xFFFFFFFFFFFFFFFF, 0xFFFFFFFFFFFFFFFF,
+        0xFFFFFFFFFFFFFFFF, 0x0000501F0003FFC3, 0xFFFFFFFFFFFFFFFF, 0x0000501F0003FFC3,
+        0x0000000000000000, 0xB8DF000000000000, 0xFFFFFFFFFFFFFFFF, 0xB8DFFFFFFFFFFFFF,
+        0xFFFFFFFBFFFFD740, 0xFFBFFFFFFFFFFFFF, 0xFFFFFFFBFFFFD7C0, 0xFFBFFFFFFFFFFFFF,
+        0xFFFFFFFFFFFFFC03, 0xFFFFFFFFFFFFFFFF, 0xFFFFFFFFFFFFFCFB, 0xFFFFFFFFFFFFFFFF,
+        0xFFFEFFFFFFFFFFFF, 0xFFFFFFFF027FFFFF, 0xFFFEFFFFFFFFFFFF, 0xFFFFFFFF027FFFFF,
+        0x00000000000001FF, 0x000787FFFFFF0000, 0xBFFFFFFFFFFE01FF, 0x000787FFFFFF00B6,
+        0xFFFFFFFF00000000, 0xFFFEC000000007FF, 0xFFFFFFFF07FF0000, 0xFFFFC3FFFFFFFFFF,
+        0xFFFFFFFFFFFFFFFF, 0x9C00C060002FFFFF, 0xFFFFFFFFFFFFFFFF, 0x9FFFFDFF9FEFFFFF,
+        0x0000FFFFFFFD0000, 0xFFFFFFFFFFFFE000, 0xFFFFFFFFFFFF0000, 0xFFFFFFFFFFFFE7FF,
+        0x0002003FFFFFFFFF, 0x043007FFFFFFFC00, 0x0003FFFFFFFFFFFF, 0x243FFFFFFFFFFFFF,
+        0x00000110043FFFFF, 0xFFFF07FF01FFFFFF, 0x00003FFFFFFFFFFF, 0xFFFF07FF0FFFFFFF,
+        0xFFFFFFFF00007EFF, 0x00000000000003FF, 0xFFFFFFFFFF007EFF, 0xFFFFFFFBFFFFFFFF,
+        0x23FFFFFFFFFFFFF0, 0xFFFE0003FF010000, 0xFFFFFFFFFFFFFFFF, 0xFFFEFFCFFFFFFFFF,
+        0x23C5FDFFFFF99FE1, 0x10030003B0004000, 0xF3C5FDFFFFF99FEF, 0x5003FFCFB080799F,
+        0x036DFDFFFFF987E0, 0x001C00005E000000, 0xD36DFDFFFFF987EE, 0x003FFFC05E023987,
+        0x23EDFDFFFFFBBFE0, 0x0200000300010000, 0xF3EDFDFFFFFBBFEE, 0xFE00FFCF00013BBF,
+        0x23EDFDFFFFF99FE0, 0x00020003B0000000, 0xF3EDFDFFFFF99FEE, 0x0002FFCFB0E0399F,
+        0x03FFC718D63DC7E8, 0x0000000000010000, 0xC3FFC718D63DC7EC, 0x0000FFC000813DC7,
+        0x23FFFDFFFFFDDFE0, 0x0000000327000000, 0xF3FFFDFFFFFDDFFF, 0x0000FFCF27603DDF,
+        0x23EFFDFFFFFDDFE1, 0x0006000360000000, 0xF3EFFDFFFFFDDFEF, 0x0006FFCF60603DDF,
+        0x27FFFFFFFFFDDFF0, 0xFC00000380704000, 0xFFFFFFFFFFFDDFFF, 0xFC00FFCF80F07DDF,
+        0x2FFBFFFFFC7FFFE0, 0x000000000000007F, 0x2FFBFFFFFC7FFFEE, 0x000CFFC0FF5F847F,
+        0x0005FFFFFFFFFFFE, 0x000000000000007F, 0x07FFFFFFFFFFFFFE, 0x0000000003FF7FFF,
+        0x2005FFAFFFFFF7D6, 0x00000000F000005F, 0x3FFFFFAFFFFFF7D6, 0x00000000F3FF3F5F,
+        0x0000000000000001, 0x00001FFFFFFFFEFF, 0xC2A003FF03000001, 0xFFFE1FFFFFFFFEFF,
+        0x0000000000001F00, 0x0000000000000000, 0x1FFFFFFFFEFFFFDF, 0x0000000000000040,
+        0x800007FFFFFFFFFF, 0xFFE1C0623C3F0000, 0xFFFFFFFFFFFFFFFF, 0xFFFFFFFFFFFF03FF,
+        0xFFFFFFFF00004003, 0xF7FFFFFFFFFF20BF, 0xFFFFFFFF3FFFFFFF, 0xF7FFFFFFFFFF20BF,
+        0xFFFFFFFFFFFFFFFF, 0xFFFFFFFF3D7F3DFF, 0xFFFFFFFFFFFFFFFF, 0xFFFFFFFF3D7F3DFF,
+        0x7F3DFFFFFFFF3DFF, 0xFFFFFFFFFF7FFF3D, 0x7F3DFFFFFFFF3DFF, 0xFFFFFFFFFF7FFF3D,
+        0xFFFFFFFFFF3DFFFF, 0x0000000007FFFFFF, 0xFFFFFFFFFF3DFFFF, 0x0003FE00E7FFFFFF,
+        0xFFFFFFFF0000FFFF, 0x3F3FFFFFFFFFFFFF, 0xFFFFFFFF0000FFFF, 0x3F3FFFFFFFFFFFFF,
+        0xFFFFFFFFFFFFFFFE, 0xFFFFFFFFFFFFFFFF, 0xFFFFFFFFFFFFFFFE, 0xFFFFFFFFFFFFFFFF,
+        0xFFFFFFFFFFFFFFFF, 0xFFFF9FFFFFFFFFFF, 0xFFFFFFFFFFFFFFFF, 0xFFFF9FFFFFFFFFFF,
+        0xFFFFFFFF07FFFFFE, 0x01FFC7FFFFFFFFFF, 0xFFFFFFFF07FFFFFE, 0x01FFC7FFFFFFFFFF,
+        0x0003FFFF8003FFFF, 0x0001DFFF0003FFFF, 0x001FFFFF803FFFFF, 0x000DDFFF000FFFFF,
+        0x000FFFFFFFFFFFFF, 0x0000000010800000, 0xFFFFFFFFFFFFFFFF, 0x000003FF308FFFFF,
+        0xFFFFFFFF00000000, 0x01FFFFFFFFFFFFFF, 0xFFFFFFFF03FFB800, 0x01FFFFFFFFFFFFFF,
+        0xFFFF05FFFFFFFFFF, 0x003FFFFFFFFFFFFF, 0xFFFF07FFFFFFFFFF, 0x003FFFFFFFFFFFFF,
+        0x000000007FFFFFFF, 0x001F3FFFFFFF0000, 0x0FFF0FFF7FFFFFFF, 0x001F3FFFFFFFFFC0,
+        0xFFFF0FFFFFFFFFFF, 0x00000000000003FF, 0xFFFF0FFFFFFFFFFF, 0x0000000007FF03FF,
+        0xFFFFFFFF007FFFFF, 0x00000000001FFFFF, 0xFFFFFFFF0FFFFFFF, 0x9FFFFFFF7FFFFFFF,
+        0x0000008000000000, 0x0000000000000000, 0xBFFF008003FF03FF, 0x0000000000007FFF,
+        0x000FFFFFFFFFFFE0, 0x0000000000001FE0, 0xFFFFFFFFFFFFFFFF, 0x000FF80003FF1FFF,
+        0xFC00C001FFFFFFF8, 0x0000003FFFFFFFFF, 0xFFFFFFFFFFFFFFFF, 0x000FFFFFFFFFFFFF,
+        0x0000000FFFFFFFFF, 0x3FFFFFFFFC00E000, 0x00FFFFFFFFFFFFFF, 0x3FFFFFFFFFFFE3FF,
+        0xE7FFFFFFFFFF01FF, 0x046FDE0000000000, 0xE7FFFFFFFFFF01FF, 0x07FFFFFFFFF70000,
+        0xFFFFFFFFFFFFFFFF, 0x0000000000000000, 0xFFFFFFFFFFFFFFFF, 0xFFFFFFFFFFFFFFFF,
+        0xFFFFFFFF3F3FFFFF, 0x3FFFFFFFAAFF3F3F, 0xFFFFFFFF3F3FFFFF, 0x3FFFFFFFAAFF3F3F,
+        0x5FDFFFFFFFFFFFFF, 0x1FDC1FFF0FCF1FDC, 0x5FDFFFFFFFFFFFFF, 0x1FDC1FFF0FCF1FDC,
+        0x0000000000000000, 0x8002000000000000, 0x8000000000000000, 0x8002000000100001,
+        0x000000001FFF0000, 0x0000000000000000, 0x000000001FFF0000, 0x0001FFE21FFF0000,
+        0xF3FFFD503F2FFC84, 0xFFFFFFFF000043E0, 0xF3FFFD503F2FFC84, 0xFFFFFFFF000043E0,
+        0x00000000000001FF, 0x0000000000000000, 0x00000000000001FF, 0x0000000000000000,
+        0x0000000000000000, 0x0000000000000000, 0x0000000000000000, 0x0000000000000000,
+        0xFFFFFFFFFFFFFFFF, 0x000C781FFFFFFFFF, 0xFFFFFFFFFFFFFFFF, 0x000FF81FFFFFFFFF,
+        0xFFFF20BFFFFFFFFF, 0x000080FFFFFFFFFF, 0xFFFF20BFFFFFFFFF, 0x800080FFFFFFFFFF,
+        0x7F7F7F7F007FFFFF, 0x000000007F7F7F7F, 0x7F7F7F7F007FFFFF, 0xFFFFFFFF7F7F7F7F,
+        0x1F3E03FE000000E0, 0xFFFFFFFFFFFFFFFE, 0x1F3EFFFE000000E0, 0xFFFFFFFFFFFFFFFE,
+        0xFFFFFFFEE07FFFFF, 0xF7FFFFFFFFFFFFFF, 0xFFFFFFFEE67FFFFF, 0xF7FFFFFFFFFFFFFF,
+        0xFFFEFFFFFFFFFFE0, 0xFFFFFFFFFFFFFFFF, 0xFFFEFFFFFFFFFFE0, 0xFFFFFFFFFFFFFFFF,
+        0xFFFFFFFF00007FFF, 0xFFFF000000000000, 0xFFFFFFFF00007FFF, 0xFFFF000000000000,
+        0xFFFFFFFFFFFFFFFF, 0x0000000000000000, 0xFFFFFFFFFFFFFFFF, 0x0000000000000000,
+        0x0000000000001FFF, 0x3FFFFFFFFFFF0000, 0x0000000000001FFF, 0x3FFFFFFFFFFF0000,
+        0x00000C00FFFF1FFF, 0x80007FFFFFFFFFFF, 0x00000FFFFFFF1FFF, 0xBFF0FFFFFFFFFFFF,
+        0xFFFFFFFF3FFFFFFF, 0x0000FFFFFFFFFFFF, 0xFFFFFFFFFFFFFFFF, 0x0003FFFFFFFFFFFF,
+        0xFFFFFFFCFF800000, 0xFFFFFFFFFFFFFFFF, 0xFFFFFFFCFF800000, 0xFFFFFFFFFFFFFFFF,
+        0xFFFFFFFFFFFFF9FF, 0xFFFC000003EB07FF, 0xFFFFFFFFFFFFF9FF, 0xFFFC000003EB07FF,
+        0x00000007FFFFF7BB, 0x000FFFFFFFFFFFFF, 0x000010FFFFFFFFFF, 0x000FFFFFFFFFFFFF,
+        0x000FFFFFFFFFFFFC, 0x68FC000000000000, 0xFFFFFFFFFFFFFFFF, 0xE8FFFFFF03FF003F,
+        0xFFFF003FFFFFFC00, 0x1FFFFFFF0000007F, 0xFFFF3FFFFFFFFFFF, 0x1FFFFFFF000FFFFF,
+        0x0007FFFFFFFFFFF0, 0x7C00FFDF00008000, 0xFFFFFFFFFFFFFFFF, 0x7FFFFFFF03FF8001,
+        0x000001FFFFFFFFFF, 0xC47FFFFF00000FF7, 0x007FFFFFFFFFFFFF, 0xFC7FFFFF03FF3FFF,
+        0x3E62FFFFFFFFFFFF, 0x001C07FF38000005, 0xFFFFFFFFFFFFFFFF, 0x007CFFFF38000007,
+        0xFFFF7F7F007E7E7E, 0xFFFF03FFF7FFFFFF, 0xFFFF7F7F007E7E7E, 0xFFFF03FFF7FFFFFF,
+        0xFFFFFFFFFFFFFFFF, 0x00000007FFFFFFFF, 0xFFFFFFFFFFFFFFFF, 0x03FF37FFFFFFFFFF,
+        0xFFFF000FFFFFFFFF, 0x0FFFFFFFFFFFF87F, 0xFFFF000FFFFFFFFF, 0x0FFFFFFFFFFFF87F,
+        0xFFFFFFFFFFFFFFFF, 0xFFFF3FFFFFFFFFFF, 0xFFFFFFFFFFFFFFFF, 0xFFFF3FFFFFFFFFFF,
+        0xFFFFFFFFFFFFFFFF, 0x0000000003FFFFFF, 0xFFFFFFFFFFFFFFFF, 0x0000000003FFFFFF,
+        0x5F7FFDFFA0F8007F, 0xFFFFFFFFFFFFFFDB, 0x5F7FFDFFE0F8007F, 0xFFFFFFFFFFFFFFDB,
+        0x0003FFFFFFFFFFFF, 0xFFFFFFFFFFF80000, 0x0003FFFFFFFFFFFF, 0xFFFFFFFFFFF80000,
+        0xFFFFFFFFFFFFFFFF, 0xFFFFFFF03FFFFFFF, 0xFFFFFFFFFFFFFFFF, 0xFFFFFFF03FFFFFFF,
+        0x3FFFFFFFFFFFFFFF, 0xFFFFFFFFFFFF0000, 0x3FFFFFFFFFFFFFFF, 0xFFFFFFFFFFFF0000,
+        0xFFFFFFFFFFFCFFFF, 0x03FF0000000000FF, 0xFFFFFFFFFFFCFFFF, 0x03FF0000000000FF,
+        0x0000000000000000, 0xAA8A000000000000, 0x0018FFFF0000FFFF, 0xAA8A00000000E000,
+        0xFFFFFFFFFFFFFFFF, 0x1FFFFFFFFFFFFFFF, 0xFFFFFFFFFFFFFFFF, 0x1FFFFFFFFFFFFFFF,
+        0x07FFFFFE00000000, 0xFFFFFFC007FFFFFE, 0x87FFFFFE03FF0000, 0xFFFFFFC007FFFFFE,
+        0x7FFFFFFF3FFFFFFF, 0x000000001CFCFCFC, 0x7FFFFFFFFFFFFFFF, 0x000000001CFCFCFC,
+        0xB7FFFF7FFFFFEFFF, 0x000000003FFF3FFF, 0xB7FFFF7FFFFFEFFF, 0x000000003FFF3FFF,
+        0xFFFFFFFFFFFFFFFF, 0x07FFFFFFFFFFFFFF, 0xFFFFFFFFFFFFFFFF, 0x07FFFFFFFFFFFFFF,
+        0x0000000000000000, 0x001FFFFFFFFFFFFF, 0x0000000000000000, 0x001FFFFFFFFFFFFF,
+        0x0000000000000000, 0x0000000000000000, 0x0000000000000000, 0x2000000000000000,
+        0xFFFFFFFF1FFFFFFF, 0x000000000001FFFF, 0xFFFFFFFF1FFFFFFF, 0x000000010001FFFF,
+        0xFFFFE000FFFFFFFF, 0x003FFFFFFFFF07FF, 0xFFFFE000FFFFFFFF, 0x07FFFFFFFFFF07FF,
+        0xFFFFFFFF3FFFFFFF, 0x00000000003EFF0F, 0xFFFFFFFF3FFFFFFF, 0x00000000003EFF0F,
+        0xFFFF00003FFFFFFF, 0x0FFFFFFFFF0FFFFF, 0xFFFF03FF3FFFFFFF, 0x0FFFFFFFFF0FFFFF,
+        0xFFFF00FFFFFFFFFF, 0xF7FF000FFFFFFFFF, 0xFFFF00FFFFFFFFFF, 0xF7FF000FFFFFFFFF,
+        0x1BFBFFFBFFB7F7FF, 0x0000000000000000, 0x1BFBFFFBFFB7F7FF, 0x0000000000000000,
+        0x007FFFFFFFFFFFFF, 0x000000FF003FFFFF, 0x007FFFFFFFFFFFFF, 0x000000FF003FFFFF,
+        0x07FDFFFFFFFFFFBF, 0x0000000000000000, 0x07FDFFFFFFFFFFBF, 0x0000000000000000,
+        0x91BFFFFFFFFFFD3F, 0x007FFFFF003FFFFF, 0x91BFFFFFFFFFFD3F, 0x007FFFFF003FFFFF,
+        0x000000007FFFFFFF, 0x0037FFFF00000000, 0x000000007FFFFFFF, 0x0037FFFF00000000,
+        0x03FFFFFF003FFFFF, 0x0000000000000000, 0x03FFFFFF003FFFFF, 0x0000000000000000,
+        0xC0FFFFFFFFFFFFFF, 0x0000000000000000, 0xC0FFFFFFFFFFFFFF, 0x0000000000000000,
+        0x003FFFFFFEEF0001, 0x1FFFFFFF00000000, 0x873FFFFFFEEFF06F, 0x1FFFFFFF00000000,
+        0x000000001FFFFFFF, 0x0000001FFFFFFEFF, 0x000000001FFFFFFF, 0x0000007FFFFFFEFF,
+        0x003FFFFFFFFFFFFF, 0x0007FFFF003FFFFF, 0x003FFFFFFFFFFFFF, 0x0007FFFF003FFFFF,
+        0x000000000003FFFF, 0x0000000000000000, 0x000000000003FFFF, 0x0000000000000000,
+        0xFFFFFFFFFFFFFFFF, 0x00000000000001FF, 0xFFFFFFFFFFFFFFFF, 0x00000000000001FF,
+        0x0007FFFFFFFFFFFF, 0x0007FFFFFFFFFFFF, 0x0007FFFFFFFFFFFF, 0x0007FFFFFFFFFFFF,
+        0x0000000FFFFFFFFF, 0x0000000000000000, 0x03FF00FFFFFFFFFF, 0x0000000000000000,
+        0x000303FFFFFFFFFF, 0x0000000000000000, 0x00031BFFFFFFFFFF, 0x0000000000000000,
+        0xFFFF00801FFFFFFF, 0xFFFF00000000003F, 0xFFFF00801FFFFFFF, 0xFFFF00000001FFFF,
+        0xFFFF000000000003, 0x007FFFFF0000001F, 0xFFFF00000000003F, 0x007FFFFF0000001F,
+        0x00FFFFFFFFFFFFF8, 0x0026000000000000, 0xFFFFFFFFFFFFFFFF, 0x803FFFC00000007F,
+        0x0000FFFFFFFFFFF8, 0x000001FFFFFF0000, 0x07FFFFFFFFFFFFFF, 0x03FF01FFFFFF0004,
+        0x0000007FFFFFFFF8, 0x0047FFFFFFFF0090, 0xFFDFFFFFFFFFFFFF, 0x004FFFFFFFFF00F0,
+        0x0007FFFFFFFFFFF8, 0x000000001400001E, 0xFFFFFFFFFFFFFFFF, 0x0000000017FFDE1F,
+        0x00000FFFFFFBFFFF, 0x0000000000000000, 0x40FFFFFFFFFBFFFF, 0x0000000000000000,
+        0xFFFF01FFBFFFBD7F, 0x000000007FFFFFFF, 0xFFFF01FFBFFFBD7F, 0x03FF07FFFFFFFFFF,
+        0x23EDFDFFFFF99FE0, 0x00000003E0010000, 0xFBEDFDFFFFF99FEF, 0x001F1FCFE081399F,
+        0x001FFFFFFFFFFFFF, 0x0000000380000780, 0xFFFFFFFFFFFFFFFF, 0x00000003C3FF07FF,
+        0x0000FFFFFFFFFFFF, 0x00000000000000B0, 0xFFFFFFFFFFFFFFFF, 0x0000000003FF00BF,
+        0x00007FFFFFFFFFFF, 0x000000000F000000, 0xFF3FFFFFFFFFFFFF, 0x000000003F000001,
+        0x0000FFFFFFFFFFFF, 0x0000000000000010, 0xFFFFFFFFFFFFFFFF, 0x0000000003FF0011,
+        0x010007FFFFFFFFFF, 0x0000000000000000, 0x01FFFFFFFFFFFFFF, 0x00000000000003FF,
+        0x0000000007FFFFFF, 0x000000000000007F, 0x03FF0FFFE7FFFFFF, 0x000000000000007F,
+        0x00000FFFFFFFFFFF, 0x0000000000000000, 0x07FFFFFFFFFFFFFF, 0x0000000000000000,
+        0xFFFFFFFF00000000, 0x80000000FFFFFFFF, 0xFFFFFFFF00000000, 0x800003FFFFFFFFFF,
+        0x8000FFFFFF6FF27F, 0x0000000000000002, 0xF9BFFFFFFF6FF27F, 0x0000000003FF000F,
+        0xFFFFFCFF00000000, 0x0000000A0001FFFF, 0xFFFFFCFF00000000, 0x0000001BFCFFFFFF,
+        0x0407FFFFFFFFF801, 0xFFFFFFFFF0010000, 0x7FFFFFFFFFFFFFFF, 0xFFFFFFFFFFFF0080,
+        0xFFFF0000200003FF, 0x01FFFFFFFFFFFFFF, 0xFFFF000023FFFFFF, 0x01FFFFFFFFFFFFFF,
+        0x00007FFFFFFFFDFF, 0xFFFC000000000001, 0xFF7FFFFFFFFFFDFF, 0xFFFC000003FF0001,
+        0x000000000000FFFF, 0x0000000000000000, 0x007FFEFFFFFCFFFF, 0x0000000000000000,
+        0x0001FFFFFFFFFB7F, 0xFFFFFDBF00000040, 0xB47FFFFFFFFFFB7F, 0xFFFFFDBF03FF00FF,
+        0x00000000010003FF, 0x0000000000000000, 0x000003FF01FB7FFF, 0x0000000000000000,
+        0x0000000000000000, 0x0007FFFF00000000, 0x0000000000000000, 0x007FFFFF00000000,
+        0x0001000000000000, 0x0000000000000000, 0x0001000000000000, 0x0000000000000000,
+        0x0000000003FFFFFF, 0x0000000000000000, 0x0000000003FFFFFF, 0x0000000000000000,
+        0xFFFFFFFFFFFFFFFF, 0x00007FFFFFFFFFFF, 0xFFFFFFFFFFFFFFFF, 0x00007FFFFFFFFFFF,
+        0xFFFFFFFFFFFFFFFF, 0x000000000000000F, 0xFFFFFFFFFFFFFFFF, 0x000000000000000F,
+        0xFFFFFFFFFFFF0000, 0x0001FFFFFFFFFFFF, 0xFFFFFFFFFFFF0000, 0x0001FFFFFFFFFFFF,
+        0x00007FFFFFFFFFFF, 0x0000000000000000, 0x00007FFFFFFFFFFF, 0x0000000000000000,
+        0xFFFFFFFFFFFFFFFF, 0x000000000000007F, 0xFFFFFFFFFFFFFFFF, 0x000000000000007F,
+        0x01FFFFFFFFFFFFFF, 0xFFFF00007FFFFFFF, 0x01FFFFFFFFFFFFFF, 0xFFFF03FF7FFFFFFF,
+        0x7FFFFFFFFFFFFFFF, 0x00003FFFFFFF0000, 0x7FFFFFFFFFFFFFFF, 0x001F3FFFFFFF03FF,
+        0x0000FFFFFFFFFFFF, 0xE0FFFFF80000000F, 0x007FFFFFFFFFFFFF, 0xE0FFFFF803FF000F,
+        0x000000000000FFFF, 0x0000000000000000, 0x000000000000FFFF, 0x0000000000000000,
+        0x0000000000000000, 0xFFFFFFFFFFFFFFFF, 0x0000000000000000, 0xFFFFFFFFFFFFFFFF,
+        0xFFFFFFFFFFFFFFFF, 0x00000000000107FF, 0xFFFFFFFFFFFFFFFF, 0xFFFFFFFFFFFF87FF,
+        0x00000000FFF80000, 0x0000000B00000000, 0x00000000FFFF80FF, 0x0003001B00000000,
+        0xFFFFFFFFFFFFFFFF, 0x00FFFFFFFFFFFFFF, 0xFFFFFFFFFFFFFFFF, 0x00FFFFFFFFFFFFFF,
+        0xFFFFFFFFFFFFFFFF, 0x00000000003FFFFF, 0xFFFFFFFFFFFFFFFF, 0x00000000003FFFFF,
+        0x0000000000000000, 0x6FEF000000000000, 0x0000000000000000, 0x6FEF000000000000,
+        0x00000007FFFFFFFF, 0xFFFF00F000070000, 0x00000007FFFFFFFF, 0xFFFF00F000070000,
+        0xFFFFFFFFFFFFFFFF, 0x0FFFFFFFFFFFFFFF, 0xFFFFFFFFFFFFFFFF, 0x0FFFFFFFFFFFFFFF,
+        0xFFFFFFFFFFFFFFFF, 0x1FFF07FFFFFFFFFF, 0xFFFFFFFFFFFFFFFF, 0x1FFF07FFFFFFFFFF,
+        0x0000000003FF01FF, 0x0000000000000000, 0x0000000063FF01FF, 0x0000000000000000,
+        0x0000000000000000, 0x0000000000000000, 0xFFFF3FFFFFFFFFFF, 0x000000000000007F,
+        0x0000000000000000, 0x0000000000000000, 0x0000000000000000, 0xF807E3E000000000,
+        0x0000000000000000, 0x0000000000000000, 0x00003C0000000FE7, 0x0000000000000000,
+        0x0000000000000000, 0x0000000000000000, 0x0000000000000000, 0x000000000000001C,
+        0xFFFFFFFFFFFFFFFF, 0xFFFFFFFFFFDFFFFF, 0xFFFFFFFFFFFFFFFF, 0xFFFFFFFFFFDFFFFF,
+        0xEBFFDE64DFFFFFFF, 0xFFFFFFFFFFFFFFEF, 0xEBFFDE64DFFFFFFF, 0xFFFFFFFFFFFFFFEF,
+        0x7BFFFFFFDFDFE7BF, 0xFFFFFFFFFFFDFC5F, 0x7BFFFFFFDFDFE7BF, 0xFFFFFFFFFFFDFC5F,
+        0xFFFFFF3FFFFFFFFF, 0xF7FFFFFFF7FFFFFD, 0xFFFFFF3FFFFFFFFF, 0xF7FFFFFFF7FFFFFD,
+        0xFFDFFFFFFFDFFFFF, 0xFFFF7FFFFFFF7FFF, 0xFFDFFFFFFFDFFFFF, 0xFFFF7FFFFFFF7FFF,
+        0xFFFFFDFFFFFFFDFF, 0x0000000000000FF7, 0xFFFFFDFFFFFFFDFF, 0xFFFFFFFFFFFFCFF7,
+        0x0000000000000000, 0x0000000000000000, 0xF87FFFFFFFFFFFFF, 0x00201FFFFFFFFFFF,
+        0x0000000000000000, 0x0000000000000000, 0x0000FFFEF8000010, 0x0000000000000000,
+        0x000000007FFFFFFF, 0x0000000000000000, 0x000000007FFFFFFF, 0x0000000000000000,
+        0x0000000000000000, 0x0000000000000000, 0x000007DBF9FFFF7F, 0x0000000000000000,
+        0x3F801FFFFFFFFFFF, 0x0000000000004000, 0x3FFF1FFFFFFFFFFF, 0x00000000000043FF,
+        0x00003FFFFFFF0000, 0x00000FFFFFFFFFFF, 0x00007FFFFFFF0000, 0x03FFFFFFFFFFFFFF,
+        0x0000000000000000, 0x7FFF6F7F00000000, 0x0000000000000000, 0x7FFF6F7F00000000,
+        0xFFFFFFFFFFFFFFFF, 0x000000000000001F, 0xFFFFFFFFFFFFFFFF, 0x00000000007F001F,
+        0xFFFFFFFFFFFFFFFF, 0x000000000000080F, 0xFFFFFFFFFFFFFFFF, 0x0000000003FF0FFF,
+        0x0AF7FE96FFFFFFEF, 0x5EF7F796AA96EA84, 0x0AF7FE96FFFFFFEF, 0x5EF7F796AA96EA84,
+        0x0FFFFBEE0FFFFBFF, 0x0000000000000000, 0x0FFFFBEE0FFFFBFF, 0x0000000000000000,
+        0x0000000000000000, 0x0000000000000000, 0x0000000000000000, 0x03FF000000000000,
+        0xFFFFFFFFFFFFFFFF, 0x00000000FFFFFFFF, 0xFFFFFFFFFFFFFFFF, 0x00000000FFFFFFFF,
+        0x01FFFFFFFFFFFFFF, 0xFFFFFFFFFFFFFFFF, 0x01FFFFFFFFFFFFFF, 0xFFFFFFFFFFFFFFFF,
+        0xFFFFFFFF3FFFFFFF, 0xFFFFFFFFFFFFFFFF, 0xFFFFFFFF3FFFFFFF, 0xFFFFFFFFFFFFFFFF,
+        0xFFFF0003FFFFFFFF, 0xFFFFFFFFFFFFFFFF, 0xFFFF0003FFFFFFFF, 0xFFFFFFFFFFFFFFFF,
+        0xFFFFFFFFFFFFFFFF, 0x00000001FFFFFFFF, 0xFFFFFFFFFFFFFFFF, 0x00000001FFFFFFFF,
+        0x000000003FFFFFFF, 0x0000000000000000, 0x000000003FFFFFFF, 0x0000000000000000,
+        0xFFFFFFFFFFFFFFFF, 0x00000000000007FF, 0xFFFFFFFFFFFFFFFF, 0x00000000000007FF,
+        0x0000000000000000, 0x0000000000000000, 0xFFFFFFFFFFFFFFFF, 0xFFFFFFFFFFFFFFFF,
+        0x0000000000000000, 0x0000000000000000, 0xFFFFFFFFFFFFFFFF, 0x0000FFFFFFFFFFFF,
+    };
+}
+#endif
@@ -0,0 +1,300 @@
+#ifndef FENNTON_SIMD_HPP
+#define FENNTON_SIMD_HPP
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+// SSE2 is part of the x86-64 baseline, so it is only missing on 32-bit x86 built without it
+// and on other architectures, which use the scalar fallbacks.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define FENNTON_SIMD_SSE2 1
+    #include <emmintrin.h>
+#endif
+// AVX2 is only used when the compiler is allowed to target it (such as with `-mavx2` or
+// `/arch:AVX2`), as there is no runtime dispatch.
+#if defined(__AVX2__)
+    #define FENNTON_SIMD_AVX2 1
+    #include <immintrin.h>
+#endif
+
+namespace Fennton::Simd {
+    // Inclusive range of characters, from first to last.
+    struct CharRange {
+        char first;
+        char last;
+    };
+    // Returns true if the character is inside the range.
+    constexpr bool inRange(char c, CharRange range) {
+        return
+            static_cast<unsigned char>(c - range.first)
+            <= static_cast<unsigned char>(range.last - range.first)
+        ;
+    }
+    #ifdef FENNTON_SIMD_SSE2
+    // Returns a mask with all bits set in the lanes whose characters are inside the range.
+    inline __m128i inRange(__m128i chunk, CharRange range) {
+        // Shifts the range to start at zero, so that a single unsigned comparison (done
+        // through the minimum, as SSE2 has no unsigned comparisons) checks both bounds.
+        __m128i _shifted = _mm_sub_epi8(chunk, _mm_set1_epi8(range.first));
+        __m128i _last = _mm_set1_epi8(static_cast<char>(range.last - range.first));
+        return _mm_cmpeq_epi8(_mm_min_epu8(_shifted, _last), _shifted);
+    }
+    #endif
+    #ifdef FENNTON_SIMD_AVX2
+    // Same as the SSE2 version, but for 32 characters.
+    inline __m256i inRange(__m256i chunk, CharRange range) {
+        __m256i _shifted = _mm256_sub_epi8(chunk, _mm256_set1_epi8(range.first));
+        __m256i _last = _mm256_set1_epi8(static_cast<char>(range.last - range.first));
+        return _mm256_cmpeq_epi8(_mm256_min_epu8(_shifted, _last), _shifted);
+    }
+    #endif
+    // Returns a pointer to the first character in [it, end) which is not inside any of the
+    // ranges, or end if there is none. Processes 32 characters at a time with AVX2 and 16 
+    // with SSE2, so it is meant for runs which might be long.
+    template<typename... R> char const* findNotInRanges(
+        char const* it,
+        char const* end,
+        R... ranges
+    ) {
+        #ifdef FENNTON_SIMD_AVX2
+        while (end - it >= 32) {
+            __m256i _chunk = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(it));
+            __m256i _in = _mm256_setzero_si256();
+            ((_in = _mm256_or_si256(_in, inRange(_chunk, ranges))), ...);
+            std::uint32_t _mask = static_cast<std::uint32_t>(_mm256_movemask_epi8(_in));
+            if (_mask != 0xFFFFFFFFu) {
+                return it + std::countr_one(_mask);
+            }
+            it += 32;
+        }
+        #endif
+        #ifdef FENNTON_SIMD_SSE2
+        while (end - it >= 16) {
+            __m128i _chunk = _mm_loadu_si128(reinterpret_cast<__m128i const*>(it));
+            __m128i _in = _mm_setzero_si128();
+            ((_in = _mm_or_si128(_in, inRange(_chunk, ranges))), ...);
+            // One bit per character, set if the character is inside one of the ranges.
+            unsigned _mask = static_cast<unsigned>(_mm_movemask_epi8(_in));
+            if (_mask != 0xFFFFu) {
+                return it + std::countr_one(_mask);
+            }
+            it += 16;
+        }
+        #endif
+        while (it != end && (inRange(*it, ranges) || ...)) {
+            ++it;
+        }
+        return it;
+    }
+    // Returns a pointer to the first character in [it, end) which is outside ASCII (whose 
+    // highest bit is set), or end if there is none.
+    inline char const* findNonAscii(char const* it, char const* end) {
+        #ifdef FENNTON_SIMD_AVX2
+        while (end - it >= 32) {
+            __m256i _chunk = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(it));
+            // The highest bit of each character is its sign, which is all movemask reads.
+            std::uint32_t _mask = static_cast<std::uint32_t>(_mm256_movemask_epi8(_chunk));
+            if (_mask != 0) {
+                return it + std::countr_zero(_mask);
+            }
+            it += 32;
+        }
+        #endif
+        #ifdef FENNTON_SIMD_SSE2
+        while (end - it >= 16) {
+            __m128i _chunk = _mm_loadu_si128(reinterpret_cast<__m128i const*>(it));
+            unsigned _mask = static_cast<unsigned>(_mm_movemask_epi8(_chunk));
+            if (_mask != 0) {
+                return it + std::countr_zero(_mask);
+            }
+            it += 16;
+        }
+        #endif
+        while (it != end && static_cast<unsigned char>(*it) < 0x80) {
+            ++it;
+        }
+        return it;
+    }
+    // Returns a pointer to the first occurrence of the character in [it, end), or end if 
+    // there is none.
+    inline char const* findChar(char const* it, char const* end, char c) {
+        #ifdef FENNTON_SIMD_AVX2
+        __m256i const _c32 = _mm256_set1_epi8(c);
+        while (end - it >= 32) {
+            __m256i _chunk = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(it));
+            std::uint32_t _mask = static_cast<std::uint32_t>(
+                _mm256_movemask_epi8(_mm256_cmpeq_epi8(_chunk, _c32))
+            );
+            if (_mask != 0) {
+                return it + std::countr_zero(_mask);
+            }
+            it += 32;
+        }
+        #endif
+        #ifdef FENNTON_SIMD_SSE2
+        __m128i const _c16 = _mm_set1_epi8(c);
+        while (end - it >= 16) {
+            __m128i _chunk = _mm_loadu_si128(reinterpret_cast<__m128i const*>(it));
+            unsigned _mask = static_cast<unsigned>(
+                _mm_movemask_epi8(_mm_cmpeq_epi8(_chunk, _c16))
+            );
+            if (_mask != 0) {
+                return it + std::countr_zero(_mask);
+            }
+            it += 16;
+        }
+        #endif
+        while (it != end && *it != c) {
+            ++it;
+        }
+        return it;
+    }
+    // Returns the number of occurrences of the character in [it, end).
+    inline std::size_t countChar(char const* it, char const* end, char c) {
+        std::size_t _count = 0;
+        #ifdef FENNTON_SIMD_AVX2
+        __m256i const _c32 = _mm256_set1_epi8(c);
+        while (end - it >= 32) {
+            __m256i _chunk = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(it));
+            _count += static_cast<std::size_t>(std::popcount(static_cast<std::uint32_t>(
+                _mm256_movemask_epi8(_mm256_cmpeq_epi8(_chunk, _c32))
+            )));
+            it += 32;
+        }
+        #endif
+        #ifdef FENNTON_SIMD_SSE2
+        __m128i const _c16 = _mm_set1_epi8(c);
+        while (end - it >= 16) {
+            __m128i _chunk = _mm_loadu_si128(reinterpret_cast<__m128i const*>(it));
+            _count += static_cast<std::size_t>(std::popcount(static_cast<unsigned>(
+                _mm_movemask_epi8(_mm_cmpeq_epi8(_chunk, _c16))
+            )));
+            it += 16;
+        }
+        #endif
+        for (; it != end; ++it) {
+            _count += (*it == c)? 1 : 0;
+        }
+        return _count;
+    }
+    // Calls the function with a pointer to each occurrence of the character in [it, end), in 
+    // order.
+    template<typename F> void forEachChar(char const* it, char const* end, char c, F&& function) {
+        #ifdef FENNTON_SIMD_AVX2
+        __m256i const _c32 = _mm256_set1_epi8(c);
+        while (end - it >= 32) {
+            __m256i _chunk = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(it));
+            std::uint32_t _mask = static_cast<std::uint32_t>(
+                _mm256_movemask_epi8(_mm256_cmpeq_epi8(_chunk, _c32))
+            );
+            // Visits the set bits from the lowest, clearing each one after it.
+            for (; _mask != 0; _mask &= _mask - 1) {
+                function(it + std::countr_zero(_mask));
+            }
+            it += 32;
+        }
+        #endif
+        #ifdef FENNTON_SIMD_SSE2
+        __m128i const _c16 = _mm_set1_epi8(c);
+        while (end - it >= 16) {
+            __m128i _chunk = _mm_loadu_si128(reinterpret_cast<__m128i const*>(it));
+            unsigned _mask = static_cast<unsigned>(
+                _mm_movemask_epi8(_mm_cmpeq_epi8(_chunk, _c16))
+            );
+            for (; _mask != 0; _mask &= _mask - 1) {
+                function(it + std::countr_zero(_mask));
+            }
+            it += 16;
+        }
+        #endif
+        for (; it != end; ++it) {
+            if (*it == c) {
+                function(it);
+            }
+        }
+    }
+    // Returns a pointer to the first occurrence of any of the characters in [it, end), or end 
+    // if there is none.
+    template<typename... C> char const* findAnyOf(char const* it, char const* end, C... chars) {
+        #ifdef FENNTON_SIMD_AVX2
+        while (end - it >= 32) {
+            __m256i _chunk = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(it));
+            __m256i _any = _mm256_setzero_si256();
+            ((_any = _mm256_or_si256(
+                _any, _mm256_cmpeq_epi8(_chunk, _mm256_set1_epi8(chars))
+            )), ...);
+            std::uint32_t _mask = static_cast<std::uint32_t>(_mm256_movemask_epi8(_any));
+            if (_mask != 0) {
+                return it + std::countr_zero(_mask);
+            }
+            it += 32;
+        }
+        #endif
+        #ifdef FENNTON_SIMD_SSE2
+        while (end - it >= 16) {
+            __m128i _chunk = _mm_loadu_si128(reinterpret_cast<__m128i const*>(it));
+            __m128i _any = _mm_setzero_si128();
+            ((_any = _mm_or_si128(_any, _mm_cmpeq_epi8(_chunk, _mm_set1_epi8(chars)))), ...);
+            unsigned _mask = static_cast<unsigned>(_mm_movemask_epi8(_any));
+            if (_mask != 0) {
+                return it + std::countr_zero(_mask);
+            }
+            it += 16;
+        }
+        #endif
+        while (it != end && !((*it == chars) || ...)) {
+            ++it;
+        }
+        return it;
+    }
+    // Returns a pointer to the first occurrence of the first character immediately followed 
+    // by the second in [it, end), or end if there is none.
+    inline char const* findPair(char const* it, char const* end, char first, char second) {
+        // Compares each chunk with the first character and the chunk starting one character 
+        // later with the second, so both loads must fit before the end.
+        #ifdef FENNTON_SIMD_AVX2
+        __m256i const _first32 = _mm256_set1_epi8(first);
+        __m256i const _second32 = _mm256_set1_epi8(second);
+        while (end - it >= 33) {
+            __m256i _chunk = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(it));
+            __m256i _next = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(it + 1));
+            std::uint32_t _mask = static_cast<std::uint32_t>(_mm256_movemask_epi8(
+                _mm256_and_si256(
+                    _mm256_cmpeq_epi8(_chunk, _first32),
+                    _mm256_cmpeq_epi8(_next, _second32)
+                )
+            ));
+            if (_mask != 0) {
+                return it + std::countr_zero(_mask);
+            }
+            it += 32;
+        }
+        #endif
+        #ifdef FENNTON_SIMD_SSE2
+        __m128i const _first16 = _mm_set1_epi8(first);
+        __m128i const _second16 = _mm_set1_epi8(second);
+        while (end - it >= 17) {
+            __m128i _chunk = _mm_loadu_si128(reinterpret_cast<__m128i const*>(it));
+            __m128i _next = _mm_loadu_si128(reinterpret_cast<__m128i const*>(it + 1));
+            unsigned _mask = static_cast<unsigned>(_mm_movemask_epi8(
+                _mm_and_si128(_mm_cmpeq_epi8(_chunk, _first16), _mm_cmpeq_epi8(_next, _second16))
+            ));
+            if (_mask != 0) {
+                return it + std::countr_zero(_mask);
+            }
+            it += 16;
+        }
+        #endif
+        if (it == end) {
+            return end;
+        }
+        for (; it + 1 != end; ++it) {
+            if (it[0] == first && it[1] == second) {
+                return it;
+            }
+        }
+        return end;
+    }
+}
+#endif
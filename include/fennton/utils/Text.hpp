@@ -4,6 +4,9 @@
 #include <string>
 
 namespace Fennton::Text {
+    // Returns the character following the backslash in the escape sequence of the character 
+    // (such as `n` for a line break), or the null character if it is not escaped.
+    char escapeSimpleChar(char c);
     // Returns the string with all the characters which need escaping replaced with their C++ 
     // escape sequences.
     std::string escape(std::string const& str);
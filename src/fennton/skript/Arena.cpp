@@ -0,0 +1,65 @@
+#include <fennton/skript/Arena.hpp>
+#include <algorithm>
+#include <utility>
+#include <cstdint>
+
+namespace Fennton::Skript {
+    void Arena::grow(std::size_t size) {
+        blockSize = std::max(blockSize == 0? firstBlockSize : blockSize * 2, size);
+        // Not value-initialised, as the memory is only ever handed out uninitialised.
+        blocks.emplace_back(new std::byte[blockSize]);
+        blockIt = blocks.back().get();
+        blockLeft = blockSize;
+        capacity += blockSize;
+    }
+    Arena::Arena(Arena&& other) noexcept
+        : blocks(std::move(other.blocks)),
+        blockSize(std::exchange(other.blockSize, 0)),
+        blockIt(std::exchange(other.blockIt, nullptr)),
+        blockLeft(std::exchange(other.blockLeft, 0)),
+        capacity(std::exchange(other.capacity, 0)) {
+        other.blocks.clear();
+    }
+    Arena& Arena::operator=(Arena&& other) noexcept {
+        if (this != &other) {
+            blocks = std::move(other.blocks);
+            other.blocks.clear();
+            blockSize = std::exchange(other.blockSize, 0);
+            blockIt = std::exchange(other.blockIt, nullptr);
+            blockLeft = std::exchange(other.blockLeft, 0);
+            capacity = std::exchange(other.capacity, 0);
+        }
+        return *this;
+    }
+    void* Arena::Allocate(std::size_t size, std::size_t alignment) {
+        std::size_t _padding = -reinterpret_cast<std::uintptr_t>(blockIt) & (alignment - 1);
+        if (_padding + size > blockLeft) {
+            // The new block might not be aligned enough, so it has room for the padding.
+            grow(size + alignment - 1);
+            _padding = -reinterpret_cast<std::uintptr_t>(blockIt) & (alignment - 1);
+        }
+        std::byte* const _data = blockIt + _padding;
+        blockIt = _data + size;
+        blockLeft -= _padding + size;
+        return _data;
+    }
+    void Arena::Reset() {
+        if (blocks.empty()) {
+            return;
+        }
+        if (blocks.size() > 1) {
+            // Replaced by a single block as large as all of them, so that allocating as much
+            // again only needs that block.
+            std::size_t const _capacity = capacity;
+            blocks.clear();
+            blocks.emplace_back(new std::byte[_capacity]);
+            blockSize = _capacity;
+        }
+        blockIt = blocks.front().get();
+        blockLeft = blockSize;
+        capacity = blockSize;
+    }
+    std::size_t Arena::GetCapacity() const {
+        return capacity;
+    }
+}
@@ -0,0 +1,434 @@
+#include <fennton/skript/Ast.hpp>
+#include <fennton/utils/Text.hpp>
+#include <algorithm>
+#include <charconv>
+#include <format>
+#include <bit>
+#include <stdexcept>
+
+namespace Fennton::Skript {
+    using Tokeniser::TokenStream;
+    using Tokeniser::Kind;
+    using Tokeniser::Span;
+    using Tokeniser::Operator;
+    using Tokeniser::ValueKind;
+    using Tokeniser::SuffixType;
+    using Tokeniser::NumberPayload;
+
+    // Binding power of the binary operators, from the loosest (1) to the tightest, or 0 for
+    // the operators which are not binary.
+    static int bindingPower(Operator op) {
+        switch (op) {
+            case Operator::Equal:
+            case Operator::NotEqual:
+                return 1;
+            case Operator::Less:
+            case Operator::Greater:
+            case Operator::LessEqual:
+            case Operator::GreaterEqual:
+                return 2;
+            case Operator::Plus:
+            case Operator::Minus:
+                return 3;
+            case Operator::Star:
+            case Operator::Slash:
+            case Operator::Percent:
+                return 4;
+            default:
+                return 0;
+        }
+    }
+    // Returns the first suffix in the text of the number, or an empty view if it has none. In
+    // base-16, the suffixes follow ".'", and in the other bases the first character which is
+    // neither a digit nor a radix.
+    static std::string_view firstSuffix(std::string_view text, NumberPayload const& number) {
+        std::size_t _start = number.base == 16
+            ? text.find(".'", number.bodyOffset)
+            : text.find_first_not_of("0123456789.", number.bodyOffset);
+        if (_start == std::string_view::npos) {
+            return {};
+        }
+        std::string_view const _suffixes = text.substr(number.base == 16? _start + 2 : _start);
+        return _suffixes.substr(0, _suffixes.find('\''));
+    }
+    // Returns the node kind of the binary operator.
+    static NodeKind binaryKind(Operator op) {
+        switch (op) {
+            case Operator::Equal: return NodeKind::Equal;
+            case Operator::NotEqual: return NodeKind::NotEqual;
+            case Operator::Less: return NodeKind::Less;
+            case Operator::Greater: return NodeKind::Greater;
+            case Operator::LessEqual: return NodeKind::LessEqual;
+            case Operator::GreaterEqual: return NodeKind::GreaterEqual;
+            case Operator::Plus: return NodeKind::Add;
+            case Operator::Minus: return NodeKind::Subtract;
+            case Operator::Star: return NodeKind::Multiply;
+            case Operator::Slash: return NodeKind::Divide;
+            default: return NodeKind::Remainder;
+        }
+    }
+    // Returns the spelling of the operator of the node kind.
+    static std::string_view operatorSpelling(NodeKind kind) {
+        switch (kind) {
+            case NodeKind::Negate: return "-";
+            case NodeKind::Add: return "+";
+            case NodeKind::Subtract: return "-";
+            case NodeKind::Multiply: return "*";
+            case NodeKind::Divide: return "/";
+            case NodeKind::Remainder: return "%";
+            case NodeKind::Less: return "<";
+            case NodeKind::Greater: return ">";
+            case NodeKind::LessEqual: return "<=";
+            case NodeKind::GreaterEqual: return ">=";
+            case NodeKind::Equal: return "==";
+            default: return "!=";
+        }
+    }
+    // Returns the spelling of the suffix, such as `u8`, or an empty string if there is none.
+    static std::string suffixSpelling(SuffixType type, std::uint16_t bits) {
+        switch (type) {
+            case SuffixType::Unsigned: return std::format("u{}", bits);
+            case SuffixType::Signed: return std::format("i{}", bits);
+            case SuffixType::Float: return std::format("f{}", bits);
+            default: return std::string();
+        }
+    }
+    // Parser of a range of tokens, which appends the nodes of each operation after those of
+    // its operands.
+    class ExpressionParser {
+    private:
+        // Deepest nesting of parentheses and unary operators, past which the parser would
+        // risk running out of stack.
+        static constexpr std::size_t maxDepth = 256;
+
+        TokenStream const& tokens;
+        Ast& ast;
+        std::size_t first;
+        std::size_t it;
+        std::size_t end;
+        std::size_t depth = 0;
+
+        // Throws the error at the offset in the source.
+        [[noreturn]] void fail(std::size_t offset, std::string const& message) const {
+            std::string_view const _source = tokens.GetSource();
+            SyntaxException _exception(message, _source.data() + offset);
+            _exception.Locate(_source);
+            throw _exception;
+        }
+        // Throws the error of a missing token at the current one, or at the end of the last
+        // token if there is none left.
+        [[noreturn]] void failExpected(std::string_view expected) const {
+            if (it == end) {
+                fail(endOffset(), std::format(
+                    "Expected {}, found the end of the expression.", expected
+                ));
+            }
+            fail(tokens.GetSpan(it).offset, std::format(
+                "Expected {}, found {}.", expected, Text::quote(std::string(tokens.GetText(it)))
+            ));
+        }
+        // Returns the offset after the last token parsed, or where the range starts if none
+        // was.
+        std::uint32_t endOffset() const {
+            if (it == first) {
+                return it != end? tokens.GetSpan(it).offset : 0;
+            }
+            Span const _span = tokens.GetSpan(it - 1);
+            return _span.offset + _span.length;
+        }
+        // Returns the span from the offset to the end of the last token parsed.
+        Span spanFrom(std::uint32_t offset) const {
+            return { offset, endOffset() - offset };
+        }
+        // Returns true if the current token is the punctuation.
+        bool isPunct(Operator op) const {
+            return
+                it != end && tokens.GetKind(it) == Kind::Punct && tokens.GetOperator(it) == op
+            ;
+        }
+        // Parses the number literal at the current token.
+        NodeIndex parseNumber() {
+            NumberPayload const& _number = tokens.GetNumber(it);
+            Span const _span = tokens.GetSpan(it);
+            std::string const _text(tokens.GetText(it));
+            if (_number.valueKind == ValueKind::None) {
+                fail(_span.offset, std::format(
+                    "Number {} has more than two parts, so it has no value.", Text::quote(_text)
+                ));
+            }
+            if (_number.valueKind == ValueKind::BigInteger) {
+                fail(_span.offset, std::format(
+                    "Integer {} does not fit in 64 bits.", Text::quote(_text)
+                ));
+            }
+            std::string_view const _suffix = firstSuffix(_text, _number);
+            if (_number.suffixType == SuffixType::None && !_suffix.empty()) {
+                // Suffixes which are not types, such as "e3" or "u0", would be dropped.
+                fail(
+                    _span.offset + static_cast<std::uint32_t>(_suffix.data() - _text.data()),
+                    std::format("Unknown suffix {}.", Text::quote(std::string(_suffix)))
+                );
+            }
+            if (_number.suffixType != SuffixType::None && !tokens.GetValue(it).Fits()) {
+                fail(_span.offset, std::format(
+                    "Number {} does not fit in the type of its suffix.", Text::quote(_text)
+                ));
+            }
+            Literal _literal{ _number.value, _number.suffixType, _number.suffixBits };
+            NodeKind _kind = NodeKind::Integer;
+            if (_number.valueKind == ValueKind::Float) {
+                _kind = NodeKind::Float;
+            } else if (_number.suffixType == SuffixType::Float) {
+                // Integers with a float suffix are floats.
+                _kind = NodeKind::Float;
+                _literal.value = std::bit_cast<std::uint64_t>(static_cast<double>(_literal.value));
+            }
+            ++it;
+            return ast.AppendLiteral(_kind, _span, _literal);
+        }
+        // Parses the operand starting at the current token: a literal, a name, a unary
+        // operation or an expression inside parentheses.
+        NodeIndex parsePrefix() {
+            if (it == end) {
+                failExpected("an expression");
+            }
+            Span const _span = tokens.GetSpan(it);
+            switch (tokens.GetKind(it)) {
+                case Kind::Number:
+                    return parseNumber();
+                case Kind::Name: {
+                    Symbol const _symbol = tokens.GetName(it);
+                    ++it;
+                    return ast.AppendName(_span, _symbol);
+                }
+                case Kind::Punct:
+                    break;
+                default:
+                    failExpected("an expression");
+            }
+            switch (tokens.GetOperator(it)) {
+                case Operator::Hash: {
+                    // Boolean literals are a name directly after the `#`.
+                    ++it;
+                    bool const _isName = it != end && tokens.GetKind(it) == Kind::Name;
+                    std::string_view const _name = _isName && !tokens.HasSpaceAfter(it - 1)
+                        ? tokens.GetText(it) : std::string_view();
+                    if (_name != "true" && _name != "false") {
+                        failExpected("\"true\" or \"false\" directly after \"#\"");
+                    }
+                    ++it;
+                    return ast.AppendBoolean(spanFrom(_span.offset), _name == "true");
+                }
+                case Operator::Minus: {
+                    ++it;
+                    enter();
+                    NodeIndex const _operand = parsePrefix();
+                    --depth;
+                    return ast.AppendUnary(NodeKind::Negate, spanFrom(_span.offset), _operand);
+                }
+                case Operator::LeftParen: {
+                    ++it;
+                    enter();
+                    NodeIndex const _inner = parse(1);
+                    --depth;
+                    if (!isPunct(Operator::RightParen)) {
+                        failExpected("\")\"");
+                    }
+                    ++it;
+                    return _inner;
+                }
+                default:
+                    failExpected("an expression");
+            }
+        }
+        // Goes one level deeper into the nesting, throwing if it is too deep.
+        void enter() {
+            if (++depth > maxDepth) {
+                fail(tokens.GetSpan(it - 1).offset, std::format(
+                    "Expression nested more than {} levels deep.", maxDepth
+                ));
+            }
+        }
+    public:
+        ExpressionParser(
+            TokenStream const& tokens,
+            Ast& ast,
+            std::size_t first,
+            std::size_t count
+        ) : tokens(tokens), ast(ast), first(first), it(first), end(first + count) {}
+        // Parses the expression starting at the current token whose binary operators bind
+        // at least as tightly as the minimum power, and returns the index of its root.
+        NodeIndex parse(int minPower) {
+            std::uint32_t const _offset = it != end? tokens.GetSpan(it).offset : endOffset();
+            NodeIndex _left = parsePrefix();
+            // Operators of the same power loop instead of recursing, so that they are
+            // left-associative and long chains use no stack.
+            while (it != end && tokens.GetKind(it) == Kind::Punct) {
+                Operator const _op = tokens.GetOperator(it);
+                int const _power = bindingPower(_op);
+                if (_power < minPower || _power == 0) {
+                    break;
+                }
+                ++it;
+                NodeIndex const _right = parse(_power + 1);
+                _left = ast.AppendBinary(binaryKind(_op), spanFrom(_offset), _left, _right);
+            }
+            return _left;
+        }
+        // Parses the whole range as one expression.
+        NodeIndex ParseAll() {
+            NodeIndex const _root = parse(1);
+            if (it != end) {
+                failExpected("an operator");
+            }
+            return _root;
+        }
+    };
+
+    Ast::Ast(Arena& arena, std::size_t capacity, std::size_t literalCapacity) {
+        // Node indices are 32-bit, and noNode is not one of them.
+        if (capacity >= noNode || literalCapacity >= noNode) {
+            throw std::length_error(std::format(
+                "Tree of {} nodes and {} literals is too large.", capacity, literalCapacity
+            ));
+        }
+        spans = arena.Allocate<Span>(capacity);
+        lefts = arena.Allocate<NodeIndex>(capacity);
+        rights = arena.Allocate<NodeIndex>(capacity);
+        literals = arena.Allocate<Literal>(literalCapacity);
+        kinds = arena.Allocate<NodeKind>(capacity);
+        this->capacity = static_cast<std::uint32_t>(capacity);
+        this->literalCapacity = static_cast<std::uint32_t>(literalCapacity);
+    }
+    NodeIndex Ast::append(NodeKind kind, Span span, NodeIndex left, NodeIndex right) {
+        if (size == capacity) {
+            throw std::length_error(std::format("Tree with room for {} nodes is full.", capacity));
+        }
+        kinds[size] = kind;
+        spans[size] = span;
+        lefts[size] = left;
+        rights[size] = right;
+        return size++;
+    }
+    std::size_t Ast::Size() const {
+        return size;
+    }
+    bool Ast::Empty() const {
+        return size == 0;
+    }
+    NodeIndex Ast::GetRoot() const {
+        return size == 0? noNode : size - 1;
+    }
+    NodeKind Ast::GetKind(NodeIndex index) const {
+        return kinds[index];
+    }
+    Span Ast::GetSpan(NodeIndex index) const {
+        return spans[index];
+    }
+    NodeIndex Ast::GetLeft(NodeIndex index) const {
+        return lefts[index];
+    }
+    NodeIndex Ast::GetRight(NodeIndex index) const {
+        return rights[index];
+    }
+    std::uint32_t Ast::GetPayload(NodeIndex index) const {
+        return lefts[index];
+    }
+    Literal const& Ast::GetLiteral(NodeIndex index) const {
+        return literals[lefts[index]];
+    }
+    bool Ast::GetBoolean(NodeIndex index) const {
+        return lefts[index] != 0;
+    }
+    Symbol Ast::GetName(NodeIndex index) const {
+        return Symbol{ lefts[index] };
+    }
+    std::span<NodeKind const> Ast::GetKinds() const {
+        return { kinds, size };
+    }
+    std::span<NodeIndex const> Ast::GetLefts() const {
+        return { lefts, size };
+    }
+    std::span<NodeIndex const> Ast::GetRights() const {
+        return { rights, size };
+    }
+    std::string Ast::GetSpelling(NodeIndex index) const {
+        switch (kinds[index]) {
+            case NodeKind::Integer: {
+                Literal const& _literal = GetLiteral(index);
+                return std::to_string(_literal.value)
+                    + suffixSpelling(_literal.suffixType, _literal.suffixBits);
+            }
+            case NodeKind::Float: {
+                Literal const& _literal = GetLiteral(index);
+                // Spelled without an exponent, which number literals do not have, and with
+                // the fewest digits which read back as the same value.
+                char _buffer[400];
+                char* const _end = std::to_chars(
+                    _buffer, _buffer + sizeof(_buffer),
+                    std::bit_cast<double>(_literal.value), std::chars_format::fixed
+                ).ptr;
+                std::string _spelling(_buffer, _end);
+                if (_spelling.find('.') == std::string::npos) {
+                    _spelling += ".0";
+                }
+                return _spelling + suffixSpelling(_literal.suffixType, _literal.suffixBits);
+            }
+            case NodeKind::Boolean:
+                return GetBoolean(index)? "#true" : "#false";
+            case NodeKind::Name:
+                return std::string(globalSymbols().GetSpelling(GetName(index)));
+            case NodeKind::Negate:
+                return std::format("(-{})", GetSpelling(lefts[index]));
+            default:
+                return std::format(
+                    "({} {} {})",
+                    GetSpelling(lefts[index]),
+                    operatorSpelling(kinds[index]),
+                    GetSpelling(rights[index])
+                );
+        }
+    }
+    std::string Ast::GetSpelling() const {
+        return size == 0? std::string() : GetSpelling(GetRoot());
+    }
+    NodeIndex Ast::AppendLiteral(NodeKind kind, Span span, Literal const& literal) {
+        if (literalCount == literalCapacity) {
+            throw std::length_error(std::format(
+                "Tree with room for {} literals is full.", literalCapacity
+            ));
+        }
+        if (size == capacity) {
+            throw std::length_error(std::format("Tree with room for {} nodes is full.", capacity));
+        }
+        literals[literalCount] = literal;
+        return append(kind, span, literalCount++, noNode);
+    }
+    NodeIndex Ast::AppendBoolean(Span span, bool value) {
+        return append(NodeKind::Boolean, span, value? 1 : 0, noNode);
+    }
+    NodeIndex Ast::AppendName(Span span, Symbol symbol) {
+        return append(NodeKind::Name, span, symbol.id, noNode);
+    }
+    NodeIndex Ast::AppendUnary(NodeKind kind, Span span, NodeIndex operand) {
+        return append(kind, span, operand, noNode);
+    }
+    NodeIndex Ast::AppendBinary(NodeKind kind, Span span, NodeIndex left, NodeIndex right) {
+        return append(kind, span, left, right);
+    }
+
+    Ast parseExpression(TokenStream const& tokens, Arena& arena) {
+        return parseExpression(tokens, 0, tokens.Size(), arena);
+    }
+    Ast parseExpression(
+        TokenStream const& tokens,
+        std::size_t first,
+        std::size_t count,
+        Arena& arena
+    ) {
+        std::span<Kind const> const _kinds = tokens.GetKinds().subspan(first, count);
+        Ast _ast(arena, count, std::count(_kinds.begin(), _kinds.end(), Kind::Number));
+        ExpressionParser(tokens, _ast, first, count).ParseAll();
+        return _ast;
+    }
+}
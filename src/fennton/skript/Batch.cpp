@@ -0,0 +1,440 @@
+#include <fennton/skript/Bytecode.hpp>
+#include <fennton/utils/Simd.hpp>
+#include <algorithm>
+#include <array>
+#include <vector>
+#include <format>
+#include <cstring>
+#include <stdexcept>
+
+namespace Fennton::Skript {
+    // Number of entities whose registers are computed by each instruction at once, so that
+    // each register takes 2 KiB and the registers of most programs fit in the L1 cache.
+    static constexpr std::size_t blockLanes = 256;
+
+    ColumnKind Column::GetKind() const {
+        return kind;
+    }
+    std::size_t Column::Size() const {
+        return size;
+    }
+    void const* Column::GetData() const {
+        return data;
+    }
+
+    #ifdef FENNTON_SIMD_AVX2
+    // Returns true if AVX2 has the operation on 4 lanes of 64 bits.
+    static constexpr bool hasVector256(Opcode op) {
+        switch (op) {
+            case Opcode::Multiply:
+            case Opcode::DivideSigned:
+            case Opcode::DivideUnsigned:
+            case Opcode::RemainderSigned:
+            case Opcode::RemainderUnsigned:
+            case Opcode::RemainderFloat:
+            case Opcode::SignedToFloat:
+            case Opcode::UnsignedToFloat:
+            case Opcode::Return:
+                return false;
+            default:
+                return true;
+        }
+    }
+    // Returns the operation on 4 lanes, where b is the bit count of wraps. Comparisons set
+    // all the bits of the lanes where they are true, which are masked down to 1.
+    template<Opcode op> static __m256i vector256(__m256i a, __m256i b, unsigned bits) {
+        __m256i const _one = _mm256_set1_epi64x(1);
+        __m256i const _sign = _mm256_set1_epi64x(std::int64_t(1) << 63);
+        auto const _pd = [](__m256i v) { return _mm256_castsi256_pd(v); };
+        auto const _si = [](__m256d v) { return _mm256_castpd_si256(v); };
+        if constexpr (op == Opcode::Add) {
+            return _mm256_add_epi64(a, b);
+        } else if constexpr (op == Opcode::Subtract) {
+            return _mm256_sub_epi64(a, b);
+        } else if constexpr (op == Opcode::Negate) {
+            return _mm256_sub_epi64(_mm256_setzero_si256(), a);
+        } else if constexpr (op == Opcode::LessSigned) {
+            return _mm256_and_si256(_mm256_cmpgt_epi64(b, a), _one);
+        } else if constexpr (op == Opcode::LessEqualSigned) {
+            return _mm256_andnot_si256(_mm256_cmpgt_epi64(a, b), _one);
+        } else if constexpr (op == Opcode::LessUnsigned) {
+            // Flipping the sign bits orders unsigned integers like signed ones.
+            __m256i const _greater = _mm256_cmpgt_epi64(
+                _mm256_xor_si256(b, _sign), _mm256_xor_si256(a, _sign)
+            );
+            return _mm256_and_si256(_greater, _one);
+        } else if constexpr (op == Opcode::LessEqualUnsigned) {
+            __m256i const _greater = _mm256_cmpgt_epi64(
+                _mm256_xor_si256(a, _sign), _mm256_xor_si256(b, _sign)
+            );
+            return _mm256_andnot_si256(_greater, _one);
+        } else if constexpr (op == Opcode::Equal) {
+            return _mm256_and_si256(_mm256_cmpeq_epi64(a, b), _one);
+        } else if constexpr (op == Opcode::NotEqual) {
+            return _mm256_andnot_si256(_mm256_cmpeq_epi64(a, b), _one);
+        } else if constexpr (op == Opcode::WrapUnsigned) {
+            return _mm256_and_si256(a, _mm256_set1_epi64x(
+                static_cast<std::int64_t>(~std::uint64_t(0) >> (64 - bits))
+            ));
+        } else if constexpr (op == Opcode::WrapSigned) {
+            // AVX2 has no arithmetic shift of 64 bits, so the sign bit of the width is
+            // extended by flipping it and subtracting it.
+            __m256i const _low = _mm256_and_si256(a, _mm256_set1_epi64x(
+                static_cast<std::int64_t>(~std::uint64_t(0) >> (64 - bits))
+            ));
+            __m256i const _top = _mm256_set1_epi64x(std::int64_t(1) << (bits - 1));
+            return _mm256_sub_epi64(_mm256_xor_si256(_low, _top), _top);
+        } else if constexpr (op == Opcode::AddFloat) {
+            return _si(_mm256_add_pd(_pd(a), _pd(b)));
+        } else if constexpr (op == Opcode::SubtractFloat) {
+            return _si(_mm256_sub_pd(_pd(a), _pd(b)));
+        } else if constexpr (op == Opcode::MultiplyFloat) {
+            return _si(_mm256_mul_pd(_pd(a), _pd(b)));
+        } else if constexpr (op == Opcode::DivideFloat) {
+            return _si(_mm256_div_pd(_pd(a), _pd(b)));
+        } else if constexpr (op == Opcode::NegateFloat) {
+            return _mm256_xor_si256(a, _sign);
+        } else if constexpr (op == Opcode::LessFloat) {
+            return _mm256_and_si256(_si(_mm256_cmp_pd(_pd(a), _pd(b), _CMP_LT_OQ)), _one);
+        } else if constexpr (op == Opcode::LessEqualFloat) {
+            return _mm256_and_si256(_si(_mm256_cmp_pd(_pd(a), _pd(b), _CMP_LE_OQ)), _one);
+        } else if constexpr (op == Opcode::EqualFloat) {
+            return _mm256_and_si256(_si(_mm256_cmp_pd(_pd(a), _pd(b), _CMP_EQ_OQ)), _one);
+        } else if constexpr (op == Opcode::NotEqualFloat) {
+            return _mm256_and_si256(_si(_mm256_cmp_pd(_pd(a), _pd(b), _CMP_NEQ_UQ)), _one);
+        } else {
+            static_assert(op == Opcode::RoundFloat32);
+            return _si(_mm256_cvtps_pd(_mm256_cvtpd_ps(_pd(a))));
+        }
+    }
+    #endif
+    #ifdef FENNTON_SIMD_SSE2
+    // Returns true if SSE2 has the operation on 2 lanes of 64 bits, which lacks the
+    // comparisons of 64-bit integers but their equality.
+    static constexpr bool hasVector128(Opcode op) {
+        switch (op) {
+            case Opcode::Add:
+            case Opcode::Subtract:
+            case Opcode::Negate:
+            case Opcode::Equal:
+            case Opcode::NotEqual:
+            case Opcode::WrapSigned:
+            case Opcode::WrapUnsigned:
+            case Opcode::AddFloat:
+            case Opcode::SubtractFloat:
+            case Opcode::MultiplyFloat:
+            case Opcode::DivideFloat:
+            case Opcode::NegateFloat:
+            case Opcode::LessFloat:
+            case Opcode::LessEqualFloat:
+            case Opcode::EqualFloat:
+            case Opcode::NotEqualFloat:
+            case Opcode::RoundFloat32:
+                return true;
+            default:
+                return false;
+        }
+    }
+    // Same as vector256, but on 2 lanes.
+    template<Opcode op> static __m128i vector128(__m128i a, __m128i b, unsigned bits) {
+        __m128i const _one = _mm_set1_epi64x(1);
+        __m128i const _sign = _mm_set1_epi64x(std::int64_t(1) << 63);
+        auto const _pd = [](__m128i v) { return _mm_castsi128_pd(v); };
+        auto const _si = [](__m128d v) { return _mm_castpd_si128(v); };
+        // Equality of 64 bits, as both halves are equal.
+        auto const _equal = [](__m128i a, __m128i b) {
+            __m128i const _halves = _mm_cmpeq_epi32(a, b);
+            return _mm_and_si128(_halves, _mm_shuffle_epi32(_halves, _MM_SHUFFLE(2, 3, 0, 1)));
+        };
+        if constexpr (op == Opcode::Add) {
+            return _mm_add_epi64(a, b);
+        } else if constexpr (op == Opcode::Subtract) {
+            return _mm_sub_epi64(a, b);
+        } else if constexpr (op == Opcode::Negate) {
+            return _mm_sub_epi64(_mm_setzero_si128(), a);
+        } else if constexpr (op == Opcode::Equal) {
+            return _mm_and_si128(_equal(a, b), _one);
+        } else if constexpr (op == Opcode::NotEqual) {
+            return _mm_andnot_si128(_equal(a, b), _one);
+        } else if constexpr (op == Opcode::WrapUnsigned) {
+            return _mm_and_si128(a, _mm_set1_epi64x(
+                static_cast<std::int64_t>(~std::uint64_t(0) >> (64 - bits))
+            ));
+        } else if constexpr (op == Opcode::WrapSigned) {
+            __m128i const _low = _mm_and_si128(a, _mm_set1_epi64x(
+                static_cast<std::int64_t>(~std::uint64_t(0) >> (64 - bits))
+            ));
+            __m128i const _top = _mm_set1_epi64x(std::int64_t(1) << (bits - 1));
+            return _mm_sub_epi64(_mm_xor_si128(_low, _top), _top);
+        } else if constexpr (op == Opcode::AddFloat) {
+            return _si(_mm_add_pd(_pd(a), _pd(b)));
+        } else if constexpr (op == Opcode::SubtractFloat) {
+            return _si(_mm_sub_pd(_pd(a), _pd(b)));
+        } else if constexpr (op == Opcode::MultiplyFloat) {
+            return _si(_mm_mul_pd(_pd(a), _pd(b)));
+        } else if constexpr (op == Opcode::DivideFloat) {
+            return _si(_mm_div_pd(_pd(a), _pd(b)));
+        } else if constexpr (op == Opcode::NegateFloat) {
+            return _mm_xor_si128(a, _sign);
+        } else if constexpr (op == Opcode::LessFloat) {
+            return _mm_and_si128(_si(_mm_cmplt_pd(_pd(a), _pd(b))), _one);
+        } else if constexpr (op == Opcode::LessEqualFloat) {
+            return _mm_and_si128(_si(_mm_cmple_pd(_pd(a), _pd(b))), _one);
+        } else if constexpr (op == Opcode::EqualFloat) {
+            return _mm_and_si128(_si(_mm_cmpeq_pd(_pd(a), _pd(b))), _one);
+        } else if constexpr (op == Opcode::NotEqualFloat) {
+            return _mm_and_si128(_si(_mm_cmpneq_pd(_pd(a), _pd(b))), _one);
+        } else {
+            static_assert(op == Opcode::RoundFloat32);
+            return _si(_mm_cvtps_pd(_mm_cvtpd_ps(_pd(a))));
+        }
+    }
+    #endif
+    // Returns true if the operation is an integer division or remainder.
+    static constexpr bool isIntegerDivision(Opcode op) {
+        return op >= Opcode::DivideSigned && op <= Opcode::RemainderUnsigned;
+    }
+    // Magnitude below which integers are divided through doubles, where the truncated
+    // quotient of two doubles is the exact quotient: a quotient which is not a whole number
+    // is at least 1/|b| away from one, more than the rounding error of |a/b| times 2^-53.
+    // Adding 2^52 + 2^51 to the bits of integers in this range also converts them to and from
+    // doubles without the 64-bit conversions which SSE2 and AVX2 lack.
+    static constexpr std::uint64_t exactDivisionLimit = std::uint64_t(1) << 51;
+    static constexpr std::uint64_t conversionMagic = 0x4338000000000000;
+    // Writes the integer division or remainder of each of the n lanes of a by b, none of which
+    // is zero. Goes through doubles if all the operands are within exactDivisionLimit, as
+    // dividing doubles is several times faster than dividing integers, and SIMD can only
+    // divide floats, and otherwise divides the integers.
+    template<Opcode op> static void divideLanes(
+        std::uint64_t* dst,
+        std::uint64_t const* a,
+        std::uint64_t const* b,
+        std::size_t n
+    ) {
+        bool constexpr _isSigned = op == Opcode::DivideSigned || op == Opcode::RemainderSigned;
+        bool constexpr _isRemainder =
+            op == Opcode::RemainderSigned || op == Opcode::RemainderUnsigned;
+        // Shifting signed integers by the limit maps the range to [0, 2 * limit).
+        std::uint64_t constexpr _shift = _isSigned? exactDivisionLimit : 0;
+        std::uint64_t constexpr _bound = _isSigned? 2 * exactDivisionLimit : exactDivisionLimit;
+        // All the operands are below the bound, a power of two, if their union is.
+        std::uint64_t _union = 0;
+        for (std::size_t i = 0; i < n; ++i) {
+            _union |= (a[i] + _shift) | (b[i] + _shift);
+        }
+        if (_union >= _bound) {
+            for (std::size_t i = 0; i < n; ++i) {
+                dst[i] = applyOpcode(op, a[i], b[i]);
+            }
+            return;
+        }
+        std::size_t i = 0;
+        #ifdef FENNTON_SIMD_AVX2
+        __m256i const _magicBits = _mm256_set1_epi64x(static_cast<std::int64_t>(conversionMagic));
+        __m256d const _magic = _mm256_castsi256_pd(_magicBits);
+        auto const _toDouble = [&](__m256i v) {
+            return _mm256_sub_pd(_mm256_castsi256_pd(_mm256_add_epi64(v, _magicBits)), _magic);
+        };
+        for (; i + 4 <= n; i += 4) {
+            __m256d const _a = _toDouble(
+                _mm256_loadu_si256(reinterpret_cast<__m256i const*>(a + i))
+            );
+            __m256d const _b = _toDouble(
+                _mm256_loadu_si256(reinterpret_cast<__m256i const*>(b + i))
+            );
+            __m256d _result = _mm256_round_pd(
+                _mm256_div_pd(_a, _b), _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC
+            );
+            if constexpr (_isRemainder) {
+                // Exact, as the product is at most |a|.
+                _result = _mm256_sub_pd(_a, _mm256_mul_pd(_result, _b));
+            }
+            __m256i const _bits = _mm256_sub_epi64(
+                _mm256_castpd_si256(_mm256_add_pd(_result, _magic)), _magicBits
+            );
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _bits);
+        }
+        #endif
+        for (; i < n; ++i) {
+            double const _a = static_cast<double>(static_cast<std::int64_t>(a[i]));
+            double const _b = static_cast<double>(static_cast<std::int64_t>(b[i]));
+            std::int64_t const _quotient = static_cast<std::int64_t>(_a / _b);
+            dst[i] = _isRemainder
+                ? a[i] - static_cast<std::uint64_t>(_quotient) * b[i]
+                : static_cast<std::uint64_t>(_quotient);
+        }
+    }
+    // Writes the operation on each of the n lanes of a and b to dst, where bits is the bit
+    // count of wraps, and b is a for unary operations. Takes 4 lanes at a time with AVX2
+    // and 2 with SSE2 where they have the operation, and applyOpcode on the rest, so that
+    // every lane gets the same result as when evaluated alone. Integer divisions, which
+    // must not be by zero, go through divideLanes.
+    template<Opcode op> static void mapLanes(
+        std::uint64_t* dst,
+        std::uint64_t const* a,
+        std::uint64_t const* b,
+        unsigned bits,
+        std::size_t n
+    ) {
+        if constexpr (isIntegerDivision(op)) {
+            divideLanes<op>(dst, a, b, n);
+            return;
+        }
+        std::size_t i = 0;
+        #ifdef FENNTON_SIMD_AVX2
+        if constexpr (hasVector256(op)) {
+            for (; i + 4 <= n; i += 4) {
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), vector256<op>(
+                    _mm256_loadu_si256(reinterpret_cast<__m256i const*>(a + i)),
+                    _mm256_loadu_si256(reinterpret_cast<__m256i const*>(b + i)),
+                    bits
+                ));
+            }
+        }
+        #endif
+        #ifdef FENNTON_SIMD_SSE2
+        if constexpr (hasVector128(op)) {
+            for (; i + 2 <= n; i += 2) {
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), vector128<op>(
+                    _mm_loadu_si128(reinterpret_cast<__m128i const*>(a + i)),
+                    _mm_loadu_si128(reinterpret_cast<__m128i const*>(b + i)),
+                    bits
+                ));
+            }
+        }
+        #endif
+        bool constexpr _isWrap = op == Opcode::WrapSigned || op == Opcode::WrapUnsigned;
+        for (; i < n; ++i) {
+            dst[i] = applyOpcode(op, a[i], _isWrap? bits : b[i]);
+        }
+    }
+    // Operation on the lanes of a block.
+    using LaneKernel = void (*)(
+        std::uint64_t* dst,
+        std::uint64_t const* a,
+        std::uint64_t const* b,
+        unsigned bits,
+        std::size_t n
+    );
+    // Returns the kernel of each opcode, indexed by its value, with none for Return.
+    template<std::size_t... I> static constexpr std::array<LaneKernel, opcodeCount> makeKernels(
+        std::index_sequence<I...>
+    ) {
+        return { (static_cast<Opcode>(I) == Opcode::Return
+            ? nullptr : &mapLanes<static_cast<Opcode>(I)>)... };
+    }
+    static constexpr std::array<LaneKernel, opcodeCount> laneKernels =
+        makeKernels(std::make_index_sequence<opcodeCount>());
+
+    // Returns true if the column's elements can be the values of the type.
+    static bool isColumnOf(ColumnKind kind, Type type) {
+        switch (type.kind) {
+            case TypeKind::Boolean:
+                return kind == ColumnKind::Boolean;
+            case TypeKind::Float:
+                return kind == ColumnKind::Float32 || kind == ColumnKind::Float64;
+            default:
+                return kind <= ColumnKind::Unsigned64;
+        }
+    }
+    // Writes the bits of the n elements of the column from the index first to the lanes, as
+    // the registers of the type, rounding doubles for f32.
+    static void loadLanes(
+        Column const& column,
+        Type type,
+        std::size_t first,
+        std::size_t n,
+        std::uint64_t* lanes
+    ) {
+        auto const _load = [&]<typename T>(T const*) {
+            T const* const _values = static_cast<T const*>(column.GetData()) + first;
+            for (std::size_t i = 0; i < n; ++i) {
+                if constexpr (std::same_as<T, bool>) {
+                    lanes[i] = booleanBits(_values[i]);
+                } else if constexpr (std::same_as<T, float>) {
+                    lanes[i] = floatBits(_values[i]);
+                } else if constexpr (std::same_as<T, double>) {
+                    lanes[i] = floatBits(
+                        type.bits == 32? static_cast<float>(_values[i]) : _values[i]
+                    );
+                } else if constexpr (std::is_signed_v<T>) {
+                    lanes[i] = integerBits(_values[i]);
+                } else {
+                    lanes[i] = _values[i];
+                }
+            }
+        };
+        switch (column.GetKind()) {
+            case ColumnKind::Signed8: _load(static_cast<std::int8_t const*>(nullptr)); break;
+            case ColumnKind::Signed16: _load(static_cast<std::int16_t const*>(nullptr)); break;
+            case ColumnKind::Signed32: _load(static_cast<std::int32_t const*>(nullptr)); break;
+            case ColumnKind::Signed64: _load(static_cast<std::int64_t const*>(nullptr)); break;
+            case ColumnKind::Unsigned8: _load(static_cast<std::uint8_t const*>(nullptr)); break;
+            case ColumnKind::Unsigned16: _load(static_cast<std::uint16_t const*>(nullptr)); break;
+            case ColumnKind::Unsigned32: _load(static_cast<std::uint32_t const*>(nullptr)); break;
+            case ColumnKind::Unsigned64: _load(static_cast<std::uint64_t const*>(nullptr)); break;
+            case ColumnKind::Float32: _load(static_cast<float const*>(nullptr)); break;
+            case ColumnKind::Float64: _load(static_cast<double const*>(nullptr)); break;
+            default: _load(static_cast<bool const*>(nullptr)); break;
+        }
+    }
+    void Program::RunBatch(
+        std::span<Column const> columns, std::span<std::uint64_t> results
+    ) const {
+        if (columns.size() < bindingCount) {
+            throw std::invalid_argument(std::format(
+                "Expected {} columns, one per binding, but got {}.", bindingCount, columns.size()
+            ));
+        }
+        for (std::size_t i = 0; i < inputs.size(); ++i) {
+            Column const& _column = columns[inputs[i]];
+            if (!isColumnOf(_column.GetKind(), inputTypes[i])) {
+                throw std::invalid_argument(std::format(
+                    "Column of binding {} cannot hold values of {}.",
+                    inputs[i], spellType(inputTypes[i])
+                ));
+            }
+            if (_column.Size() < results.size()) {
+                throw std::invalid_argument(std::format(
+                    "Column of binding {} has {} values, fewer than the {} results.",
+                    inputs[i], _column.Size(), results.size()
+                ));
+            }
+        }
+        // The lanes of each register, one after the other, allocated once per batch. The
+        // constants are the same in every block, and the inputs are loaded for each block.
+        std::vector<std::uint64_t> _lanes(registerCount * blockLanes);
+        for (std::size_t i = 0; i < constants.size(); ++i) {
+            std::fill_n(_lanes.data() + i * blockLanes, blockLanes, constants[i]);
+        }
+        std::uint64_t* const _inputs = _lanes.data() + constants.size() * blockLanes;
+        for (std::size_t _first = 0; _first < results.size(); _first += blockLanes) {
+            std::size_t const _n = std::min(blockLanes, results.size() - _first);
+            for (std::size_t i = 0; i < inputs.size(); ++i) {
+                loadLanes(
+                    columns[inputs[i]], inputTypes[i], _first, _n, _inputs + i * blockLanes
+                );
+            }
+            for (std::size_t i = 0; i < code.size(); ++i) {
+                Instruction const _in = code[i];
+                std::uint64_t const* const _a = _lanes.data() + _in.a * blockLanes;
+                if (_in.op == Opcode::Return) {
+                    std::memcpy(results.data() + _first, _a, _n * sizeof(std::uint64_t));
+                    break;
+                }
+                bool const _isWrap = _in.op == Opcode::WrapSigned || _in.op == Opcode::WrapUnsigned;
+                bool const _isUnary = _isWrap || _in.op == Opcode::Negate
+                    || _in.op == Opcode::NegateFloat || _in.op >= Opcode::RoundFloat32;
+                std::uint64_t const* const _b = _isUnary? _a : _lanes.data() + _in.b * blockLanes;
+                if (isIntegerDivision(_in.op) && std::find(_b, _b + _n, 0) != _b + _n) {
+                    throw EvaluationException(
+                        "Integer division by zero.", static_cast<std::size_t>(offsets[i])
+                    );
+                }
+                laneKernels[static_cast<std::size_t>(_in.op)](
+                    _lanes.data() + _in.dst * blockLanes, _a, _b, _in.b, _n
+                );
+            }
+        }
+    }
+}
@@ -0,0 +1,542 @@
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include <fennton/skript/Cache.hpp>
+#include <whereami.h>
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <span>
+#include <system_error>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+namespace Fennton::Skript::Tokeniser {
+    static_assert(std::is_trivially_copyable_v<NumberPayload>);
+    static_assert(std::is_trivially_copyable_v<Span>);
+
+    // Read-only mapping of a whole file, which is unmapped when destroyed.
+    class MappedFile {
+    private:
+        char const* data = nullptr;
+        std::size_t size = 0;
+        #ifdef _WIN32
+        HANDLE mapping = nullptr;
+        #endif
+    public:
+        // Maps the file, or constructs an empty mapping if it cannot be opened or mapped.
+        MappedFile(std::filesystem::path const& path) {
+            #ifdef _WIN32
+            HANDLE _file = CreateFileW(
+                path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr,
+                OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr
+            );
+            if (_file == INVALID_HANDLE_VALUE) {
+                return;
+            }
+            LARGE_INTEGER _size;
+            if (GetFileSizeEx(_file, &_size) && _size.QuadPart > 0) {
+                mapping = CreateFileMappingW(_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            }
+            // The mapping keeps the file open.
+            CloseHandle(_file);
+            if (mapping == nullptr) {
+                return;
+            }
+            data = static_cast<char const*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+            if (data == nullptr) {
+                CloseHandle(mapping);
+                mapping = nullptr;
+                return;
+            }
+            size = static_cast<std::size_t>(_size.QuadPart);
+            #else
+            int _file = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+            if (_file == -1) {
+                return;
+            }
+            // Reads the whole file in at once where possible, as all of it is copied right away,
+            // instead of faulting each page in.
+            #ifdef MAP_POPULATE
+            constexpr int _flags = MAP_PRIVATE | MAP_POPULATE;
+            #else
+            constexpr int _flags = MAP_PRIVATE;
+            #endif
+            struct stat _stat;
+            if (fstat(_file, &_stat) == 0 && _stat.st_size > 0) {
+                void* _data = mmap(
+                    nullptr, static_cast<std::size_t>(_stat.st_size), PROT_READ, _flags, _file, 0
+                );
+                if (_data != MAP_FAILED) {
+                    data = static_cast<char const*>(_data);
+                    size = static_cast<std::size_t>(_stat.st_size);
+                }
+            }
+            // The mapping keeps the file open.
+            close(_file);
+            #endif
+        }
+        MappedFile(MappedFile const&) = delete;
+        MappedFile& operator=(MappedFile const&) = delete;
+        ~MappedFile() {
+            if (data == nullptr) {
+                return;
+            }
+            #ifdef _WIN32
+            UnmapViewOfFile(data);
+            CloseHandle(mapping);
+            #else
+            munmap(const_cast<char*>(data), size);
+            #endif
+        }
+        std::string_view GetData() const {
+            return std::string_view(data, size);
+        }
+    };
+
+    // Start of each file, followed by the stream's arrays in the order of its fields, each
+    // starting at a multiple of 8 bytes from the start of the file. Names are stored as
+    // indices in the file's symbol table, which is stored last as the end offset of each
+    // spelling followed by the spellings.
+    struct FileHeader {
+        char magic[4];
+        std::uint32_t version;
+        // Rejects files written on machines of the other endianness.
+        std::uint32_t byteOrder;
+        // Rejects files written with another layout of the payloads.
+        std::uint32_t payloadSize;
+        std::uint64_t sourceHash;
+        std::uint64_t sourceSize;
+        std::uint64_t tokenCount;
+        std::uint64_t numberCount;
+        std::uint64_t limbCount;
+        std::uint64_t stringCount;
+        std::uint64_t arenaSize;
+        std::uint64_t symbolCount;
+        std::uint64_t spellingSize;
+    };
+    static constexpr char fileMagic[4] = { 'S', 'K', 'T', 'C' };
+    static constexpr std::uint32_t fileByteOrder = 0x01020304;
+
+    // Returns the size rounded up to a multiple of 8.
+    static std::uint64_t alignSize(std::uint64_t size) {
+        return (size + 7) & ~std::uint64_t(7);
+    }
+    // Offsets of the arrays of a file from its start, and the file's size.
+    struct FileLayout {
+        std::uint64_t kinds;
+        std::uint64_t spans;
+        std::uint64_t spaceAfterBits;
+        std::uint64_t payloads;
+        std::uint64_t numbers;
+        std::uint64_t limbs;
+        std::uint64_t strings;
+        std::uint64_t stringArena;
+        std::uint64_t spellingEnds;
+        std::uint64_t spellings;
+        std::uint64_t size;
+
+        FileLayout(FileHeader const& header) {
+            std::uint64_t const _count = header.tokenCount;
+            kinds = alignSize(sizeof(FileHeader));
+            spans = kinds + alignSize(_count * sizeof(Kind));
+            spaceAfterBits = spans + alignSize(_count * sizeof(Span));
+            payloads = spaceAfterBits + (_count + 63) / 64 * sizeof(std::uint64_t);
+            numbers = payloads + alignSize(_count * sizeof(std::uint32_t));
+            limbs = numbers + alignSize(header.numberCount * sizeof(NumberPayload));
+            strings = limbs + alignSize(header.limbCount * sizeof(std::uint32_t));
+            stringArena = strings + alignSize(header.stringCount * sizeof(Span));
+            spellingEnds = stringArena + alignSize(header.arenaSize);
+            spellings = spellingEnds + alignSize(header.symbolCount * sizeof(std::uint32_t));
+            size = spellings + alignSize(header.spellingSize);
+        }
+    };
+    // Replaces the vector's elements with the count elements stored at the offset.
+    template<typename T> static void readArray(
+        std::vector<T>& out,
+        std::string_view file,
+        std::uint64_t offset,
+        std::uint64_t count
+    ) {
+        out.resize(static_cast<std::size_t>(count));
+        if (count != 0) {
+            std::memcpy(out.data(), file.data() + offset, count * sizeof(T));
+        }
+    }
+    // Copies the array to the file at the offset.
+    template<typename T> static void writeArray(
+        std::string& file,
+        std::uint64_t offset,
+        std::span<T const> array
+    ) {
+        if (!array.empty()) {
+            std::memcpy(file.data() + offset, array.data(), array.size_bytes());
+        }
+    }
+
+    // Returns true if the number's base is one the tokeniser gives and its body starts after
+    // the base's prefix (`0b`, `0x`, and `0` or `0o` for octal), inside the token, as its
+    // spelling is rebuilt from them.
+    static bool isValidLead(NumberPayload const& number, Span span) {
+        switch (number.base) {
+            case 2:
+            case 16:
+                return number.bodyOffset == 2 && span.length > 2;
+            case 8:
+                return (number.bodyOffset == 1 || number.bodyOffset == 2)
+                    && span.length > number.bodyOffset;
+            case 10:
+                return number.bodyOffset == 0;
+            default:
+                return false;
+        }
+    }
+    // Returns the name of the file of the streams of sources with the hash.
+    static std::string fileName(std::uint64_t hash) {
+        return std::format("{:016x}.sktc", hash);
+    }
+
+    std::uint64_t hashSource(std::string_view source) {
+        constexpr std::uint64_t _prime1 = 0x9E3779B185EBCA87;
+        constexpr std::uint64_t _prime2 = 0xC2B2AE3D27D4EB4F;
+        constexpr std::uint64_t _prime3 = 0x165667B19E3779F9;
+        constexpr std::uint64_t _prime4 = 0x85EBCA77C2B2AE63;
+        constexpr std::uint64_t _prime5 = 0x27D4EB2F165667C5;
+        auto _read64 = [](char const* it) {
+            std::uint64_t _value;
+            std::memcpy(&_value, it, sizeof(_value));
+            return _value;
+        };
+        auto _read32 = [](char const* it) {
+            std::uint32_t _value;
+            std::memcpy(&_value, it, sizeof(_value));
+            return _value;
+        };
+        auto _round = [](std::uint64_t acc, std::uint64_t lane) {
+            return std::rotl(acc + lane * _prime2, 31) * _prime1;
+        };
+        auto _merge = [&](std::uint64_t hash, std::uint64_t acc) {
+            return (hash ^ _round(0, acc)) * _prime1 + _prime4;
+        };
+
+        char const* _it = source.data();
+        char const* const _end = _it + source.size();
+        std::uint64_t _hash;
+        if (source.size() >= 32) {
+            // Four independent lanes, so that the multiplications overlap.
+            std::uint64_t _acc1 = _prime1 + _prime2;
+            std::uint64_t _acc2 = _prime2;
+            std::uint64_t _acc3 = 0;
+            std::uint64_t _acc4 = 0 - _prime1;
+            for (; _end - _it >= 32; _it += 32) {
+                _acc1 = _round(_acc1, _read64(_it));
+                _acc2 = _round(_acc2, _read64(_it + 8));
+                _acc3 = _round(_acc3, _read64(_it + 16));
+                _acc4 = _round(_acc4, _read64(_it + 24));
+            }
+            _hash = std::rotl(_acc1, 1) + std::rotl(_acc2, 7) + std::rotl(_acc3, 12)
+                + std::rotl(_acc4, 18);
+            _hash = _merge(_hash, _acc1);
+            _hash = _merge(_hash, _acc2);
+            _hash = _merge(_hash, _acc3);
+            _hash = _merge(_hash, _acc4);
+        } else {
+            _hash = _prime5;
+        }
+        _hash += source.size();
+        for (; _end - _it >= 8; _it += 8) {
+            _hash ^= _round(0, _read64(_it));
+            _hash = std::rotl(_hash, 27) * _prime1 + _prime4;
+        }
+        if (_end - _it >= 4) {
+            _hash ^= _read32(_it) * _prime1;
+            _hash = std::rotl(_hash, 23) * _prime2 + _prime3;
+            _it += 4;
+        }
+        for (; _it != _end; ++_it) {
+            _hash ^= static_cast<unsigned char>(*_it) * _prime5;
+            _hash = std::rotl(_hash, 11) * _prime1;
+        }
+        _hash ^= _hash >> 33;
+        _hash *= _prime2;
+        _hash ^= _hash >> 29;
+        _hash *= _prime3;
+        _hash ^= _hash >> 32;
+        return _hash;
+    }
+
+    TokenCache::TokenCache(std::filesystem::path directory) {
+        this->directory = std::move(directory);
+    }
+    std::filesystem::path TokenCache::defaultDirectory() {
+        int _dirnameLength = 0;
+        int const _length = wai_getExecutablePath(nullptr, 0, nullptr);
+        if (_length <= 0) {
+            throw std::runtime_error("TokenCache::defaultDirectory: Executable not found.");
+        }
+        std::string _path = std::string(static_cast<std::size_t>(_length), '\0');
+        wai_getExecutablePath(_path.data(), _length, &_dirnameLength);
+        _path.resize(static_cast<std::size_t>(_dirnameLength));
+        return std::filesystem::u8path(_path) / "skript_cache";
+    }
+    std::filesystem::path const& TokenCache::GetDirectory() const {
+        return directory;
+    }
+    std::filesystem::path TokenCache::GetPath(std::string_view source) const {
+        return directory / fileName(hashSource(source));
+    }
+    std::optional<TokenStream> TokenCache::Load(Memory::Strong<std::string const> source) const {
+        std::uint64_t const _hash = hashSource(*source);
+        MappedFile const _mapped = MappedFile(directory / fileName(_hash));
+        std::string_view const _file = _mapped.GetData();
+        if (_file.size() < sizeof(FileHeader)) {
+            return std::nullopt;
+        }
+        FileHeader _header;
+        std::memcpy(&_header, _file.data(), sizeof(_header));
+        // The bounds keep the layout's arithmetic from overflowing, as tokens are never empty.
+        if (
+            !std::equal(std::begin(fileMagic), std::end(fileMagic), _header.magic)
+            || _header.version != version
+            || _header.byteOrder != fileByteOrder
+            || _header.payloadSize != sizeof(NumberPayload)
+            || _header.sourceHash != _hash
+            || _header.sourceSize != source->size()
+            || _header.tokenCount > _header.sourceSize
+            || _header.numberCount > _header.tokenCount
+            || _header.limbCount > _header.sourceSize
+            || _header.stringCount > _header.tokenCount
+            || _header.arenaSize > _header.sourceSize
+            || _header.symbolCount > _header.tokenCount
+            || _header.spellingSize > _header.sourceSize
+        ) {
+            return std::nullopt;
+        }
+        FileLayout const _layout = FileLayout(_header);
+        if (_layout.size != _file.size()) {
+            return std::nullopt;
+        }
+
+        TokenStream _stream = TokenStream(std::move(source));
+        readArray(_stream.kinds, _file, _layout.kinds, _header.tokenCount);
+        readArray(_stream.spans, _file, _layout.spans, _header.tokenCount);
+        readArray(
+            _stream.spaceAfterBits, _file, _layout.spaceAfterBits, (_header.tokenCount + 63) / 64
+        );
+        readArray(_stream.payloads, _file, _layout.payloads, _header.tokenCount);
+        readArray(_stream.numbers, _file, _layout.numbers, _header.numberCount);
+        readArray(_stream.limbs, _file, _layout.limbs, _header.limbCount);
+        readArray(_stream.strings, _file, _layout.strings, _header.stringCount);
+        _stream.stringArena.assign(
+            _file.data() + _layout.stringArena, static_cast<std::size_t>(_header.arenaSize)
+        );
+
+        // Interns the names again, as their symbols are only valid in the process which
+        // wrote the file.
+        std::vector<Symbol> _symbols;
+        _symbols.reserve(static_cast<std::size_t>(_header.symbolCount));
+        char const* const _spellings = _file.data() + _layout.spellings;
+        std::uint32_t _start = 0;
+        for (std::uint64_t i = 0; i < _header.symbolCount; ++i) {
+            std::uint32_t _end;
+            std::memcpy(&_end, _file.data() + _layout.spellingEnds + i * sizeof(_end), 4);
+            if (_end < _start || _end > _header.spellingSize) {
+                return std::nullopt;
+            }
+            _symbols.push_back(
+                globalSymbols().Intern(std::string_view(_spellings + _start, _end - _start))
+            );
+            _start = _end;
+        }
+        // Checks the indices and spans, so that a corrupt file is never trusted. The numbers 
+        // (with their limbs) and the decoded strings (with their arena) must also follow each 
+        // other in the order of their tokens and fill their tables, as the tokeniser stores 
+        // them, since retokenising copies those of a range of tokens as one slice.
+        std::size_t _numberCount = 0;
+        std::uint64_t _limbCount = 0;
+        std::size_t _stringCount = 0;
+        std::uint64_t _arenaSize = 0;
+        for (std::size_t i = 0; i < _stream.kinds.size(); ++i) {
+            Span const _span = _stream.spans[i];
+            if (std::uint64_t(_span.offset) + _span.length > _header.sourceSize) {
+                return std::nullopt;
+            }
+            std::uint32_t& _payload = _stream.payloads[i];
+            switch (_stream.kinds[i]) {
+                case Kind::Name:
+                    if (_payload >= _symbols.size()) {
+                        return std::nullopt;
+                    }
+                    _payload = _symbols[_payload].id;
+                    break;
+                case Kind::Number: {
+                    if (_payload != _numberCount || _payload >= _stream.numbers.size()) {
+                        return std::nullopt;
+                    }
+                    ++_numberCount;
+                    NumberPayload const& _number = _stream.numbers[_payload];
+                    if (!isValidLead(_number, _span)) {
+                        return std::nullopt;
+                    }
+                    if (_number.valueKind == ValueKind::BigInteger) {
+                        if ((_number.value & 0xFFFFFFFF) != _limbCount) {
+                            return std::nullopt;
+                        }
+                        _limbCount += _number.value >> 32;
+                        if (_limbCount > _stream.limbs.size()) {
+                            return std::nullopt;
+                        }
+                    }
+                    break;
+                }
+                case Kind::String: {
+                    // Only the strings with escape sequences have a decoded value, and the 
+                    // others are viewed in the source between their quotes.
+                    if (_payload == TokenStream::noPayload) {
+                        if (_span.length < 2) {
+                            return std::nullopt;
+                        }
+                        break;
+                    }
+                    if (_payload != _stringCount || _payload >= _stream.strings.size()) {
+                        return std::nullopt;
+                    }
+                    ++_stringCount;
+                    Span const _value = _stream.strings[_payload];
+                    if (_value.offset != _arenaSize) {
+                        return std::nullopt;
+                    }
+                    _arenaSize += _value.length;
+                    if (_arenaSize > _header.arenaSize) {
+                        return std::nullopt;
+                    }
+                    break;
+                }
+                case Kind::Punct:
+                    if (_payload >= operatorCount) {
+                        return std::nullopt;
+                    }
+                    break;
+                // Error tokens are never stored, as tokenise throws for them instead.
+                default:
+                    return std::nullopt;
+            }
+        }
+        if (
+            _numberCount != _stream.numbers.size()
+            || _limbCount != _stream.limbs.size()
+            || _stringCount != _stream.strings.size()
+            || _arenaSize != _header.arenaSize
+        ) {
+            return std::nullopt;
+        }
+        return _stream;
+    }
+    bool TokenCache::Store(TokenStream const& stream) const {
+        // Streams with errors only come from tokenising with diagnostics, and loading them 
+        // would not throw as tokenise does.
+        std::vector<Kind> const& _kinds = stream.kinds;
+        if (std::find(_kinds.begin(), _kinds.end(), Kind::Error) != _kinds.end()) {
+            return false;
+        }
+        std::string_view const _source = stream.GetSource();
+        // Gives each distinct symbol an index in the file's table, in order of appearance.
+        std::vector<std::uint32_t> _payloads = stream.payloads;
+        std::unordered_map<Symbol, std::uint32_t> _indices;
+        std::vector<std::uint32_t> _spellingEnds;
+        std::string _spellings;
+        for (std::size_t i = 0; i < _payloads.size(); ++i) {
+            if (stream.kinds[i] != Kind::Name) {
+                continue;
+            }
+            Symbol const _symbol = Symbol{ _payloads[i] };
+            auto [_it, _added] = _indices.try_emplace(
+                _symbol, static_cast<std::uint32_t>(_spellingEnds.size())
+            );
+            if (_added) {
+                _spellings += globalSymbols().GetSpelling(_symbol);
+                _spellingEnds.push_back(static_cast<std::uint32_t>(_spellings.size()));
+            }
+            _payloads[i] = _it->second;
+        }
+
+        FileHeader _header;
+        std::copy(std::begin(fileMagic), std::end(fileMagic), _header.magic);
+        _header.version = version;
+        _header.byteOrder = fileByteOrder;
+        _header.payloadSize = sizeof(NumberPayload);
+        _header.sourceHash = hashSource(_source);
+        _header.sourceSize = _source.size();
+        _header.tokenCount = stream.kinds.size();
+        _header.numberCount = stream.numbers.size();
+        _header.limbCount = stream.limbs.size();
+        _header.stringCount = stream.strings.size();
+        _header.arenaSize = stream.stringArena.size();
+        _header.symbolCount = _spellingEnds.size();
+        _header.spellingSize = _spellings.size();
+        FileLayout const _layout = FileLayout(_header);
+
+        // Built in memory, so that the file is written in one go (the padding is zeroed).
+        std::string _file = std::string(static_cast<std::size_t>(_layout.size), '\0');
+        std::memcpy(_file.data(), &_header, sizeof(_header));
+        writeArray(_file, _layout.kinds, std::span<Kind const>(stream.kinds));
+        writeArray(_file, _layout.spans, std::span<Span const>(stream.spans));
+        writeArray(
+            _file, _layout.spaceAfterBits, std::span<std::uint64_t const>(stream.spaceAfterBits)
+        );
+        writeArray(_file, _layout.payloads, std::span<std::uint32_t const>(_payloads));
+        writeArray(_file, _layout.numbers, std::span<NumberPayload const>(stream.numbers));
+        writeArray(_file, _layout.limbs, std::span<std::uint32_t const>(stream.limbs));
+        writeArray(_file, _layout.strings, std::span<Span const>(stream.strings));
+        writeArray(_file, _layout.stringArena, std::span<char const>(stream.stringArena));
+        writeArray(_file, _layout.spellingEnds, std::span<std::uint32_t const>(_spellingEnds));
+        writeArray(_file, _layout.spellings, std::span<char const>(_spellings));
+
+        std::error_code _error;
+        std::filesystem::create_directories(directory, _error);
+        if (_error) {
+            return false;
+        }
+        std::filesystem::path const _path = directory / fileName(_header.sourceHash);
+        // Written to a file of its own first and then renamed over the old one, so that
+        // readers only ever see complete files.
+        std::filesystem::path _temporary = _path;
+        _temporary += std::format(
+            ".{}.tmp", std::chrono::steady_clock::now().time_since_epoch().count()
+        );
+        {
+            std::ofstream _out = std::ofstream(_temporary, std::ios::binary | std::ios::trunc);
+            _out.write(_file.data(), static_cast<std::streamsize>(_file.size()));
+            if (!_out.good()) {
+                _out.close();
+                std::filesystem::remove(_temporary, _error);
+                return false;
+            }
+        }
+        std::filesystem::rename(_temporary, _path, _error);
+        if (_error) {
+            std::filesystem::remove(_temporary, _error);
+            return false;
+        }
+        return true;
+    }
+    TokenStream tokenise(Memory::Strong<std::string const> source, TokenCache const& cache) {
+        std::optional<TokenStream> _cached = cache.Load(source);
+        if (_cached) {
+            return std::move(*_cached);
+        }
+        TokenStream _stream = tokenise(std::move(source));
+        cache.Store(_stream);
+        return _stream;
+    }
+}
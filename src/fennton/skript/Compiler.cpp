@@ -0,0 +1,688 @@
+#include <fennton/skript/Bytecode.hpp>
+#include <fennton/utils/Text.hpp>
+#include <unordered_map>
+#include <optional>
+#include <format>
+#include <charconv>
+#include <algorithm>
+#include <cmath>
+
+namespace Fennton::Skript {
+    using Tokeniser::SuffixType;
+
+    // Registers are numbered in three spaces while compiling, as the registers of the inputs
+    // come after all the constants, and those of the temporaries after all the inputs. The
+    // space is in the upper bits of the number.
+    static constexpr std::uint32_t constantSpace = 0u << 30;
+    static constexpr std::uint32_t inputSpace = 1u << 30;
+    static constexpr std::uint32_t tempSpace = 2u << 30;
+    static constexpr std::uint32_t spaceMask = 3u << 30;
+
+    // Returns the spelling of the operator of the operation.
+    static std::string_view operatorOf(NodeKind kind) {
+        switch (kind) {
+            case NodeKind::Negate: return "-";
+            case NodeKind::Add: return "+";
+            case NodeKind::Subtract: return "-";
+            case NodeKind::Multiply: return "*";
+            case NodeKind::Divide: return "/";
+            case NodeKind::Remainder: return "%";
+            case NodeKind::Less: return "<";
+            case NodeKind::Greater: return ">";
+            case NodeKind::LessEqual: return "<=";
+            case NodeKind::GreaterEqual: return ">=";
+            case NodeKind::Equal: return "==";
+            default: return "!=";
+        }
+    }
+    // Returns true if the type is an integer or a float.
+    static bool isNumeric(Type type) {
+        return type.kind != TypeKind::Boolean;
+    }
+
+    // Returns true if the operation is an integer division or remainder, which throws if
+    // its divisor is zero.
+    static bool isIntegerDivision(Opcode op) {
+        return op >= Opcode::DivideSigned && op <= Opcode::RemainderUnsigned;
+    }
+    // Returns true if the b operand of the operation is a bit count instead of a register.
+    static bool isWrap(Opcode op) {
+        return op == Opcode::WrapSigned || op == Opcode::WrapUnsigned;
+    }
+    // Returns true if values of the types have the same bits in a register, so that a value
+    // of one is a value of the other without a wrap or conversion.
+    static bool isSameRepresentation(Type a, Type b) {
+        return a.kind == b.kind && a.bits == b.bits;
+    }
+
+    // Compiler of a tree, which assigns a register to each node in a single forward loop
+    // over the nodes, as they are in post-order. Temporaries are allocated like a stack, as
+    // the operands of an operation are always the last values computed. Values known at
+    // compile time stay constants until an instruction reads them, so that folding them
+    // leaves no unused constants behind.
+    class Compiler {
+    private:
+        // Number of the register of the values known at compile time.
+        static constexpr std::uint32_t noRegister = 0xFFFFFFFF;
+
+        // Value of a node: its type, and its register or its bits if known at compile time.
+        struct Operand {
+            Type type;
+            std::uint32_t reg = noRegister;
+            std::uint64_t bits = 0;
+            // Name node which the value is the negation of, or noNode, so that `-(-x)` can be
+            // simplified to `x` where x is an input, whose register is never overwritten.
+            NodeIndex negated = noNode;
+
+            bool IsConstant() const {
+                return reg == noRegister;
+            }
+        };
+        // Instruction with registers in the spaces used while compiling, with noRegister for
+        // the operands it does not read.
+        struct Pending {
+            Opcode op;
+            std::uint32_t dst;
+            std::uint32_t a;
+            std::uint32_t b;
+            std::uint32_t offset;
+        };
+
+        Ast const& ast;
+        std::span<Binding const> bindings;
+        bool fold;
+        Program program;
+        std::vector<Operand> operands;
+        std::vector<Pending> pending;
+        // Constants and inputs read by the instructions, whose registers are numbered in the
+        // program once the unused instructions are dropped.
+        std::vector<std::uint64_t> constants;
+        std::vector<std::uint16_t> inputs;
+        std::unordered_map<std::uint64_t, std::uint32_t> constantRegisters;
+        std::unordered_map<std::uint32_t, std::uint32_t> inputRegisters;
+        std::uint32_t tempCount = 0;
+        std::uint32_t maxTempCount = 0;
+
+        // Throws the error at the node.
+        [[noreturn]] void fail(NodeIndex node, std::string const& message) const {
+            throw CompileException(message, static_cast<std::size_t>(ast.GetSpan(node).offset));
+        }
+        // Returns the register of the constant.
+        std::uint32_t constant(std::uint64_t bits) {
+            auto const [_it, _inserted] = constantRegisters.try_emplace(
+                bits, constantSpace | static_cast<std::uint32_t>(constants.size())
+            );
+            if (_inserted) {
+                constants.push_back(bits);
+            }
+            return _it->second;
+        }
+        // Returns the register of the binding's value.
+        std::uint32_t input(std::uint32_t binding) {
+            auto const [_it, _inserted] = inputRegisters.try_emplace(
+                binding, inputSpace | static_cast<std::uint32_t>(inputs.size())
+            );
+            if (_inserted) {
+                inputs.push_back(static_cast<std::uint16_t>(binding));
+            }
+            return _it->second;
+        }
+        // Returns the register of the operand, giving a register to its value if it is a
+        // constant.
+        std::uint32_t use(Operand const& operand) {
+            return operand.IsConstant()? constant(operand.bits) : operand.reg;
+        }
+        std::uint32_t allocateTemp() {
+            maxTempCount = std::max(maxTempCount, tempCount + 1);
+            return tempSpace | tempCount++;
+        }
+        // Frees the temporary of the operand, if it has one, which must be the last one.
+        void release(Operand const& operand) {
+            if (!operand.IsConstant() && (operand.reg & spaceMask) == tempSpace) {
+                --tempCount;
+            }
+        }
+        void emit(Opcode op, std::uint32_t dst, std::uint32_t a, std::uint32_t b, NodeIndex node) {
+            pending.push_back({ op, dst, a, b, ast.GetSpan(node).offset });
+        }
+        // Returns true if the values of the type are narrower than the 64 bits of the
+        // registers, so that they are wrapped or rounded after each operation.
+        static bool isNarrow(Type type) {
+            return type.kind == TypeKind::Float? type.bits == 32 : type.bits < 64;
+        }
+        // Emits the wrap or rounding which brings the value of the source register into the
+        // type, into the destination register, if the type is narrow.
+        void narrow(std::uint32_t dst, std::uint32_t src, Type type, NodeIndex node) {
+            if (type.kind == TypeKind::Signed && type.bits < 64) {
+                emit(Opcode::WrapSigned, dst, src, type.bits, node);
+            } else if (type.kind == TypeKind::Unsigned && type.bits < 64) {
+                emit(Opcode::WrapUnsigned, dst, src, type.bits, node);
+            } else if (type.kind == TypeKind::Float && type.bits == 32) {
+                emit(Opcode::RoundFloat32, dst, src, noRegister, node);
+            }
+        }
+        // Returns the constant result of an operation, brought back into its type like
+        // narrow does when evaluating.
+        static Operand constantOf(Type type, std::uint64_t bits) {
+            if (type.kind == TypeKind::Signed && type.bits < 64) {
+                bits = applyOpcode(Opcode::WrapSigned, bits, type.bits);
+            } else if (type.kind == TypeKind::Unsigned && type.bits < 64) {
+                bits = applyOpcode(Opcode::WrapUnsigned, bits, type.bits);
+            } else if (type.kind == TypeKind::Float && type.bits == 32) {
+                bits = applyOpcode(Opcode::RoundFloat32, bits, 0);
+            }
+            return { type, noRegister, bits };
+        }
+        // Converts the integer operand to a float: at compile time for constants, in place for
+        // temporaries, and into a new temporary for inputs.
+        void toFloat(Operand& operand, NodeIndex node) {
+            Opcode const _op = operand.type.kind == TypeKind::Unsigned
+                ? Opcode::UnsignedToFloat : Opcode::SignedToFloat;
+            if (operand.IsConstant()) {
+                operand.bits = applyOpcode(_op, operand.bits, 0);
+            } else if ((operand.reg & spaceMask) == tempSpace) {
+                emit(_op, operand.reg, operand.reg, noRegister, node);
+            } else {
+                std::uint32_t const _temp = allocateTemp();
+                emit(_op, _temp, operand.reg, noRegister, node);
+                operand.reg = _temp;
+            }
+            operand.type = { TypeKind::Float, 64, operand.type.isDefault };
+            operand.negated = noNode;
+        }
+        // Brings the operand of a default type at the node into the type it takes from the
+        // other operand of an operation, as its value may not fit in it: against a `u8`, `456`
+        // wraps to `200u8` in arithmetic, like `health + 456` does when evaluating. A constant
+        // integer which does not fit is an error in a comparison, where `health < 456` would
+        // otherwise silently become `health < 200`.
+        void settle(Operand& operand, Type type, NodeIndex node, bool isComparison) {
+            if (!operand.type.isDefault || type.isDefault) {
+                return;
+            }
+            if (operand.IsConstant()) {
+                Operand const _settled = constantOf(type, operand.bits);
+                bool const _isInteger = type.kind == TypeKind::Signed
+                    || type.kind == TypeKind::Unsigned;
+                // Default integers are signed, so they are negative if their highest bit is set.
+                bool const _fits = _settled.bits == operand.bits && (
+                    type.kind == TypeKind::Signed || static_cast<std::int64_t>(operand.bits) >= 0
+                );
+                if (isComparison && _isInteger && !_fits) {
+                    fail(node, std::format(
+                        "Constant {} does not fit in {}.",
+                        spellValue(operand.bits, operand.type), spellType(type)
+                    ));
+                }
+                operand = _settled;
+                return;
+            }
+            if (isNarrow(type)) {
+                std::uint32_t const _dst = (operand.reg & spaceMask) == tempSpace
+                    ? operand.reg : allocateTemp();
+                narrow(_dst, operand.reg, type, node);
+                operand.reg = _dst;
+                operand.negated = noNode;
+            }
+            operand.type = type;
+        }
+        // Returns the type which both operands of the binary operation are converted to,
+        // converting default integers to floats if the other operand is a float.
+        Type unifyTypes(Operand& left, Operand& right, NodeIndex node) {
+            auto const _isInteger = [](Type type) {
+                return type.kind == TypeKind::Signed || type.kind == TypeKind::Unsigned;
+            };
+            auto const _isDefaultInteger = [&](Type type) {
+                return _isInteger(type) && type.isDefault;
+            };
+            if (left.type.kind == TypeKind::Float && _isDefaultInteger(right.type)) {
+                toFloat(right, node);
+                return left.type;
+            }
+            if (right.type.kind == TypeKind::Float && _isDefaultInteger(left.type)) {
+                toFloat(left, node);
+                return right.type;
+            }
+            Type const _left = left.type;
+            Type const _right = right.type;
+            // Integers of different kinds are compatible if one of them has the default type.
+            bool const _compatible =
+                _left.kind == _right.kind || (_isInteger(_left) && _isInteger(_right))
+            ;
+            if (_compatible && _left.isDefault) {
+                return _right;
+            }
+            if (_compatible && (_right.isDefault || _left == _right)) {
+                return _left;
+            }
+            fail(node, std::format(
+                "Mismatched types {} and {} for {}.",
+                spellType(_left), spellType(_right), Text::quote(std::string(operatorOf(
+                    ast.GetKind(node)
+                )))
+            ));
+        }
+        // Converts both operands of the binary operation to their common type, and returns it.
+        Type unify(Operand& left, Operand& right, NodeIndex node) {
+            Type const _type = unifyTypes(left, right, node);
+            bool const _isComparison = isComparison(ast.GetKind(node));
+            settle(left, _type, ast.GetLeft(node), _isComparison);
+            settle(right, _type, ast.GetRight(node), _isComparison);
+            return _type;
+        }
+        // Compiles the leaf at the index.
+        Operand compileLeaf(NodeIndex node) {
+            switch (ast.GetKind(node)) {
+                case NodeKind::Integer: {
+                    Literal const& _literal = ast.GetLiteral(node);
+                    if (_literal.suffixType == SuffixType::None) {
+                        return { defaultInteger, noRegister, _literal.value };
+                    }
+                    if (_literal.suffixBits > 64) {
+                        fail(node, "Integers of more than 64 bits are not supported.");
+                    }
+                    TypeKind const _kind = _literal.suffixType == SuffixType::Signed
+                        ? TypeKind::Signed : TypeKind::Unsigned;
+                    return {
+                        { _kind, static_cast<std::uint8_t>(_literal.suffixBits) },
+                        noRegister,
+                        _literal.value
+                    };
+                }
+                case NodeKind::Float: {
+                    Literal const& _literal = ast.GetLiteral(node);
+                    if (_literal.suffixType == SuffixType::None) {
+                        return { defaultFloat, noRegister, _literal.value };
+                    }
+                    if (_literal.suffixBits == 16) {
+                        fail(node, "16-bit floats are not supported.");
+                    }
+                    if (_literal.suffixBits == 32) {
+                        return constantOf({ TypeKind::Float, 32 }, _literal.value);
+                    }
+                    return { { TypeKind::Float, 64 }, noRegister, _literal.value };
+                }
+                case NodeKind::Boolean:
+                    return { booleanType, noRegister, booleanBits(ast.GetBoolean(node)) };
+                default: {
+                    Symbol const _name = ast.GetName(node);
+                    for (std::size_t i = 0; i < bindings.size(); ++i) {
+                        if (bindings[i].name != _name) {
+                            continue;
+                        }
+                        if (bindings[i].value) {
+                            return { bindings[i].type, noRegister, *bindings[i].value };
+                        }
+                        return { bindings[i].type, input(static_cast<std::uint32_t>(i)) };
+                    }
+                    fail(node, std::format(
+                        "Unknown name {}.",
+                        Text::quote(std::string(globalSymbols().GetSpelling(_name)))
+                    ));
+                }
+            }
+        }
+        // Compiles the unary operation at the index.
+        Operand compileUnary(NodeIndex node) {
+            NodeIndex const _left = ast.GetLeft(node);
+            Operand const _operand = operands[_left];
+            if (!isNumeric(_operand.type)) {
+                fail(node, std::format(
+                    "Expected a number for \"-\", found {}.", spellType(_operand.type)
+                ));
+            }
+            bool const _isFloat = _operand.type.kind == TypeKind::Float;
+            Opcode const _op = _isFloat? Opcode::NegateFloat : Opcode::Negate;
+            if (fold && _operand.IsConstant()) {
+                return constantOf(_operand.type, applyOpcode(_op, _operand.bits, 0));
+            }
+            release(_operand);
+            if (fold && _operand.negated != noNode) {
+                return operands[_operand.negated];
+            }
+            std::uint32_t const _dst = allocateTemp();
+            emit(_op, _dst, use(_operand), noRegister, node);
+            narrow(_dst, _dst, _operand.type, node);
+            bool const _isInput = !_operand.IsConstant()
+                && (_operand.reg & spaceMask) == inputSpace;
+            return { _operand.type, _dst, 0, _isInput? _left : noNode };
+        }
+        // Returns the operation on the operands simplified at compile time, if it can be:
+        // computed if both are constants, or reduced to a constant or to one of its operands
+        // by an identity. Releases the temporaries which the result does not use.
+        std::optional<Operand> simplify(
+            Opcode op,
+            Operand const& left,
+            Operand const& right,
+            Type type
+        ) {
+            if (left.IsConstant() && right.IsConstant()) {
+                // Left to throw when evaluated.
+                if (isIntegerDivision(op) && right.bits == 0) {
+                    return std::nullopt;
+                }
+                return constantOf(type, applyOpcode(op, left.bits, right.bits));
+            }
+            auto const _is = [](Operand const& operand, std::uint64_t bits) {
+                return operand.IsConstant() && operand.bits == bits;
+            };
+            // The operand itself, if it needs no wrap into the type of the result.
+            auto const _identity = [&](Operand operand) -> std::optional<Operand> {
+                if (!isSameRepresentation(operand.type, type)) {
+                    return std::nullopt;
+                }
+                operand.type = type;
+                return operand;
+            };
+            // A constant replacing the operation, whose unused instructions are dropped later.
+            auto const _constant = [&](std::uint64_t bits) -> std::optional<Operand> {
+                release(right);
+                release(left);
+                return constantOf(type, bits);
+            };
+            // Both operands are the same input, whose value is the same on both sides.
+            bool const _isSameInput = !left.IsConstant() && left.reg == right.reg
+                && (left.reg & spaceMask) == inputSpace;
+            std::uint64_t const _one = floatBits(1.0);
+            switch (op) {
+                case Opcode::Add:
+                    return _is(right, 0)? _identity(left)
+                        : _is(left, 0)? _identity(right) : std::nullopt;
+                case Opcode::Subtract:
+                    return _is(right, 0)? _identity(left)
+                        : _isSameInput? _constant(0) : std::nullopt;
+                case Opcode::Multiply:
+                    return _is(right, 1)? _identity(left)
+                        : _is(left, 1)? _identity(right)
+                        : _is(left, 0) || _is(right, 0)? _constant(0) : std::nullopt;
+                case Opcode::DivideSigned:
+                case Opcode::DivideUnsigned:
+                    return _is(right, 1)? _identity(left) : std::nullopt;
+                case Opcode::RemainderSigned:
+                case Opcode::RemainderUnsigned:
+                    return _is(right, 1)? _constant(0) : std::nullopt;
+                case Opcode::LessSigned:
+                case Opcode::LessUnsigned:
+                case Opcode::NotEqual:
+                    return _isSameInput? _constant(booleanBits(false)) : std::nullopt;
+                case Opcode::LessEqualSigned:
+                case Opcode::LessEqualUnsigned:
+                case Opcode::Equal:
+                    return _isSameInput? _constant(booleanBits(true)) : std::nullopt;
+                // Only the identities which hold for every float, including NaNs and -0, as
+                // `x + 0.0` is 0 for -0 and `x * 0.0` is NaN for infinities.
+                case Opcode::SubtractFloat:
+                    return _is(right, floatBits(0.0))? _identity(left) : std::nullopt;
+                case Opcode::MultiplyFloat:
+                    return _is(right, _one)? _identity(left)
+                        : _is(left, _one)? _identity(right) : std::nullopt;
+                case Opcode::DivideFloat:
+                    return _is(right, _one)? _identity(left) : std::nullopt;
+                default:
+                    return std::nullopt;
+            }
+        }
+        // Compiles the binary operation at the index.
+        Operand compileBinary(NodeIndex node) {
+            NodeKind const _kind = ast.GetKind(node);
+            Operand _left = operands[ast.GetLeft(node)];
+            Operand _right = operands[ast.GetRight(node)];
+            Type const _type = unify(_left, _right, node);
+            bool const _isEquality = _kind == NodeKind::Equal || _kind == NodeKind::NotEqual;
+            if (!_isEquality && !isNumeric(_type)) {
+                fail(node, std::format(
+                    "Expected numbers for {}, found {}.",
+                    Text::quote(std::string(operatorOf(_kind))), spellType(_type)
+                ));
+            }
+            bool const _isFloat = _type.kind == TypeKind::Float;
+            bool const _isSigned = _type.kind == TypeKind::Signed;
+            auto _pick = [&](Opcode signedOp, Opcode unsignedOp, Opcode floatOp) {
+                return _isFloat? floatOp : _isSigned? signedOp : unsignedOp;
+            };
+            // Operations whose result has the operands' type.
+            Opcode _op;
+            Operand const* _a = &_left;
+            Operand const* _b = &_right;
+            bool _isArithmetic = true;
+            switch (_kind) {
+                case NodeKind::Add:
+                    _op = _pick(Opcode::Add, Opcode::Add, Opcode::AddFloat);
+                    break;
+                case NodeKind::Subtract:
+                    _op = _pick(Opcode::Subtract, Opcode::Subtract, Opcode::SubtractFloat);
+                    break;
+                case NodeKind::Multiply:
+                    _op = _pick(Opcode::Multiply, Opcode::Multiply, Opcode::MultiplyFloat);
+                    break;
+                case NodeKind::Divide:
+                    _op = _pick(Opcode::DivideSigned, Opcode::DivideUnsigned, Opcode::DivideFloat);
+                    break;
+                case NodeKind::Remainder:
+                    _op = _pick(
+                        Opcode::RemainderSigned, Opcode::RemainderUnsigned, Opcode::RemainderFloat
+                    );
+                    break;
+                default:
+                    _isArithmetic = false;
+                    break;
+            }
+            if (!_isArithmetic) {
+                // Comparisons, where `a > b` is `b < a` and `a >= b` is `b <= a`.
+                if (_kind == NodeKind::Greater || _kind == NodeKind::GreaterEqual) {
+                    std::swap(_a, _b);
+                }
+                switch (_kind) {
+                    case NodeKind::Less:
+                    case NodeKind::Greater:
+                        _op = _pick(Opcode::LessSigned, Opcode::LessUnsigned, Opcode::LessFloat);
+                        break;
+                    case NodeKind::LessEqual:
+                    case NodeKind::GreaterEqual:
+                        _op = _pick(
+                            Opcode::LessEqualSigned,
+                            Opcode::LessEqualUnsigned,
+                            Opcode::LessEqualFloat
+                        );
+                        break;
+                    case NodeKind::Equal:
+                        _op = _isFloat? Opcode::EqualFloat : Opcode::Equal;
+                        break;
+                    default:
+                        _op = _isFloat? Opcode::NotEqualFloat : Opcode::NotEqual;
+                        break;
+                }
+            }
+            Type const _resultType = _isArithmetic? _type : booleanType;
+            if (fold) {
+                if (std::optional<Operand> const _simplified = simplify(
+                    _op, *_a, *_b, _resultType
+                )) {
+                    return *_simplified;
+                }
+            }
+            // Freed in the reverse order of their allocation.
+            release(_right);
+            release(_left);
+            std::uint32_t const _dst = allocateTemp();
+            emit(_op, _dst, use(*_a), use(*_b), node);
+            if (_isArithmetic) {
+                narrow(_dst, _dst, _type, node);
+            }
+            return { _resultType, _dst };
+        }
+        // Drops the instructions whose results are never read, which simplifications leave
+        // behind, by following the reads backwards from the return. Temporaries are reused,
+        // so a temporary is live from each read back to the last write before it. Integer
+        // divisions are kept unless their divisor is a constant other than zero, as they
+        // throw when evaluated.
+        void sweep() {
+            std::vector<bool> _live(maxTempCount, false);
+            auto const _read = [&](std::uint32_t reg) {
+                if (reg != noRegister && (reg & spaceMask) == tempSpace) {
+                    _live[reg & ~spaceMask] = true;
+                }
+            };
+            std::size_t _kept = pending.size();
+            for (std::size_t i = pending.size(); i-- > 0;) {
+                Pending const& _pending = pending[i];
+                bool const _mayThrow = isIntegerDivision(_pending.op)
+                    && ((_pending.b & spaceMask) != constantSpace
+                        || constants[_pending.b & ~spaceMask] == 0);
+                bool const _isLive = _pending.op == Opcode::Return
+                    || _live[_pending.dst & ~spaceMask];
+                if (!_isLive && !_mayThrow) {
+                    continue;
+                }
+                if (_pending.op != Opcode::Return) {
+                    _live[_pending.dst & ~spaceMask] = false;
+                }
+                _read(_pending.a);
+                if (!isWrap(_pending.op)) {
+                    _read(_pending.b);
+                }
+                pending[--_kept] = _pending;
+            }
+            pending.erase(pending.begin(), pending.begin() + _kept);
+        }
+    public:
+        Compiler(Ast const& ast, std::span<Binding const> bindings, bool fold)
+            : ast(ast), bindings(bindings), fold(fold) {}
+        Program Compile() {
+            if (ast.Empty()) {
+                throw CompileException("Cannot compile an empty expression.");
+            }
+            operands.resize(ast.Size());
+            for (NodeIndex i = 0; i < ast.Size(); ++i) {
+                NodeKind const _kind = ast.GetKind(i);
+                if (isLeaf(_kind)) {
+                    operands[i] = compileLeaf(i);
+                } else if (isBinary(_kind)) {
+                    operands[i] = compileBinary(i);
+                } else {
+                    operands[i] = compileUnary(i);
+                }
+            }
+            Operand const& _result = operands[ast.GetRoot()];
+            emit(Opcode::Return, noRegister, use(_result), noRegister, ast.GetRoot());
+            sweep();
+            // Numbers the constants and inputs in the order of their first read, leaving out
+            // those only read by dropped instructions.
+            std::vector<std::uint32_t> _constantIndices(constants.size(), noRegister);
+            std::vector<std::uint32_t> _inputIndices(inputs.size(), noRegister);
+            std::uint32_t _tempCount = 0;
+            auto const _number = [&](std::uint32_t reg) {
+                std::uint32_t const _index = reg & ~spaceMask;
+                if (reg == noRegister) {
+                    return;
+                }
+                if ((reg & spaceMask) == constantSpace) {
+                    if (_constantIndices[_index] == noRegister) {
+                        _constantIndices[_index] =
+                            static_cast<std::uint32_t>(program.constants.size());
+                        program.constants.push_back(constants[_index]);
+                    }
+                } else if ((reg & spaceMask) == inputSpace) {
+                    if (_inputIndices[_index] == noRegister) {
+                        _inputIndices[_index] = static_cast<std::uint32_t>(program.inputs.size());
+                        program.inputs.push_back(inputs[_index]);
+                        program.inputTypes.push_back(bindings[inputs[_index]].type);
+                    }
+                } else {
+                    _tempCount = std::max(_tempCount, _index + 1);
+                }
+            };
+            for (Pending const& _pending : pending) {
+                _number(_pending.dst);
+                _number(_pending.a);
+                if (!isWrap(_pending.op)) {
+                    _number(_pending.b);
+                }
+            }
+            program.resultType = _result.type;
+            program.bindingCount = static_cast<std::uint32_t>(bindings.size());
+            program.registerCount = static_cast<std::uint32_t>(
+                program.constants.size() + program.inputs.size() + _tempCount
+            );
+            if (program.registerCount > Program::maxRegisters) {
+                fail(ast.GetRoot(), std::format(
+                    "Expression needs {} registers, more than the {} available.",
+                    program.registerCount, Program::maxRegisters
+                ));
+            }
+            // Returns the register of the number in a compiling space.
+            auto const _resolve = [&](std::uint32_t reg) -> std::uint8_t {
+                std::uint32_t const _index = reg & ~spaceMask;
+                if (reg == noRegister) {
+                    return 0;
+                }
+                switch (reg & spaceMask) {
+                    case constantSpace:
+                        return static_cast<std::uint8_t>(_constantIndices[_index]);
+                    case inputSpace:
+                        return static_cast<std::uint8_t>(
+                            program.constants.size() + _inputIndices[_index]
+                        );
+                    default:
+                        return static_cast<std::uint8_t>(
+                            program.constants.size() + program.inputs.size() + _index
+                        );
+                }
+            };
+            program.code.reserve(pending.size());
+            program.offsets.reserve(pending.size());
+            for (Pending const& _pending : pending) {
+                program.code.push_back({
+                    _pending.op,
+                    _resolve(_pending.dst),
+                    _resolve(_pending.a),
+                    isWrap(_pending.op)
+                        ? static_cast<std::uint8_t>(_pending.b) : _resolve(_pending.b)
+                });
+                program.offsets.push_back(_pending.offset);
+            }
+            return std::move(program);
+        }
+    };
+
+    std::string spellType(Type type) {
+        switch (type.kind) {
+            case TypeKind::Boolean: return "bool";
+            case TypeKind::Signed: return std::format("i{}", static_cast<unsigned>(type.bits));
+            case TypeKind::Unsigned: return std::format("u{}", static_cast<unsigned>(type.bits));
+            default: return std::format("f{}", static_cast<unsigned>(type.bits));
+        }
+    }
+    std::string spellValue(std::uint64_t bits, Type type) {
+        std::string _spelling;
+        switch (type.kind) {
+            case TypeKind::Boolean:
+                return bits != 0? "#true" : "#false";
+            case TypeKind::Signed:
+                _spelling = std::to_string(static_cast<std::int64_t>(bits));
+                break;
+            case TypeKind::Unsigned:
+                _spelling = std::to_string(bits);
+                break;
+            default: {
+                // With the fewest digits which read back as the same value of the type, and
+                // with a fractional part if it is a whole number, so that it reads as a float.
+                double const _value = std::bit_cast<double>(bits);
+                char _buffer[32];
+                char* const _end = type.bits == 32
+                    ? std::to_chars(
+                        _buffer, _buffer + sizeof(_buffer), static_cast<float>(_value)
+                    ).ptr
+                    : std::to_chars(_buffer, _buffer + sizeof(_buffer), _value).ptr;
+                _spelling.assign(_buffer, _end);
+                if (std::isfinite(_value) && _spelling.find_first_of(".e") == std::string::npos) {
+                    _spelling += ".0";
+                }
+                break;
+            }
+        }
+        return type.isDefault? _spelling : _spelling + spellType(type);
+    }
+    Program compileExpression(Ast const& ast, std::span<Binding const> bindings, bool fold) {
+        return Compiler(ast, bindings, fold).Compile();
+    }
+}
@@ -0,0 +1,64 @@
+#include <fennton/skript/Grammar.hpp>
+#include <fennton/skript/CharClass.hpp>
+#include <string_view>
+
+namespace Fennton::Skript::Tokeniser {
+    // Lexer generated from the grammar, whose table is built by the compiler and stored in the
+    // binary.
+    static constexpr auto lexer = generateLexer<grammar>();
+
+    std::string_view::const_iterator lexSpace(
+        std::string_view::const_iterator start,
+        std::string_view::const_iterator end
+    ) {
+        // Most tokens are not preceded by any space, so those are returned without running
+        // the lexer over them.
+        while (start != end && (hasClass(*start, CharClass::Space) || *start == '/')) {
+            LexerMatch const _match = lexer.Match(std::string_view(start, end));
+            if (_match.tag == tagOf(TokenClass::Malformed)) {
+                // Throws for the unterminated comment.
+                return consumeSpace(start, end);
+            }
+            if (
+                _match.tag != tagOf(TokenClass::Space)
+                && _match.tag != tagOf(TokenClass::Comment)
+            ) {
+                break;
+            }
+            start += _match.length;
+        }
+        return start;
+    }
+    TokenResult lexNext(
+        std::string_view::const_iterator start,
+        std::string_view::const_iterator end
+    ) {
+        LexerMatch const _match = lexer.Match(std::string_view(start, end));
+        std::string_view::const_iterator const _it = start + _match.length;
+        if (_match.length == 0) {
+            // Throws for unexpected characters, or returns the empty token at the end. Names
+            // starting with characters outside ASCII are also tokenised there.
+            return tokeniseNext(start, end);
+        }
+        if (_match.tag < operatorCount) {
+            return { _it, Token(Punct(static_cast<Operator>(_match.tag)), false) };
+        }
+        switch (static_cast<TokenClass>(_match.tag)) {
+            case TokenClass::Name:
+                // The grammar's names are ASCII, so those continuing with other characters
+                // are left to tokeniseNext.
+                if (_it != end && static_cast<unsigned char>(*_it) >= 0x80) {
+                    return tokeniseNext(start, end);
+                }
+                return { _it, Token(Name(std::string_view(start, _it)), false) };
+            case TokenClass::PlainString:
+                return { _it, Token(String(std::string_view(start + 1, _it - 1)), false) };
+            case TokenClass::EscapedString:
+                return String::parse(start, end);
+            default:
+                // Numbers are decoded by the number parsers, and the errors of malformed
+                // tokens (and of the space, which is not a token) are thrown as usual.
+                return tokeniseNext(start, end);
+        }
+    }
+}
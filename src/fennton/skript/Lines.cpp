@@ -0,0 +1,38 @@
+#include <fennton/skript/Lines.hpp>
+#include <fennton/utils/Simd.hpp>
+#include <algorithm>
+#include <format>
+#include <stdexcept>
+
+namespace Fennton::Skript {
+    LineTable::LineTable(std::string_view source) {
+        char const* const _begin = source.data();
+        char const* const _end = _begin + source.size();
+        // Counted first, so that the table is allocated a single time.
+        starts.reserve(Simd::countChar(_begin, _end, '\n') + 1);
+        starts.push_back(0);
+        Simd::forEachChar(_begin, _end, '\n', [&](char const* it) {
+            starts.push_back(static_cast<std::uint32_t>(it - _begin + 1));
+        });
+    }
+    std::size_t LineTable::Size() const {
+        return starts.size();
+    }
+    std::uint32_t LineTable::GetLineStart(std::uint32_t line) const {
+        if (line == 0 || line > starts.size()) {
+            throw std::out_of_range(std::format(
+                "LineTable::GetLineStart: Line {} is outside the {} lines.", line, starts.size()
+            ));
+        }
+        return starts[line - 1];
+    }
+    SourceLocation LineTable::Locate(std::size_t offset) const {
+        // The line is the last one starting at or before the offset, which always exists as 
+        // the first line starts at 0.
+        auto _it = std::prev(std::upper_bound(starts.begin(), starts.end(), offset));
+        return {
+            static_cast<std::uint32_t>(_it - starts.begin() + 1),
+            static_cast<std::uint32_t>(offset - *_it + 1)
+        };
+    }
+}
@@ -1,377 +1,2049 @@
 #include <fennton/skript/Parser.hpp>
+#include <fennton/skript/CharClass.hpp>
+#include <fennton/skript/Static.hpp>
+#include <fennton/skript/Unicode.hpp>
 #include <fennton/utils/Text.hpp>
+#include <fennton/utils/Simd.hpp>
 #include <utility>
 #include <algorithm>
+#include <array>
+#include <memory>
+#include <limits>
+#include <bit>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <functional>
+#include <exception>
 #include <format>
-#include <locale>
 #include <stdexcept>
-#include <cctype>
+#include <type_traits>
 
 namespace Fennton::Skript {
     namespace Tokeniser {
+        // Returns the class flag for the digits of a base.
+        static std::uint16_t digitClassOf(std::int32_t base) {
+            switch (base) {
+                case 2: return CharClass::Digit2;
+                case 8: return CharClass::Digit8;
+                case 10: return CharClass::Digit10;
+                // Uppercase digits are converted while copying the number.
+                case 16: return CharClass::Digit16 | CharClass::UpperHex;
+                default:
+                    throw std::runtime_error(std::format("Base {} is unsupported.", base));
+            }
+        }
+        // Returns an iterator to the first character in [start, end) which is not a digit of
+        // the base. Long runs of digits are skipped many characters at a time.
+        static std::string_view::const_iterator skipDigits(
+            std::string_view::const_iterator start,
+            std::string_view::const_iterator end,
+            std::int32_t base
+        ) {
+            char const* _first = std::to_address(start);
+            char const* _last = _first + (end - start);
+            char const* _stop;
+            switch (base) {
+                case 2:
+                    _stop = Simd::findNotInRanges(_first, _last, Simd::CharRange{ '0', '1' });
+                    break;
+                case 8:
+                    _stop = Simd::findNotInRanges(_first, _last, Simd::CharRange{ '0', '7' });
+                    break;
+                case 10:
+                    _stop = Simd::findNotInRanges(_first, _last, Simd::CharRange{ '0', '9' });
+                    break;
+                default:
+                    _stop = Simd::findNotInRanges(_first, _last,
+                        Simd::CharRange{ '0', '9' },
+                        Simd::CharRange{ 'a', 'f' },
+                        Simd::CharRange{ 'A', 'F' }
+                    );
+                    break;
+            }
+            return start + (_stop - _first);
+        }
+        // Returns true if the character at it (which must be before end) can start a name.
+        static bool startsName(
+            std::string_view::const_iterator it,
+            std::string_view::const_iterator end
+        ) {
+            char const* const _it = std::to_address(it);
+            return nameStartLength(_it, _it + (end - it)) != 0;
+        }
+        // Returns true if the character at it (which must be before end) can continue a name.
+        static bool continuesName(
+            std::string_view::const_iterator it,
+            std::string_view::const_iterator end
+        ) {
+            char const* const _it = std::to_address(it);
+            return nameContinueLength(_it, _it + (end - it)) != 0;
+        }
+        // Returns an iterator to the end of the suffix starting at start, which must be a
+        // valid suffix start.
+        static std::string_view::const_iterator skipSuffix(
+            std::string_view::const_iterator start,
+            std::string_view::const_iterator end
+        ) {
+            // Characters which can start a name can also continue it.
+            char const* const _first = std::to_address(start);
+            return start + (skipNameContinue(_first, _first + (end - start)) - _first);
+        }
+        // Error found while scanning, which is only thrown by the functions which do not 
+        // collect diagnostics, so that scanning never throws.
+        struct ScanError {
+            // Character where the error is, or null if there is no error.
+            char const* position = nullptr;
+            ErrorCode code = ErrorCode::UnexpectedCharacter;
+            // Base of the number the error is in, if any.
+            std::int32_t base = 10;
+        };
+        // Throws the exception of the error, with a message detailing it.
+        [[noreturn]] static void throwError(ScanError const& error) {
+            switch (error.code) {
+                case ErrorCode::InvalidDigit:
+                    throw Exception(std::format(
+                        "Invalid digit {} in base-{} number.",
+                        Text::quote({ *error.position }), error.base
+                    ), error.position);
+                case ErrorCode::ExpectedDigit:
+                    throw Exception(
+                        std::format("Expected a base-{} digit.", error.base), error.position
+                    );
+                case ErrorCode::ExpectedSuffix:
+                    throw Exception(std::format(
+                        "Expected a suffix after {}.",
+                        Text::quote(error.base == 16 && error.position[-2] == '.'? ".'" : "'")
+                    ), error.position);
+                case ErrorCode::UnseparatedSuffix:
+                    throw Exception(std::format(
+                        "Unexpected character {} in base-16 number (suffixes must be "
+                        "preceded by \".'\").", Text::quote({ *error.position })
+                    ), error.position);
+                case ErrorCode::UnterminatedComment:
+                    throw Exception("Unterminated multi-line comment.", error.position);
+                case ErrorCode::UnterminatedString:
+                    throw Exception("Unterminated string literal.", error.position);
+                case ErrorCode::InvalidEscape:
+                    throw Exception(std::format(
+                        "Invalid escape sequence {} in string literal.",
+                        Text::quote(std::string(error.position, 2))
+                    ), error.position);
+                case ErrorCode::InvalidUtf8:
+                    throw Exception(std::format(
+                        "Invalid UTF-8 sequence starting with byte 0x{:02X}.",
+                        static_cast<unsigned char>(*error.position)
+                    ), error.position);
+                default:
+                    throw Exception(std::format(
+                        "Unexpected character {}.", Text::quote({ *error.position })
+                    ), error.position);
+            }
+        }
+        // Returns the table of the characters the escape sequences decode to, indexed by the 
+        // character after the backslash, or -1 if there is no such escape sequence. Built by 
+        // inverting Text::escapeSimpleChar, so that the strings spelled by Text::escape are 
+        // read back exactly.
+        static std::array<std::int16_t, 256> const& unescapeTable() {
+            static std::array<std::int16_t, 256> const _table = []() {
+                std::array<std::int16_t, 256> _table;
+                _table.fill(-1);
+                for (int c = 0; c < 256; ++c) {
+                    char const _escaped = Text::escapeSimpleChar(static_cast<char>(c));
+                    if (_escaped != '\0') {
+                        _table[static_cast<unsigned char>(_escaped)] = static_cast<std::int16_t>(c);
+                    }
+                }
+                return _table;
+            }();
+            return _table;
+        }
+        // Scans the string literal starting at start, which must be a double quote, looking 
+        // for its closing quote and backslashes with vector compares, so that long literals 
+        // are skipped many characters at a time. Returns the iterator after the closing quote 
+        // and sets hasEscapes to whether there are escape sequences to decode. If the literal 
+        // is malformed, sets the error and returns the iterator after the malformed token 
+        // instead: the end if there is no closing quote, else after the closing quote.
+        static std::string_view::const_iterator scanString(
+            std::string_view::const_iterator start,
+            std::string_view::const_iterator end,
+            bool& hasEscapes,
+            ScanError& error
+        ) {
+            char const* const _first = std::to_address(start);
+            char const* const _last = _first + (end - start);
+            std::array<std::int16_t, 256> const& _unescape = unescapeTable();
+            hasEscapes = false;
+            for (char const* _it = _first + 1;;) {
+                _it = Simd::findAnyOf(_it, _last, '"', '\\');
+                // A backslash as the last character escapes nothing, so the quote is missing.
+                if (_last - _it < 2 && (_it == _last || *_it == '\\')) {
+                    error = { _first, ErrorCode::UnterminatedString };
+                    return end;
+                }
+                if (*_it == '"') {
+                    return start + (_it + 1 - _first);
+                }
+                // The escaped character is skipped even if the escape sequence is invalid, so 
+                // that an escaped quote never closes the literal.
+                hasEscapes = true;
+                bool const _isValid = _unescape[static_cast<unsigned char>(_it[1])] >= 0;
+                if (!_isValid && error.position == nullptr) {
+                    error = { _it, ErrorCode::InvalidEscape };
+                }
+                _it += 2;
+            }
+        }
+        // Appends the value of the body of a string literal (without its quotes), whose escape 
+        // sequences must be valid, to the string. The runs between the backslashes are found 
+        // with vector compares and copied in one go.
+        static void decodeString(std::string_view body, std::string& out) {
+            std::array<std::int16_t, 256> const& _unescape = unescapeTable();
+            char const* _it = body.data();
+            char const* const _end = _it + body.size();
+            for (;;) {
+                char const* const _backslash = Simd::findChar(_it, _end, '\\');
+                out.append(_it, _backslash);
+                if (_backslash == _end) {
+                    return;
+                }
+                out.push_back(
+                    static_cast<char>(_unescape[static_cast<unsigned char>(_backslash[1])])
+                );
+                _it = _backslash + 2;
+            }
+        }
+        // Scans the number whose digits begin at start in a single pass, passing its parts 
+        // and suffixes to the collector. Returns the iterator after the number's end and sets
+        // hasUpper to whether there are uppercase hexadecimal digits to convert. If the number 
+        // is malformed, sets the error and returns the iterator to the character at fault 
+        // instead.
+        template<typename Collector> static std::string_view::const_iterator scanNumber(
+            std::string_view::const_iterator start,
+            std::string_view::const_iterator end,
+            std::int32_t base,
+            Collector& collector,
+            bool& hasUpper,
+            ScanError& error
+        ) {
+            std::uint16_t const _digitClass = digitClassOf(base);
+            hasUpper = false;
+
+            std::string_view::const_iterator _it = start;
+            for (;;) {
+                std::string_view::const_iterator _partEnd = skipDigits(_it, end, base);
+                if (_partEnd == _it) {
+                    // Only reachable for the first part, as the others are only started
+                    // after checking that there is a digit.
+                    bool const _isDigit = _it != end && hasClass(*_it, CharClass::Digit10);
+                    error = {
+                        std::to_address(_it),
+                        _isDigit? ErrorCode::InvalidDigit : ErrorCode::ExpectedDigit,
+                        base
+                    };
+                    return _it;
+                }
+                if (base == 16 && !hasUpper) {
+                    hasUpper = std::any_of(_it, _partEnd, [](char c) {
+                        return hasClass(c, CharClass::UpperHex);
+                    });
+                }
+                collector.AddPart(std::string_view(_it, _partEnd));
+                _it = _partEnd;
+                // A radix only belongs to the number if it is followed by another part.
+                if (
+                    _it != end && *_it == '.'
+                    && std::next(_it) != end
+                    && hasClass(*std::next(_it), _digitClass)
+                ) {
+                    ++_it;
+                    continue;
+                }
+                break;
+            }
+            // Checks for the start of the suffix list, which must be preceded by ".'" in
+            // base-16, as its digits include letters.
+            bool _hasSuffixes = false;
+            if (base == 16) {
+                if (
+                    _it != end && *_it == '.'
+                    && std::next(_it) != end && *std::next(_it) == '\''
+                ) {
+                    _it += 2;
+                    _hasSuffixes = true;
+                    if (_it == end || !startsName(_it, end)) {
+                        error = { std::to_address(_it), ErrorCode::ExpectedSuffix, base };
+                        return _it;
+                    }
+                }
+            } else {
+                _hasSuffixes = _it != end && startsName(_it, end);
+            }
+            if (_hasSuffixes) {
+                for (;;) {
+                    std::string_view::const_iterator _suffixEnd = skipSuffix(_it, end);
+                    collector.AddSuffix(std::string_view(_it, _suffixEnd));
+                    _it = _suffixEnd;
+                    if (_it == end || *_it != '\'') {
+                        break;
+                    }
+                    ++_it;
+                    if (_it == end || !startsName(_it, end)) {
+                        error = { std::to_address(_it), ErrorCode::ExpectedSuffix, base };
+                        return _it;
+                    }
+                }
+            } else if (_it != end && continuesName(_it, end)) {
+                // Digits from larger bases and letters in base-16 numbers cannot follow the
+                // number directly.
+                error = {
+                    std::to_address(_it),
+                    base == 16? ErrorCode::UnseparatedSuffix : ErrorCode::InvalidDigit,
+                    base
+                };
+            }
+            return _it;
+        }
+        // Collector which only keeps what is needed to decode the number's value (its first 
+        // two parts, its number of parts and its first suffix) and to build its owning token 
+        // (where its parts end and its number of suffixes).
+        struct ValueCollector {
+            std::string_view parts[2];
+            std::size_t partCount = 0;
+            std::string_view suffix;
+            std::size_t suffixCount = 0;
+            char const* partsEnd = nullptr;
+
+            void AddPart(std::string_view part) {
+                if (partCount < 2) {
+                    parts[partCount] = part;
+                }
+                ++partCount;
+                partsEnd = part.data() + part.size();
+            }
+            void AddSuffix(std::string_view suffix) {
+                if (suffixCount == 0) {
+                    this->suffix = suffix;
+                }
+                ++suffixCount;
+            }
+        };
+        // Returns the value of a valid digit of any base, in either case.
+        static std::uint32_t digitValue(char c) {
+            if (hasClass(c, CharClass::Digit10)) {
+                return static_cast<std::uint32_t>(c - '0');
+            }
+            return static_cast<std::uint32_t>((c | 0x20) - 'a' + 10);
+        }
+        // Decodes the type requested by the suffix, leaving it as SuffixType::None if it does 
+        // not request one.
+        static void decodeSuffix(
+            std::string_view suffix,
+            SuffixType& suffixType,
+            std::uint16_t& suffixBits
+        ) {
+            suffixType = SuffixType::None;
+            suffixBits = 0;
+            // The bit count cannot have leading zeros, and must fit in 16 bits.
+            if (suffix.size() < 2 || suffix.size() > 6 || suffix[1] == '0') {
+                return;
+            }
+            std::uint32_t _bits = 0;
+            for (char c : suffix.substr(1)) {
+                if (!hasClass(c, CharClass::Digit10)) {
+                    return;
+                }
+                _bits = _bits * 10 + digitValue(c);
+            }
+            if (_bits > std::numeric_limits<std::uint16_t>::max()) {
+                return;
+            }
+            switch (suffix[0]) {
+                case 'u':
+                    suffixType = SuffixType::Unsigned;
+                    break;
+                case 'i':
+                    suffixType = SuffixType::Signed;
+                    break;
+                case 'f':
+                    if (_bits != 16 && _bits != 32 && _bits != 64) {
+                        return;
+                    }
+                    suffixType = SuffixType::Float;
+                    break;
+                default:
+                    return;
+            }
+            suffixBits = static_cast<std::uint16_t>(_bits);
+        }
+        // Returns the number of digits of the base which any 64-bit integer can hold.
+        static std::size_t safeDigitsOf(std::int32_t base) {
+            switch (base) {
+                case 2: return 64;
+                case 8: return 21;
+                case 10: return 19;
+                default: return 16;
+            }
+        }
+        // Returns the value of the eight decimal digits starting at digits, converting all of 
+        // them at once as the bytes of a single integer. Only for little-endian targets.
+        static std::uint64_t decodeEightDigits(char const* digits) {
+            std::uint64_t _chunk;
+            std::memcpy(&_chunk, digits, sizeof(_chunk));
+            // Combines pairs of digits, then pairs of pairs and finally pairs of quadruples, 
+            // the first digit being in the lowest byte.
+            _chunk = ((_chunk & 0x0F0F0F0F0F0F0F0F) * 2561) >> 8;
+            _chunk = ((_chunk & 0x00FF00FF00FF00FF) * 6553601) >> 16;
+            return ((_chunk & 0x0000FFFF0000FFFF) * 42949672960001) >> 32;
+        }
+        // Returns the integer with the digits appended to it, without checking for overflow.
+        static std::uint64_t appendDigits(
+            std::uint64_t integer,
+            std::string_view digits,
+            std::int32_t base
+        ) {
+            std::uint64_t const _base = static_cast<std::uint64_t>(base);
+            if (base == 10) {
+                if constexpr (std::endian::native == std::endian::little) {
+                    while (digits.size() >= 8) {
+                        integer = integer * 100000000 + decodeEightDigits(digits.data());
+                        digits.remove_prefix(8);
+                    }
+                }
+                for (char c : digits) {
+                    integer = integer * 10 + static_cast<std::uint64_t>(c - '0');
+                }
+                return integer;
+            }
+            for (char c : digits) {
+                integer = integer * _base + digitValue(c);
+            }
+            return integer;
+        }
+        // Decodes the digits as a 64-bit integer, returning false if it overflows.
+        static bool decodeInteger(
+            std::string_view digits,
+            std::int32_t base,
+            std::uint64_t& integer
+        ) {
+            // The leading digits cannot overflow, so only the others are checked.
+            std::size_t const _safeDigits = std::min(safeDigitsOf(base), digits.size());
+            integer = appendDigits(0, digits.substr(0, _safeDigits), base);
+            std::uint64_t const _base = static_cast<std::uint64_t>(base);
+            std::uint64_t const _max = std::numeric_limits<std::uint64_t>::max();
+            std::uint64_t const _maxBeforeDigit = _max / _base;
+            for (char c : digits.substr(_safeDigits)) {
+                std::uint32_t _digit = digitValue(c);
+                if (integer > _maxBeforeDigit || integer * _base > _max - _digit) {
+                    return false;
+                }
+                integer = integer * _base + _digit;
+            }
+            return true;
+        }
+        // Decodes the digits as an integer of any size into its 32-bit limbs, starting with 
+        // the least significant.
+        static void decodeBigInteger(
+            std::string_view digits,
+            std::int32_t base,
+            std::vector<std::uint32_t>& limbs
+        ) {
+            std::uint32_t const _base = static_cast<std::uint32_t>(base);
+            // Digits are gathered into chunks as large as possible without overflowing 32 bits,
+            // so that the limbs are only multiplied once per chunk.
+            std::size_t _chunkDigits = 0;
+            for (std::uint64_t _power = 1; _power * _base <= 0xFFFFFFFF; _power *= _base) {
+                ++_chunkDigits;
+            }
+            limbs.clear();
+            for (std::size_t i = 0; i < digits.size(); i += _chunkDigits) {
+                std::string_view _chunk = digits.substr(i, _chunkDigits);
+                std::uint64_t _multiplier = 1;
+                for (std::size_t j = 0; j < _chunk.size(); ++j) {
+                    _multiplier *= _base;
+                }
+                std::uint64_t _carry = appendDigits(0, _chunk, base);
+                for (std::uint32_t& _limb : limbs) {
+                    std::uint64_t _product = _limb * _multiplier + _carry;
+                    _limb = static_cast<std::uint32_t>(_product);
+                    _carry = _product >> 32;
+                }
+                if (_carry != 0) {
+                    limbs.push_back(static_cast<std::uint32_t>(_carry));
+                }
+            }
+        }
+        // Appends the digits of a base-2 or base-8 number as base-16 digits. The integer part 
+        // is padded with zeros on its left and the fractional part on its right, so that the 
+        // value stays the same.
+        static void appendAsHex(
+            std::string& hex,
+            std::string_view digits,
+            std::int32_t base,
+            bool isFraction
+        ) {
+            std::int32_t const _digitBits = base == 2? 1 : 3;
+            std::size_t const _bitCount = digits.size() * _digitBits;
+            std::size_t const _padding = (4 - _bitCount % 4) % 4;
+            std::uint32_t _nibble = 0;
+            std::size_t _nibbleBits = isFraction? 0 : _padding;
+            auto _pushBit = [&](std::uint32_t bit) {
+                _nibble = (_nibble << 1) | bit;
+                if (++_nibbleBits == 4) {
+                    hex.push_back("0123456789abcdef"[_nibble]);
+                    _nibble = 0;
+                    _nibbleBits = 0;
+                }
+            };
+            for (char c : digits) {
+                std::uint32_t _digit = digitValue(c);
+                for (std::int32_t b = _digitBits - 1; b >= 0; --b) {
+                    _pushBit((_digit >> b) & 1);
+                }
+            }
+            while (_nibbleBits != 0) {
+                _pushBit(0);
+            }
+        }
+        // Decodes the number with the integer and fractional parts, correctly rounded to the 
+        // nearest double.
+        static double decodeFloat(
+            std::string_view integer,
+            std::string_view fraction,
+            std::int32_t base
+        ) {
+            // Fast path for mantissas (all the digits, as an integer) which are exact doubles, 
+            // so that dividing by an exact power of ten, or scaling by a power of two, rounds 
+            // a single time and is thus correctly rounded.
+            if (integer.size() + fraction.size() <= safeDigitsOf(base)) {
+                std::uint64_t const _mantissa = appendDigits(
+                    appendDigits(0, integer, base), fraction, base
+                );
+                if (_mantissa <= (std::uint64_t(1) << 53)) {
+                    double const _exact = static_cast<double>(_mantissa);
+                    if (base != 10) {
+                        int const _digitBits = std::countr_zero(static_cast<unsigned>(base));
+                        return std::ldexp(
+                            _exact, -_digitBits * static_cast<int>(fraction.size())
+                        );
+                    }
+                    // Powers of ten up to 10^22 are exact doubles.
+                    static constexpr double _powers[] = {
+                        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+                    };
+                    // Always true, as there are at most 19 digits.
+                    if (fraction.size() < std::size(_powers)) {
+                        return _exact / _powers[fraction.size()];
+                    }
+                }
+            }
+            std::string _copy;
+            std::string_view _text;
+            std::chars_format const _format =
+                base == 10? std::chars_format::fixed : std::chars_format::hex;
+            if (base == 2 || base == 8) {
+                // Powers of two, so converted exactly to base-16.
+                appendAsHex(_copy, integer, base, false);
+                _copy.push_back('.');
+                appendAsHex(_copy, fraction, base, true);
+                _text = _copy;
+            } else if (integer.data() + integer.size() + 1 == fraction.data()) {
+                // The parts are still in the source, separated by the radix.
+                _text = std::string_view(integer.data(), integer.size() + 1 + fraction.size());
+            } else {
+                _copy.reserve(integer.size() + 1 + fraction.size());
+                _copy.append(integer);
+                _copy.push_back('.');
+                _copy.append(fraction);
+                _text = _copy;
+            }
+            double _real = 0.0;
+            std::from_chars_result _result = std::from_chars(
+                _text.data(), _text.data() + _text.size(), _real, _format
+            );
+            // The value cannot be too small, as the integer part is never negative.
+            if (_result.ec == std::errc::result_out_of_range) {
+                _real = std::numeric_limits<double>::infinity();
+            }
+            return _real;
+        }
+        // Decodes the value of the number with the parts, of which only the first two are 
+        // needed, and the first suffix into the payload. The limbs of big integers are 
+        // decoded into limbs instead, to be stored by TokenStream::AppendNumber, so that the 
+        // buffer can be reused and most numbers never allocate.
+        static void decodeValue(
+            std::int32_t base,
+            std::size_t partCount,
+            std::string_view integer,
+            std::string_view fraction,
+            std::string_view suffix,
+            NumberPayload& number,
+            std::vector<std::uint32_t>& limbs
+        ) {
+            if (suffix.empty()) {
+                number.suffixType = SuffixType::None;
+                number.suffixBits = 0;
+            } else {
+                decodeSuffix(suffix, number.suffixType, number.suffixBits);
+            }
+            number.value = 0;
+            switch (partCount) {
+                case 1:
+                    if (decodeInteger(integer, base, number.value)) {
+                        number.valueKind = ValueKind::Integer;
+                    } else {
+                        decodeBigInteger(integer, base, limbs);
+                        number.valueKind = ValueKind::BigInteger;
+                    }
+                    break;
+                case 2:
+                    number.valueKind = ValueKind::Float;
+                    number.value = std::bit_cast<std::uint64_t>(
+                        decodeFloat(integer, fraction, base)
+                    );
+                    break;
+                default:
+                    number.valueKind = ValueKind::None;
+                    break;
+            }
+        }
+        // Returns the value stored in the payload, with the limbs of the big integer.
+        static NumberValue valueOf(
+            NumberPayload const& number,
+            std::span<std::uint32_t const> limbs
+        ) {
+            switch (number.valueKind) {
+                case ValueKind::Integer:
+                    return NumberValue(number.value, number.suffixType, number.suffixBits);
+                case ValueKind::Float:
+                    return NumberValue(
+                        std::bit_cast<double>(number.value), number.suffixType, number.suffixBits
+                    );
+                case ValueKind::BigInteger:
+                    return NumberValue(
+                        std::vector<std::uint32_t>(limbs.begin(), limbs.end()),
+                        number.suffixType,
+                        number.suffixBits
+                    );
+                default:
+                    return NumberValue(number.suffixType, number.suffixBits);
+            }
+        }
+        // Decodes the value of the number with the parts and suffixes.
+        static NumberValue decodeValue(
+            std::int32_t base,
+            std::vector<std::string_view> const& parts,
+            std::vector<std::string_view> const& suffixes
+        ) {
+            NumberPayload _number;
+            std::vector<std::uint32_t> _limbs;
+            decodeValue(
+                base,
+                parts.size(),
+                parts.empty()? std::string_view() : parts[0],
+                parts.size() > 1? parts[1] : std::string_view(),
+                suffixes.empty()? std::string_view() : suffixes[0],
+                _number,
+                _limbs
+            );
+            return valueOf(_number, _limbs);
+        }
+        // Scans the number whose digits begin at start and builds its token. Used by all 
+        // Number::parseBase* functions.
+        static TokenResult parseNumber(
+            std::string_view::const_iterator start,
+            std::string_view::const_iterator end,
+            std::int32_t base
+        ) {
+            ValueCollector _collector;
+            bool _hasUpper;
+            ScanError _error;
+            std::string_view::const_iterator _it = scanNumber(
+                start, end, base, _collector, _hasUpper, _error
+            );
+            if (_error.position != nullptr) {
+                throwError(_error);
+            }
+            NumberPayload _number;
+            std::vector<std::uint32_t> _limbs;
+            decodeValue(
+                base,
+                _collector.partCount,
+                _collector.parts[0],
+                _collector.parts[1],
+                _collector.suffix,
+                _number,
+                _limbs
+            );
+            // The parts and suffixes are copied with their separators, as in the source.
+            char const* const _first = std::to_address(start);
+            std::string_view const _parts = std::string_view(
+                _first, _collector.partsEnd - _first
+            );
+            std::string_view _suffixes;
+            if (_collector.suffixCount != 0) {
+                char const* const _suffixStart = _collector.suffix.data();
+                _suffixes = std::string_view(_suffixStart, std::to_address(_it) - _suffixStart);
+            }
+            return {
+                _it, Token(
+                    Number(
+                        _parts,
+                        _collector.partCount,
+                        _suffixes,
+                        _collector.suffixCount,
+                        base,
+                        _hasUpper,
+                        valueOf(_number, _limbs)
+                    ),
+                    false
+                )
+            };
+        }
+        // Where the body of a number starts (after its base prefix) and its base.
+        struct NumberLead {
+            std::string_view::const_iterator body;
+            std::int32_t base;
+        };
+        // Decodes the base prefix of the number starting at start, which must be a decimal 
+        // digit.
+        static NumberLead leadNumber(
+            std::string_view::const_iterator start,
+            std::string_view::const_iterator end
+        ) {
+            if (*start == '0') {
+                std::string_view::const_iterator _next = std::next(start);
+                if (_next != end) {
+                    switch (*_next) {
+                        // Binary (`0b`).
+                        case 'b':
+                            return { std::next(_next), 2 };
+                        // Octal (`0o`).
+                        case 'o':
+                            return { std::next(_next), 8 };
+                        // Hexadecimal (`0x`).
+                        case 'x':
+                            return { std::next(_next), 16 };
+                        default:
+                            // Octal (`0` followed by digits).
+                            if (isDigit10(*_next)) {
+                                return { _next, 8 };
+                            }
+                            break;
+                    }
+                }
+                // Decimal number starting with zero, such as `0`, `0.5` or `0u8`.
+            }
+            return { start, 10 };
+        }
+        // Returns an iterator to the end of the name starting at start, which must be a 
+        // character which can start a name.
+        static std::string_view::const_iterator skipName(
+            std::string_view::const_iterator start,
+            std::string_view::const_iterator end
+        ) {
+            char const* _first = std::to_address(start);
+            char const* _last = _first + (end - start);
+            // The first character can also continue a name, so it is skipped like the others.
+            char const* _it = _first;
+            for (;;) {
+                _it = Simd::findNotInRanges(_it, _last,
+                    Simd::CharRange{ 'a', 'z' },
+                    Simd::CharRange{ 'A', 'Z' },
+                    Simd::CharRange{ '0', '9' },
+                    Simd::CharRange{ '_', '_' }
+                );
+                // Characters outside ASCII are decoded one at a time, and the vector scan
+                // resumes after them.
+                if (_it == _last || static_cast<unsigned char>(*_it) < 0x80) {
+                    break;
+                }
+                std::size_t const _length = nameContinueLength(_it, _last);
+                if (_length == 0) {
+                    break;
+                }
+                _it += _length;
+            }
+            return start + (_it - _first);
+        }
+        // Returns an iterator to the end of the malformed token whose error is at start, 
+        // skipping the rest of what looks like the same token.
+        static std::string_view::const_iterator skipMalformed(
+            std::string_view::const_iterator start,
+            std::string_view::const_iterator end
+        ) {
+            while (start != end) {
+                if (*start == '.' || *start == '\'') {
+                    ++start;
+                    continue;
+                }
+                char const* const _it = std::to_address(start);
+                std::size_t const _length = nameContinueLength(_it, _it + (end - start));
+                if (_length == 0) {
+                    break;
+                }
+                start += _length;
+            }
+            return start;
+        }
+        // Returns an iterator to the next character after start which can start a token (or 
+        // whitespace or a comment), so that a run of unexpected characters is a single error.
+        // Characters outside ASCII are skipped whole, as are invalid UTF-8 sequences.
+        static std::string_view::const_iterator skipUnexpected(
+            std::string_view::const_iterator start,
+            std::string_view::const_iterator end
+        ) {
+            char const* const _first = std::to_address(start);
+            char const* const _last = _first + (end - start);
+            char const* _it = _first + decodeUtf8(_first, _last).length;
+            while (_it != _last) {
+                if (static_cast<unsigned char>(*_it) < 0x80) {
+                    if (
+                        hasClass(*_it, CharClass::Space | CharClass::NameStart | CharClass::Digit10)
+                        || *_it == '"' || operatorTable.IsStart(*_it)
+                    ) {
+                        break;
+                    }
+                    ++_it;
+                } else {
+                    if (nameStartLength(_it, _last) != 0) {
+                        break;
+                    }
+                    _it += decodeUtf8(_it, _last).length;
+                }
+            }
+            return start + (_it - _first);
+        }
+        // Kind of a scanned token and its payload, if it has one.
+        struct Scanned {
+            Kind kind;
+            NumberPayload number;
+            // Limbs of a big integer. Reused between tokens, so that it rarely allocates.
+            std::vector<std::uint32_t> limbs;
+            Symbol name;
+            Operator op;
+            // Whether a string has escape sequences to decode.
+            bool hasEscapes = false;
+            // Error of an error token.
+            ScanError error;
+        };
+        // Appends the scanned token to the stream.
+        static void appendScanned(TokenStream& stream, Span span, Scanned const& scanned) {
+            switch (scanned.kind) {
+                case Kind::Number:
+                    stream.AppendNumber(span, scanned.number, scanned.limbs);
+                    break;
+                case Kind::Name:
+                    stream.AppendName(span, scanned.name);
+                    break;
+                case Kind::String:
+                    stream.AppendString(span, scanned.hasEscapes);
+                    break;
+                case Kind::Punct:
+                    stream.AppendPunct(span, scanned.op);
+                    break;
+                default:
+                    stream.Append(scanned.kind, span);
+                    break;
+            }
+        }
+        // Scans the token starting at start without building it, returning the iterator 
+        // after its end and setting its kind and payload. Names are interned in the global 
+        // symbol table. Never throws for errors in the source: malformed tokens are scanned 
+        // as error tokens, with their error.
+        static std::string_view::const_iterator scanNext(
+            std::string_view::const_iterator start,
+            std::string_view::const_iterator end,
+            Scanned& scanned
+        ) {
+            // Characters outside ASCII are only decoded when their first byte is reached.
+            if (
+                hasClass(*start, CharClass::NameStart)
+                || (static_cast<unsigned char>(*start) >= 0x80 && startsName(start, end))
+            ) {
+                std::string_view::const_iterator _it = skipName(start, end);
+                scanned.kind = Kind::Name;
+                scanned.name = globalSymbols().Intern(std::string_view(start, _it));
+                return _it;
+            }
+            if (isDigit10(*start)) {
+                NumberLead _lead = leadNumber(start, end);
+                ValueCollector _collector;
+                bool _hasUpper;
+                scanned.error.position = nullptr;
+                std::string_view::const_iterator _it = scanNumber(
+                    _lead.body, end, _lead.base, _collector, _hasUpper, scanned.error
+                );
+                if (scanned.error.position != nullptr) {
+                    scanned.kind = Kind::Error;
+                    return skipMalformed(_it, end);
+                }
+                decodeValue(
+                    _lead.base,
+                    _collector.partCount,
+                    _collector.parts[0],
+                    _collector.parts[1],
+                    _collector.suffix,
+                    scanned.number,
+                    scanned.limbs
+                );
+                scanned.kind = Kind::Number;
+                scanned.number.bodyOffset = static_cast<std::uint8_t>(_lead.body - start);
+                scanned.number.base = static_cast<std::uint8_t>(_lead.base);
+                scanned.number.flags = _hasUpper? NumberPayload::uppercaseFlag : 0;
+                return _it;
+            }
+            if (*start == '"') {
+                scanned.error.position = nullptr;
+                std::string_view::const_iterator _it = scanString(
+                    start, end, scanned.hasEscapes, scanned.error
+                );
+                scanned.kind = scanned.error.position != nullptr? Kind::Error : Kind::String;
+                return _it;
+            }
+            OperatorMatch const _match = operatorTable.Match(std::string_view(start, end));
+            if (_match.length != 0) {
+                scanned.kind = Kind::Punct;
+                scanned.op = _match.op;
+                return start + _match.length;
+            }
+            scanned.kind = Kind::Error;
+            scanned.error = { std::to_address(start), ErrorCode::UnexpectedCharacter };
+            return skipUnexpected(start, end);
+        }
+        // Appends the spelling of the token (or view) to the string, growing it a single time 
+        // to the exact size.
+        template<typename T> static void spellInto(T const& token, std::string& out) {
+            std::size_t const _oldSize = out.size();
+            out.resize(_oldSize + token.GetSpellingSize());
+            token.AppendSpelling(out.data() + _oldSize);
+        }
+
+        Exception::Exception(std::string const& message, char const* position)
+            : std::runtime_error(message) {
+            this->position = position;
+        }
+        Exception::Exception(std::string const& message, std::size_t offset)
+            : std::runtime_error(message) {
+            this->offset = offset;
+        }
+        std::size_t Exception::GetOffset() const {
+            return offset;
+        }
+        void Exception::Locate(std::string_view source) {
+            // Compared through std::less_equal, as the position might be in another buffer.
+            std::less_equal<char const*> const _lessEqual;
+            if (
+                offset == noOffset && position != nullptr
+                && _lessEqual(source.data(), position)
+                && _lessEqual(position, source.data() + source.size())
+            ) {
+                offset = static_cast<std::size_t>(position - source.data());
+            }
+        }
+
+        std::string_view errorMessage(ErrorCode code) {
+            switch (code) {
+                case ErrorCode::UnexpectedCharacter:
+                    return "Unexpected character.";
+                case ErrorCode::InvalidDigit:
+                    return "Invalid digit in number.";
+                case ErrorCode::ExpectedDigit:
+                    return "Expected a digit.";
+                case ErrorCode::ExpectedSuffix:
+                    return "Expected a suffix.";
+                case ErrorCode::UnseparatedSuffix:
+                    return "Suffixes of base-16 numbers must be preceded by \".'\".";
+                case ErrorCode::UnterminatedComment:
+                    return "Unterminated multi-line comment.";
+                case ErrorCode::UnterminatedString:
+                    return "Unterminated string literal.";
+                case ErrorCode::InvalidEscape:
+                    return "Invalid escape sequence in string literal.";
+                case ErrorCode::InvalidUtf8:
+                    return "Invalid UTF-8 sequence.";
+                default:
+                    return "Unknown error.";
+            }
+        }
+
+        Name::Name(Symbol symbol) {
+            this->symbol = symbol;
+        }
+        Name::Name(std::string_view spelling) {
+            this->symbol = globalSymbols().Intern(spelling);
+        }
         bool Name::operator==(Name const& other) const {
-            return spelling == other.spelling;
+            return symbol == other.symbol;
         }
         bool Name::operator!=(Name const& other) const {
             return !(*this == other);
         }
         std::string Name::GetSpelling() const {
-            throw NotImplementedException("Not implemented yet.");
+            return std::string(globalSymbols().GetSpelling(symbol));
         }
-        void Number::moveFrom(Number&& other) {
-            this->storage = std::move(other.storage);
-            this->parts = std::move(other.parts);
-            this->suffixes = std::move(other.suffixes);
-            this->base = std::move(other.base);
+        std::size_t Name::GetSpellingSize() const {
+            return globalSymbols().GetSpelling(symbol).size();
         }
-        Number::Number(Number&& other) {
-            moveFrom(std::move(other));
+        void Name::SpellInto(std::string& out) const {
+            out.append(globalSymbols().GetSpelling(symbol));
         }
-        Number::Number(
-            std::unique_ptr<std::string>&& storage,
-            std::vector<std::string_view>&& parts,
-            std::vector<std::string_view>&& suffixes,
-            std::int32_t base
+        Symbol Name::GetSymbol() const {
+            return symbol;
+        }
+        void NumberValue::setSuffix(SuffixType suffixType, std::uint16_t suffixBits) {
+            this->suffixType = suffixType;
+            this->suffixBits = suffixBits;
+            // Number of significant bits of an integer.
+            std::uint32_t _valueBits = 0;
+            if (kind == ValueKind::Integer) {
+                _valueBits = static_cast<std::uint32_t>(std::bit_width(integer));
+            } else if (kind == ValueKind::BigInteger) {
+                _valueBits =
+                    static_cast<std::uint32_t>(limbs.size() - 1) * 32
+                    + static_cast<std::uint32_t>(std::bit_width(limbs.back()))
+                ;
+            }
+            switch (suffixType) {
+                case SuffixType::None:
+                    fits = true;
+                    break;
+                case SuffixType::Unsigned:
+                case SuffixType::Signed: {
+                    bool _isInteger = kind == ValueKind::Integer || kind == ValueKind::BigInteger;
+                    // One of the bits is the sign of signed integers.
+                    std::uint32_t _available =
+                        suffixType == SuffixType::Signed? suffixBits - 1u : suffixBits;
+                    fits = _isInteger && _valueBits <= _available;
+                    break;
+                }
+                case SuffixType::Float: {
+                    double _max;
+                    switch (suffixBits) {
+                        case 16: _max = 65504.0; break;
+                        case 32: _max = std::numeric_limits<float>::max(); break;
+                        default: _max = std::numeric_limits<double>::max(); break;
+                    }
+                    switch (kind) {
+                        case ValueKind::Integer:
+                            fits = static_cast<double>(integer) <= _max;
+                            break;
+                        case ValueKind::BigInteger:
+                            // Larger than any double, even after rounding.
+                            fits = _valueBits <= 1024 && std::ldexp(
+                                static_cast<double>(limbs.back()),
+                                static_cast<int>(limbs.size() - 1) * 32
+                            ) <= _max;
+                            break;
+                        case ValueKind::Float:
+                            fits = real <= _max;
+                            break;
+                        default:
+                            fits = false;
+                            break;
+                    }
+                    break;
+                }
+            }
+        }
+        NumberValue::NumberValue(SuffixType suffixType, std::uint16_t suffixBits) {
+            setSuffix(suffixType, suffixBits);
+        }
+        NumberValue::NumberValue(
+            std::uint64_t integer,
+            SuffixType suffixType,
+            std::uint16_t suffixBits
+        ) {
+            this->kind = ValueKind::Integer;
+            this->integer = integer;
+            setSuffix(suffixType, suffixBits);
+        }
+        NumberValue::NumberValue(
+            std::vector<std::uint32_t>&& limbs,
+            SuffixType suffixType,
+            std::uint16_t suffixBits
         ) {
-            this->storage = std::move(storage);
-            this->parts = std::move(parts);
-            this->suffixes = std::move(suffixes);
+            while (!limbs.empty() && limbs.back() == 0) {
+                limbs.pop_back();
+            }
+            if (limbs.size() <= 2) {
+                this->kind = ValueKind::Integer;
+                for (std::size_t i = limbs.size(); i-- > 0;) {
+                    this->integer = (this->integer << 32) | limbs[i];
+                }
+            } else {
+                this->kind = ValueKind::BigInteger;
+                this->limbs = std::move(limbs);
+            }
+            setSuffix(suffixType, suffixBits);
+        }
+        NumberValue::NumberValue(double real, SuffixType suffixType, std::uint16_t suffixBits) {
+            this->kind = ValueKind::Float;
+            this->real = real;
+            setSuffix(suffixType, suffixBits);
+        }
+        ValueKind NumberValue::GetKind() const {
+            return kind;
+        }
+        SuffixType NumberValue::GetSuffixType() const {
+            return suffixType;
+        }
+        std::uint16_t NumberValue::GetSuffixBits() const {
+            return suffixBits;
+        }
+        bool NumberValue::Fits() const {
+            return fits;
+        }
+        std::uint64_t NumberValue::GetInteger() const {
+            return integer;
+        }
+        double NumberValue::GetFloat() const {
+            return real;
+        }
+        std::span<std::uint32_t const> NumberValue::GetLimbs() const {
+            return limbs;
+        }
+
+        char* Number::allocateText(std::size_t size) {
+            if (size > std::numeric_limits<std::uint32_t>::max()) {
+                throw std::length_error(std::format(
+                    "Number: Text of {} bytes is too long.", size
+                ));
+            }
+            textSize = static_cast<std::uint32_t>(size);
+            if (size <= inlineCapacity) {
+                return inlineText;
+            }
+            heapText = new char[size];
+            return heapText;
+        }
+        char const* Number::getText() const {
+            return textSize <= inlineCapacity? inlineText : heapText;
+        }
+        std::string_view Number::getElement(
+            std::string_view text,
+            char separator,
+            std::size_t index
+        ) {
+            for (; index != 0; --index) {
+                text.remove_prefix(text.find(separator) + 1);
+            }
+            return text.substr(0, text.find(separator));
+        }
+        Number::Number(
+            std::string_view parts,
+            std::size_t partCount,
+            std::string_view suffixes,
+            std::size_t suffixCount,
+            std::int32_t base,
+            bool lowercase,
+            NumberValue&& value
+        ) : value(std::move(value)) {
+            char* _it = allocateText(parts.size() + suffixes.size());
+            if (lowercase) {
+                // Hexadecimal numbers are always lowercase internally.
+                _it = std::transform(parts.begin(), parts.end(), _it, [](char c) {
+                    return hasClass(c, CharClass::UpperHex)? static_cast<char>(c - 'A' + 'a') : c;
+                });
+            } else {
+                _it = std::copy(parts.begin(), parts.end(), _it);
+            }
+            // Suffixes are not digits, so they are never converted.
+            std::copy(suffixes.begin(), suffixes.end(), _it);
+            this->partsSize = static_cast<std::uint32_t>(parts.size());
+            this->partCount = static_cast<std::uint32_t>(partCount);
+            this->suffixCount = static_cast<std::uint32_t>(suffixCount);
             this->base = base;
         }
         Number::Number(
             std::vector<std::string_view> const& parts,
             std::vector<std::string_view> const& suffixes,
             std::int32_t base
-        ) {
-            // The base can be set without worrying about the storage string.
-            {
-                std::size_t _totalSize = 0;
-                for (std::string_view s : parts) { _totalSize += s.size(); }
-                for (std::string_view s : suffixes) { _totalSize += s.size(); }
-                // Reconstructs the storage string with the correct size, so that there is no 
-                // need for multiple allocations.
-                this->storage = std::make_unique<std::string>(_totalSize, '#');
-            }
-            this->parts = std::vector<std::string_view>(parts.size());
-            this->suffixes = std::vector<std::string_view>(suffixes.size());
-            this->base = base;
+        ) : value(decodeValue(base, parts, suffixes)) {
+            // Computes the size first, so that the text is allocated a single time.
+            std::size_t _partsSize = parts.empty()? 0 : parts.size() - 1;
+            for (std::string_view _part : parts) { _partsSize += _part.size(); }
+            std::size_t _suffixesSize = suffixes.empty()? 0 : suffixes.size() - 1;
+            for (std::string_view _suffix : suffixes) { _suffixesSize += _suffix.size(); }
 
-            std::string::iterator _it = this->storage->begin();
+            char* _it = allocateText(_partsSize + _suffixesSize);
             for (std::size_t i = 0; i < parts.size(); ++i) {
-                std::string_view _s = parts[i];
+                if (i != 0) {
+                    *_it++ = '.';
+                }
+                _it = std::copy(parts[i].begin(), parts[i].end(), _it);
+            }
+            for (std::size_t i = 0; i < suffixes.size(); ++i) {
+                if (i != 0) {
+                    *_it++ = '\'';
+                }
+                _it = std::copy(suffixes[i].begin(), suffixes[i].end(), _it);
+            }
+            this->partsSize = static_cast<std::uint32_t>(_partsSize);
+            this->partCount = static_cast<std::uint32_t>(parts.size());
+            this->suffixCount = static_cast<std::uint32_t>(suffixes.size());
+            this->base = base;
+        }
+        Number::Number(Number&& other) noexcept
+            : textSize(other.textSize),
+            partsSize(other.partsSize),
+            partCount(other.partCount),
+            suffixCount(other.suffixCount),
+            base(other.base),
+            value(std::move(other.value)) {
+            // Either the inline text or the heap pointer, which is taken over.
+            std::memcpy(inlineText, other.inlineText, inlineCapacity);
+            other.textSize = 0;
+            other.partsSize = 0;
+            other.partCount = 0;
+            other.suffixCount = 0;
+        }
+        Number::~Number() {
+            if (textSize > inlineCapacity) {
+                delete[] heapText;
+            }
+        }
+        Number& Number::operator=(Number&& other) noexcept {
+            if (this != &other) {
+                if (textSize > inlineCapacity) {
+                    delete[] heapText;
+                }
+                std::memcpy(inlineText, other.inlineText, inlineCapacity);
+                textSize = std::exchange(other.textSize, 0);
+                partsSize = std::exchange(other.partsSize, 0);
+                partCount = std::exchange(other.partCount, 0);
+                suffixCount = std::exchange(other.suffixCount, 0);
+                base = other.base;
+                value = std::move(other.value);
+            }
+            return *this;
+        }
+        bool Number::operator==(Number const& other) const {
+            // The counts and the joined text are enough, as the separators are unambiguous.
+            return
+                (partCount == other.partCount)
+                && (suffixCount == other.suffixCount)
+                && (partsSize == other.partsSize)
+                && (base == other.base)
+                && std::string_view(getText(), textSize)
+                    == std::string_view(other.getText(), other.textSize)
+            ;
+        }
+        bool Number::operator!=(Number const& other) const {
+            return !(*this == other);
+        }
+        TokenResult Number::parseBase2(
+            std::string_view::const_iterator start,
+            std::string_view::const_iterator end
+        ) {
+            return parseNumber(start, end, 2);
+        }
+        TokenResult Number::parseBase8(
+            std::string_view::const_iterator start,
+            std::string_view::const_iterator end
+        ) {
+            return parseNumber(start, end, 8);
+        }
+        TokenResult Number::parseBase10(
+            std::string_view::const_iterator start,
+            std::string_view::const_iterator end
+        ) {
+            return parseNumber(start, end, 10);
+        }
+        TokenResult Number::parseBase16(
+            std::string_view::const_iterator start,
+            std::string_view::const_iterator end
+        ) {
+            return parseNumber(start, end, 16);
+        }
+        std::string_view basePrefix(std::int32_t base) {
+            switch (base) {
+                case 2:
+                    return "0b";
+                case 8:
+                    return "0";
+                case 10:
+                    return "";
+                case 16:
+                    return "0x";
+                default:
+                    throw std::runtime_error(std::format(
+                        "basePrefix: Base {} is unsupported.", base
+                    ));
+            }
+        }
+        std::string Number::GetSpelling() const {
+            std::string _spelling;
+            SpellInto(_spelling);
+            return _spelling;
+        }
+        std::size_t Number::GetSpellingSize() const {
+            // The text already includes the radixes and suffix separators, so only the base 
+            // prefix is added.
+            std::size_t _size = textSize + basePrefix(base).size();
+            // Adds the radix followed by a suffix/number separator (".'"), necessary before 
+            // the suffix list, as a base-16 number includes letters.
+            if (base == 16 && suffixCount != 0) { _size += 2; }
+            return _size;
+        }
+        void Number::SpellInto(std::string& out) const {
+            spellInto(*this, out);
+        }
+        std::size_t Number::GetPartCount() const {
+            return partCount;
+        }
+        std::string_view Number::GetPart(std::size_t index) const {
+            if (index >= partCount) {
+                throw std::out_of_range(std::format(
+                    "Number::GetPart: Part {} is outside the {} parts.", index, partCount
+                ));
+            }
+            return getElement(std::string_view(getText(), partsSize), '.', index);
+        }
+        std::size_t Number::GetSuffixCount() const {
+            return suffixCount;
+        }
+        std::string_view Number::GetSuffix(std::size_t index) const {
+            if (index >= suffixCount) {
+                throw std::out_of_range(std::format(
+                    "Number::GetSuffix: Suffix {} is outside the {} suffixes.", index, suffixCount
+                ));
+            }
+            return getElement(
+                std::string_view(getText() + partsSize, textSize - partsSize), '\'', index
+            );
+        }
+        std::int32_t Number::GetBase() const {
+            return base;
+        }
+        NumberValue const& Number::GetValue() const {
+            return value;
+        }
 
-                std::string::iterator _oldIt = _it;
-                _it = std::copy(_s.begin(), _s.end(), _it);
+        std::size_t quotedSize(std::string_view value) {
+            std::size_t _size = value.size() + 2;
+            for (char c : value) {
+                _size += hasClass(c, CharClass::Escaped)? 1 : 0;
+            }
+            return _size;
+        }
+        String::String(std::string_view value) {
+            this->value = value;
+        }
+        bool String::operator==(String const& other) const {
+            return value == other.value;
+        }
+        bool String::operator!=(String const& other) const {
+            return !(*this == other);
+        }
+        TokenResult String::parse(
+            std::string_view::const_iterator start,
+            std::string_view::const_iterator end
+        ) {
+            bool _hasEscapes;
+            ScanError _error;
+            std::string_view::const_iterator _it = scanString(start, end, _hasEscapes, _error);
+            if (_error.position != nullptr) {
+                throwError(_error);
+            }
+            std::string_view const _body = std::string_view(std::next(start), std::prev(_it));
+            String _string;
+            if (_hasEscapes) {
+                decodeString(_body, _string.value);
+            } else {
+                _string.value = _body;
+            }
+            return { _it, Token(std::move(_string), false) };
+        }
+        std::string String::GetSpelling() const {
+            std::string _spelling;
+            SpellInto(_spelling);
+            return _spelling;
+        }
+        std::size_t String::GetSpellingSize() const {
+            return quotedSize(value);
+        }
+        void String::SpellInto(std::string& out) const {
+            spellInto(*this, out);
+        }
+        std::string_view String::GetValue() const {
+            return value;
+        }
 
-                // Uses the previous iterator and the current one to constuct the string_view.
-                this->parts[i] = std::string_view(_oldIt, _it);
+        Punct::Punct(Operator op) {
+            this->op = op;
+        }
+        bool Punct::operator==(Punct const& other) const {
+            return op == other.op;
+        }
+        bool Punct::operator!=(Punct const& other) const {
+            return !(*this == other);
+        }
+        TokenResult Punct::parse(
+            std::string_view::const_iterator start,
+            std::string_view::const_iterator end
+        ) {
+            OperatorMatch const _match = operatorTable.Match(std::string_view(start, end));
+            if (_match.length == 0) {
+                throwError({ std::to_address(start), ErrorCode::UnexpectedCharacter });
             }
-            for (std::size_t i = 0; i < suffixes.size(); ++i) {
-                std::string_view _s = suffixes[i];
+            return { start + _match.length, Token(Punct(_match.op), false) };
+        }
+        std::string Punct::GetSpelling() const {
+            return std::string(spellingOf(op));
+        }
+        std::size_t Punct::GetSpellingSize() const {
+            return spellingOf(op).size();
+        }
+        void Punct::SpellInto(std::string& out) const {
+            out.append(spellingOf(op));
+        }
+        Operator Punct::GetOperator() const {
+            return op;
+        }
+
+        // Containers relocate tokens by moving them only if it cannot throw.
+        static_assert(std::is_nothrow_move_constructible_v<Token>);
+        static_assert(std::is_nothrow_move_assignable_v<Token>);
+
+        Token::Token(VariantType&& innerVal, bool hasSpaceAfter) {
+            var = std::move(innerVal);
+            this->hasSpaceAfter = hasSpaceAfter;
+        }
+        bool Token::operator==(Token const& other) const {
+            return this->var == other.var && this->hasSpaceAfter == other.hasSpaceAfter;
+        }
+        bool Token::operator!=(Token const& other) const {
+            return !(operator==(other));
+        }
+        std::string Token::GetSpelling() const {
+            std::string _spelling;
+            SpellInto(_spelling);
+            return _spelling;
+        }
+        std::size_t Token::GetSpellingSize() const {
+            std::size_t _size = std::visit([](auto const& arg) {
+                return arg.GetSpellingSize();
+            }, var);
+            return hasSpaceAfter? _size + 1 : _size;
+        }
+        void Token::SpellInto(std::string& out) const {
+            spellInto(*this, out);
+        }
+        bool Token::HasSpaceAfter() const {
+            return hasSpaceAfter;
+        }
+        void Token::HasSpaceAfter(bool hasSpaceAfter) {
+            this->hasSpaceAfter = hasSpaceAfter;
+        }
 
-                std::string::iterator _oldIt = _it;
-                _it = std::copy(_s.begin(), _s.end(), _it);
+        TokenView::TokenView(TokenStream const& stream, std::size_t index) {
+            this->stream = &stream;
+            this->index = index;
+        }
+        bool TokenView::operator==(Token const& other) const {
+            return MakeToken() == other;
+        }
+        bool TokenView::operator!=(Token const& other) const {
+            return !(*this == other);
+        }
+        std::size_t TokenView::GetIndex() const {
+            return index;
+        }
+        Kind TokenView::GetKind() const {
+            return stream->GetKind(index);
+        }
+        Span TokenView::GetSpan() const {
+            return stream->GetSpan(index);
+        }
+        SourceLocation TokenView::GetLocation() const {
+            return stream->GetLocation(index);
+        }
+        std::string_view TokenView::GetText() const {
+            return stream->GetText(index);
+        }
+        bool TokenView::HasSpaceAfter() const {
+            return stream->HasSpaceAfter(index);
+        }
+        Token TokenView::MakeToken() const {
+            return stream->MakeToken(index);
+        }
+        std::string TokenView::GetSpelling() const {
+            std::string _spelling;
+            SpellInto(_spelling);
+            return _spelling;
+        }
+        std::size_t TokenView::GetSpellingSize() const {
+            return stream->GetSpellingSize(index);
+        }
+        void TokenView::SpellInto(std::string& out) const {
+            spellInto(*this, out);
+        }
+
+        TokenWindow::TokenWindow(TokenStream const& stream, std::size_t first, std::size_t count) {
+            this->stream = &stream;
+            this->first = std::min(first, stream.Size());
+            this->count = std::min(count, stream.Size() - this->first);
+        }
+        std::size_t TokenWindow::Size() const {
+            return count;
+        }
+        TokenView TokenWindow::operator[](std::size_t index) const {
+            return TokenView(*stream, first + index);
+        }
+        std::span<Kind const> TokenWindow::GetKinds() const {
+            return stream->GetKinds().subspan(first, count);
+        }
+
+        TokenStream::Iterator::Iterator(TokenStream const& stream, std::size_t index) {
+            this->stream = &stream;
+            this->index = index;
+        }
+        TokenView TokenStream::Iterator::operator*() const {
+            return TokenView(*stream, index);
+        }
+        TokenStream::Iterator::pointer TokenStream::Iterator::operator->() const {
+            return { TokenView(*stream, index) };
+        }
+        TokenView TokenStream::Iterator::operator[](difference_type offset) const {
+            return TokenView(*stream, index + offset);
+        }
+        TokenStream::Iterator& TokenStream::Iterator::operator++() {
+            ++index;
+            return *this;
+        }
+        TokenStream::Iterator TokenStream::Iterator::operator++(int) {
+            Iterator _old = *this;
+            ++index;
+            return _old;
+        }
+        TokenStream::Iterator& TokenStream::Iterator::operator--() {
+            --index;
+            return *this;
+        }
+        TokenStream::Iterator TokenStream::Iterator::operator--(int) {
+            Iterator _old = *this;
+            --index;
+            return _old;
+        }
+        TokenStream::Iterator& TokenStream::Iterator::operator+=(difference_type offset) {
+            index += offset;
+            return *this;
+        }
+        TokenStream::Iterator& TokenStream::Iterator::operator-=(difference_type offset) {
+            index -= offset;
+            return *this;
+        }
+        TokenStream::Iterator TokenStream::Iterator::operator+(difference_type offset) const {
+            return Iterator(*stream, index + offset);
+        }
+        TokenStream::Iterator TokenStream::Iterator::operator-(difference_type offset) const {
+            return Iterator(*stream, index - offset);
+        }
+        TokenStream::Iterator::difference_type TokenStream::Iterator::operator-(
+            Iterator const& other
+        ) const {
+            return static_cast<difference_type>(index) - static_cast<difference_type>(other.index);
+        }
+        bool TokenStream::Iterator::operator==(Iterator const& other) const {
+            return index == other.index;
+        }
 
-                // Uses the previous iterator and the current one to constuct the string_view.
-                this->suffixes[i] = std::string_view(_oldIt, _it);
+        TokenStream::TokenStream(Memory::Strong<std::string const> source) {
+            this->source = std::move(source);
+            this->lines = Memory::makeStrong<LazyLines>();
+        }
+        bool TokenStream::operator==(TokenStream const& other) const {
+            if (kinds != other.kinds || spans != other.spans || *source != *other.source) {
+                return false;
             }
+            for (std::size_t i = 0; i < kinds.size(); ++i) {
+                if (HasSpaceAfter(i) != other.HasSpaceAfter(i)) {
+                    return false;
+                }
+                if (kinds[i] == Kind::Number && GetNumber(i) != other.GetNumber(i)) {
+                    return false;
+                }
+                if (kinds[i] == Kind::Name && GetName(i) != other.GetName(i)) {
+                    return false;
+                }
+                if (kinds[i] == Kind::String && GetString(i) != other.GetString(i)) {
+                    return false;
+                }
+                if (kinds[i] == Kind::Punct && GetOperator(i) != other.GetOperator(i)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+        bool TokenStream::operator!=(TokenStream const& other) const {
+            return !(*this == other);
         }
-        Number& Number::operator=(Number&& other) {
-            moveFrom(std::move(other));
-            return *this;
+        std::string_view TokenStream::GetSource() const {
+            return *source;
         }
-        bool Number::operator==(Number const& other) const {
-            return
-                (parts == other.parts)
-                && (suffixes == other.suffixes)
-                && (base == other.base)
-            ;
+        Memory::Strong<std::string const> const& TokenStream::GetSourceBuffer() const {
+            return source;
         }
-        bool Number::operator!=(Number const& other) const {
-            return !(*this == other);
+        std::size_t TokenStream::Size() const {
+            return kinds.size();
         }
-        TokenResult Number::parseBase2(
-            std::string_view::const_iterator start,
-            std::string_view::const_iterator end
-        ) {
-            return {};
+        bool TokenStream::Empty() const {
+            return kinds.empty();
         }
-        TokenResult Number::parseBase8(
-            std::string_view::const_iterator start,
-            std::string_view::const_iterator end
-        ) {
-            return {};
+        TokenView TokenStream::operator[](std::size_t index) const {
+            return TokenView(*this, index);
         }
-        TokenResult Number::parseBase10(
-            std::string_view::const_iterator start,
-            std::string_view::const_iterator end
-        ) {
-            return {};
+        TokenStream::Iterator TokenStream::begin() const {
+            return Iterator(*this, 0);
         }
-        TokenResult Number::parseBase16(
-            std::string_view::const_iterator start,
-            std::string_view::const_iterator end
-        ) {
-            return {};
+        TokenStream::Iterator TokenStream::end() const {
+            return Iterator(*this, kinds.size());
         }
-        std::string Number::GetSpelling() const {
-            // Base size.
-            std::size_t _size = storage->size();
-            // If there is more than one part, then reserves space for the radixes.
-            if (parts.size() > 1) { _size += parts.size() - 1; }
-            // If there is more than one suffix, then reserves space for the 
-            // suffix separators.
-            if (suffixes.size() > 1) { _size += suffixes.size() - 1; }
-            // Increases the size based on the base and its necessary prefixes or delimiters.
-            switch (base) {
-                case 2:
-                    // Space for the base prefix ("0b").
-                    _size += 2;
-                    break;
-                case 8:
-                    // Space for the base prefix ("0").
-                    _size += 1;
-                    break;
-                case 10:
-                    // No prefix.
-                    break;
-                case 16:
-                    // Space for the base prefix ("0x").
-                    _size += 2;
-                    // Space for the radix followed by a suffix/number separator (".'"), 
-                    // necessary before the suffix list, as a base-16 number includes letters.
-                    if (!suffixes.empty()) {
-                        _size += 2;
-                    }
-                    break;
-                default:
-                    throw std::runtime_error(std::format(
-                        "Number::GetSpelling: Base {} is unsupported.", base
-                    ));
+        TokenWindow TokenStream::Window(std::size_t index, std::size_t count) const {
+            return TokenWindow(*this, index, count);
+        }
+        Kind TokenStream::GetKind(std::size_t index) const {
+            return kinds[index];
+        }
+        Span TokenStream::GetSpan(std::size_t index) const {
+            return spans[index];
+        }
+        bool TokenStream::HasSpaceAfter(std::size_t index) const {
+            return (spaceAfterBits[index / 64] >> (index % 64)) & 1;
+        }
+        std::uint32_t TokenStream::GetPayload(std::size_t index) const {
+            return payloads[index];
+        }
+        std::string_view TokenStream::GetText(std::size_t index) const {
+            Span _span = spans[index];
+            return std::string_view(*source).substr(_span.offset, _span.length);
+        }
+        NumberPayload const& TokenStream::GetNumber(std::size_t index) const {
+            return numbers[payloads[index]];
+        }
+        NumberValue TokenStream::GetValue(std::size_t index) const {
+            NumberPayload const& _number = GetNumber(index);
+            std::span<std::uint32_t const> _limbs;
+            if (_number.valueKind == ValueKind::BigInteger) {
+                _limbs = std::span<std::uint32_t const>(limbs).subspan(
+                    static_cast<std::uint32_t>(_number.value), _number.value >> 32
+                );
             }
-            // Allocates the spelling string a single time with the correct size.
-            std::string _spelling = std::string(_size, '#');
-            // Iterator to the beginning of the spelling string.
-            std::string::iterator _spellingIt = _spelling.begin();
-            switch (base) {
-                // Prefix "0b".
-                case 2:
-                    *(_spellingIt++) = '0';
-                    *(_spellingIt++) = 'b';
-                    break;
-                // Prefix "0".
-                case 8:
-                    *(_spellingIt++) = '0';
-                    break;
-                // Prefix "0x".
-                case 16:
-                    *(_spellingIt++) = '0';
-                    *(_spellingIt++) = 'x';
-                    break;
-                // No need for a default case, as unsupported bases have already been handled.
-            }
-            // Writes the number's parts.
-            if (!parts.empty()) {
-                // Iterator to the beginning of the parts vector.
-                auto _partsIt = parts.begin();
-                // Copies the first part to the spelling string and updates the spelling 
-                // iterator.
-                _spellingIt = std::copy(_partsIt->begin(), _partsIt->end(), _spellingIt);
-                // Moves to the second part. The loop automatically prevents using a non-
-                // -existent second part.
-                ++_partsIt;
-                for (; _partsIt != parts.cend(); ++_partsIt) {
-                    // Writes the radix and increments the spelling iterator.
-                    *(_spellingIt++) = '.';
-                    // Writes the part and updates the spelling iterator.
-                    _spellingIt = std::copy(_partsIt->begin(), _partsIt->end(), _spellingIt);
-                }
-            }
-            // Writes the number's suffixes.
-            if (!suffixes.empty()) {
-                // Base-16 includes letters, so an unambiguous separator is necessary.
-                if (base == 16) {
-                    *(_spellingIt++) = '.';
-                    *(_spellingIt++) = '\'';
-                }
-                // Iterator to the beginning of the suffixes vector.
-                auto _suffixesIt = suffixes.begin();
-                // Copies the first suffix to the spelling string and updates the 
-                // spelling iterator.
-                _spellingIt = std::copy(_suffixesIt->begin(), _suffixesIt->end(), _spellingIt);
-                // Moves to the second suffix. The loop automatically prevents using a non-
-                // -existent second suffix.
-                ++_suffixesIt;
-                for (; _suffixesIt != suffixes.end(); ++_suffixesIt) {
-                    // Writes the suffix separator and increments the spelling iterator.
-                    *(_spellingIt++) = '\'';
-                    // Writes the part and updates the spelling iterator.
-                    _spellingIt = std::copy(_suffixesIt->begin(), _suffixesIt->end(), _spellingIt);
-                }
-            }
-            return std::move(_spelling);
-        }
-        std::vector<std::string_view> const& Number::GetParts() const {
-            return parts;
-        }
-        std::vector<std::string_view> const& Number::GetSuffixes() const {
-            return suffixes;
+            return valueOf(_number, _limbs);
         }
-        std::int32_t Number::GetBase() const {
-            return base;
+        Symbol TokenStream::GetName(std::size_t index) const {
+            return Symbol{ payloads[index] };
         }
-
-        bool String::operator==(String const& other) const {
-            return false;
+        std::string_view TokenStream::GetString(std::size_t index) const {
+            if (payloads[index] == noPayload) {
+                // No escape sequences, so the value is the source between the quotes.
+                Span const _span = spans[index];
+                return std::string_view(*source).substr(_span.offset + 1, _span.length - 2);
+            }
+            Span const _value = strings[payloads[index]];
+            return std::string_view(stringArena).substr(_value.offset, _value.length);
         }
-        bool String::operator!=(String const& other) const {
-            return !(*this == other);
+        Operator TokenStream::GetOperator(std::size_t index) const {
+            return static_cast<Operator>(payloads[index]);
         }
-        std::string String::GetSpelling() const {
-            throw NotImplementedException("Not implemented yet.");
+        std::span<Kind const> TokenStream::GetKinds() const {
+            return kinds;
         }
-
-        bool Punct::operator==(Punct const& other) const {
-            return false;
+        std::span<Span const> TokenStream::GetSpans() const {
+            return spans;
         }
-        bool Punct::operator!=(Punct const& other) const {
-            return !(*this == other);
+        LineTable const& TokenStream::GetLines() const {
+            // Once built, this is a single acquire load of the flag, without any lock.
+            std::call_once(lines->built, [this]() {
+                lines->table.emplace(GetSource());
+            });
+            return *lines->table;
         }
-        std::string Punct::GetSpelling() const {
-            throw NotImplementedException("Not implemented yet.");
+        SourceLocation TokenStream::Locate(std::size_t offset) const {
+            return GetLines().Locate(offset);
         }
-
-        void Token::moveFrom(Token&& other) {
-            this->var = std::move(other.var);
-            this->hasSpaceAfter = other.hasSpaceAfter;
+        SourceLocation TokenStream::GetLocation(std::size_t index) const {
+            return Locate(spans[index].offset);
         }
-        Token::Token(Token&& other) {
-            moveFrom(std::move(other));
+        Token TokenStream::MakeToken(std::size_t index) const {
+            // Names are already interned, so there is no need to look their text up again.
+            if (kinds[index] == Kind::Name) {
+                return Token(Name(GetName(index)), HasSpaceAfter(index));
+            }
+            // Strings are already decoded.
+            if (kinds[index] == Kind::String) {
+                return Token(String(GetString(index)), HasSpaceAfter(index));
+            }
+            if (kinds[index] == Kind::Punct) {
+                return Token(Punct(GetOperator(index)), HasSpaceAfter(index));
+            }
+            std::string_view _text = GetText(index);
+            if (kinds[index] == Kind::Error) {
+                Exception _exception = Exception(std::format(
+                    "TokenStream::MakeToken: Token {} is an error token.", index
+                ), _text.data());
+                _exception.Locate(GetSource());
+                throw _exception;
+            }
+            // The text is exactly one valid token, so retokenising it cannot fail.
+            Token _token = std::move(tokeniseNext(_text.begin(), _text.end()).second);
+            _token.HasSpaceAfter(HasSpaceAfter(index));
+            return _token;
         }
-        Token::Token(VariantType&& innerVal, bool hasSpaceAfter) {
-            var = std::move(innerVal);
-            this->hasSpaceAfter = hasSpaceAfter;
+        std::size_t TokenStream::GetSpellingSize(std::size_t index) const {
+            std::size_t _size = spans[index].length + (HasSpaceAfter(index)? 1 : 0);
+            if (kinds[index] == Kind::Number) {
+                // The base prefix replaces the source's one, which can be longer.
+                NumberPayload const& _number = numbers[payloads[index]];
+                _size = _size + basePrefix(_number.base).size() - _number.bodyOffset;
+            } else if (kinds[index] == Kind::String) {
+                // Strings are spelled with the canonical escape sequences.
+                _size = _size - spans[index].length + quotedSize(GetString(index));
+            }
+            return _size;
         }
-        Token& Token::operator=(Token&& other) {
-            moveFrom(std::move(other));
-            return *this;
+        std::size_t TokenStream::GetSpellingSize() const {
+            std::size_t _size = 0;
+            for (std::uint64_t _bits : spaceAfterBits) {
+                _size += static_cast<std::size_t>(std::popcount(_bits));
+            }
+            for (std::size_t i = 0; i < kinds.size(); ++i) {
+                _size += spans[i].length;
+                if (kinds[i] == Kind::Number) {
+                    NumberPayload const& _number = numbers[payloads[i]];
+                    _size = _size + basePrefix(_number.base).size() - _number.bodyOffset;
+                } else if (kinds[i] == Kind::String) {
+                    _size = _size - spans[i].length + quotedSize(GetString(i));
+                }
+            }
+            return _size;
         }
-        bool Token::operator==(Token const& other) const {
-            return this->var == other.var && this->hasSpaceAfter == other.hasSpaceAfter;
+        std::string TokenStream::GetSpelling() const {
+            std::string _spelling;
+            SpellInto(_spelling);
+            return _spelling;
         }
-        bool Token::operator!=(Token const& other) const {
-            return !(operator==(other));
+        void TokenStream::SpellInto(std::string& out) const {
+            // Sized exactly up front, so that the whole stream is written with a single 
+            // allocation.
+            std::size_t const _oldSize = out.size();
+            out.resize(_oldSize + GetSpellingSize());
+            char* _it = out.data() + _oldSize;
+            char const* const _source = source->data();
+            for (std::size_t i = 0; i < kinds.size(); ++i) {
+                if (kinds[i] == Kind::Number || kinds[i] == Kind::String) {
+                    _it = AppendSpelling(i, _it);
+                    continue;
+                }
+                // Other tokens are spelled as in the source.
+                _it = std::copy_n(_source + spans[i].offset, spans[i].length, _it);
+                if ((spaceAfterBits[i / 64] >> (i % 64)) & 1) {
+                    *_it++ = ' ';
+                }
+            }
         }
-        std::string Token::GetSpelling() const {
-            std::string _spelling = std::visit([](auto&& arg){
-                return arg.GetSpelling();
-            }, var);
+        void TokenStream::Append(Kind kind, Span span) {
+            if (kinds.size() % 64 == 0) {
+                spaceAfterBits.push_back(0);
+            }
+            kinds.push_back(kind);
+            spans.push_back(span);
+            payloads.push_back(noPayload);
+        }
+        void TokenStream::AppendNumber(
+            Span span,
+            NumberPayload const& number,
+            std::span<std::uint32_t const> bigLimbs
+        ) {
+            Append(Kind::Number, span);
+            payloads.back() = static_cast<std::uint32_t>(numbers.size());
+            numbers.push_back(number);
+            if (number.valueKind == ValueKind::BigInteger) {
+                numbers.back().value = (std::uint64_t(bigLimbs.size()) << 32) | limbs.size();
+                limbs.insert(limbs.end(), bigLimbs.begin(), bigLimbs.end());
+            }
+        }
+        void TokenStream::AppendName(Span span, Symbol symbol) {
+            Append(Kind::Name, span);
+            payloads.back() = symbol.id;
+        }
+        void TokenStream::AppendString(Span span, bool hasEscapes) {
+            Append(Kind::String, span);
+            if (hasEscapes) {
+                std::size_t const _offset = stringArena.size();
+                decodeString(
+                    std::string_view(*source).substr(span.offset + 1, span.length - 2), stringArena
+                );
+                payloads.back() = static_cast<std::uint32_t>(strings.size());
+                strings.push_back(Span{
+                    static_cast<std::uint32_t>(_offset),
+                    static_cast<std::uint32_t>(stringArena.size() - _offset)
+                });
+            }
+        }
+        void TokenStream::AppendPunct(Span span, Operator op) {
+            Append(Kind::Punct, span);
+            payloads.back() = static_cast<std::uint32_t>(op);
+        }
+        void TokenStream::HasSpaceAfter(std::size_t index, bool hasSpaceAfter) {
+            std::uint64_t _bit = std::uint64_t(1) << (index % 64);
             if (hasSpaceAfter) {
-                _spelling.append({' '});
+                spaceAfterBits[index / 64] |= _bit;
+            } else {
+                spaceAfterBits[index / 64] &= ~_bit;
             }
-            return std::move(_spelling);
         }
-        bool Token::HasSpaceAfter() const {
-            return hasSpaceAfter;
+        // Sets the count bits of the destination starting at the bit at to the ones of the 
+        // source starting at the bit first. The destination's bits from at on must be clear.
+        static void copyBits(
+            std::span<std::uint64_t const> source,
+            std::size_t first,
+            std::span<std::uint64_t> destination,
+            std::size_t at,
+            std::size_t count
+        ) {
+            // Returns the 64 bits of the source from the bit on, with zeros past its end.
+            auto const _read = [&source](std::size_t bit) {
+                std::size_t const _word = bit / 64;
+                std::size_t const _shift = bit % 64;
+                std::uint64_t _bits = source[_word] >> _shift;
+                if (_shift != 0 && _word + 1 < source.size()) {
+                    _bits |= source[_word + 1] << (64 - _shift);
+                }
+                return _bits;
+            };
+            for (std::size_t _done = 0; _done < count;) {
+                std::size_t const _bit = at + _done;
+                std::size_t const _shift = _bit % 64;
+                std::size_t const _size = std::min<std::size_t>(64 - _shift, count - _done);
+                std::uint64_t _bits = _read(first + _done);
+                if (_size < 64) {
+                    _bits &= (std::uint64_t(1) << _size) - 1;
+                }
+                destination[_bit / 64] |= _bits << _shift;
+                _done += _size;
+            }
         }
-        void Token::HasSpaceAfter(bool hasSpaceAfter) {
-            this->hasSpaceAfter = hasSpaceAfter;
+        void TokenStream::AppendRange(
+            TokenStream const& other,
+            std::size_t first,
+            std::size_t count,
+            std::int64_t offsetDelta
+        ) {
+            if (count == 0) {
+                return;
+            }
+            std::size_t const _oldSize = kinds.size();
+            std::size_t const _last = first + count;
+            auto const _kinds = other.kinds.begin();
+            kinds.insert(kinds.end(), _kinds + first, _kinds + _last);
+            spans.insert(spans.end(), other.spans.begin() + first, other.spans.begin() + _last);
+            if (offsetDelta != 0) {
+                for (std::size_t i = _oldSize; i < spans.size(); ++i) {
+                    spans[i].offset = static_cast<std::uint32_t>(spans[i].offset + offsetDelta);
+                }
+            }
+            payloads.insert(
+                payloads.end(), other.payloads.begin() + first, other.payloads.begin() + _last
+            );
+            // The bits past the old last token are cleared, so that they can be ORed into.
+            if (_oldSize % 64 != 0) {
+                spaceAfterBits.back() &= (std::uint64_t(1) << (_oldSize % 64)) - 1;
+            }
+            spaceAfterBits.resize((kinds.size() + 63) / 64, 0);
+            copyBits(other.spaceAfterBits, first, spaceAfterBits, _oldSize, count);
+
+            // The numbers (with their limbs) and the decoded strings of the tokens are stored 
+            // in the order of the tokens, so those of the range are contiguous in the other 
+            // stream's tables. They are copied in one go, and the indices into them moved by 
+            // the difference between where they start in each stream. Symbols are global and 
+            // operators are not indices, so the other payloads stay the same.
+            std::uint32_t _numberDelta = 0;
+            std::uint32_t _stringDelta = 0;
+            auto const _firstNumber = std::find(_kinds + first, _kinds + _last, Kind::Number);
+            if (_firstNumber != _kinds + _last) {
+                std::uint32_t const _from = other.payloads[_firstNumber - _kinds];
+                std::size_t const _numberCount = static_cast<std::size_t>(
+                    std::count(_firstNumber, _kinds + _last, Kind::Number)
+                );
+                std::size_t const _oldNumberCount = numbers.size();
+                _numberDelta = static_cast<std::uint32_t>(_oldNumberCount - _from);
+                numbers.insert(
+                    numbers.end(),
+                    other.numbers.begin() + _from,
+                    other.numbers.begin() + _from + _numberCount
+                );
+                // The limbs of the big integers, whose offsets move the same way.
+                std::uint64_t _limbsFrom = 0;
+                std::uint64_t _limbsTo = 0;
+                std::uint64_t const _limbDelta = limbs.size();
+                bool _hasLimbs = false;
+                for (std::size_t i = _oldNumberCount; i < numbers.size(); ++i) {
+                    std::uint64_t& _value = numbers[i].value;
+                    if (numbers[i].valueKind != ValueKind::BigInteger) {
+                        continue;
+                    }
+                    if (!_hasLimbs) {
+                        _limbsFrom = _value & 0xFFFFFFFF;
+                        _hasLimbs = true;
+                    }
+                    _limbsTo = (_value & 0xFFFFFFFF) + (_value >> 32);
+                    _value = (_value & 0xFFFFFFFF00000000)
+                        | ((_value & 0xFFFFFFFF) - _limbsFrom + _limbDelta);
+                }
+                limbs.insert(
+                    limbs.end(), other.limbs.begin() + _limbsFrom, other.limbs.begin() + _limbsTo
+                );
+            }
+            // Only the strings with escape sequences have a decoded value.
+            auto const _isDecoded = [&other](std::size_t index) {
+                return other.kinds[index] == Kind::String && other.payloads[index] != noPayload;
+            };
+            std::size_t _firstString = first;
+            while (_firstString != _last && !_isDecoded(_firstString)) {
+                _firstString = std::find(_kinds + _firstString + 1, _kinds + _last, Kind::String)
+                    - _kinds;
+            }
+            if (_firstString != _last) {
+                std::size_t _lastString = _last - 1;
+                while (!_isDecoded(_lastString)) {
+                    --_lastString;
+                }
+                std::uint32_t const _from = other.payloads[_firstString];
+                std::uint32_t const _to = other.payloads[_lastString] + 1;
+                std::uint32_t const _arenaFrom = other.strings[_from].offset;
+                std::uint32_t const _arenaTo =
+                    other.strings[_to - 1].offset + other.strings[_to - 1].length;
+                std::uint32_t const _arenaDelta =
+                    static_cast<std::uint32_t>(stringArena.size()) - _arenaFrom;
+                _stringDelta = static_cast<std::uint32_t>(strings.size()) - _from;
+                std::size_t const _oldStringCount = strings.size();
+                strings.insert(
+                    strings.end(), other.strings.begin() + _from, other.strings.begin() + _to
+                );
+                for (std::size_t i = _oldStringCount; i < strings.size(); ++i) {
+                    strings[i].offset += _arenaDelta;
+                }
+                stringArena.append(other.stringArena, _arenaFrom, _arenaTo - _arenaFrom);
+            }
+            if (_numberDelta != 0 || _stringDelta != 0) {
+                for (std::size_t i = _oldSize; i < kinds.size(); ++i) {
+                    std::uint32_t const _delta = kinds[i] == Kind::Number? _numberDelta
+                        : kinds[i] == Kind::String && payloads[i] != noPayload? _stringDelta : 0;
+                    payloads[i] += _delta;
+                }
+            }
+        }
+        void TokenStream::Reserve(TokenStream const& other, std::size_t extraTokenCount) {
+            std::size_t const _tokenCount = other.kinds.size() + extraTokenCount;
+            kinds.reserve(_tokenCount);
+            spans.reserve(_tokenCount);
+            payloads.reserve(_tokenCount);
+            numbers.reserve(other.numbers.size() + extraTokenCount);
+            limbs.reserve(other.limbs.size());
+            strings.reserve(other.strings.size());
+            stringArena.reserve(other.stringArena.size());
+            spaceAfterBits.reserve((_tokenCount + 63) / 64);
+        }
+        void TokenStream::Reserve(std::size_t tokenCount) {
+            kinds.reserve(tokenCount);
+            spans.reserve(tokenCount);
+            payloads.reserve(tokenCount);
+            numbers.reserve(tokenCount);
+            spaceAfterBits.reserve((tokenCount + 63) / 64);
         }
 
         bool isPunct(char c) {
-            return c != '_' && std::ispunct(c, std::locale::classic());
+            return hasClass(c, CharClass::Punct);
         }
         bool isDigit2(char c) {
-            switch (c) {
-                case '0':
-                case '1':
-                    return true;
-                default:
-                    return false;
-            }
+            return hasClass(c, CharClass::Digit2);
         }
         bool isDigit8(char c) {
-            switch (c) {
-                case '0':
-                case '1':
-                case '2':
-                case '3':
-                case '4':
-                case '5':
-                case '6':
-                case '7':
-                    return true;
-                default:
-                    return false;
-            }
+            return hasClass(c, CharClass::Digit8);
         }
         bool isDigit10(char c) {
-            switch (c) {
-                case '0':
-                case '1':
-                case '2':
-                case '3':
-                case '4':
-                case '5':
-                case '6':
-                case '7':
-                case '8':
-                case '9':
-                    return true;
-                default:
-                    return false;
-            }
+            return hasClass(c, CharClass::Digit10);
         }
         HexError isDigit16(char c) {
-            switch (c) {
-                case '0':
-                case '1':
-                case '2':
-                case '3':
-                case '4':
-                case '5':
-                case '6':
-                case '7':
-                case '8':
-                case '9':
-                case 'a':
-                case 'b':
-                case 'c':
-                case 'd':
-                case 'e':
-                case 'f':
-                    return HexError::True;
-                case 'A':
-                case 'B':
-                case 'C':
-                case 'D':
-                case 'E':
-                case 'F':
-                    return HexError::Uppercase;
-                default:
-                    return HexError::False;
+            std::uint16_t _class = classOf(c);
+            if (_class & CharClass::Digit16) {
+                return HexError::True;
             }
+            if (_class & CharClass::UpperHex) {
+                return HexError::Uppercase;
+            }
+            return HexError::False;
         }
         bool isSpace(char c) {
-            return std::isspace(c, std::locale::classic());
+            return hasClass(c, CharClass::Space);
         }
         bool isControl(char c) {
-            return std::iscntrl(c, std::locale::classic());
+            return hasClass(c, CharClass::Control);
         }
-        std::string_view::const_iterator consumeSpace(
+        bool isNameStart(char c) {
+            return hasClass(c, CharClass::NameStart);
+        }
+        bool isNameContinue(char c) {
+            return hasClass(c, CharClass::NameContinue);
+        }
+        // Same as consumeSpace, but instead of throwing for an unterminated multi-line comment, 
+        // sets the error and returns the iterator to the comment's start.
+        static std::string_view::const_iterator skipSpace(
             std::string_view::const_iterator start,
-            std::string_view::const_iterator end
+            std::string_view::const_iterator end,
+            ScanError& error
         ) {
+            char const* _first = std::to_address(start);
+            char const* _last = _first + (end - start);
+            char const* _it = _first;
             for (;;) {
-                if (
-                    start == end
-                    || !isSpace(*start)
-                ) {
-                    return start;
+                // Most tokens are separated by a single space or none at all, so a single 
+                // character is checked before skipping a whole run with vectors.
+                if (_it != _last && hasClass(*_it, CharClass::Space)) {
+                    ++_it;
+                    if (_it != _last && hasClass(*_it, CharClass::Space)) {
+                        // Space, \t, \n, \v, \f and \r.
+                        _it = Simd::findNotInRanges(_it, _last,
+                            Simd::CharRange{ ' ', ' ' }, Simd::CharRange{ '\t', '\r' }
+                        );
+                    }
+                }
+                if (_last - _it < 2 || _it[0] != '/') {
+                    break;
+                }
+                if (_it[1] == '/') {
+                    // Single-line comment, whose line break is consumed as whitespace.
+                    _it = Simd::findChar(_it + 2, _last, '\n');
+                } else if (_it[1] == '*') {
+                    // Multi-line comment.
+                    char const* _close = Simd::findPair(_it + 2, _last, '*', '/');
+                    if (_close == _last) {
+                        error = { _it, ErrorCode::UnterminatedComment };
+                        break;
+                    }
+                    _it = _close + 2;
+                } else {
+                    break;
                 }
-                ++start;
             }
-            return start;
+            return start + (_it - _first);
+        }
+        std::string_view::const_iterator consumeSpace(
+            std::string_view::const_iterator start,
+            std::string_view::const_iterator end
+        ) {
+            ScanError _error;
+            std::string_view::const_iterator _it = skipSpace(start, end, _error);
+            if (_error.position != nullptr) {
+                throwError(_error);
+            }
+            return _it;
         }
         TokenResult tokeniseNext(
             std::string_view::const_iterator start,
@@ -381,42 +2053,6 @@ namespace Fennton::Skript {
                 switch (*start) {
                     // Base 2, 8, 10 or 16.
                     case '0':
-                        ++start;
-                        if (start != end) {
-                            switch (*start) {
-                                // Binary (`0b`).
-                                case 'b':
-                                    return Number::parseBase2(start, end);
-                                // Octal (`0o`).
-                                case 'o':
-                                    return Number::parseBase8(start, end);
-                                // Hexadecimal (`0x`).
-                                case 'x':
-                                    return Number::parseBase16(start, end);
-                                // Decimal (no prefix).
-                                case '0':
-                                case '1':
-                                case '2':
-                                case '3':
-                                case '4':
-                                case '5':
-                                case '6':
-                                case '7':
-                                case '8':
-                                case '9':
-                                    return Number::parseBase10(start, end);
-                            }
-                        } else {
-                            // The only possible number is zero.
-                            auto _storage = std::make_unique<std::string>("0");
-                            return {
-                                start, Token(
-                                    Number(std::move(_storage), { *_storage }, {}, 10),
-                                    false
-                                )
-                            };
-                        }
-                    // Base 10 number.
                     case '1':
                     case '2':
                     case '3':
@@ -425,41 +2061,525 @@ namespace Fennton::Skript {
                     case '6':
                     case '7':
                     case '8':
-                    case '9':
-                        return Number::parseBase10(start, end);
+                    case '9': {
+                        NumberLead _lead = leadNumber(start, end);
+                        switch (_lead.base) {
+                            case 2:
+                                return Number::parseBase2(_lead.body, end);
+                            case 8:
+                                return Number::parseBase8(_lead.body, end);
+                            case 16:
+                                return Number::parseBase16(_lead.body, end);
+                            default:
+                                return Number::parseBase10(_lead.body, end);
+                        }
+                    }
+                    case '"':
+                        return String::parse(start, end);
                     default:
-                        throw Exception(std::format(
-                            "Unexpected character {}.", Text::quote({ *start })
-                        ));
+                        if (startsName(start, end)) {
+                            std::string_view::const_iterator _it = skipName(start, end);
+                            return {
+                                _it, Token(Name(std::string_view(start, _it)), false)
+                            };
+                        }
+                        // Throws for unexpected characters.
+                        return Punct::parse(start, end);
                 }
             } else {
                 return { start, Token() };
             }
         }
-        std::deque<Token> tokenise(std::string_view str) {
-            std::deque<Token> _tokens;
+        TokenStream tokenise(std::string_view str) {
+            return tokenise(Memory::makeStrong<std::string const>(str));
+        }
+        // Throws if the source is too large for the 32-bit offsets of the spans.
+        static void checkSourceSize(std::string_view str) {
+            if (str.size() > std::numeric_limits<std::uint32_t>::max()) {
+                throw Exception(std::format(
+                    "Source of {} bytes is too large for 32-bit offsets.", str.size()
+                ));
+            }
+        }
+        // Validates the range [from, to) of the source as UTF-8, appending each invalid sequence 
+        // to the diagnostics, or throwing for the first one if null. They are errors of the 
+        // source rather than of a token, so no error tokens are appended for them.
+        static void checkUtf8(
+            std::string_view str,
+            std::size_t from,
+            std::size_t to,
+            std::vector<Diagnostic>* diagnostics
+        ) {
+            char const* const _begin = str.data();
+            char const* const _end = _begin + to;
+            for (
+                char const* _it = findInvalidUtf8(_begin + from, _end);
+                _it != _end;
+                _it = findInvalidUtf8(_it, _end)
+            ) {
+                if (diagnostics == nullptr) {
+                    try {
+                        throwError({ _it, ErrorCode::InvalidUtf8 });
+                    } catch (Exception& e) {
+                        e.Locate(str);
+                        throw;
+                    }
+                }
+                std::uint32_t const _length = decodeUtf8(_it, _end).length;
+                diagnostics->push_back({
+                    ErrorCode::InvalidUtf8, static_cast<std::uint32_t>(_it - _begin), _length
+                });
+                _it += _length;
+            }
+        }
+        // Appends the error token with its error to the diagnostics and the stream, or throws 
+        // the error if there are no diagnostics to append it to.
+        static void reportError(
+            TokenStream& stream,
+            Span span,
+            ScanError const& error,
+            std::vector<Diagnostic>* diagnostics
+        ) {
+            if (diagnostics == nullptr) {
+                throwError(error);
+            }
+            std::string_view const _str = stream.GetSource();
+            std::uint32_t const _offset = static_cast<std::uint32_t>(error.position - _str.data());
+            std::uint32_t _length;
+            switch (error.code) {
+                case ErrorCode::UnterminatedComment:
+                    // The comment's opening `/*`.
+                    _length = 2;
+                    break;
+                case ErrorCode::ExpectedDigit:
+                case ErrorCode::ExpectedSuffix:
+                    // The missing characters are expected at the offset.
+                    _length = 0;
+                    break;
+                case ErrorCode::InvalidEscape:
+                    // The backslash and the character after it.
+                    _length = 2;
+                    break;
+                default:
+                    // The whole character, which can be longer than a byte outside ASCII.
+                    _length = decodeUtf8(error.position, _str.data() + _str.size()).length;
+                    break;
+            }
+            diagnostics->push_back({ error.code, _offset, _length });
+            stream.Append(Kind::Error, span);
+        }
+        // Tokenises the range [from, to) of the stream's source, appending the tokens to the 
+        // stream. The last token never has a space after it, as the range's end is treated as 
+        // the source's end. Errors are appended to the diagnostics, or thrown if null.
+        static void tokeniseRange(
+            TokenStream& stream,
+            std::size_t from,
+            std::size_t to,
+            std::vector<Diagnostic>* diagnostics
+        ) {
+            std::string_view _str = stream.GetSource();
+            std::string_view::const_iterator const _begin = _str.begin();
+            std::string_view::const_iterator const _end = _begin + to;
+
+            try {
+                Scanned _scanned;
+                std::string_view::const_iterator _it = skipSpace(
+                    _begin + from, _end, _scanned.error
+                );
+                while (_it != _end) {
+                    std::string_view::const_iterator _tokenEnd;
+                    if (_scanned.error.position != nullptr) {
+                        // Unterminated multi-line comment, which runs until the end.
+                        _scanned.kind = Kind::Error;
+                        _tokenEnd = _end;
+                    } else {
+                        _tokenEnd = scanNext(_it, _end, _scanned);
+                    }
+                    Span _span = {
+                        static_cast<std::uint32_t>(_it - _begin),
+                        static_cast<std::uint32_t>(_tokenEnd - _it)
+                    };
+                    if (_scanned.kind == Kind::Error) {
+                        reportError(stream, _span, _scanned.error, diagnostics);
+                        _scanned.error.position = nullptr;
+                    } else {
+                        appendScanned(stream, _span, _scanned);
+                    }
+                    // The token only has a space after it if there is another token after the 
+                    // space.
+                    _it = skipSpace(_tokenEnd, _end, _scanned.error);
+                    if (_it != _tokenEnd && _it != _end) {
+                        stream.HasSpaceAfter(stream.Size() - 1, true);
+                    }
+                }
+            } catch (Exception& e) {
+                e.Locate(_str);
+                throw;
+            }
+        }
+        TokenStream tokenise(Memory::Strong<std::string const> source) {
+            checkSourceSize(*source);
+            checkUtf8(*source, 0, source->size(), nullptr);
+            TokenStream _stream = TokenStream(std::move(source));
+            tokeniseRange(_stream, 0, _stream.GetSource().size(), nullptr);
+            return _stream;
+        }
+        TokenStream tokenise(std::string_view str, std::vector<Diagnostic>& diagnostics) {
+            return tokenise(Memory::makeStrong<std::string const>(str), diagnostics);
+        }
+        TokenStream tokenise(
+            Memory::Strong<std::string const> source,
+            std::vector<Diagnostic>& diagnostics
+        ) {
+            checkSourceSize(*source);
+            checkUtf8(*source, 0, source->size(), &diagnostics);
+            TokenStream _stream = TokenStream(std::move(source));
+            tokeniseRange(_stream, 0, _stream.GetSource().size(), &diagnostics);
+            return _stream;
+        }
+        void staticError(ErrorCode code, std::string_view source, std::size_t offset) {
+            Exception _exception = Exception(
+                std::string(errorMessage(code)), source.data() + offset
+            );
+            _exception.Locate(source);
+            throw _exception;
+        }
+        TokenStream makeStaticStream(
+            std::string_view source,
+            std::span<StaticToken const> tokens,
+            std::span<StaticNumber const> numbers
+        ) {
+            TokenStream _stream = TokenStream(Memory::makeStrong<std::string const>(source));
+            _stream.Reserve(tokens.size());
+            std::vector<std::uint32_t> _limbs;
+            std::span<StaticNumber const>::iterator _number = numbers.begin();
+            for (std::size_t i = 0; i < tokens.size(); ++i) {
+                StaticToken const& _token = tokens[i];
+                std::string_view const _text = source.substr(
+                    _token.span.offset, _token.span.length
+                );
+                switch (_token.kind) {
+                    case Kind::Name:
+                        _stream.AppendName(_token.span, globalSymbols().Intern(_text));
+                        break;
+                    case Kind::Number: {
+                        auto _part = [&](Span span) {
+                            return _text.substr(span.offset, span.length);
+                        };
+                        NumberPayload _payload;
+                        _limbs.clear();
+                        decodeValue(
+                            _number->base,
+                            _number->partCount,
+                            _part(_number->integer),
+                            _part(_number->fraction),
+                            _part(_number->suffix),
+                            _payload,
+                            _limbs
+                        );
+                        _payload.bodyOffset = _number->bodyOffset;
+                        _payload.base = _number->base;
+                        _payload.flags = _number->flags;
+                        _stream.AppendNumber(_token.span, _payload, _limbs);
+                        ++_number;
+                        break;
+                    }
+                    case Kind::String:
+                        _stream.AppendString(_token.span, _text.find('\\') != _text.npos);
+                        break;
+                    case Kind::Punct:
+                        _stream.AppendPunct(_token.span, _token.op);
+                        break;
+                    default:
+                        _stream.Append(_token.kind, _token.span);
+                        break;
+                }
+                if (_token.hasSpaceAfter) {
+                    _stream.HasSpaceAfter(i, true);
+                }
+            }
+            return _stream;
+        }
+        TokenStream retokenise(
+            TokenStream const& previous,
+            std::size_t offset,
+            std::size_t length,
+            std::string_view replacement
+        ) {
+            std::string_view const _oldStr = previous.GetSource();
+            if (offset > _oldStr.size() || length > _oldStr.size() - offset) {
+                throw std::out_of_range(std::format(
+                    "retokenise: Range [{}, {}) is outside the source of {} bytes.",
+                    offset, offset + length, _oldStr.size()
+                ));
+            }
+            // Builds the edited source, which must be contiguous and immutable like any other.
+            Memory::Strong<std::string const> _source;
+            {
+                std::string _edited;
+                _edited.reserve(_oldStr.size() - length + replacement.size());
+                _edited.append(_oldStr.substr(0, offset));
+                _edited.append(replacement);
+                _edited.append(_oldStr.substr(offset + length));
+                _source = Memory::makeStrong<std::string const>(std::move(_edited));
+            }
+            checkSourceSize(*_source);
+            std::string_view const _str = *_source;
+            std::int64_t const _delta =
+                static_cast<std::int64_t>(replacement.size()) - static_cast<std::int64_t>(length);
+            // The end of the edit in the old and in the new source.
+            std::size_t const _oldEditEnd = offset + length;
+            std::size_t const _newEditEnd = offset + replacement.size();
+            {
+                // The edit might split the characters around it, so their bytes before it (up 
+                // to their first one) and after it (until the next character) are validated 
+                // with the replacement.
+                auto _isContinuation = [&_str](std::size_t index) {
+                    return (static_cast<unsigned char>(_str[index]) & 0xC0) == 0x80;
+                };
+                std::size_t _from = offset;
+                for (std::size_t i = offset; i > 0 && offset - i < 3; --i) {
+                    if (!_isContinuation(i - 1)) {
+                        if (static_cast<unsigned char>(_str[i - 1]) >= 0xC0) {
+                            _from = i - 1;
+                        }
+                        break;
+                    }
+                }
+                std::size_t _to = _newEditEnd;
+                while (_to < _str.size() && _to - _newEditEnd < 3 && _isContinuation(_to)) {
+                    ++_to;
+                }
+                checkUtf8(_str, _from, _to, nullptr);
+            }
+
+            std::span<Span const> const _oldSpans = previous.GetSpans();
+            // The tokenisation of a token can look at up to three bytes after its end (such as 
+            // `.'` after a base-16 number, or the rest of the character after a name, which 
+            // might continue it), so only the tokens ending before that are kept.
+            std::size_t const _kept = static_cast<std::size_t>(std::partition_point(
+                _oldSpans.begin(), _oldSpans.end(), [offset](Span const& _span) {
+                    return std::size_t(_span.offset) + _span.length + 3 < offset;
+                }
+            ) - _oldSpans.begin());
+
+            TokenStream _stream = TokenStream(_source);
+            // Each byte of the replacement adds at most a token, and the edit can split one, so 
+            // that the tables are never grown (and copied again) by the tokens appended after 
+            // the kept ones.
+            _stream.Reserve(previous, replacement.size() + 1);
+            _stream.AppendRange(previous, 0, _kept);
 
-            std::string_view::const_iterator _it = str.begin();
+            std::string_view::const_iterator const _begin = _str.begin();
+            std::string_view::const_iterator const _end = _str.end();
+            // Restarts right after the last kept token, which is always between tokens.
+            std::string_view::const_iterator _tokenEnd = _begin;
+            if (_kept > 0) {
+                Span const _last = _oldSpans[_kept - 1];
+                _tokenEnd += _last.offset + _last.length;
+            }
+            // Index of the first previous token which could still be resynchronised with.
+            std::size_t _candidate = _kept;
+            Scanned _scanned;
+            try {
+                for (;;) {
+                    std::string_view::const_iterator _it = consumeSpace(_tokenEnd, _end);
+                    // The space after the last token might have been edited.
+                    if (!_stream.Empty()) {
+                        _stream.HasSpaceAfter(
+                            _stream.Size() - 1, _it != _tokenEnd && _it != _end
+                        );
+                    }
+                    if (_it == _end) {
+                        return _stream;
+                    }
+                    std::size_t const _position = _it - _begin;
+                    if (_position >= _newEditEnd) {
+                        // Looks for a previous token starting at the same place, after the edit, 
+                        // from which the tokenisation would be the same.
+                        std::int64_t const _oldPosition =
+                            static_cast<std::int64_t>(_position) - _delta;
+                        while (
+                            _candidate < _oldSpans.size()
+                            && (
+                                _oldSpans[_candidate].offset < _oldEditEnd
+                                || _oldSpans[_candidate].offset < _oldPosition
+                            )
+                        ) {
+                            ++_candidate;
+                        }
+                        if (
+                            _candidate < _oldSpans.size()
+                            && _oldSpans[_candidate].offset == _oldPosition
+                        ) {
+                            _stream.AppendRange(
+                                previous, _candidate, _oldSpans.size() - _candidate, _delta
+                            );
+                            return _stream;
+                        }
+                    }
+                    _tokenEnd = scanNext(_it, _end, _scanned);
+                    if (_scanned.kind == Kind::Error) {
+                        throwError(_scanned.error);
+                    }
+                    Span _span = {
+                        static_cast<std::uint32_t>(_position),
+                        static_cast<std::uint32_t>(_tokenEnd - _it)
+                    };
+                    appendScanned(_stream, _span, _scanned);
+                }
+            } catch (Exception& e) {
+                e.Locate(_str);
+                throw;
+            }
+        }
+        // Returns the position after the first line break at or after target which is not 
+        // inside a string or a comment, or end if there is none. Only the characters which 
+        // can start or end strings and comments are looked at, skipping everything else with 
+        // vector scans. The it iterator must not be inside a string or a comment.
+        static char const* findSafeSplit(char const* it, char const* end, char const* target) {
             for (;;) {
-                // Consumes whitespace and comments before trying to emit a token.
-                _it = consumeSpace(_it, str.end());
-                // Checks whether EOF has been reached.
-                if (_it == str.end()) {
-                    // EOF has been reached, so returns the deque.
-                    return std::move(_tokens);
-                }
-                // Retrieves a pair containing the iterator after the next token and the 
-                // next token.
-                TokenResult _nextResult = tokeniseNext(_it, str.end());
-                // Adds the token, which must exist, because all contiguous space before 
-                // it has been consumed and there was already a check for whether EOF has 
-                // been reached.
-                _tokens.emplace_back(std::move(_nextResult.second));
-                // If EOF has been reached, returns the deque.
-                if (_nextResult.first == str.end()) {
-                    return std::move(_tokens);
+                it = Simd::findAnyOf(it, end, '\n', '/', '"');
+                if (it == end) {
+                    return end;
+                }
+                switch (*it) {
+                    case '\n':
+                        ++it;
+                        if (it > target) {
+                            return it;
+                        }
+                        break;
+                    case '/':
+                        if (end - it >= 2 && it[1] == '/') {
+                            // Stops at the comment's line break, which is safe.
+                            it = Simd::findChar(it + 2, end, '\n');
+                        } else if (end - it >= 2 && it[1] == '*') {
+                            char const* _close = Simd::findPair(it + 2, end, '*', '/');
+                            if (_close == end) {
+                                // Unterminated comment, which is an error left for the 
+                                // tokeniser to report.
+                                return end;
+                            }
+                            it = _close + 2;
+                        } else {
+                            ++it;
+                        }
+                        break;
+                    default:
+                        // String, which ends at the first quote not escaped by a backslash.
+                        for (++it;;) {
+                            it = Simd::findAnyOf(it, end, '"', '\\');
+                            if (it == end) {
+                                return end;
+                            }
+                            if (*it == '"') {
+                                ++it;
+                                break;
+                            }
+                            it += (end - it >= 2)? 2 : 1;
+                        }
+                        break;
+                }
+            }
+        }
+        TokenStream tokeniseParallel(
+            std::string_view str,
+            std::size_t threadCount,
+            std::size_t minChunkSize
+        ) {
+            return tokeniseParallel(
+                Memory::makeStrong<std::string const>(str), threadCount, minChunkSize
+            );
+        }
+        TokenStream tokeniseParallel(
+            Memory::Strong<std::string const> source,
+            std::size_t threadCount,
+            std::size_t minChunkSize
+        ) {
+            checkSourceSize(*source);
+            if (threadCount == 0) {
+                threadCount = std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+            }
+            std::string_view const _str = *source;
+            minChunkSize = std::max<std::size_t>(minChunkSize, 1);
+            // Multiple chunks per thread, so that threads which finish early take more work.
+            std::size_t const _chunkCount = std::min(threadCount * 4, _str.size() / minChunkSize);
+            if (threadCount == 1 || _chunkCount <= 1) {
+                return tokenise(std::move(source));
+            }
+            // Validated once for the whole source, before it is split into chunks.
+            checkUtf8(_str, 0, _str.size(), nullptr);
+            // Offsets at which the chunks start, followed by the source's end.
+            std::vector<std::size_t> _bounds = { 0 };
+            {
+                char const* const _begin = _str.data();
+                char const* const _end = _begin + _str.size();
+                char const* _it = _begin;
+                for (std::size_t i = 1; i < _chunkCount && _it != _end; ++i) {
+                    char const* _target = _begin + _str.size() * i / _chunkCount;
+                    _it = findSafeSplit(_it, _end, std::max(_target, _it));
+                    if (_it != _end) {
+                        _bounds.push_back(_it - _begin);
+                    }
+                }
+                _bounds.push_back(_str.size());
+            }
+            std::size_t const _actualCount = _bounds.size() - 1;
+            std::vector<TokenStream> _chunks = std::vector<TokenStream>(
+                _actualCount, TokenStream(source)
+            );
+            std::vector<std::exception_ptr> _errors = std::vector<std::exception_ptr>(
+                _actualCount
+            );
+            {
+                // Workers take the next chunk until there are none left.
+                std::atomic<std::size_t> _next = 0;
+                auto _work = [&]() {
+                    for (;;) {
+                        std::size_t _index = _next.fetch_add(1, std::memory_order_relaxed);
+                        if (_index >= _actualCount) {
+                            return;
+                        }
+                        try {
+                            tokeniseRange(
+                                _chunks[_index], _bounds[_index], _bounds[_index + 1], nullptr
+                            );
+                        } catch (...) {
+                            _errors[_index] = std::current_exception();
+                        }
+                    }
+                };
+                std::vector<std::jthread> _workers;
+                for (std::size_t i = 1; i < std::min(threadCount, _actualCount); ++i) {
+                    _workers.emplace_back(_work);
+                }
+                // The calling thread is one of the workers.
+                _work();
+            }
+            // Reports the same error as tokenise would, which is the first in the source.
+            for (std::exception_ptr const& _error : _errors) {
+                if (_error) {
+                    std::rethrow_exception(_error);
+                }
+            }
+            TokenStream _stream = TokenStream(std::move(source));
+            {
+                std::size_t _total = 0;
+                for (TokenStream const& _chunk : _chunks) {
+                    _total += _chunk.Size();
+                }
+                _stream.Reserve(_total);
+            }
+            for (TokenStream const& _chunk : _chunks) {
+                // The chunks are separated by line breaks, so the last token of the stitched 
+                // stream has a space after it if another token follows.
+                if (!_chunk.Empty() && !_stream.Empty()) {
+                    _stream.HasSpaceAfter(_stream.Size() - 1, true);
                 }
+                _stream.AppendRange(_chunk, 0, _chunk.Size());
             }
+            return _stream;
         }
     }
 }
\ No newline at end of file
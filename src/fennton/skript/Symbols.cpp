@@ -0,0 +1,161 @@
+#include <fennton/skript/Symbols.hpp>
+#include <algorithm>
+#include <bit>
+#include <format>
+#include <limits>
+#include <stdexcept>
+
+namespace Fennton::Skript {
+    // Returns the 32-bit hash of the string stored in the index's slots.
+    static std::uint32_t hashOf(std::string_view str) {
+        std::uint64_t _hash = std::hash<std::string_view>()(str);
+        return static_cast<std::uint32_t>(_hash ^ (_hash >> 32));
+    }
+    // Returns the slot packing the hash and the symbol's id.
+    static std::uint64_t slotOf(std::uint32_t hash, std::uint32_t id) {
+        return (std::uint64_t(hash) << 32) | (std::uint64_t(id) + 1);
+    }
+
+    SymbolTable::Location SymbolTable::locate(std::uint32_t id) {
+        // Ids are shifted by the first page's size, so that the page is given by the position
+        // of the highest set bit and the offset by the bits below it.
+        std::uint64_t _shifted = std::uint64_t(id) + (std::uint64_t(1) << firstPageBits);
+        std::uint32_t _bit = static_cast<std::uint32_t>(std::bit_width(_shifted)) - 1;
+        return {
+            _bit - firstPageBits,
+            static_cast<std::size_t>(_shifted - (std::uint64_t(1) << _bit))
+        };
+    }
+    SymbolTable::Entry const& SymbolTable::entryAt(std::uint32_t id) const {
+        Location _location = locate(id);
+        return pages[_location.page].load(std::memory_order_acquire)[_location.offset];
+    }
+    std::optional<Symbol> SymbolTable::find(
+        Index const& index,
+        std::string_view str,
+        std::uint32_t hash
+    ) const {
+        for (std::size_t i = hash & index.mask;; i = (i + 1) & index.mask) {
+            std::uint64_t _slot = index.slots[i].load(std::memory_order_acquire);
+            if (_slot == 0) {
+                return std::nullopt;
+            }
+            if (static_cast<std::uint32_t>(_slot >> 32) == hash) {
+                std::uint32_t _id = static_cast<std::uint32_t>(_slot) - 1;
+                Entry const& _entry = entryAt(_id);
+                if (std::string_view(_entry.data, _entry.size) == str) {
+                    return Symbol{ _id };
+                }
+            }
+        }
+    }
+    char const* SymbolTable::store(std::string_view str) {
+        if (str.size() > blockSize / 4) {
+            // Long strings would waste most of a shared block.
+            blocks.push_back(std::make_unique<char[]>(str.size()));
+            std::copy(str.begin(), str.end(), blocks.back().get());
+            return blocks.back().get();
+        }
+        if (str.size() > blockLeft) {
+            blocks.push_back(std::make_unique<char[]>(blockSize));
+            blockIt = blocks.back().get();
+            blockLeft = blockSize;
+        }
+        char* _data = blockIt;
+        std::copy(str.begin(), str.end(), _data);
+        blockIt += str.size();
+        blockLeft -= str.size();
+        return _data;
+    }
+    void SymbolTable::grow(std::size_t capacity) {
+        auto _index = std::make_unique<Index>();
+        _index->mask = capacity - 1;
+        _index->slots = std::make_unique<std::atomic<std::uint64_t>[]>(capacity);
+        std::uint32_t const _count = count.load(std::memory_order_relaxed);
+        for (std::uint32_t id = 0; id < _count; ++id) {
+            std::uint32_t _hash = entryAt(id).hash;
+            std::size_t i = _hash & _index->mask;
+            while (_index->slots[i].load(std::memory_order_relaxed) != 0) {
+                i = (i + 1) & _index->mask;
+            }
+            _index->slots[i].store(slotOf(_hash, id), std::memory_order_relaxed);
+        }
+        // Publishes the filled index, while the old one stays alive for its readers.
+        index.store(_index.get(), std::memory_order_release);
+        indices.push_back(std::move(_index));
+    }
+    SymbolTable::SymbolTable() {
+        grow(std::size_t(1) << firstPageBits);
+        Intern("");
+    }
+    SymbolTable::~SymbolTable() {
+        for (std::uint32_t i = 0; i < pageCount; ++i) {
+            delete[] pages[i].load(std::memory_order_relaxed);
+        }
+    }
+    Symbol SymbolTable::Intern(std::string_view str) {
+        std::uint32_t const _hash = hashOf(str);
+        // Most strings are already interned, so they are looked up without locking first.
+        std::optional<Symbol> _symbol = find(*index.load(std::memory_order_acquire), str, _hash);
+        if (_symbol) {
+            return *_symbol;
+        }
+        std::lock_guard<std::mutex> _lock = std::lock_guard<std::mutex>(mutex);
+        // Another thread might have added it since.
+        _symbol = find(*index.load(std::memory_order_relaxed), str, _hash);
+        if (_symbol) {
+            return *_symbol;
+        }
+        if (str.size() > std::numeric_limits<std::uint32_t>::max()) {
+            throw std::length_error(std::format(
+                "SymbolTable::Intern: String of {} bytes is too long.", str.size()
+            ));
+        }
+        std::uint32_t const _id = count.load(std::memory_order_relaxed);
+        // The id plus one must fit in the lower half of a slot.
+        if (_id == std::numeric_limits<std::uint32_t>::max() - 1) {
+            throw std::length_error("SymbolTable::Intern: Too many symbols.");
+        }
+        Location const _location = locate(_id);
+        if (_location.offset == 0) {
+            // First entry of a page, so the page is allocated and published.
+            pages[_location.page].store(
+                new Entry[std::size_t(1) << (_location.page + firstPageBits)],
+                std::memory_order_release
+            );
+        }
+        Entry* _entries = pages[_location.page].load(std::memory_order_relaxed);
+        _entries[_location.offset] = Entry{
+            str.empty()? "" : store(str), static_cast<std::uint32_t>(str.size()), _hash
+        };
+        count.store(_id + 1, std::memory_order_release);
+        // Keeps the index at most half full, so that the probe sequences stay short.
+        Index const* _index = index.load(std::memory_order_relaxed);
+        if (std::size_t(_id + 1) * 2 > _index->mask + 1) {
+            // Also inserts the new entry.
+            grow((_index->mask + 1) * 2);
+        } else {
+            std::size_t i = _hash & _index->mask;
+            while (_index->slots[i].load(std::memory_order_relaxed) != 0) {
+                i = (i + 1) & _index->mask;
+            }
+            // Published last, so readers finding the slot also see the entry.
+            _index->slots[i].store(slotOf(_hash, _id), std::memory_order_release);
+        }
+        return Symbol{ _id };
+    }
+    std::optional<Symbol> SymbolTable::Find(std::string_view str) const {
+        return find(*index.load(std::memory_order_acquire), str, hashOf(str));
+    }
+    std::string_view SymbolTable::GetSpelling(Symbol symbol) const {
+        Entry const& _entry = entryAt(symbol.id);
+        return std::string_view(_entry.data, _entry.size);
+    }
+    std::size_t SymbolTable::Size() const {
+        return count.load(std::memory_order_acquire);
+    }
+    SymbolTable& globalSymbols() {
+        static SymbolTable _table;
+        return _table;
+    }
+}
@@ -0,0 +1,216 @@
+#include <fennton/skript/Unicode.hpp>
+#include <fennton/utils/Simd.hpp>
+#include <array>
+#include <cstring>
+
+namespace Fennton::Skript::Tokeniser {
+    #ifdef FENNTON_SIMD_AVX2
+    // Errors of a pair of consecutive bytes, looked up from the nibbles of the pair by
+    // Keiser and Lemire's validator. Each table sets the bits of the errors its nibble can be
+    // part of, so that an error remains after and-ing the three lookups only if all agree.
+    namespace Utf8Errors {
+        // Lead byte followed by a byte which is not a continuation byte.
+        constexpr std::uint8_t tooShort = 1 << 0;
+        // Continuation byte after an ASCII byte.
+        constexpr std::uint8_t tooLong = 1 << 1;
+        constexpr std::uint8_t overlong3 = 1 << 2;
+        // Code point after U+10FFFF.
+        constexpr std::uint8_t tooLarge = 1 << 3;
+        constexpr std::uint8_t surrogate = 1 << 4;
+        constexpr std::uint8_t overlong2 = 1 << 5;
+        // Shared by two errors which both require a continuation byte in the 0x80-0x8F range.
+        constexpr std::uint8_t tooLarge1000 = 1 << 6;
+        constexpr std::uint8_t overlong4 = 1 << 6;
+        // Two continuation bytes, which is only valid as the third or fourth byte.
+        constexpr std::uint8_t twoConts = 1 << 7;
+        // Errors which do not depend on the low nibble of the first byte.
+        constexpr std::uint8_t carry = tooShort | tooLong | twoConts;
+
+        // Indexed by the high nibble of the first byte.
+        constexpr std::array<std::uint8_t, 16> firstHigh = {
+            tooLong, tooLong, tooLong, tooLong, tooLong, tooLong, tooLong, tooLong,
+            twoConts, twoConts, twoConts, twoConts,
+            tooShort | overlong2,
+            tooShort,
+            tooShort | overlong3 | surrogate,
+            tooShort | tooLarge | tooLarge1000 | overlong4
+        };
+        // Indexed by the low nibble of the first byte.
+        constexpr std::array<std::uint8_t, 16> firstLow = {
+            carry | overlong3 | overlong2 | overlong4,
+            carry | overlong2,
+            carry,
+            carry,
+            carry | tooLarge,
+            carry | tooLarge | tooLarge1000,
+            carry | tooLarge | tooLarge1000,
+            carry | tooLarge | tooLarge1000,
+            carry | tooLarge | tooLarge1000,
+            carry | tooLarge | tooLarge1000,
+            carry | tooLarge | tooLarge1000,
+            carry | tooLarge | tooLarge1000,
+            carry | tooLarge | tooLarge1000,
+            carry | tooLarge | tooLarge1000 | surrogate,
+            carry | tooLarge | tooLarge1000,
+            carry | tooLarge | tooLarge1000
+        };
+        // Indexed by the high nibble of the second byte.
+        constexpr std::array<std::uint8_t, 16> secondHigh = {
+            tooShort, tooShort, tooShort, tooShort, tooShort, tooShort, tooShort, tooShort,
+            tooLong | overlong2 | twoConts | overlong3 | tooLarge1000 | overlong4,
+            tooLong | overlong2 | twoConts | overlong3 | tooLarge,
+            tooLong | overlong2 | twoConts | surrogate | tooLarge,
+            tooLong | overlong2 | twoConts | surrogate | tooLarge,
+            tooShort, tooShort, tooShort, tooShort
+        };
+    }
+    // Returns the table repeated in both halves of a vector, as shuffles are done per half.
+    static __m256i broadcastTable(std::array<std::uint8_t, 16> const& table) {
+        return _mm256_broadcastsi128_si256(
+            _mm_loadu_si128(reinterpret_cast<__m128i const*>(table.data()))
+        );
+    }
+    // Returns the bytes of the input shifted by Count, with the last ones of the previous
+    // input shifted in.
+    template<int Count> static __m256i previousBytes(__m256i input, __m256i previous) {
+        return _mm256_alignr_epi8(
+            input, _mm256_permute2x128_si256(previous, input, 0x21), 16 - Count
+        );
+    }
+    // Returns a vector which is not zero if the input has an error, given the previous input
+    // (which ends with the first bytes of the sequences the input continues).
+    static __m256i checkUtf8Block(__m256i input, __m256i previous) {
+        __m256i const _nibble = _mm256_set1_epi8(0x0F);
+        __m256i const _prev1 = previousBytes<1>(input, previous);
+        __m256i const _special = _mm256_and_si256(
+            _mm256_and_si256(
+                _mm256_shuffle_epi8(
+                    broadcastTable(Utf8Errors::firstHigh),
+                    _mm256_and_si256(_mm256_srli_epi16(_prev1, 4), _nibble)
+                ),
+                _mm256_shuffle_epi8(
+                    broadcastTable(Utf8Errors::firstLow), _mm256_and_si256(_prev1, _nibble)
+                )
+            ),
+            _mm256_shuffle_epi8(
+                broadcastTable(Utf8Errors::secondHigh),
+                _mm256_and_si256(_mm256_srli_epi16(input, 4), _nibble)
+            )
+        );
+        // Bytes which must be the third or fourth of a sequence, as the byte two or three
+        // before them is the lead of a longer sequence. Their highest bit cancels out the
+        // twoConts error, which must be set for them and only for them.
+        __m256i const _third = _mm256_subs_epu8(
+            previousBytes<2>(input, previous), _mm256_set1_epi8(static_cast<char>(0xE0 - 0x80))
+        );
+        __m256i const _fourth = _mm256_subs_epu8(
+            previousBytes<3>(input, previous), _mm256_set1_epi8(static_cast<char>(0xF0 - 0x80))
+        );
+        __m256i const _mustContinue = _mm256_and_si256(
+            _mm256_or_si256(_third, _fourth), _mm256_set1_epi8(static_cast<char>(0x80))
+        );
+        return _mm256_xor_si256(_mustContinue, _special);
+    }
+    // Returns a vector which is not zero if the input ends in the middle of a sequence.
+    static __m256i isIncomplete(__m256i input) {
+        __m256i const _max = _mm256_setr_epi8(
+            -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+            -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+            static_cast<char>(0xF0 - 1), static_cast<char>(0xE0 - 1), static_cast<char>(0xC0 - 1)
+        );
+        return _mm256_subs_epu8(input, _max);
+    }
+    // Returns a pointer to the first character in [it, end) which is outside ASCII, or end if
+    // there is none, testing four vectors with a single movemask before finding it by one.
+    static char const* skipAscii(char const* it, char const* end) {
+        while (end - it >= 128) {
+            __m256i const* const _chunks = reinterpret_cast<__m256i const*>(it);
+            __m256i const _any = _mm256_or_si256(
+                _mm256_or_si256(_mm256_loadu_si256(_chunks), _mm256_loadu_si256(_chunks + 1)),
+                _mm256_or_si256(_mm256_loadu_si256(_chunks + 2), _mm256_loadu_si256(_chunks + 3))
+            );
+            if (_mm256_movemask_epi8(_any) != 0) {
+                break;
+            }
+            it += 128;
+        }
+        return Simd::findNonAscii(it, end);
+    }
+    #endif
+
+    char const* findInvalidUtf8(char const* it, char const* end) {
+        #ifdef FENNTON_SIMD_AVX2
+        char const* const _begin = it;
+        // Returns the first invalid byte at or after the first byte of the sequence which
+        // the block at start begins in, as everything before that sequence is valid.
+        auto _locate = [_begin, end](char const* start) {
+            for (std::ptrdiff_t i = 1; i <= 3 && i <= start - _begin; ++i) {
+                unsigned char const _byte = static_cast<unsigned char>(start[-i]);
+                if (_byte >= 0xC0) {
+                    start -= i;
+                    break;
+                }
+                if (_byte < 0x80) {
+                    break;
+                }
+            }
+            return findInvalidUtf8Scalar(start, end);
+        };
+        __m256i _previous = _mm256_setzero_si256();
+        __m256i _incomplete = _mm256_setzero_si256();
+        char const* _block = it;
+        while (it != end) {
+            _block = it;
+            __m256i _input;
+            if (end - it >= 32) {
+                _input = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(it));
+                it += 32;
+            } else {
+                // The last bytes are padded with null characters, so that a sequence they
+                // end in the middle of is too short.
+                alignas(32) char _padded[32] = {};
+                std::memcpy(_padded, it, static_cast<std::size_t>(end - it));
+                _input = _mm256_load_si256(reinterpret_cast<__m256i const*>(_padded));
+                it = end;
+            }
+            if (_mm256_movemask_epi8(_input) == 0) {
+                // Only ASCII, which is only an error if the previous input was incomplete.
+                if (!_mm256_testz_si256(_incomplete, _incomplete)) {
+                    return _locate(_block);
+                }
+                // Otherwise no sequence continues past it, so the rest of the run of ASCII is
+                // skipped without checking it, and the next block follows ASCII (as zeros do).
+                it = skipAscii(it, end);
+                _previous = _mm256_setzero_si256();
+                continue;
+            }
+            __m256i const _error = checkUtf8Block(_input, _previous);
+            _incomplete = isIncomplete(_input);
+            if (!_mm256_testz_si256(_error, _error)) {
+                return _locate(_block);
+            }
+            _previous = _input;
+        }
+        // A full last block can end in the middle of a sequence.
+        if (!_mm256_testz_si256(_incomplete, _incomplete)) {
+            return _locate(_block);
+        }
+        return end;
+        #else
+        for (;;) {
+            it = Simd::findNonAscii(it, end);
+            if (it == end) {
+                return end;
+            }
+            // Decodes the whole run of characters outside ASCII before looking for the next.
+            do {
+                Utf8Char const _char = decodeUtf8(it, end);
+                if (!_char.valid) {
+                    return it;
+                }
+                it += _char.length;
+            } while (it != end && static_cast<unsigned char>(*it) >= 0x80);
+        }
+        #endif
+    }
+}
@@ -0,0 +1,332 @@
+#include <fennton/skript/Bytecode.hpp>
+#include <array>
+#include <format>
+#include <cstring>
+#include <stdexcept>
+
+// Computed gotos (a GNU extension) give each operation its own indirect jump, which branch
+// predictors learn far better than the single jump of a switch. Defining FENNTON_VM_SWITCH
+// forces the switch, to test it on compilers which have both.
+#if (defined(__GNUC__) || defined(__clang__)) && !defined(FENNTON_VM_SWITCH)
+#define FENNTON_VM_COMPUTED_GOTO
+#endif
+
+namespace Fennton::Skript {
+    // Names of the opcodes, indexed by their value.
+    static constexpr std::array<std::string_view, opcodeCount> opcodeNames = {
+        "add", "sub", "mul", "div.s", "div.u", "rem.s", "rem.u", "neg",
+        "lt.s", "lt.u", "le.s", "le.u", "eq", "ne", "wrap.s", "wrap.u",
+        "add.f", "sub.f", "mul.f", "div.f", "rem.f", "neg.f", "lt.f", "le.f", "eq.f", "ne.f",
+        "round.f32", "cvt.s", "cvt.u", "ret"
+    };
+
+    Type Program::GetResultType() const {
+        return resultType;
+    }
+    std::span<Instruction const> Program::GetCode() const {
+        return code;
+    }
+    std::span<std::uint64_t const> Program::GetConstants() const {
+        return constants;
+    }
+    std::span<std::uint16_t const> Program::GetInputs() const {
+        return inputs;
+    }
+    std::size_t Program::GetRegisterCount() const {
+        return registerCount;
+    }
+    std::string Program::Disassemble() const {
+        std::string _text;
+        for (Instruction const& _instruction : code) {
+            std::string_view const _name = opcodeNames[static_cast<std::size_t>(_instruction.op)];
+            unsigned const _dst = _instruction.dst;
+            unsigned const _a = _instruction.a;
+            unsigned const _b = _instruction.b;
+            switch (_instruction.op) {
+                case Opcode::Return:
+                    _text += std::format("{} r{}\n", _name, _a);
+                    break;
+                case Opcode::WrapSigned:
+                case Opcode::WrapUnsigned:
+                    // The second operand is a bit count.
+                    _text += std::format("{} r{}, r{}, {}\n", _name, _dst, _a, _b);
+                    break;
+                case Opcode::Negate:
+                case Opcode::NegateFloat:
+                case Opcode::RoundFloat32:
+                case Opcode::SignedToFloat:
+                case Opcode::UnsignedToFloat:
+                    _text += std::format("{} r{}, r{}\n", _name, _dst, _a);
+                    break;
+                default:
+                    _text += std::format("{} r{}, r{}, r{}\n", _name, _dst, _a, _b);
+                    break;
+            }
+        }
+        return _text;
+    }
+    std::uint64_t Program::Run(std::span<std::uint64_t const> values) const {
+        if (values.size() < bindingCount) {
+            throw std::invalid_argument(std::format(
+                "Expected {} values, one per binding, but got {}.", bindingCount, values.size()
+            ));
+        }
+        // Only the registers the program uses are initialised.
+        alignas(64) std::uint64_t _registers[maxRegisters];
+        std::memcpy(_registers, constants.data(), constants.size() * sizeof(std::uint64_t));
+        std::uint64_t* const _inputs = _registers + constants.size();
+        for (std::size_t i = 0; i < inputs.size(); ++i) {
+            _inputs[i] = values[inputs[i]];
+        }
+        return execute(_registers);
+    }
+    // Returns the bits of the value in a register of the type, or throws if it is not of the
+    // type's kind or does not fit in it.
+    static std::uint64_t unbox(Value value, Type type, std::size_t binding) {
+        static constexpr std::string_view _kindNames[] = {
+            "a float", "an integer", "a Boolean", "a pointer", "nothing"
+        };
+        bool _isKind;
+        switch (type.kind) {
+            case TypeKind::Boolean: _isKind = value.IsBoolean(); break;
+            case TypeKind::Float: _isKind = value.IsFloat(); break;
+            default: _isKind = value.IsInteger(); break;
+        }
+        if (!_isKind) {
+            throw std::invalid_argument(std::format(
+                "Expected {} for binding {}, found {}.", spellType(type), binding,
+                _kindNames[static_cast<std::size_t>(value.GetKind())]
+            ));
+        }
+        switch (type.kind) {
+            case TypeKind::Boolean:
+                return booleanBits(value.GetBoolean());
+            case TypeKind::Float:
+                // Rounded like the results of the operations on the type.
+                return type.bits == 32
+                    ? applyOpcode(Opcode::RoundFloat32, value.GetBits(), 0)
+                    : value.GetBits();
+            default: {
+                std::uint64_t const _bits = value.GetUnsigned();
+                bool const _fits = type.kind == TypeKind::Signed
+                    ? value.FitsSigned()
+                        && applyOpcode(Opcode::WrapSigned, _bits, type.bits) == _bits
+                    : (!value.FitsSigned() || value.GetInteger() >= 0)
+                        && applyOpcode(Opcode::WrapUnsigned, _bits, type.bits) == _bits;
+                if (!_fits) {
+                    std::string const _integer = value.FitsSigned()
+                        ? std::to_string(value.GetInteger()) : std::to_string(_bits);
+                    throw std::invalid_argument(std::format(
+                        "Value {} of binding {} does not fit in {}.",
+                        _integer, binding, spellType(type)
+                    ));
+                }
+                return _bits;
+            }
+        }
+    }
+    std::uint64_t Program::evaluate(std::span<Value const> values) const {
+        if (values.size() < bindingCount) {
+            throw std::invalid_argument(std::format(
+                "Expected {} values, one per binding, but got {}.", bindingCount, values.size()
+            ));
+        }
+        alignas(64) std::uint64_t _registers[maxRegisters];
+        std::memcpy(_registers, constants.data(), constants.size() * sizeof(std::uint64_t));
+        std::uint64_t* const _inputs = _registers + constants.size();
+        for (std::size_t i = 0; i < inputs.size(); ++i) {
+            _inputs[i] = unbox(values[inputs[i]], inputTypes[i], inputs[i]);
+        }
+        return execute(_registers);
+    }
+    Value Program::makeResult(std::uint64_t result, Arena* arena) const {
+        switch (resultType.kind) {
+            case TypeKind::Boolean:
+                return Value::FromBoolean(result != 0);
+            case TypeKind::Float:
+                return Value::FromFloat(std::bit_cast<double>(result));
+            default:
+                break;
+        }
+        std::int64_t const _integer = static_cast<std::int64_t>(result);
+        if (arena != nullptr) {
+            return resultType.kind == TypeKind::Signed
+                ? Value::FromInteger(_integer, *arena) : Value::FromUnsigned(result, *arena);
+        }
+        // Unsigned results of 64 bits above the largest signed one read as negative.
+        bool const _fits = Value::FitsInline(_integer)
+            && (resultType.kind == TypeKind::Signed || _integer >= 0);
+        if (!_fits) {
+            // At the root, where the return comes from.
+            throw EvaluationException(
+                std::format(
+                    "Result {} does not fit inline in a value.", spellValue(result, resultType)
+                ),
+                static_cast<std::size_t>(offsets.back())
+            );
+        }
+        return Value::FromInteger(_integer);
+    }
+    Value Program::Evaluate(std::span<Value const> values) const {
+        return makeResult(evaluate(values), nullptr);
+    }
+    Value Program::Evaluate(std::span<Value const> values, Arena& arena) const {
+        return makeResult(evaluate(values), &arena);
+    }
+    #ifdef FENNTON_VM_COMPUTED_GOTO
+    // Taking the address of a label and jumping to it are the extension itself, which
+    // -Wpedantic warns about, so it is silenced for the interpreter loop alone.
+    #pragma GCC diagnostic push
+    #pragma GCC diagnostic ignored "-Wpedantic"
+    #endif
+    std::uint64_t Program::execute(std::uint64_t* registers) const {
+        Instruction const* const _begin = code.data();
+        Instruction const* _ip = _begin;
+        Instruction _in;
+        // Register accesses, and the operation of an opcode on the register a and the given
+        // b, which inlines into the operation alone as the opcode is known.
+        #define FENNTON_R(index) registers[_in.index]
+        #define FENNTON_APPLY(name, b) FENNTON_R(dst) = applyOpcode(Opcode::name, FENNTON_R(a), b)
+
+        #ifdef FENNTON_VM_COMPUTED_GOTO
+        // In the order of the opcodes.
+        static void* const _labels[] = {
+            &&Add, &&Subtract, &&Multiply, &&DivideSigned, &&DivideUnsigned,
+            &&RemainderSigned, &&RemainderUnsigned, &&Negate,
+            &&LessSigned, &&LessUnsigned, &&LessEqualSigned, &&LessEqualUnsigned,
+            &&Equal, &&NotEqual, &&WrapSigned, &&WrapUnsigned,
+            &&AddFloat, &&SubtractFloat, &&MultiplyFloat, &&DivideFloat, &&RemainderFloat,
+            &&NegateFloat, &&LessFloat, &&LessEqualFloat, &&EqualFloat, &&NotEqualFloat,
+            &&RoundFloat32, &&SignedToFloat, &&UnsignedToFloat, &&Return
+        };
+        static_assert(std::size(_labels) == opcodeCount);
+        #define FENNTON_CASE(name) name:
+        #define FENNTON_NEXT() \
+            _in = *_ip++; \
+            goto *_labels[static_cast<std::size_t>(_in.op)]
+        FENNTON_NEXT();
+        #else
+        #define FENNTON_CASE(name) case Opcode::name:
+        #define FENNTON_NEXT() break
+        for (;;) {
+        _in = *_ip++;
+        switch (_in.op) {
+        #endif
+            FENNTON_CASE(Add)
+                FENNTON_APPLY(Add, FENNTON_R(b));
+                FENNTON_NEXT();
+            FENNTON_CASE(Subtract)
+                FENNTON_APPLY(Subtract, FENNTON_R(b));
+                FENNTON_NEXT();
+            FENNTON_CASE(Multiply)
+                FENNTON_APPLY(Multiply, FENNTON_R(b));
+                FENNTON_NEXT();
+            FENNTON_CASE(DivideSigned)
+                if (FENNTON_R(b) == 0) {
+                    goto divisionByZero;
+                }
+                FENNTON_APPLY(DivideSigned, FENNTON_R(b));
+                FENNTON_NEXT();
+            FENNTON_CASE(DivideUnsigned)
+                if (FENNTON_R(b) == 0) {
+                    goto divisionByZero;
+                }
+                FENNTON_APPLY(DivideUnsigned, FENNTON_R(b));
+                FENNTON_NEXT();
+            FENNTON_CASE(RemainderSigned)
+                if (FENNTON_R(b) == 0) {
+                    goto divisionByZero;
+                }
+                FENNTON_APPLY(RemainderSigned, FENNTON_R(b));
+                FENNTON_NEXT();
+            FENNTON_CASE(RemainderUnsigned)
+                if (FENNTON_R(b) == 0) {
+                    goto divisionByZero;
+                }
+                FENNTON_APPLY(RemainderUnsigned, FENNTON_R(b));
+                FENNTON_NEXT();
+            FENNTON_CASE(Negate)
+                FENNTON_APPLY(Negate, 0);
+                FENNTON_NEXT();
+            FENNTON_CASE(LessSigned)
+                FENNTON_APPLY(LessSigned, FENNTON_R(b));
+                FENNTON_NEXT();
+            FENNTON_CASE(LessUnsigned)
+                FENNTON_APPLY(LessUnsigned, FENNTON_R(b));
+                FENNTON_NEXT();
+            FENNTON_CASE(LessEqualSigned)
+                FENNTON_APPLY(LessEqualSigned, FENNTON_R(b));
+                FENNTON_NEXT();
+            FENNTON_CASE(LessEqualUnsigned)
+                FENNTON_APPLY(LessEqualUnsigned, FENNTON_R(b));
+                FENNTON_NEXT();
+            FENNTON_CASE(Equal)
+                FENNTON_APPLY(Equal, FENNTON_R(b));
+                FENNTON_NEXT();
+            FENNTON_CASE(NotEqual)
+                FENNTON_APPLY(NotEqual, FENNTON_R(b));
+                FENNTON_NEXT();
+            FENNTON_CASE(WrapSigned)
+                FENNTON_APPLY(WrapSigned, _in.b);
+                FENNTON_NEXT();
+            FENNTON_CASE(WrapUnsigned)
+                FENNTON_APPLY(WrapUnsigned, _in.b);
+                FENNTON_NEXT();
+            FENNTON_CASE(AddFloat)
+                FENNTON_APPLY(AddFloat, FENNTON_R(b));
+                FENNTON_NEXT();
+            FENNTON_CASE(SubtractFloat)
+                FENNTON_APPLY(SubtractFloat, FENNTON_R(b));
+                FENNTON_NEXT();
+            FENNTON_CASE(MultiplyFloat)
+                FENNTON_APPLY(MultiplyFloat, FENNTON_R(b));
+                FENNTON_NEXT();
+            FENNTON_CASE(DivideFloat)
+                FENNTON_APPLY(DivideFloat, FENNTON_R(b));
+                FENNTON_NEXT();
+            FENNTON_CASE(RemainderFloat)
+                FENNTON_APPLY(RemainderFloat, FENNTON_R(b));
+                FENNTON_NEXT();
+            FENNTON_CASE(NegateFloat)
+                FENNTON_APPLY(NegateFloat, 0);
+                FENNTON_NEXT();
+            FENNTON_CASE(LessFloat)
+                FENNTON_APPLY(LessFloat, FENNTON_R(b));
+                FENNTON_NEXT();
+            FENNTON_CASE(LessEqualFloat)
+                FENNTON_APPLY(LessEqualFloat, FENNTON_R(b));
+                FENNTON_NEXT();
+            FENNTON_CASE(EqualFloat)
+                FENNTON_APPLY(EqualFloat, FENNTON_R(b));
+                FENNTON_NEXT();
+            FENNTON_CASE(NotEqualFloat)
+                FENNTON_APPLY(NotEqualFloat, FENNTON_R(b));
+                FENNTON_NEXT();
+            FENNTON_CASE(RoundFloat32)
+                FENNTON_APPLY(RoundFloat32, 0);
+                FENNTON_NEXT();
+            FENNTON_CASE(SignedToFloat)
+                FENNTON_APPLY(SignedToFloat, 0);
+                FENNTON_NEXT();
+            FENNTON_CASE(UnsignedToFloat)
+                FENNTON_APPLY(UnsignedToFloat, 0);
+                FENNTON_NEXT();
+            FENNTON_CASE(Return)
+                return FENNTON_R(a);
+        #ifndef FENNTON_VM_COMPUTED_GOTO
+        }
+        }
+        #endif
+        #undef FENNTON_R
+        #undef FENNTON_APPLY
+        #undef FENNTON_CASE
+        #undef FENNTON_NEXT
+    divisionByZero:
+        throw EvaluationException(
+            "Integer division by zero.", static_cast<std::size_t>(offsets[_ip - 1 - _begin])
+        );
+    }
+    #ifdef FENNTON_VM_COMPUTED_GOTO
+    #pragma GCC diagnostic pop
+    #endif
+}
@@ -0,0 +1,73 @@
+# Command: python src/python/XidTables.py > include/fennton/skript/XidTables.hpp
+
+import sys
+import unicodedata
+
+# Generates the two-level tables of the XID_Start and XID_Continue properties used for the
+# names of the tokeniser. The code points are split into blocks, each of which refers to a
+# leaf with the bits of both properties; identical leaves are shared.
+
+_blockSize = 128
+_wordsPerSet = _blockSize // 64
+
+def _isStart(c):
+    # Python identifiers can also start with an underscore, which is not XID_Start.
+    return c != '_' and c.isidentifier()
+
+def _isContinue(c):
+    return ('a' + c).isidentifier()
+
+def _bits(block, test):
+    _words = [0] * _wordsPerSet
+    for i in range(_blockSize):
+        _cp = block * _blockSize + i
+        if 0xD800 <= _cp < 0xE000:
+            continue
+        if test(chr(_cp)):
+            _words[i // 64] |= 1 << (i % 64)
+    return _words
+
+_leaves = {}
+_leafList = []
+_index = []
+for _block in range(0x110000 // _blockSize):
+    _leaf = tuple(_bits(_block, _isStart) + _bits(_block, _isContinue))
+    if _leaf not in _leaves:
+        _leaves[_leaf] = len(_leafList)
+        _leafList.append(_leaf)
+    _index.append(_leaves[_leaf])
+# The blocks after the last one with a property refer to the empty leaf, so they are left out
+# of the index.
+_empty = _leaves[tuple([0] * (_wordsPerSet * 2))]
+while _index[-1] == _empty:
+    _index.pop()
+if len(_leafList) > 256:
+    sys.exit("Too many leaves for an 8-bit index.")
+
+print(f"""// Generated by src/python/XidTables.py from Unicode {unicodedata.unidata_version}.
+
+#ifndef FENNTON_XID_TABLES_HPP
+#define FENNTON_XID_TABLES_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace Fennton::Skript::Tokeniser::XidTables {{
+    // Number of code points per block.
+    inline constexpr std::size_t blockSize = {_blockSize};
+    // Leaf which has none of the properties, used for the blocks after the index.
+    inline constexpr std::uint8_t emptyLeaf = {_empty};
+    // Leaf of each block of code points.
+    inline constexpr std::array<std::uint8_t, {len(_index)}> blocks = {{""")
+for i in range(0, len(_index), 16):
+    print("        " + ", ".join(str(v) for v in _index[i:i + 16]) + ",")
+print(f"""    }};
+    // Bits of each leaf, first those of XID_Start and then those of XID_Continue, with
+    // {_wordsPerSet} words per property.
+    inline constexpr std::array<std::uint64_t, {len(_leafList) * _wordsPerSet * 2}> leaves = {{""")
+for _leaf in _leafList:
+    print("        " + ", ".join(f"0x{w:016X}" for w in _leaf) + ",")
+print("""    };
+}
+#endif""")
@@ -0,0 +1,1032 @@
+#ifdef _WIN32
+#include <Windows.h>
+#include <psapi.h>
+#endif
+
+#include <fennton/utils/Console.hpp>
+#include <fennton/skript/Parser.hpp>
+#include <fennton/skript/CharClass.hpp>
+#include <fennton/skript/Cache.hpp>
+#include <fennton/skript/Grammar.hpp>
+#include <fennton/skript/Ast.hpp>
+#include <fennton/skript/Bytecode.hpp>
+#include <chrono>
+#include <functional>
+#include <locale>
+#include <thread>
+#include <atomic>
+#include <fstream>
+#include <filesystem>
+#include <sstream>
+#include <format>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <array>
+#include <optional>
+#include <algorithm>
+#include <new>
+#include <stdexcept>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+
+// The baseline, built with its default configuration.
+#define STB_C_LEXER_IMPLEMENTATION
+#include <stb_c_lexer.h>
+
+namespace Console = Fennton::Console;
+namespace Tokeniser = Fennton::Skript::Tokeniser;
+
+// Number of allocations made through the global operator new, by any thread.
+static std::atomic<std::size_t> allocationCount = 0;
+
+// GCC takes the pointers passed to the replaced operator delete for ones from operator new, and
+// warns about freeing them, though they come from the malloc of the replaced operator new.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void* operator new(std::size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    // malloc might return null for zero bytes, which operator new must not.
+    if (void* _pointer = std::malloc(size == 0? 1 : size)) {
+        return _pointer;
+    }
+    throw std::bad_alloc();
+}
+void operator delete(void* pointer) noexcept {
+    std::free(pointer);
+}
+void operator delete(void* pointer, std::size_t) noexcept {
+    std::free(pointer);
+}
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+// The number literals from the skript_tokeniser tests.
+static std::vector<std::string_view> const numberLiterals = {
+    "123", "0", "010", "0o10", "0b10", "0xff", "0xfF", "0xFf", "0xFF",
+    "12345678901234567890123456789012345678901234567890",
+    "0x0123456789abcdefABCDEF0123456789",
+    "123u8", "123u1", "123a'b'c", "0u8", "0b10u8", "0xff.'u8", "0xFF.'a'b",
+    "123.912", "0.5", "123.912.0.1000", "123.912.0u8", "123.661a'b'c", "0x1.fF.'u8"
+};
+// Words which the generated identifiers and comments are made of.
+static std::vector<std::string_view> const words = {
+    "player", "entity", "damage", "health", "count", "index", "value", "name", "item",
+    "world", "block", "event", "target", "source", "max", "min", "x", "y", "z", "tmp",
+    "location", "inventory", "cooldown", "message", "speed", "list", "on", "by"
+};
+// Words outside ASCII, for localised names and text: "été", "naïve", "größe", "игрок", "λόγος" and 
+// "名前", spelled as escape sequences so that the source's encoding does not matter.
+static std::vector<std::string_view> const unicodeWords = {
+    "\xC3\xA9t\xC3\xA9", "na\xC3\xAFve", "gr\xC3\xB6\xC3\x9F" "e",
+    "\xD0\xB8\xD0\xB3\xD1\x80\xD0\xBE\xD0\xBA", "\xCE\xBB\xCF\x8C\xCE\xB3\xCE\xBF\xCF\x82",
+    "\xE5\x90\x8D\xE5\x89\x8D"
+};
+// Operators which the generated expressions are made of.
+static std::vector<std::string_view> const operators = {
+    "+", "-", "*", "/", "%", "==", "!=", "<", ">=", "&&", "||", "->", "=", "."
+};
+
+// Rules of the evaluation benchmark, like the gameplay rules evaluated every frame, and the
+// names they are evaluated with.
+static std::vector<std::string_view> const rules = {
+    "2 + 2 != 5",
+    "(20 + 4) * 0",
+    "level * 12 + strength / 3 - armor % 7 > threshold",
+    "health - (damage * 3u8 + 1) / 2u8",
+    "speed * 0.5 + speed * speed < 10.0",
+    "level * (threshold / 10) + armor * 0 > threshold - 1"
+};
+static std::vector<std::string_view> const ruleNames = {
+    "level", "strength", "armor", "threshold", "health", "damage", "speed"
+};
+static std::vector<Fennton::Skript::Type> const ruleTypes = {
+    { Fennton::Skript::TypeKind::Signed, 32 },
+    { Fennton::Skript::TypeKind::Signed, 32 },
+    { Fennton::Skript::TypeKind::Signed, 32 },
+    { Fennton::Skript::TypeKind::Signed, 32 },
+    { Fennton::Skript::TypeKind::Unsigned, 8 },
+    { Fennton::Skript::TypeKind::Unsigned, 8 },
+    { Fennton::Skript::TypeKind::Float, 64 }
+};
+// Deterministic pseudo-random generator (SplitMix64), so that the corpora are the same on
+// every platform and run, which the standard distributions do not guarantee.
+class Random {
+private:
+    std::uint64_t state;
+public:
+    Random(std::uint64_t seed) : state(seed) {}
+
+    // Returns the next 64 random bits.
+    std::uint64_t Next() {
+        std::uint64_t _z = (state += 0x9e3779b97f4a7c15);
+        _z = (_z ^ (_z >> 30)) * 0xbf58476d1ce4e5b9;
+        _z = (_z ^ (_z >> 27)) * 0x94d049bb133111eb;
+        return _z ^ (_z >> 31);
+    }
+    // Returns a number in [0, bound).
+    std::size_t Below(std::size_t bound) {
+        return static_cast<std::size_t>(Next() % bound);
+    }
+    // Returns a number in [0, bound), where smaller numbers are more likely, like the
+    // identifiers of a script, of which a few are used most of the time.
+    std::size_t Skewed(std::size_t bound) {
+        return std::min(Below(bound), Below(bound));
+    }
+    // Returns one of the elements, picked uniformly.
+    template<typename T> T const& Pick(std::vector<T> const& elements) {
+        return elements[Below(elements.size())];
+    }
+};
+// Deterministic corpus, generated by appending pieces until it reaches its size.
+struct Corpus {
+    std::string_view name;
+    // Appends the next piece of the corpus.
+    void (*generate)(Random& random, std::string& corpus);
+};
+// Measurements of one stage on one corpus.
+struct Result {
+    std::string name;
+    std::size_t bytes = 0;
+    std::size_t tokens = 0;
+    // Fastest run.
+    double seconds = 0.0;
+    // Allocations per run.
+    double allocations = 0.0;
+    // Peak resident set size of the process while running the stage, or 0 if unknown.
+    std::size_t peakKiB = 0;
+    // Why the stage could not process the corpus, if it could not.
+    std::string error;
+};
+// Stage of the tokeniser (or of the baseline), which processes a corpus and returns the number
+// of tokens.
+struct Stage {
+    std::string_view name;
+    std::size_t (*function)(std::string const& corpus);
+};
+// Command line options.
+struct Options {
+    // Size of each corpus, in bytes.
+    std::size_t size = 16 << 20;
+    std::int32_t repeats = 5;
+    // Where to write the results as JSON, if anywhere.
+    std::string jsonPath;
+    // Results to compare the throughputs against, if any.
+    std::string baselinePath;
+    // Fraction of a baseline's throughput which can be lost before it is a regression.
+    double tolerance = 0.1;
+};
+
+void init();
+void term();
+// Returns the options parsed from the command line.
+Options parseOptions(int argc, char** argv);
+// Appends a random identifier.
+void appendName(Random& random, std::string& corpus);
+// Appends a random number literal.
+void appendNumber(Random& random, std::string& corpus);
+// Appends a random comment of the specified number of words, without its delimiters.
+void appendWords(Random& random, std::string& corpus, std::size_t count);
+// Appends a random expression, nested at most to the specified depth.
+void appendExpression(Random& random, std::string& corpus, std::int32_t depth);
+// Generators of the corpora.
+void generateNumbers(Random& random, std::string& corpus);
+void generateNames(Random& random, std::string& corpus);
+void generateComments(Random& random, std::string& corpus);
+void generatePunctuation(Random& random, std::string& corpus);
+void generateDialogue(Random& random, std::string& corpus);
+void generateMixed(Random& random, std::string& corpus);
+void generateUnicode(Random& random, std::string& corpus);
+// Builds a corpus of at least the specified size, always the same for the same generator.
+std::string makeCorpus(Corpus const& corpus, std::size_t size);
+// Runs the stage on the corpus repeatedly and returns its measurements, which are also
+// printed.
+Result benchStage(
+    std::string_view corpusName,
+    std::string const& corpus,
+    Stage const& stage,
+    std::int32_t repeats
+);
+// Runs the classification function on every character of the corpus repeatedly and prints
+// the cost per character.
+void benchClassify(
+    std::string_view name,
+    std::string const& corpus,
+    std::int32_t repeats,
+    bool (*function)(char)
+);
+// Prints the throughput of the parallel tokeniser for each power-of-two thread count up to
+// the hardware's concurrency, and its speedup over the serial tokeniser.
+void benchParallel(std::string_view name, std::string const& corpus, std::int32_t repeats);
+// Prints the time taken to retokenise the corpus after replacing one of the characters in its
+// middle with a digit, compared with tokenising the edited corpus from scratch.
+void benchRetokenise(std::string_view name, std::string const& corpus, std::int32_t repeats);
+// Prints the startup time of tokenising the corpus through a token cache, both cold (tokenised 
+// and stored) and warm (loaded from the stored file), in a temporary directory.
+void benchCache(std::string_view name, std::string const& corpus, std::int32_t repeats);
+// Prints the time taken to evaluate each rule with its compiled bytecode, without and with
+// folding (where threshold is a setting known at compile time), the allocations per
+// evaluation, and the time taken to parse and compile it.
+void benchEvaluate(std::int32_t repeats);
+// Prints the time taken to evaluate each rule for a batch of entities with the values of
+// their bindings in columns, one entity at a time and with Program::RunBatch.
+void benchBatch(std::int32_t repeats);
+// Tokenises into a stream sharing the source.
+std::size_t tokeniseStream(std::string const& corpus);
+// Tokenises into a stream and builds the owning token of each of its tokens.
+std::size_t tokeniseOwned(std::string const& corpus);
+// Tokenises into a stream with as many threads as the hardware has.
+std::size_t tokeniseThreads(std::string const& corpus);
+// Tokenises into a stream and serialises it back into a single string.
+std::size_t tokeniseSpell(std::string const& corpus);
+// Tokenises into a stream while collecting the errors, counting the error tokens too.
+std::size_t tokeniseRecover(std::string const& corpus);
+// Builds the line table of the corpus, returning the number of lines instead of tokens.
+std::size_t buildLines(std::string const& corpus);
+// Tokenises into owning tokens one at a time with the hand-written consumeSpace and
+// tokeniseNext.
+std::size_t tokeniseHandwritten(std::string const& corpus);
+// Same, but with the lexer generated from the grammar (lexSpace and lexNext).
+std::size_t tokeniseGenerated(std::string const& corpus);
+// Tokenises with stb_c_lexer, counting its parse errors as tokens.
+std::size_t tokeniseStb(std::string const& corpus);
+// Writes the results as JSON, one result per line so that runs diff line by line.
+void writeJson(
+    std::string const& path,
+    Options const& options,
+    std::vector<Result> const& results
+);
+// Compares the throughputs with the ones of the baseline, printing each regression, and
+// returns whether there was any.
+bool compareBaseline(
+    std::string const& path,
+    double tolerance,
+    std::vector<Result> const& results
+);
+int main(int argc, char** argv) {
+    int _errorCode;
+    try {
+        init();
+        Options const _options = parseOptions(argc, argv);
+        std::vector<Corpus> const _corpora = {
+            { "numbers", generateNumbers },
+            { "names", generateNames },
+            { "comments", generateComments },
+            { "punctuation", generatePunctuation },
+            { "dialogue", generateDialogue },
+            { "mixed", generateMixed },
+            { "unicode", generateUnicode }
+        };
+        std::vector<Stage> const _stages = {
+            { "tokenise", tokeniseStream },
+            { "owned", tokeniseOwned },
+            { "parallel", tokeniseThreads },
+            { "spell", tokeniseSpell },
+            { "recover", tokeniseRecover },
+            { "lines", buildLines },
+            { "handwritten", tokeniseHandwritten },
+            { "generated", tokeniseGenerated },
+            { "stb_c_lexer", tokeniseStb }
+        };
+        std::vector<Result> _results;
+        for (Corpus const& _corpus : _corpora) {
+            // Built one at a time, so that the peak memory of a stage only includes its own
+            // corpus.
+            std::string const _text = makeCorpus(_corpus, _options.size);
+            for (Stage const& _stage : _stages) {
+                _results.push_back(benchStage(_corpus.name, _text, _stage, _options.repeats));
+            }
+            if (_corpus.name == "numbers") {
+                // Character classification, through the classic C locale and through the
+                // tokeniser's table.
+                benchClassify("classify/locale", _text, _options.repeats, [](char c) {
+                    std::locale const& _locale = std::locale::classic();
+                    return
+                        (c != '_' && std::ispunct(c, _locale))
+                        || std::isspace(c, _locale)
+                        || std::iscntrl(c, _locale)
+                    ;
+                });
+                benchClassify("classify/table", _text, _options.repeats, [](char c) {
+                    return
+                        Tokeniser::isPunct(c)
+                        || Tokeniser::isSpace(c)
+                        || Tokeniser::isControl(c)
+                    ;
+                });
+                // Same, but through the inlined table lookup, as done inside the tokeniser.
+                benchClassify("classify/inline", _text, _options.repeats, [](char c) {
+                    namespace CharClass = Tokeniser::CharClass;
+                    return Tokeniser::hasClass(
+                        c, CharClass::Punct | CharClass::Space | CharClass::Control
+                    );
+                });
+                benchParallel(_corpus.name, _text, _options.repeats);
+                benchRetokenise(_corpus.name, _text, _options.repeats);
+            }
+            if (_corpus.name == "numbers" || _corpus.name == "names") {
+                benchCache(_corpus.name, _text, _options.repeats);
+            }
+        }
+        benchEvaluate(_options.repeats);
+        benchBatch(_options.repeats);
+        if (!_options.jsonPath.empty()) {
+            writeJson(_options.jsonPath, _options, _results);
+        }
+        _errorCode = 0;
+        if (!_options.baselinePath.empty()
+            && compareBaseline(_options.baselinePath, _options.tolerance, _results)
+        ) {
+            _errorCode = 0b10;
+        }
+    } catch (std::exception& e) {
+        Console::printl("[EXCEPTION] {}", e.what());
+        _errorCode = 0b1;
+    } catch (...) {
+        Console::printl("[UNKNOWN EXCEPTION]");
+        _errorCode = 0b1;
+    }
+    term();
+    return _errorCode;
+}
+void init() {
+    Console::init();
+}
+void term() {
+    Console::term();
+}
+Options parseOptions(int argc, char** argv) {
+    Options _options;
+    for (int i = 1; i < argc; ++i) {
+        std::string_view _option = argv[i];
+        if (i + 1 == argc) {
+            throw std::invalid_argument(std::format("Missing value of option {}.", _option));
+        }
+        std::string_view _value = argv[++i];
+        if (_option == "--json") {
+            _options.jsonPath = _value;
+        } else if (_option == "--baseline") {
+            _options.baselinePath = _value;
+        } else if (_option == "--tolerance") {
+            _options.tolerance = std::stod(std::string(_value));
+        } else if (_option == "--size") {
+            // In MiB.
+            _options.size = static_cast<std::size_t>(std::stoull(std::string(_value))) << 20;
+        } else if (_option == "--repeats") {
+            _options.repeats = std::stoi(std::string(_value));
+        } else {
+            throw std::invalid_argument(std::format(
+                "Unknown option {}; expected --json, --baseline, --tolerance, --size or "
+                "--repeats.", _option
+            ));
+        }
+    }
+    return _options;
+}
+void appendName(Random& random, std::string& corpus) {
+    // A few short prefixes, then words joined by underscores, sometimes with a digit.
+    if (random.Below(8) == 0) {
+        corpus.push_back('_');
+    }
+    std::size_t const _wordCount = 1 + random.Skewed(4);
+    for (std::size_t i = 0; i < _wordCount; ++i) {
+        if (i != 0) {
+            corpus.push_back('_');
+        }
+        corpus.append(words[random.Skewed(words.size())]);
+    }
+    if (random.Below(4) == 0) {
+        corpus.push_back(static_cast<char>('0' + random.Below(10)));
+    }
+}
+void appendNumber(Random& random, std::string& corpus) {
+    if (random.Below(2) == 0) {
+        corpus.append(random.Pick(numberLiterals));
+        return;
+    }
+    // Mostly small integers, as in real scripts.
+    corpus.append(std::to_string(random.Skewed(1000)));
+    if (random.Below(4) == 0) {
+        corpus.push_back('.');
+        corpus.append(std::to_string(random.Below(100)));
+    }
+}
+void appendWords(Random& random, std::string& corpus, std::size_t count) {
+    for (std::size_t i = 0; i < count; ++i) {
+        if (i != 0) {
+            corpus.push_back(' ');
+        }
+        corpus.append(random.Pick(words));
+    }
+}
+void appendExpression(Random& random, std::string& corpus, std::int32_t depth) {
+    static char const* const _brackets[] = { "()", "[]", "{}" };
+
+    std::size_t const _operandCount = 1 + random.Below(3);
+    for (std::size_t i = 0; i < _operandCount; ++i) {
+        if (i != 0) {
+            corpus.push_back(' ');
+            corpus.append(random.Below(3) == 0? "," : random.Pick(operators));
+            corpus.push_back(' ');
+        }
+        // Nests most of the time while there is depth left, so that the brackets pile up.
+        if (depth > 0 && random.Below(3) != 0) {
+            char const* _pair = _brackets[random.Below(3)];
+            corpus.push_back(_pair[0]);
+            appendExpression(random, corpus, depth - 1);
+            corpus.push_back(_pair[1]);
+        } else if (random.Below(2) == 0) {
+            appendName(random, corpus);
+        } else {
+            appendNumber(random, corpus);
+        }
+    }
+}
+void generateNumbers(Random& random, std::string& corpus) {
+    // A line of values, like a table.
+    for (std::size_t i = 0; i < 8; ++i) {
+        appendNumber(random, corpus);
+        corpus.push_back(i == 7? '\n' : ' ');
+    }
+}
+void generateNames(Random& random, std::string& corpus) {
+    for (std::size_t i = 0; i < 8; ++i) {
+        appendName(random, corpus);
+        corpus.push_back(i == 7? '\n' : ' ');
+    }
+}
+void generateComments(Random& random, std::string& corpus) {
+    corpus.append(4 * random.Below(5), ' ');
+    switch (random.Below(3)) {
+    case 0:
+        corpus.append("// ");
+        appendWords(random, corpus, 3 + random.Below(10));
+        break;
+    case 1:
+        corpus.append("/* ");
+        appendWords(random, corpus, 3 + random.Below(10));
+        corpus.append("\n   ");
+        appendWords(random, corpus, 3 + random.Below(10));
+        corpus.append(" */ ");
+        appendNumber(random, corpus);
+        break;
+    default:
+        appendNumber(random, corpus);
+        corpus.append(" // ");
+        appendWords(random, corpus, 2 + random.Below(6));
+        break;
+    }
+    corpus.push_back('\n');
+}
+void generatePunctuation(Random& random, std::string& corpus) {
+    appendExpression(random, corpus, 24);
+    corpus.push_back('\n');
+}
+void generateDialogue(Random& random, std::string& corpus) {
+    // A line spoken by a character, mostly plain text with the occasional escape sequence, as
+    // in dialogue and localisation scripts.
+    appendName(random, corpus);
+    corpus.append(" \"");
+    std::size_t const _sentenceCount = 1 + random.Below(3);
+    for (std::size_t i = 0; i < _sentenceCount; ++i) {
+        if (i != 0) {
+            corpus.append(random.Below(4) == 0? "\\n" : " ");
+        }
+        if (random.Below(8) == 0) {
+            corpus.append("\\\"");
+            appendWords(random, corpus, 2 + random.Below(4));
+            corpus.append("\\\"");
+        } else {
+            appendWords(random, corpus, 4 + random.Below(12));
+        }
+        corpus.push_back('.');
+    }
+    corpus.append("\"\n");
+}
+void generateMixed(Random& random, std::string& corpus) {
+    // A block of statements, shaped like a script's event handler.
+    corpus.append("on ");
+    appendName(random, corpus);
+    corpus.append(":\n");
+    std::size_t const _statementCount = 2 + random.Below(12);
+    for (std::size_t i = 0; i < _statementCount; ++i) {
+        std::size_t const _indent = 1 + random.Skewed(3);
+        corpus.append(4 * _indent, ' ');
+        switch (random.Below(6)) {
+        case 0:
+            corpus.append("// ");
+            appendWords(random, corpus, 3 + random.Below(8));
+            break;
+        case 1:
+            corpus.append("if ");
+            appendExpression(random, corpus, 2);
+            corpus.push_back(':');
+            break;
+        case 2:
+            appendName(random, corpus);
+            corpus.push_back('(');
+            appendExpression(random, corpus, 1);
+            corpus.push_back(')');
+            break;
+        default:
+            corpus.append("set ");
+            appendName(random, corpus);
+            corpus.append(" to ");
+            appendExpression(random, corpus, 2);
+            if (random.Below(4) == 0) {
+                corpus.append(" // ");
+                appendWords(random, corpus, 2 + random.Below(4));
+            }
+            break;
+        }
+        corpus.push_back('\n');
+    }
+    corpus.push_back('\n');
+}
+void generateUnicode(Random& random, std::string& corpus) {
+    // A line of localised dialogue, whose speaker's name and text are mostly outside ASCII.
+    corpus.append(unicodeWords[random.Below(unicodeWords.size())]);
+    corpus.push_back('_');
+    appendName(random, corpus);
+    corpus.append(" \"");
+    std::size_t const _wordCount = 4 + random.Below(12);
+    for (std::size_t i = 0; i < _wordCount; ++i) {
+        if (i != 0) {
+            corpus.push_back(' ');
+        }
+        corpus.append(unicodeWords[random.Skewed(unicodeWords.size())]);
+    }
+    corpus.append(".\"\n");
+}
+std::string makeCorpus(Corpus const& corpus, std::size_t size) {
+    // Seeded by the corpus alone, so that it is the same in every run.
+    Random _random = Random(std::hash<std::string_view>()(corpus.name));
+    std::string _corpus;
+    _corpus.reserve(size + 4096);
+    while (_corpus.size() < size) {
+        corpus.generate(_random, _corpus);
+    }
+    return _corpus;
+}
+std::size_t tokeniseStream(std::string const& corpus) {
+    return Tokeniser::tokenise(corpus).Size();
+}
+std::size_t tokeniseOwned(std::string const& corpus) {
+    Tokeniser::TokenStream _stream = Tokeniser::tokenise(corpus);
+    std::size_t _count = 0;
+    for (Tokeniser::TokenView _view : _stream) {
+        Tokeniser::Token _token = _view.MakeToken();
+        ++_count;
+    }
+    return _count;
+}
+std::size_t tokeniseThreads(std::string const& corpus) {
+    return Tokeniser::tokeniseParallel(corpus, 0).Size();
+}
+std::size_t tokeniseSpell(std::string const& corpus) {
+    Tokeniser::TokenStream _stream = Tokeniser::tokenise(corpus);
+    std::string _spelling = _stream.GetSpelling();
+    // The spelling is never smaller than the tokens it separates.
+    return _spelling.size() >= _stream.Size()? _stream.Size() : 0;
+}
+std::size_t tokeniseRecover(std::string const& corpus) {
+    std::vector<Tokeniser::Diagnostic> _diagnostics;
+    return Tokeniser::tokenise(corpus, _diagnostics).Size();
+}
+std::size_t buildLines(std::string const& corpus) {
+    return Fennton::Skript::LineTable(corpus).Size();
+}
+// Tokenises the corpus into owning tokens with the functions skipping the space and reading
+// the next token.
+static std::size_t tokeniseWith(
+    std::string const& corpus,
+    std::string_view::const_iterator (*space)(
+        std::string_view::const_iterator, std::string_view::const_iterator
+    ),
+    Tokeniser::TokenResult (*next)(
+        std::string_view::const_iterator, std::string_view::const_iterator
+    )
+) {
+    std::string_view const _corpus = corpus;
+    std::size_t _count = 0;
+    std::string_view::const_iterator _it = space(_corpus.begin(), _corpus.end());
+    while (_it != _corpus.end()) {
+        auto [_end, _token] = next(_it, _corpus.end());
+        ++_count;
+        _it = space(_end, _corpus.end());
+    }
+    return _count;
+}
+std::size_t tokeniseHandwritten(std::string const& corpus) {
+    return tokeniseWith(corpus, Tokeniser::consumeSpace, Tokeniser::tokeniseNext);
+}
+std::size_t tokeniseGenerated(std::string const& corpus) {
+    return tokeniseWith(corpus, Tokeniser::lexSpace, Tokeniser::lexNext);
+}
+std::size_t tokeniseStb(std::string const& corpus) {
+    // Storage of the last string or identifier.
+    static char _store[64 * 1024];
+
+    stb_lexer _lexer;
+    stb_c_lexer_init(
+        &_lexer, corpus.data(), corpus.data() + corpus.size(), _store, sizeof(_store)
+    );
+    std::size_t _count = 0;
+    // Parse errors resume after the invalid token, so they are counted as tokens too.
+    while (stb_c_lexer_get_token(&_lexer)) {
+        ++_count;
+    }
+    return _count;
+}
+// Returns the fastest time, in seconds, of running the function repeatedly.
+static double bestTime(std::int32_t repeats, std::function<void()> const& function) {
+    using Clock = std::chrono::steady_clock;
+
+    // The fastest run is the least disturbed by the rest of the system.
+    double _bestSeconds = 0.0;
+    for (std::int32_t i = 0; i < repeats; ++i) {
+        Clock::time_point _start = Clock::now();
+        function();
+        std::chrono::duration<double> _elapsed = Clock::now() - _start;
+        if (i == 0 || _elapsed.count() < _bestSeconds) {
+            _bestSeconds = _elapsed.count();
+        }
+    }
+    return _bestSeconds;
+}
+// Resets the peak resident set size where the system allows it, so that the next peak is
+// the stage's own rather than the whole run's.
+static void resetPeakMemory() {
+    #ifdef __linux__
+    std::ofstream("/proc/self/clear_refs") << "5";
+    #endif
+}
+// Returns the peak resident set size of the process in KiB, or 0 if unknown.
+static std::size_t peakMemory() {
+    #if defined(__linux__)
+    std::ifstream _status = std::ifstream("/proc/self/status");
+    std::string _line;
+    while (std::getline(_status, _line)) {
+        if (_line.starts_with("VmHWM:")) {
+            return static_cast<std::size_t>(std::stoull(_line.substr(6)));
+        }
+    }
+    return 0;
+    #elif defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS _counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &_counters, sizeof(_counters))) {
+        return 0;
+    }
+    return _counters.PeakWorkingSetSize / 1024;
+    #else
+    return 0;
+    #endif
+}
+// Returns the megabytes per second of processing the bytes in the time.
+static double megabytesPerSecond(std::size_t bytes, double seconds) {
+    return static_cast<double>(bytes) / (1024.0 * 1024.0) / seconds;
+}
+// Returns the average number of allocations made per token of the result.
+static double allocationsPerToken(Result const& result) {
+    return result.allocations / static_cast<double>(std::max<std::size_t>(result.tokens, 1));
+}
+Result benchStage(
+    std::string_view corpusName,
+    std::string const& corpus,
+    Stage const& stage,
+    std::int32_t repeats
+) {
+    Result _result;
+    _result.name = std::format("{}/{}", corpusName, stage.name);
+    _result.bytes = corpus.size();
+    resetPeakMemory();
+    std::size_t const _allocations = allocationCount.load(std::memory_order_relaxed);
+    try {
+        _result.seconds = bestTime(repeats, [&]() {
+            _result.tokens = stage.function(corpus);
+        });
+    } catch (Tokeniser::Exception& e) {
+        // Corpora using features which the tokeniser does not support yet.
+        _result.error = e.what();
+        Console::printl("[BENCH] {} | unsupported: {}", _result.name, _result.error);
+        return _result;
+    }
+    _result.allocations = static_cast<double>(
+        allocationCount.load(std::memory_order_relaxed) - _allocations
+    ) / repeats;
+    _result.peakKiB = peakMemory();
+    Console::printl(
+        "[BENCH] {} | {} tokens | {:.1f} MB/s | {:.2f} Mtokens/s | {:.4f} allocs/token | "
+        "{} KiB peak",
+        _result.name,
+        _result.tokens,
+        megabytesPerSecond(_result.bytes, _result.seconds),
+        static_cast<double>(_result.tokens) / _result.seconds / 1e6,
+        allocationsPerToken(_result),
+        _result.peakKiB
+    );
+    return _result;
+}
+void benchClassify(
+    std::string_view name,
+    std::string const& corpus,
+    std::int32_t repeats,
+    bool (*function)(char)
+) {
+    // Printed, so that the classification cannot be optimised away.
+    std::size_t _matches = 0;
+    double _bestSeconds = bestTime(repeats, [&]() {
+        _matches = 0;
+        for (char c : corpus) {
+            _matches += function(c)? 1 : 0;
+        }
+    });
+    Console::printl("[BENCH] {} | {} matches | {:.3f} ns/byte",
+        name, _matches, _bestSeconds * 1e9 / static_cast<double>(corpus.size())
+    );
+}
+void benchParallel(std::string_view name, std::string const& corpus, std::int32_t repeats) {
+    double const _serial = bestTime(repeats, [&]() { Tokeniser::tokenise(corpus); });
+    std::size_t const _maxThreads = std::max(std::thread::hardware_concurrency(), 1u);
+    for (std::size_t _threads = 1;; _threads *= 2) {
+        _threads = std::min(_threads, _maxThreads);
+        double _parallel = bestTime(repeats, [&]() {
+            Tokeniser::tokeniseParallel(corpus, _threads);
+        });
+        Console::printl("[BENCH] {}/parallel | {} threads | {:.1f} MB/s | {:.2f}x",
+            name, _threads, megabytesPerSecond(corpus.size(), _parallel), _serial / _parallel
+        );
+        if (_threads == _maxThreads) {
+            break;
+        }
+    }
+}
+void benchRetokenise(std::string_view name, std::string const& corpus, std::int32_t repeats) {
+    Tokeniser::TokenStream const _previous = Tokeniser::tokenise(corpus);
+    // Replaces the first space after the middle with a digit, merging two tokens.
+    std::size_t const _offset = corpus.find(' ', corpus.size() / 2);
+    std::string _edited = corpus;
+    _edited[_offset] = '1';
+    double const _full = bestTime(repeats, [&]() { Tokeniser::tokenise(_edited); });
+    double const _incremental = bestTime(repeats, [&]() {
+        Tokeniser::retokenise(_previous, _offset, 1, "1");
+    });
+    Console::printl("[BENCH] {}/retokenise | {:.3f} ms | full: {:.3f} ms | {:.1f}x",
+        name, _incremental * 1e3, _full * 1e3, _full / _incremental
+    );
+}
+void benchCache(std::string_view name, std::string const& corpus, std::int32_t repeats) {
+    std::filesystem::path const _directory =
+        std::filesystem::temp_directory_path() / "fennton_skript_bench_cache";
+    Tokeniser::TokenCache const _cache = Tokeniser::TokenCache(_directory);
+    auto const _source = Fennton::Memory::makeStrong<std::string const>(corpus);
+    double const _cold = bestTime(repeats, [&]() {
+        std::filesystem::remove_all(_directory);
+        Tokeniser::tokenise(_source, _cache);
+    });
+    std::size_t const _fileSize = std::filesystem::file_size(_cache.GetPath(corpus));
+    std::size_t _allocations = 0;
+    std::size_t _tokenCount = 0;
+    double const _warm = bestTime(repeats, [&]() {
+        std::size_t const _before = allocationCount.load(std::memory_order_relaxed);
+        _tokenCount = Tokeniser::tokenise(_source, _cache).GetKinds().size();
+        _allocations = allocationCount.load(std::memory_order_relaxed) - _before;
+    });
+    std::filesystem::remove_all(_directory);
+    // Part of a hit spent finding the file, as it is named after the source's hash.
+    std::uint64_t _hashes = 0;
+    double const _hash = bestTime(repeats, [&]() { _hashes ^= Tokeniser::hashSource(corpus); });
+    Console::printl(
+        "[BENCH] {}/cache | warm: {:.3f} ms ({} allocs, {:.2f} ns/token, hash: {:.3f} ms) | "
+        "cold: {:.3f} ms | {:.1f}x | {} KiB | sink {}",
+        name, _warm * 1e3, _allocations, _warm * 1e9 / static_cast<double>(_tokenCount),
+        _hash * 1e3, _cold * 1e3, _cold / _warm, _fileSize / 1024, _hashes % 10
+    );
+}
+void benchEvaluate(std::int32_t repeats) {
+    namespace Skript = Fennton::Skript;
+    constexpr std::size_t _evaluations = 1 << 20;
+
+    std::vector<Skript::Binding> _bindings;
+    for (std::size_t i = 0; i < ruleNames.size(); ++i) {
+        _bindings.push_back({ Skript::globalSymbols().Intern(ruleNames[i]), ruleTypes[i] });
+    }
+    std::vector<std::uint64_t> const _initialValues = {
+        Skript::integerBits(7), Skript::integerBits(20), Skript::integerBits(13),
+        Skript::integerBits(50), Skript::integerBits(200), Skript::integerBits(9),
+        Skript::floatBits(1.5)
+    };
+    std::vector<Skript::Binding> _settings = _bindings;
+    _settings[3].value = _initialValues[3];
+    for (std::string_view const _rule : rules) {
+        Tokeniser::TokenStream const _tokens = Tokeniser::tokenise(_rule);
+        Skript::Arena _arena;
+        Skript::Program _unfolded;
+        Skript::Program _folded;
+        double const _compile = bestTime(repeats, [&]() {
+            _arena.Reset();
+            _folded = Skript::compileExpression(
+                Skript::parseExpression(_tokens, _arena), _settings
+            );
+        });
+        _unfolded = Skript::compileExpression(
+            Skript::parseExpression(_tokens, _arena), _bindings, false
+        );
+        // Folded into the output, so that no evaluation can be left out.
+        std::uint64_t _sink = 0;
+        std::size_t _allocations = 0;
+        // Returns the time taken by each evaluation of the program.
+        auto const _evaluate = [&](Skript::Program const& program) {
+            std::vector<std::uint64_t> _values = _initialValues;
+            double const _seconds = bestTime(repeats, [&]() {
+                std::size_t const _before = allocationCount.load(std::memory_order_relaxed);
+                for (std::size_t i = 0; i < _evaluations; ++i) {
+                    // Changes an input every time, like the entities a rule is evaluated for.
+                    _values[0] = Skript::integerBits(static_cast<std::int64_t>(i & 63));
+                    _sink += program.Run(_values);
+                }
+                _allocations += allocationCount.load(std::memory_order_relaxed) - _before;
+            });
+            return _seconds / _evaluations;
+        };
+        double const _unfoldedTime = _evaluate(_unfolded);
+        double const _foldedTime = _evaluate(_folded);
+        Console::printl(
+            "[BENCH] evaluate/\"{}\" | unfolded: {:.2f} ns/eval ({} instructions) | "
+            "folded: {:.2f} ns/eval ({} instructions) | {} allocs | compile: {:.2f} us | "
+            "sink {}",
+            _rule, _unfoldedTime * 1e9, _unfolded.GetCode().size(), _foldedTime * 1e9,
+            _folded.GetCode().size(), _allocations, _compile * 1e6, _sink % 10
+        );
+    }
+}
+void benchBatch(std::int32_t repeats) {
+    namespace Skript = Fennton::Skript;
+    constexpr std::size_t _entities = 100'000;
+
+    std::vector<Skript::Binding> _bindings;
+    for (std::size_t i = 0; i < ruleNames.size(); ++i) {
+        _bindings.push_back({ Skript::globalSymbols().Intern(ruleNames[i]), ruleTypes[i] });
+    }
+    // The columns of the entities, in the order of the names.
+    Random _random(0x5eed);
+    std::array<std::vector<std::int32_t>, 4> _integers;
+    std::array<std::vector<std::uint8_t>, 2> _bytes;
+    std::vector<double> _speeds(_entities);
+    for (std::size_t i = 0; i < _entities; ++i) {
+        for (std::vector<std::int32_t>& _column : _integers) {
+            _column.push_back(static_cast<std::int32_t>(_random.Below(100)));
+        }
+        for (std::vector<std::uint8_t>& _column : _bytes) {
+            _column.push_back(static_cast<std::uint8_t>(_random.Below(256)));
+        }
+        _speeds[i] = static_cast<double>(_random.Below(4000)) / 1000.0;
+    }
+    std::vector<Skript::Column> const _columns = {
+        Skript::Column(std::span(_integers[0])), Skript::Column(std::span(_integers[1])),
+        Skript::Column(std::span(_integers[2])), Skript::Column(std::span(_integers[3])),
+        Skript::Column(std::span(_bytes[0])), Skript::Column(std::span(_bytes[1])),
+        Skript::Column(std::span(_speeds))
+    };
+    std::vector<std::uint64_t> _results(_entities);
+    for (std::string_view const _rule : rules) {
+        Skript::Arena _arena;
+        Skript::Program const _program = Skript::compileExpression(
+            Skript::parseExpression(Tokeniser::tokenise(_rule), _arena), _bindings
+        );
+        // Folded into the output, so that no evaluation can be left out.
+        std::uint64_t _sink = 0;
+        double const _alone = bestTime(repeats, [&]() {
+            std::array<std::uint64_t, 7> _values;
+            for (std::size_t i = 0; i < _entities; ++i) {
+                for (std::size_t j = 0; j < 4; ++j) {
+                    _values[j] = Skript::integerBits(_integers[j][i]);
+                }
+                _values[4] = _bytes[0][i];
+                _values[5] = _bytes[1][i];
+                _values[6] = Skript::floatBits(_speeds[i]);
+                _results[i] = _program.Run(_values);
+            }
+            _sink += _results.back();
+        });
+        std::vector<std::uint64_t> const _expected = _results;
+        double const _batch = bestTime(repeats, [&]() {
+            _program.RunBatch(_columns, _results);
+            _sink += _results.back();
+        });
+        bool const _same = _results == _expected;
+        Console::printl(
+            "[BENCH] batch/\"{}\" | {} entities | alone: {:.3f} ms | batch: {:.3f} ms | {:.1f}x | "
+            "{} | sink {}",
+            _rule, _entities, _alone * 1e3, _batch * 1e3, _alone / _batch,
+            _same? "same results" : "DIFFERENT RESULTS", _sink % 10
+        );
+    }
+}
+// Returns the string as a JSON string literal.
+static std::string jsonString(std::string_view str) {
+    std::string _json = "\"";
+    for (char c : str) {
+        if (c == '"' || c == '\\') {
+            _json.push_back('\\');
+            _json.push_back(c);
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            _json.append(std::format("\\u{:04x}", static_cast<unsigned char>(c)));
+        } else {
+            _json.push_back(c);
+        }
+    }
+    _json.push_back('"');
+    return _json;
+}
+void writeJson(
+    std::string const& path,
+    Options const& options,
+    std::vector<Result> const& results
+) {
+    std::ofstream _file = std::ofstream(path);
+    if (!_file) {
+        throw std::runtime_error(std::format("Could not open {} for writing.", path));
+    }
+    _file << std::format(
+        "{{\n    \"corpusBytes\": {},\n    \"repeats\": {},\n    \"results\": [\n",
+        options.size, options.repeats
+    );
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        Result const& _result = results[i];
+        _file << "        { \"name\": " << jsonString(_result.name);
+        if (_result.error.empty()) {
+            _file << std::format(
+                ", \"tokens\": {}, \"seconds\": {:.6f}, \"mbPerSecond\": {:.2f}, "
+                "\"tokensPerSecond\": {:.0f}, \"allocationsPerToken\": {:.6f}, "
+                "\"peakKiB\": {} }}",
+                _result.tokens,
+                _result.seconds,
+                megabytesPerSecond(_result.bytes, _result.seconds),
+                static_cast<double>(_result.tokens) / _result.seconds,
+                allocationsPerToken(_result),
+                _result.peakKiB
+            );
+        } else {
+            _file << ", \"error\": " << jsonString(_result.error) << " }";
+        }
+        _file << (i + 1 == results.size()? "\n" : ",\n");
+    }
+    _file << "    ]\n}\n";
+}
+// Returns the value of the field in the line written by writeJson, if it has the field.
+static std::optional<std::string> jsonField(std::string_view line, std::string_view field) {
+    std::string const _key = std::format("\"{}\": ", field);
+    std::size_t _start = line.find(_key);
+    if (_start == std::string_view::npos) {
+        return std::nullopt;
+    }
+    _start += _key.size();
+    if (line[_start] == '"') {
+        // The names have no escapes.
+        std::size_t _end = line.find('"', _start + 1);
+        return std::string(line.substr(_start + 1, _end - _start - 1));
+    }
+    std::size_t _end = line.find_first_of(",}", _start);
+    return std::string(line.substr(_start, _end - _start));
+}
+bool compareBaseline(
+    std::string const& path,
+    double tolerance,
+    std::vector<Result> const& results
+) {
+    std::ifstream _file = std::ifstream(path);
+    if (!_file) {
+        throw std::runtime_error(std::format("Could not open {} for reading.", path));
+    }
+    bool _regressed = false;
+    std::string _line;
+    while (std::getline(_file, _line)) {
+        std::optional<std::string> _name = jsonField(_line, "name");
+        std::optional<std::string> _baseline = jsonField(_line, "mbPerSecond");
+        if (!_name || !_baseline) {
+            continue;
+        }
+        auto _result = std::find_if(results.begin(), results.end(), [&](Result const& r) {
+            return r.name == *_name;
+        });
+        // Results which are gone or failing are not comparable.
+        if (_result == results.end() || !_result->error.empty()) {
+            Console::printl("[BASELINE] {} | not measured", *_name);
+            continue;
+        }
+        double const _before = std::stod(*_baseline);
+        double const _after = megabytesPerSecond(_result->bytes, _result->seconds);
+        bool const _regression = _after < _before * (1.0 - tolerance);
+        Console::printl("[{}] {} | {:.1f} -> {:.1f} MB/s | {:+.1f}%",
+            _regression? "REGRESSION" : "BASELINE",
+            *_name, _before, _after, (_after / _before - 1.0) * 100.0
+        );
+        _regressed = _regressed || _regression;
+    }
+    return _regressed;
+}
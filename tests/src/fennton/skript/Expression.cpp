@@ -1,20 +1,115 @@
 #include <fennton/utils/Console.hpp>
 #include <fennton/utils/Text.hpp>
 #include <fennton/skript/Parser.hpp>
+#include <fennton/skript/Ast.hpp>
+#include <fennton/skript/Arena.hpp>
+#include <fennton/skript/Bytecode.hpp>
+#include <fennton/skript/Value.hpp>
+#include <algorithm>
+#include <array>
+#include <concepts>
+#include <iterator>
 #include <stdexcept>
+#include <string>
+#include <vector>
+#include <format>
+#include <limits>
 #include <cstdint>
 
 namespace Console = Fennton::Console;
 namespace Text = Fennton::Text;
 
+using Fennton::Skript::Tokeniser::tokenise;
+using Fennton::Skript::Tokeniser::TokenStream;
+using Fennton::Skript::Tokeniser::Exception;
+using Fennton::Skript::Tokeniser::SuffixType;
+using Fennton::Skript::Arena;
+using Fennton::Skript::Ast;
+using Fennton::Skript::NodeKind;
+using Fennton::Skript::NodeIndex;
+using Fennton::Skript::noNode;
+using Fennton::Skript::Literal;
+using Fennton::Skript::SyntaxException;
+using Fennton::Skript::CompileException;
+using Fennton::Skript::EvaluationException;
+using Fennton::Skript::parseExpression;
+using Fennton::Skript::compileExpression;
+using Fennton::Skript::Program;
+using Fennton::Skript::Binding;
+using Fennton::Skript::TypeKind;
+using Fennton::Skript::Column;
+using Fennton::Skript::Value;
+using Fennton::Skript::RuntimeKind;
+using Fennton::Skript::globalSymbols;
+using Fennton::Skript::integerBits;
+using Fennton::Skript::floatBits;
+using Fennton::Skript::booleanBits;
+
 static std::int64_t testCount = 0, failCount = 0;
 
+// Names bound in the expressions of the tests, and their values.
+static std::vector<Binding> const bindings = {
+    { globalSymbols().Intern("level"), { TypeKind::Signed, 32 } },
+    { globalSymbols().Intern("health"), { TypeKind::Unsigned, 8 } },
+    { globalSymbols().Intern("speed"), { TypeKind::Float, 64 } },
+    { globalSymbols().Intern("alive"), { TypeKind::Boolean, 1 } },
+    // A setting known at compile time, whose value given to Run is ignored.
+    { globalSymbols().Intern("difficulty"), { TypeKind::Signed, 32 }, integerBits(3) }
+};
+static std::vector<std::uint64_t> const values = {
+    integerBits(7), integerBits(200), floatBits(1.5), booleanBits(true), integerBits(0)
+};
+
 void init();
 void term();
 void runTests();
 // Executes an expression and checks if the string version of the result matches the 
 // expected value.
-void testCase();
+void testCase(std::string const& input, std::string const& expected);
+// Parses an expression and checks if the spelling of its tree, with every operation inside
+// parentheses, matches the expected one, and if its nodes are in post-order.
+void testTree(std::string const& input, std::string const& expected);
+// Compiles an expression with folding and checks if the disassembly of its program matches
+// the expected one.
+void testFold(std::string const& input, std::string const& expected);
+// Evaluates an expression for a batch of entities, with and without folding, and checks if
+// the result of each entity (or the exception) is the same as when running it alone.
+void testBatch(std::string const& input);
+// Checks if values keep their kind and contents, and if programs evaluate values of any kind.
+void testValues();
+// Checks if the arena frees its memory at once and reuses its largest block after a reset.
+void testArena();
+// Checks if appending to a tree without room for the node or literal throws, instead of
+// writing past its arrays.
+void testCapacity();
+// Parses, compiles and runs the expression with the bindings of the tests, and returns the
+// spelling of its result, which must be the same with and without folding.
+std::string run(std::string const& input);
+// Checks if running the expression throws the exception at the expected offset.
+template<std::derived_from<Exception> ExceptionType> void testError(
+    std::string const& input,
+    std::size_t expected
+) {
+    ++testCount;
+
+    std::size_t _actual = Exception::noOffset;
+    std::string _message = "no exception";
+    try {
+        run(input);
+    } catch (ExceptionType const& e) {
+        _actual = e.GetOffset();
+        _message = e.what();
+    } catch (Exception const& e) {
+        _message = std::format("wrong exception: {}", e.what());
+    }
+    if (_actual != expected) {
+        Console::printl("[FAIL] Test {}", testCount - 1);
+        Console::printl("[INPUT] {}", Text::quote(input));
+        Console::printl("[ACTUAL] {} ({})", _actual, _message);
+        Console::printl("[EXPECTED] {}", expected);
+        ++failCount;
+    }
+}
 int main(int argc, char** argv) {
     try {
         init();
@@ -60,7 +155,576 @@ void runTests() {
 
     // - Comparison and arithmetics:
     testCase("2 + 2 != 5", "#true");
+
+    // Trees:
+
+    // - Precedence and associativity:
+    testTree("1 + 2 * 3", "(1 + (2 * 3))");
+    testTree("1 * 2 + 3", "((1 * 2) + 3)");
+    testTree("1 - 2 - 3", "((1 - 2) - 3)");
+    testTree("1 - (2 - 3)", "(1 - (2 - 3))");
+    testTree("8 / 4 % 3 * 2", "(((8 / 4) % 3) * 2)");
+    testTree("1 < 2 == 3 > 4", "((1 < 2) == (3 > 4))");
+    testTree("a + b <= c - d", "((a + b) <= (c - d))");
+    testTree("x != y >= z", "(x != (y >= z))");
+
+    // - Unary minus:
+    testTree("-1 * 2", "((-1) * 2)");
+    testTree("- -x", "(-(-x))");
+    testTree("-(1 + 2)", "(-(1 + 2))");
+
+    // - Literals:
+    testTree("#true == #false", "(#true == #false)");
+    testTree("255u8 + 1i32", "(255u8 + 1i32)");
+    testTree("0.5 * 2f32", "(0.5 * 2.0f32)");
+    testTree("0x10 + 010", "(16 + 8)");
+    testTree("(((7)))", "7");
+
+    // Syntax errors:
+    testError<SyntaxException>("", 0);
+    testError<SyntaxException>("1 +", 3);
+    testError<SyntaxException>("1 + * 2", 4);
+    testError<SyntaxException>("(1 + 2", 6);
+    testError<SyntaxException>("1 2", 2);
+    testError<SyntaxException>("1 + 2)", 5);
+    testError<SyntaxException>("#maybe", 1);
+    testError<SyntaxException>("# true", 2);
+    testError<SyntaxException>("1.2.3", 0);
+    testError<SyntaxException>("256u8", 0);
+    testError<SyntaxException>("1e3", 1);
+    testError<SyntaxException>("5f", 1);
+    testError<SyntaxException>("5u0", 1);
+    testError<SyntaxException>("0x1f.'q", 6);
+    testError<SyntaxException>("18446744073709551616", 0);
+    testError<SyntaxException>("\"a\" + 1", 0);
+    testError<SyntaxException>(std::string(300, '(') + "1" + std::string(300, ')'), 256);
+
+    // Types:
+
+    // - Integers wrap around at their width:
+    testCase("255u8 + 1u8", "0u8");
+    testCase("127i8 + 1i8", "-128i8");
+    testCase("0u8 - 1", "255u8");
+    testCase("-1 * 1u16", "65535u16");
+    testCase("100i8 * 3", "44i8");
+    testCase("-9223372036854775807 - 2", "9223372036854775807");
+    testCase("(-9223372036854775807 - 1) / -1", "-9223372036854775808");
+    testCase("(-9223372036854775807 - 1) % -1", "0");
+
+    // - Values without a suffix take the width of the other operand, in comparisons too, where
+    //   those which do not fit in it are errors (see below):
+    testCase("255u8 == 255", "#true");
+    testCase("0u8 - 1 == 255u8", "#true");
+    testCase("200 < 100u8", "#false");
+    testCase("-1 < 1i8", "#true");
+    testCase("(200 + 55) == 255u8", "#true");
+    testCase("0.1f32 == 0.1", "#true");
+
+    // - Signed and unsigned operations:
+    testCase("-7 / 2", "-3");
+    testCase("-7 % 2", "-1");
+    testCase("200u8 / 3", "66u8");
+    testCase("200u8 > 100u8", "#true");
+    testCase("-1i8 < 1i8", "#true");
+    testCase("1 >= 1", "#true");
+    testCase("2 <= 1", "#false");
+
+    // - Floats:
+    testCase("0.5 * 2", "1.0");
+    testCase("1 / 4.0", "0.25");
+    testCase("-0.5 + 3", "2.5");
+    testCase("7.5 % 2", "1.5");
+    testCase("0.1f32 + 0.2f32", "0.3f32");
+    testCase("1f64 / 8", "0.125f64");
+    testCase("0.1 + 0.2 == 0.3", "#false");
+    testCase("2.5 > 2", "#true");
+
+    // - Booleans:
+    testCase("#true == #true", "#true");
+    testCase("#true != #true", "#false");
+
+    // Bindings:
+    testCase("level", "7i32");
+    testCase("level * 2 + 1", "15i32");
+    testCase("health + 100", "44u8");
+    testCase("health > 100", "#true");
+    testCase("health == 200", "#true");
+    testCase("health < 255", "#true");
+    testCase("speed * 2", "3.0f64");
+    testCase("speed * level", "exception at 0: Mismatched types f64 and i32 for \"*\".");
+    testCase("alive == #true", "#true");
+    testCase("level < 10 == alive", "#true");
+    testCase("-level - level", "-14i32");
+
+    // Compile errors:
+    testError<CompileException>("unknown + 1", 0);
+    testError<CompileException>("health + level", 0);
+    testError<CompileException>("1 + (health + 1.5)", 5);
+    testError<CompileException>("#true + 1", 0);
+    testError<CompileException>("2 * -#true", 4);
+    testError<CompileException>("#true < #false", 0);
+    testError<CompileException>("1u128", 0);
+    testError<CompileException>("1.0f16", 0);
+    testError<CompileException>("255u8 == -1", 9);
+    testError<CompileException>("300 < 100u8", 0);
+    testError<CompileException>("-1 > 1u8", 0);
+    testError<CompileException>("(200 + 56) == 0u8", 1);
+    testError<CompileException>("health == 456", 10);
+    testError<CompileException>("health < 456", 9);
+    testError<CompileException>("level > 2147483648", 8);
+
+    // Evaluation errors:
+    testError<EvaluationException>("1 / 0", 0);
+    testError<EvaluationException>("2 + 5 % (1 - 1)", 4);
+    testError<EvaluationException>("health / (health - 200)", 0);
+
+    // Folding:
+    testFold("20 + 4 * 0", "ret r0\n");
+    testFold("2 + 2 != 5", "ret r0\n");
+    testFold("level + 2 * 3", "add r2, r1, r0\nwrap.s r2, r2, 32\nret r2\n");
+    testFold("level * 1 + 0", "ret r0\n");
+    testFold("(level + 1) * 0", "ret r0\n");
+    testFold("level - level", "ret r0\n");
+    testFold("-(-level)", "ret r0\n");
+    testFold("speed * 1.0 / 1", "ret r0\n");
+    testFold("speed + 0.0", "add.f r2, r1, r0\nret r2\n");
+    testFold("speed * 0.0", "mul.f r2, r1, r0\nret r2\n");
+    testFold("difficulty * 2 + level", "add r2, r0, r1\nwrap.s r2, r2, 32\nret r2\n");
+    testFold("alive == alive", "ret r0\n");
+    testFold("1 / (level - level)", "div.s r2, r0, r1\nwrap.s r2, r2, 32\nret r2\n");
+    testCase("255u8 + 1u8 + health * 0", "0u8");
+    testCase("-(-(127i8 + 1i8))", "-128i8");
+    testCase("0u8 - 1 == 255u8", "#true");
+    testCase("-7 / 2 * 1 + 0", "-3");
+    testCase("(health + 100) * 1", "44u8");
+    testCase("level % 1 + difficulty", "3i32");
+    testCase("difficulty * 2 + level", "13i32");
+    testCase("(0.5 * 3 + speed) * 1", "3.0f64");
+    testCase("-(-speed) - 0.0", "1.5f64");
+    testError<EvaluationException>("(1 / (level - level)) * 0", 1);
+    testError<EvaluationException>("health / (health - 200) * 0", 0);
+
+    // Batches:
+    testBatch("level * 12 + level / 3 - level % 7 > 5");
+    testBatch("-level <= level");
+    testBatch("-(level + 2147483647i32)");
+    testBatch("level != 0 == (level * level >= 1)");
+    testBatch("health + 100 < health * 2u8");
+    testBatch("health == 200");
+    testBatch("health - 1 >= health / 2u8");
+    testBatch("health % 7u8 == 3u8");
+    testBatch("speed * 0.5 + speed * speed < 10.0");
+    testBatch("-speed / 3 <= speed % 2.5");
+    testBatch("speed == speed");
+    testBatch("speed != 1.5");
+    testBatch("speed > -1 == (speed >= 0.0)");
+    testBatch("(0.1f32 * 3f32 + 1f32) * 2");
+    testBatch("alive == level > 0");
+    testBatch("alive != #true");
+    testBatch("difficulty * level");
+    testBatch("100 / level");
+    testBatch("health % (health - health)");
+
+    // Values:
+    testValues();
+
+    // Arena:
+    testArena();
+    testCapacity();
 }
 void testCase(std::string const& input, std::string const& expected) {
+    ++testCount;
+
+    std::string _actual;
+    try {
+        _actual = run(input);
+    } catch (Exception const& e) {
+        _actual = std::format("exception at {}: {}", e.GetOffset(), e.what());
+    }
+    if (_actual != expected) {
+        Console::printl("[FAIL] Test {}", testCount - 1);
+        Console::printl("[INPUT] {}", Text::quote(input));
+        Console::printl("[ACTUAL] {}", _actual);
+        Console::printl("[EXPECTED] {}", expected);
+        ++failCount;
+    }
+}
+void testTree(std::string const& input, std::string const& expected) {
+    ++testCount;
+
+    std::string _actual;
+    try {
+        Arena _arena;
+        Ast const _ast = parseExpression(tokenise(input), _arena);
+        _actual = _ast.GetSpelling();
+        // Operands come before their operations, and the root (the last node) spans the
+        // whole input but its outer parentheses.
+        for (NodeIndex i = 0; i < _ast.Size(); ++i) {
+            bool const _isLeaf = Fennton::Skript::isLeaf(_ast.GetKind(i));
+            bool const _ordered = _isLeaf || (
+                _ast.GetLeft(i) < i && (_ast.GetRight(i) == noNode || _ast.GetRight(i) < i)
+            );
+            if (!_ordered) {
+                _actual += std::format(" | node {} is before its operands", i);
+            }
+        }
+        // Spelling the tree again gives the same tree.
+        std::string const _spelling = _ast.GetSpelling();
+        if (parseExpression(tokenise(_spelling), _arena).GetSpelling() != _spelling) {
+            _actual += " | spelling parses into another tree";
+        }
+    } catch (Exception const& e) {
+        _actual = std::format("exception at {}: {}", e.GetOffset(), e.what());
+    }
+    if (_actual != expected) {
+        Console::printl("[FAIL] Test {}", testCount - 1);
+        Console::printl("[INPUT] {}", Text::quote(input));
+        Console::printl("[ACTUAL] {}", _actual);
+        Console::printl("[EXPECTED] {}", expected);
+        ++failCount;
+    }
+}
+void testArena() {
+    ++testCount;
+
+    Arena _arena;
+    std::string _source = "1";
+    for (int i = 0; i < 5000; ++i) {
+        _source += " + 1";
+    }
+    TokenStream const _tokens = tokenise(_source);
+    std::size_t const _size = parseExpression(_tokens, _arena).Size();
+    std::size_t const _capacity = _arena.GetCapacity();
+    _arena.Reset();
+    std::size_t const _kept = _arena.GetCapacity();
+    // Parsing the same expression again fits in the kept block.
+    parseExpression(_tokens, _arena);
+    std::size_t const _reused = _arena.GetCapacity();
+    Arena const _moved = std::move(_arena);
+    bool const _fail =
+        _size != 10001 || _kept != _capacity || _reused != _kept
+        || _moved.GetCapacity() != _kept || _arena.GetCapacity() != 0
     ;
-}
\ No newline at end of file
+    if (_fail) {
+        Console::printl("[FAIL] Test {}", testCount - 1);
+        Console::printl(
+            "[ACTUAL] {} nodes, capacity {}, kept {}, reused {}, moved {}, left {}",
+            _size, _capacity, _kept, _reused, _moved.GetCapacity(), _arena.GetCapacity()
+        );
+        Console::printl("[EXPECTED] 10001 nodes, all memory kept and reused after a reset");
+        ++failCount;
+    }
+}
+void testCapacity() {
+    ++testCount;
+
+    Arena _arena;
+    Literal const _one = Literal{ 1, SuffixType::None, 0 };
+    // Returns the message of the exception thrown by the function, or an empty string.
+    auto const _error = [](auto const& function) -> std::string {
+        try {
+            function();
+        } catch (std::length_error const& e) {
+            return e.what();
+        }
+        return "";
+    };
+    Ast _full = Ast(_arena, 2, 1);
+    NodeIndex const _left = _full.AppendLiteral(NodeKind::Integer, { 0, 1 }, _one);
+    NodeIndex const _right = _full.AppendBoolean({ 2, 1 }, true);
+    std::string const _actual[] = {
+        _error([&]() { Ast(_arena, 1, 0).AppendLiteral(NodeKind::Integer, { 0, 1 }, _one); }),
+        _error([&]() { Ast().AppendBoolean({ 0, 1 }, false); }),
+        _error([&]() { _full.AppendBinary(NodeKind::Add, { 0, 3 }, _left, _right); }),
+        _error([&]() { Ast(_arena, noNode, 0); })
+    };
+    std::string const _expected[] = {
+        "Tree with room for 0 literals is full.",
+        "Tree with room for 0 nodes is full.",
+        "Tree with room for 2 nodes is full.",
+        "Tree of 4294967295 nodes and 0 literals is too large."
+    };
+    if (!std::equal(std::begin(_actual), std::end(_actual), std::begin(_expected))) {
+        Console::printl("[FAIL] Test {}", testCount - 1);
+        for (std::string const& _message : _actual) {
+            Console::printl("[ACTUAL] {}", _message);
+        }
+        ++failCount;
+    }
+}
+void testFold(std::string const& input, std::string const& expected) {
+    ++testCount;
+
+    std::string _actual;
+    try {
+        Arena _arena;
+        _actual = compileExpression(
+            parseExpression(tokenise(input), _arena), bindings
+        ).Disassemble();
+    } catch (Exception const& e) {
+        _actual = std::format("exception at {}: {}", e.GetOffset(), e.what());
+    }
+    if (_actual != expected) {
+        Console::printl("[FAIL] Test {}", testCount - 1);
+        Console::printl("[INPUT] {}", Text::quote(input));
+        Console::printl("[ACTUAL] {}", Text::quote(_actual));
+        Console::printl("[EXPECTED] {}", Text::quote(expected));
+        ++failCount;
+    }
+}
+std::string run(std::string const& input) {
+    Arena _arena;
+    Ast const _ast = parseExpression(tokenise(input), _arena);
+    Program const _unfolded = compileExpression(_ast, bindings, false);
+    std::string const _expected = Fennton::Skript::spellValue(
+        _unfolded.Run(values), _unfolded.GetResultType()
+    );
+    Program const _folded = compileExpression(_ast, bindings);
+    std::string const _actual = Fennton::Skript::spellValue(
+        _folded.Run(values), _folded.GetResultType()
+    );
+    if (_actual != _expected) {
+        return std::format("{} when folded, {} otherwise", _actual, _expected);
+    }
+    return _actual;
+}
+void testValues() {
+    double const _nan = std::numeric_limits<double>::quiet_NaN();
+    double const _infinity = std::numeric_limits<double>::infinity();
+    int const _object = 0;
+    // Cells of the boxed integers of the checks.
+    Arena _boxes;
+    // Values of each kind, and the values of the bindings of the tests.
+    Value const _float = Value::FromFloat(-0.0);
+    Value const _integer = Value::FromInteger(Value::minInlineInteger);
+    Value const _pointer = Value::FromPointer(&_object);
+    std::vector<Value> _values = {
+        Value::FromInteger(7), Value::FromInteger(200), Value::FromFloat(1.5),
+        Value::FromBoolean(true), Value()
+    };
+    // Returns the result of evaluating the expression with the values, boxing it in an arena
+    // if needed or not at all, or the message of its exception.
+    auto const _evaluate = [&](std::string const& input, bool boxes = true) -> std::string {
+        try {
+            Arena _arena;
+            Program const _program = compileExpression(
+                parseExpression(tokenise(input), _arena), bindings
+            );
+            Value const _result = boxes
+                ? _program.Evaluate(_values, _arena) : _program.Evaluate(_values);
+            switch (_result.GetKind()) {
+                case RuntimeKind::Float: return std::format("float {}", _result.GetFloat());
+                case RuntimeKind::Integer:
+                    return _result.FitsSigned()
+                        ? std::format("integer {}", _result.GetInteger())
+                        : std::format("unsigned {}", _result.GetUnsigned());
+                case RuntimeKind::Boolean: return std::format("Boolean {}", _result.GetBoolean());
+                default: return "other";
+            }
+        } catch (std::exception const& e) {
+            return e.what();
+        }
+    };
+    struct Check {
+        std::string description;
+        bool passed;
+    };
+    std::vector<Check> const _checks = {
+        { "sizeof(Value) == 8", sizeof(Value) == 8 },
+        { "default value is nothing", Value().IsNothing() },
+        { "-0.0 is a float of its own", _float.IsFloat() && _float != Value::FromFloat(0.0) },
+        {
+            "infinities are floats",
+            Value::FromFloat(-_infinity).IsFloat() && Value::FromFloat(_infinity).IsFloat()
+        },
+        {
+            "NaNs of any sign are the same float",
+            Value::FromFloat(_nan).IsFloat() && Value::FromFloat(-_nan).IsFloat()
+                && Value::FromFloat(-_nan) == Value::FromFloat(_nan)
+        },
+        {
+            "integers keep their 48 bits and sign",
+            _integer.IsInteger() && !_integer.IsFloat()
+                && _integer.GetInteger() == Value::minInlineInteger
+                && Value::FromInteger(Value::maxInlineInteger).GetInteger()
+                    == Value::maxInlineInteger
+                && Value::FromInteger(-1).GetInteger() == -1
+        },
+        {
+            "FitsInline is the range of 48 bits",
+            Value::FitsInline(Value::maxInlineInteger)
+                && !Value::FitsInline(Value::maxInlineInteger + 1)
+                && !Value::FitsInline(Value::minInlineInteger - 1)
+        },
+        {
+            "integers out of 48 bits are boxed and equal by value",
+            Value::FromInteger(Value::minInlineInteger - 1, _boxes).GetInteger()
+                    == Value::minInlineInteger - 1
+                && Value::FromInteger(std::numeric_limits<std::int64_t>::max(), _boxes)
+                    .IsInteger()
+                && Value::FromInteger(std::int64_t(1) << 60, _boxes)
+                    == Value::FromInteger(std::int64_t(1) << 60, _boxes)
+                && Value::FromInteger(std::int64_t(1) << 60, _boxes)
+                    != Value::FromInteger(std::int64_t(1) << 61, _boxes)
+                && Value::FromInteger(5, _boxes) == Value::FromInteger(5)
+        },
+        {
+            "unsigned integers above the signed ones are boxed",
+            !Value::FromUnsigned(~std::uint64_t(0), _boxes).FitsSigned()
+                && Value::FromUnsigned(~std::uint64_t(0), _boxes).GetUnsigned()
+                    == ~std::uint64_t(0)
+                && Value::FromUnsigned(~std::uint64_t(0), _boxes)
+                    != Value::FromInteger(-1, _boxes)
+                && Value::FromUnsigned(5, _boxes) == Value::FromInteger(5)
+        },
+        {
+            "Booleans are not integers",
+            Value::FromBoolean(true).GetBoolean() && !Value::FromBoolean(false).GetBoolean()
+                && !Value::FromBoolean(true).IsInteger()
+                && Value::FromBoolean(true) != Value::FromInteger(1)
+        },
+        {
+            "pointers keep their address",
+            _pointer.IsPointer() && _pointer.GetPointer() == &_object
+        },
+        { "evaluate an integer", _evaluate("level * 2 + 2") == "integer 16" },
+        { "evaluate a float", _evaluate("speed * 2") == "float 3" },
+        { "evaluate a Boolean", _evaluate("alive == level > 5") == "Boolean true" },
+        {
+            "results out of 48 bits",
+            _evaluate("140737488355327 + 1") == "integer 140737488355328"
+                && _evaluate("-9223372036854775807 - 1") == "integer -9223372036854775808"
+                && _evaluate("0u64 - 1") == "unsigned 18446744073709551615"
+        },
+        {
+            "results out of 48 bits without an arena",
+            _evaluate("140737488355327", false) == "integer 140737488355327"
+                && _evaluate("140737488355327 + 1", false)
+                    == "Result 140737488355328 does not fit inline in a value."
+                && _evaluate("0u64 - 1", false)
+                    == "Result 18446744073709551615u64 does not fit inline in a value."
+        },
+        {
+            "boxing in an arena reset between evaluations does not grow it",
+            [&]() {
+                Arena _arena;
+                Program const _program = compileExpression(
+                    parseExpression(tokenise("0u64 - 1"), _arena), bindings
+                );
+                _arena.Reset();
+                _program.Evaluate(_values, _arena);
+                std::size_t const _capacity = _arena.GetCapacity();
+                for (int i = 0; i < 10000; ++i) {
+                    _arena.Reset();
+                    if (_program.Evaluate(_values, _arena).GetUnsigned() != ~std::uint64_t(0)) {
+                        return false;
+                    }
+                }
+                return _arena.GetCapacity() == _capacity;
+            }()
+        },
+        {
+            "value of the wrong kind",
+            (_values[2] = Value::FromInteger(1), _evaluate("speed"))
+                == "Expected f64 for binding 2, found an integer."
+        },
+        {
+            "value out of range",
+            (_values[1] = Value::FromInteger(256), _evaluate("health"))
+                == "Value 256 of binding 1 does not fit in u8."
+        },
+        {
+            "boxed value out of range",
+            (_values[1] = Value::FromUnsigned(~std::uint64_t(0), _boxes), _evaluate("health"))
+                == "Value 18446744073709551615 of binding 1 does not fit in u8."
+        },
+        {
+            "negative value of an unsigned type",
+            (_values[1] = Value::FromInteger(-1), _evaluate("health"))
+                == "Value -1 of binding 1 does not fit in u8."
+        }
+    };
+    for (Check const& _check : _checks) {
+        ++testCount;
+        if (!_check.passed) {
+            Console::printl("[FAIL] Test {}", testCount - 1);
+            Console::printl("[INPUT] {}", _check.description);
+            ++failCount;
+        }
+    }
+}
+void testBatch(std::string const& input) {
+    ++testCount;
+
+    // Number of entities, which is not a multiple of the number of lanes of a block, nor even.
+    constexpr std::size_t _size = 1003;
+    // Values of the bindings for each entity, including a zero level and NaN and -0 speeds.
+    static std::array<std::int32_t, _size> _levels;
+    static std::array<std::uint8_t, _size> _healths;
+    static std::array<double, _size> _speeds;
+    static std::array<bool, _size> _alives;
+    for (std::size_t i = 0; i < _size; ++i) {
+        _levels[i] = static_cast<std::int32_t>(i * 37 % 101) - 50;
+        _healths[i] = static_cast<std::uint8_t>(i * 53);
+        _speeds[i] = i % 9 == 0? std::numeric_limits<double>::quiet_NaN()
+            : i % 7 == 0? -0.0 : static_cast<double>(i) * 0.37 - 60.0;
+        _alives[i] = i % 3 != 0;
+    }
+    std::vector<Column> const _columns = {
+        Column(std::span(_levels)), Column(std::span(_healths)), Column(std::span(_speeds)),
+        Column(std::span(_alives)), Column()
+    };
+    std::string _actual = "same results";
+    try {
+        Arena _arena;
+        Ast const _ast = parseExpression(tokenise(input), _arena);
+        for (bool _fold : { false, true }) {
+            Program const _program = compileExpression(_ast, bindings, _fold);
+            std::string _alone = "same results";
+            std::vector<std::uint64_t> _expected(_size);
+            for (std::size_t i = 0; i < _size && _alone == "same results"; ++i) {
+                std::vector<std::uint64_t> const _values = {
+                    integerBits(_levels[i]), _healths[i], floatBits(_speeds[i]),
+                    booleanBits(_alives[i]), integerBits(0)
+                };
+                try {
+                    _expected[i] = _program.Run(_values);
+                } catch (Exception const& e) {
+                    _alone = std::format("exception at {}: {}", e.GetOffset(), e.what());
+                }
+            }
+            std::vector<std::uint64_t> _results(_size);
+            try {
+                _program.RunBatch(_columns, _results);
+                for (std::size_t i = 0; i < _size && _actual == "same results"; ++i) {
+                    if (_results[i] != _expected[i]) {
+                        _actual = std::format(
+                            "entity {} is {} in the batch and {} alone",
+                            i,
+                            Fennton::Skript::spellValue(_results[i], _program.GetResultType()),
+                            Fennton::Skript::spellValue(_expected[i], _program.GetResultType())
+                        );
+                    }
+                }
+            } catch (Exception const& e) {
+                _actual = std::format("exception at {}: {}", e.GetOffset(), e.what());
+            }
+            if (_actual != _alone) {
+                _actual = std::format(
+                    "{} ({}, alone: {})", _actual, _fold? "folded" : "unfolded", _alone
+                );
+                break;
+            }
+            _actual = "same results";
+        }
+    } catch (Exception const& e) {
+        _actual = std::format("exception at {}: {}", e.GetOffset(), e.what());
+    }
+    if (_actual != "same results") {
+        Console::printl("[FAIL] Test {}", testCount - 1);
+        Console::printl("[INPUT] {}", Text::quote(input));
+        Console::printl("[ACTUAL] {}", _actual);
+        Console::printl("[EXPECTED] same results");
+        ++failCount;
+    }
+}
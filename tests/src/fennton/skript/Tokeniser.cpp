@@ -1,6 +1,9 @@
 #include <fennton/utils/Console.hpp>
 #include <fennton/utils/Text.hpp>
 #include <fennton/skript/Parser.hpp>
+#include <fennton/skript/Cache.hpp>
+#include <fennton/skript/Static.hpp>
+#include <fennton/skript/Grammar.hpp>
 #include <algorithm>
 #include <iterator>
 #include <utility>
@@ -10,20 +13,67 @@
 #include <stdexcept>
 #include <initializer_list>
 #include <typeinfo>
+#include <thread>
+#include <format>
+#include <vector>
+#include <span>
+#include <locale>
+#include <filesystem>
+#include <fstream>
 #include <cstdint>
+#include <cstddef>
+#include <cstring>
 
 namespace Console = Fennton::Console;
 namespace Text = Fennton::Text;
+namespace CharClass = Fennton::Skript::Tokeniser::CharClass;
 
 using Fennton::Skript::Tokeniser::Token;
 using Fennton::Skript::Tokeniser::Name;
 using Fennton::Skript::Tokeniser::Number;
+using Fennton::Skript::Tokeniser::String;
 using Fennton::Skript::Tokeniser::Punct;
+using Fennton::Skript::Tokeniser::Operator;
+using Fennton::Skript::Tokeniser::TokenStream;
+using Fennton::Skript::Tokeniser::TokenView;
 using Fennton::Skript::Tokeniser::tokenise;
+using Fennton::Skript::Tokeniser::tokeniseParallel;
+using Fennton::Skript::Tokeniser::retokenise;
 using Fennton::Skript::Tokeniser::Exception;
+using Fennton::Skript::Tokeniser::NumberValue;
+using Fennton::Skript::Tokeniser::SuffixType;
+using Fennton::Skript::Tokeniser::Kind;
+using Fennton::Skript::Tokeniser::ErrorCode;
+using Fennton::Skript::Tokeniser::Diagnostic;
+using Fennton::Skript::Tokeniser::errorMessage;
+using Fennton::Skript::Tokeniser::TokenCache;
+using Fennton::Skript::Tokeniser::NumberPayload;
+using Fennton::Skript::Tokeniser::ValueKind;
+using Fennton::Skript::Tokeniser::Span;
+using Fennton::Skript::Tokeniser::hashSource;
+using Fennton::Skript::Tokeniser::StaticToken;
+using Fennton::Skript::Tokeniser::StaticNumber;
+using Fennton::Skript::Tokeniser::staticTokens;
+using Fennton::Skript::Tokeniser::hasClass;
+using Fennton::Skript::Tokeniser::LexerRule;
+using Fennton::Skript::Tokeniser::generateLexer;
+using Fennton::Skript::Symbol;
+using Fennton::Skript::SymbolTable;
+using Fennton::Skript::LineTable;
+using Fennton::Skript::SourceLocation;
 
 static std::int64_t testCount = 0, failCount = 0;
 
+// Grammars of the lexer generator's tests: the textbook (a|b)*abb, whose minimal automaton has
+// four states (plus the dead one), and rules which tie or overlap.
+constexpr std::array<LexerRule, 1> abbGrammar = {{ { "(a|b)*abb", 1 } }};
+constexpr std::array<LexerRule, 4> overlapGrammar = {{
+    { "if", 1, true },
+    { "[a-z]+", 2 },
+    { "[0-9]+(\\.[0-9]+)?", 3 },
+    { "[^a-z0-9]", 4 }
+}};
+
 void init();
 void term();
 Token number(
@@ -32,6 +82,9 @@ Token number(
     std::vector<std::string_view> const& suffixes,
     std::int32_t base
 );
+Token name(bool hasSpaceAfter, std::string_view spelling);
+Token string(bool hasSpaceAfter, std::string_view value);
+Token punct(bool hasSpaceAfter, Operator op);
 void runTests();
 // Tests the spelling of a token.
 void testSpelling(Token::VariantType&& innerToken, std::string_view expected);
@@ -58,13 +111,146 @@ void testSpelling(Token const& token, ExceptionType const& exception) {
         Console::printl("[EXPECTED] {} | {}" typeid(ExceptionType).name(), exception.what());
     }
 } */
+// Tests if the classification function agrees with the classic C locale's for all characters.
+void testClassification(
+    std::string_view name,
+    bool (*function)(char),
+    bool (*expected)(char)
+);
 // Tests the tokenisation of a string.
 void testTokens(std::string const& input, std::initializer_list<Token> const& expected);
+// Tests if the stream builds the same tokens after the original string is destroyed.
+void testShared(std::string_view input);
+// Tests if the spelling of the stream of the string is the expected one, agrees with the 
+// spellings of its owning tokens and generates the same tokens if retokenised.
+void testStreamSpelling(std::string const& input, std::string_view expected);
+// Tests if tokenising the string in parallel (with tiny chunks, to force splitting) results in 
+// the same stream as tokenising it serially.
+void testParallel(std::string const& input);
+// Tests if retokenising the input with the length characters starting at offset replaced 
+// results in the same stream as tokenising the edited input from scratch.
+void testRetokenise(
+    std::string const& input,
+    std::size_t offset,
+    std::size_t length,
+    std::string_view replacement
+);
+// Tests if the decoded value of the only token of the string, in a stream, is the expected one 
+// and whether it fits in the suffix's type.
+void testValue(std::string const& input, NumberValue const& expected, bool fits);
+// Same, but for the value decoded by an owning number.
+void testValue(Number const& number, NumberValue const& expected, bool fits);
+// Tests if the number's parts and suffixes are the expected ones.
+void testElements(
+    Number const& number,
+    std::vector<std::string_view> const& parts,
+    std::vector<std::string_view> const& suffixes
+);
+// Tests if the spelling of each operator is tokenised as that operator alone, both by tokenise 
+// and by the owning token's parser.
+void testOperators();
+// Tests if the string's tokens, which must all be strings, have the expected values, and if 
+// only the ones with escape sequences were decoded, while the others view the source.
+void testStrings(std::string const& input, std::vector<std::string_view> const& expected);
+// Tests if the owning tokens of the string's tokens are still equal to the stream's after being 
+// relocated by a growing vector.
+void testRelocation(std::string const& input);
+// Tests if interning the same strings on threadCount threads at once, each in a different 
+// order, gives every string a single symbol which spells it.
+void testSymbols(std::size_t threadCount, std::size_t stringCount);
+// Tests if the line table and the stream resolve every offset of the string to the same line 
+// and column as counting the line breaks one by one.
+void testLines(std::string const& input);
+// Tests if tokenising the string fails at the expected offset, serially, in parallel (with tiny 
+// chunks) and when retokenising it after an edit.
+void testErrorOffset(std::string const& input, std::size_t expected);
+// Tests if tokenising the string while collecting the errors gives the expected diagnostics and 
+// token kinds, and if tokenising it without collecting them fails at the first diagnostic.
+void testDiagnostics(
+    std::string const& input,
+    std::vector<Diagnostic> const& expected,
+    std::vector<Kind> const& kinds
+);
+// Tests if the hash of the string is the expected one.
+void testHash(std::string const& input, std::uint64_t expected);
+// Tests if a stream stored in a cache in a fresh directory is loaded back equal to tokenising 
+// the string, and if the file is ignored once corrupted by giving its first number an 
+// unsupported base or by truncating it.
+void testCache(std::string const& input);
+// Tests if the file of a stream stored in a cache is ignored once the numbers or decoded strings 
+// of the tokens at the two indices are swapped, in the payloads of the tokens and (for big 
+// integers and decoded strings) in their table. The string must have no names, so that its 
+// payloads are stored as they are, and the first token must have the first entry of its table.
+void testCacheOrder(std::string const& input, std::size_t first, std::size_t second);
+// Tests if a stream with errors, tokenised while collecting them, is not stored in a cache, so 
+// that tokenising the string with the cache still fails.
+void testCacheErrors(std::string const& input);
+// Gives the first number of the stream an unsupported base in the file of its cache. Returns 
+// false if the stream has no number, and throws if its payload is not found in the file.
+bool corruptFirstBase(TokenStream const& stream, std::filesystem::path const& path);
+// Returns the position of the number's payload in the file of a cache, which is stored with its 
+// bytes at a multiple of 8 and recognised by its first fields and its value. Throws if it is 
+// not found.
+std::size_t findNumber(std::string const& file, NumberPayload const& number);
+// Overwrites the first occurrence of the bytes at a multiple of 8 in the file with others of 
+// the same size. Throws if they are not found.
+void replaceInFile(std::filesystem::path const& path, std::string_view from, std::string_view to);
+// Tests if the static tokeniser, run at runtime, gives the same stream as tokenise, or fails at 
+// the same offset.
+void testStatic(std::string const& input);
+// Tests if the lexer generated from the grammar gives the same tokens as the hand-written 
+// tokeniser, or fails at the same offset with the same message.
+void testLexer(std::string const& input);
+// Tests if the stream of a table built at compile time is the same as tokenise's.
+template<std::size_t TokenCount, std::size_t NumberCount> void testStatic(
+    Fennton::Skript::Tokeniser::StaticTokens<TokenCount, NumberCount> const& table
+) {
+    ++testCount;
+
+    std::string const _input = std::string(table.source);
+    TokenStream const _actual = table.MakeStream();
+    TokenStream const _expected = tokenise(_input);
+    if (_actual != _expected) {
+        Console::printl("[FAIL] Test {}", testCount - 1);
+        Console::printl("[INPUT] {}", Text::quote(_input));
+        Console::printl("[ACTUAL] {} tokens", _actual.Size());
+        Console::printl("[EXPECTED] {} tokens", _expected.Size());
+        ++failCount;
+    }
+}
 // Tests if trying to tokenise the string results in the expected exception.
-/* template<std::derived_from<Exception> ExceptionType>
-void testTokens(std::string const& input, ExceptionType const& exception) {
-    ;
-} */
+template<std::derived_from<Exception> ExceptionType> void testTokens(std::string const& input) {
+    ++testCount;
+    // Checks both the serial and the parallel tokeniser (with tiny chunks).
+    std::initializer_list<std::pair<std::string_view, TokenStream (*)(std::string const&)>> const
+    _modes = {
+        { "serial", [](std::string const& s) { return tokenise(s); } },
+        { "parallel", [](std::string const& s) { return tokeniseParallel(s, 4, 1); } }
+    };
+    bool _fail = false;
+    for (auto const& [_mode, _tokenise] : _modes) {
+        try {
+            _tokenise(input);
+            // Prints the zero-based index of the test.
+            Console::printl("[FAIL] Test {} ({})", testCount - 1, _mode);
+            Console::printl("[INPUT] {}", Text::quote(input));
+            Console::printl("[EXPECTED] {}", typeid(ExceptionType).name());
+            _fail = true;
+        } catch (ExceptionType const&) {
+            ;
+        } catch (std::exception const& e) {
+            // Prints the zero-based index of the test.
+            Console::printl("[FAIL] Test {} ({})", testCount - 1, _mode);
+            Console::printl("[INPUT] {}", Text::quote(input));
+            Console::printl("[EXCEPTION] {} | {}", typeid(e).name(), e.what());
+            Console::printl("[EXPECTED] {}", typeid(ExceptionType).name());
+            _fail = true;
+        }
+    }
+    if (_fail) {
+        ++failCount;
+    }
+}
 int main(int argc, char** argv) {
     int _errorCode;
     try {
@@ -106,9 +292,48 @@ Token number(
 ) {
     return Token(Number(parts, suffixes, base), hasSpaceAfter);
 }
+Token name(bool hasSpaceAfter, std::string_view spelling) {
+    return Token(Name(spelling), hasSpaceAfter);
+}
+Token string(bool hasSpaceAfter, std::string_view value) {
+    return Token(String(value), hasSpaceAfter);
+}
+Token punct(bool hasSpaceAfter, Operator op) {
+    return Token(Punct(op), hasSpaceAfter);
+}
 void runTests() {
     // NOTE: Not testing spellings from tokens with internal states which should never 
     // happen under normal usage.
+    Console::printl("[SECTION] Classification");
+
+    testClassification("isPunct", Fennton::Skript::Tokeniser::isPunct, [](char c) {
+        return c != '_' && std::ispunct(c, std::locale::classic());
+    });
+    testClassification("isSpace", Fennton::Skript::Tokeniser::isSpace, [](char c) {
+        return std::isspace(c, std::locale::classic());
+    });
+    testClassification("isControl", Fennton::Skript::Tokeniser::isControl, [](char c) {
+        return std::iscntrl(c, std::locale::classic());
+    });
+    // The classes of the string literals must agree with the escape sequences of Text::escape.
+    testClassification(
+        "Escaped",
+        [](char c) { return hasClass(c, CharClass::Escaped); },
+        [](char c) { return Text::escapeSimpleChar(c) != '\0'; }
+    );
+    testClassification(
+        "Escape",
+        [](char c) { return hasClass(c, CharClass::Escape); },
+        [](char c) {
+            for (int i = 0; i < 256; ++i) {
+                if (c != '\0' && Text::escapeSimpleChar(static_cast<char>(i)) == c) {
+                    return true;
+                }
+            }
+            return false;
+        }
+    );
+
     Console::printl("[SECTION] Integers - Spelling");
 
     testSpelling(Number( { "0" }, {}, 10), "0");
@@ -121,21 +346,36 @@ void runTests() {
     testSpelling(Number( { "123" }, { "u1" }, 10), "123u1");
     testSpelling(Number( { "123" }, { "a", "b", "c" }, 10), "123a'b'c");
 
-    /* Console::printl("[SECTION] Integers - Tokenisation");
+    Console::printl("[SECTION] Integers - Tokenisation");
 
     testTokens("123", { number(false, { "123" }, {}, 10) });
+    testTokens("0", { number(false, { "0" }, {}, 10) });
     testTokens("010", { number(false, { "10" }, {}, 8) });
+    testTokens("0o10", { number(false, { "10" }, {}, 8) });
     testTokens("0b10", { number(false, { "10" }, {}, 2) });
 
     // Hexadecimal numbers are always lowercase internally.
     testTokens("0xff", { number(false, { "ff" }, {}, 16) });
     testTokens("0xfF", { number(false, { "ff" }, {}, 16) });
     testTokens("0xFf", { number(false, { "ff" }, {}, 16) });
-    testTokens("0xFF", { number(false, { "ff" }, {}, 16) }); */
+    testTokens("0xFF", { number(false, { "ff" }, {}, 16) });
 
-    /*testTokens("123u8", { Number( { "123" }, { "u8" }, 10) });
-    testTokens("123u1", { Number( { "123" }, { "u1" }, 10) });
-    testTokens("123a'b'c", { Number( { "123" }, { "a", "b", "c" }, 10) }); */
+    testTokens("1 2  3", {
+        number(true, { "1" }, {}, 10),
+        number(true, { "2" }, {}, 10),
+        number(false, { "3" }, {}, 10)
+    });
+    testTokens(" 1\t\n2 ", {
+        number(true, { "1" }, {}, 10),
+        number(false, { "2" }, {}, 10)
+    });
+    // Long enough for the digits to be scanned in chunks.
+    testTokens("12345678901234567890123456789012345678901234567890", {
+        number(false, { "12345678901234567890123456789012345678901234567890" }, {}, 10)
+    });
+    testTokens("0x0123456789abcdefABCDEF0123456789", {
+        number(false, { "0123456789abcdefabcdef0123456789" }, {}, 16)
+    });
 
     #if 0
         // - Literals:
@@ -168,12 +408,606 @@ void runTests() {
     testSpelling(Number( { "123", "0" }, { "u1" }, 10), "123.0u1");
     testSpelling(Number( { "123", "661" }, { "a", "b", "c" }, 10), "123.661a'b'c");
 
-    /* Console::printl("[SECTION] Decimals - Tokenisation");
+    Console::printl("[SECTION] Suffixes - Tokenisation");
+
+    testTokens("123u8", { number(false, { "123" }, { "u8" }, 10) });
+    testTokens("123u1", { number(false, { "123" }, { "u1" }, 10) });
+    testTokens("123a'b'c", { number(false, { "123" }, { "a", "b", "c" }, 10) });
+    testTokens("0u8", { number(false, { "0" }, { "u8" }, 10) });
+    testTokens("0b10u8", { number(false, { "10" }, { "u8" }, 2) });
+    testTokens("0xff.'u8", { number(false, { "ff" }, { "u8" }, 16) });
+    testTokens("0xFF.'a'b", { number(false, { "ff" }, { "a", "b" }, 16) });
+
+    Console::printl("[SECTION] Multipart - Tokenisation");
+
+    testTokens("123.912", { number(false, { "123", "912" }, {}, 10) });
+    testTokens("0.5", { number(false, { "0", "5" }, {}, 10) });
+    testTokens("123.912.0.1000", { number(false, { "123", "912", "0", "1000" }, {}, 10) });
+    testTokens("123.912.0u8", { number(false, { "123", "912", "0" }, { "u8" }, 10) });
+    testTokens("123.661a'b'c", { number(false, { "123", "661" }, { "a", "b", "c" }, 10) });
+    testTokens("0x1.fF.'u8", { number(false, { "1", "ff" }, { "u8" }, 16) });
+
+    Console::printl("[SECTION] Comments - Tokenisation");
+
+    testTokens("1 // comment\n2", {
+        number(true, { "1" }, {}, 10),
+        number(false, { "2" }, {}, 10)
+    });
+    // Comments separate tokens like whitespace.
+    testTokens("1/* comment */2", {
+        number(true, { "1" }, {}, 10),
+        number(false, { "2" }, {}, 10)
+    });
+    testTokens("1/**/2", {
+        number(true, { "1" }, {}, 10),
+        number(false, { "2" }, {}, 10)
+    });
+    testTokens("/*/ 1 * 2 / 3 **/4 // 5", { number(false, { "4" }, {}, 10) });
+    testTokens("// Only a comment.", {});
+    testTokens("1 /* trailing */ ", { number(false, { "1" }, {}, 10) });
+    // Long enough for the whitespace and comments to be scanned in chunks.
+    testTokens(
+        "                                                                1\n"
+        "\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t2"
+        " // A single-line comment long enough to span multiple vector chunks.\n"
+        "/* A multi-line comment long enough to span multiple vector chunks, with a * and a /.\n"
+        "   It continues on the next line. */ 3", {
+        number(true, { "1" }, {}, 10),
+        number(true, { "2" }, {}, 10),
+        number(false, { "3" }, {}, 10)
+    });
+    testTokens<Exception>("1 /* unterminated");
+    testTokens<Exception>("1 /* unterminated *");
+
+    Console::printl("[SECTION] Names - Spelling");
+
+    testSpelling(Name("a"), "a");
+    testSpelling(Name("_name1"), "_name1");
+    testSpelling(Name(), "");
+
+    Console::printl("[SECTION] Names - Tokenisation");
+
+    testTokens("a", { name(false, "a") });
+    testTokens("abc _d e1_F", {
+        name(true, "abc"),
+        name(true, "_d"),
+        name(false, "e1_F")
+    });
+    // Long enough for the name to be scanned in chunks.
+    testTokens("a_very_long_name_which_spans_multiple_vector_chunks_0123456789_ABCDEFGHIJ", {
+        name(false, "a_very_long_name_which_spans_multiple_vector_chunks_0123456789_ABCDEFGHIJ")
+    });
+    // Letters after a number are its suffixes, but a name can continue with digits.
+    testTokens("x 123 y1 0xff z", {
+        name(true, "x"),
+        number(true, { "123" }, {}, 10),
+        name(true, "y1"),
+        number(true, { "ff" }, {}, 16),
+        name(false, "z")
+    });
+    testTokens("123abc", { number(false, { "123" }, { "abc" }, 10) });
+    testTokens("a/**/b", { name(true, "a"), name(false, "b") });
+    testTokens<Exception>("a'b");
+
+    Console::printl("[SECTION] Strings - Spelling");
+
+    testSpelling(String("abc"), "\"abc\"");
+    testSpelling(String("a\"b\\c\n\t"), "\"a\\\"b\\\\c\\n\\t\"");
+    testSpelling(String(std::string_view("\0\x01'?", 4)), "\"\\0\\1\\'\\?\"");
+    testSpelling(String(), "\"\"");
+
+    Console::printl("[SECTION] Strings - Tokenisation");
+
+    testTokens("\"\"", { string(false, "") });
+    testTokens("\"a b\" x \"c\\n\\td\"", {
+        string(true, "a b"),
+        name(true, "x"),
+        string(false, "c\n\td")
+    });
+    testTokens("1\"a\"b", {
+        number(false, { "1" }, {}, 10),
+        string(false, "a"),
+        name(false, "b")
+    });
+    // Every escape sequence of Text::escape, and a line break, which needs none.
+    testTokens("\"\\\\\\'\\\"\\?\\a\\b\\f\\n\\r\\t\\v\\0\\6\n\"", {
+        string(false, std::string_view("\\'\"?\a\b\f\n\r\t\v\0\6\n", 14))
+    });
+    // Long enough for the quote and the backslashes to be found in chunks.
+    testTokens("\"A line of dialogue which spans multiple vector chunks, \\\"quoted\\\".\"", {
+        string(false, "A line of dialogue which spans multiple vector chunks, \"quoted\".")
+    });
+    testStrings("\"\" \"abc\" \"a\\tb\" \"\\\"\" \"x\"", { "", "abc", "a\tb", "\"", "x" });
+    testTokens<Exception>("\"abc");
+    testTokens<Exception>("\"abc\\\"");
+    testTokens<Exception>("\"abc\\");
+    testTokens<Exception>("\"a\\qb\"");
+    testTokens<Exception>("\"a\\7\"");
+    testStreamSpelling("\"it's\"\t\"a\nb\"  \"\\?\"", "\"it\\'s\" \"a\\nb\" \"\\?\"");
+    testRelocation("\"a\" \"b\\n\" \"A string too long for the small string buffer.\"");
+
+    Console::printl("[SECTION] Punctuation - Spelling");
+
+    testSpelling(Punct(), "(");
+    testSpelling(Punct(Operator::NotEqual), "!=");
+    testSpelling(Punct(Operator::ShiftLeftAssign), "<<=");
+
+    Console::printl("[SECTION] Punctuation - Tokenisation");
 
-    testTokens("123", { Number( { "123" }, {}, 10) });
-    testTokens("123u8", { Number( { "123" }, { "u8" }, 10) });
-    testTokens("123u1", { Number( { "123" }, { "u1" }, 10) });
-    testTokens("123a'b'c", { Number( { "123" }, { "a", "b", "c" }, 10) }); */
+    testOperators();
+    testTokens("0 < 2 != #false", {
+        number(true, { "0" }, {}, 10),
+        punct(true, Operator::Less),
+        number(true, { "2" }, {}, 10),
+        punct(true, Operator::NotEqual),
+        punct(false, Operator::Hash),
+        name(false, "false")
+    });
+    testTokens("f(a, b[1])", {
+        name(false, "f"),
+        punct(false, Operator::LeftParen),
+        name(false, "a"),
+        punct(true, Operator::Comma),
+        name(false, "b"),
+        punct(false, Operator::LeftBracket),
+        number(false, { "1" }, {}, 10),
+        punct(false, Operator::RightBracket),
+        punct(false, Operator::RightParen)
+    });
+    // Maximal munch, which takes the longest operator even if the rest cannot continue it.
+    testTokens("<<<=>", {
+        punct(false, Operator::ShiftLeft),
+        punct(false, Operator::Compare)
+    });
+    testTokens("....->-!=!", {
+        punct(false, Operator::Ellipsis),
+        punct(false, Operator::Dot),
+        punct(false, Operator::Arrow),
+        punct(false, Operator::Minus),
+        punct(false, Operator::NotEqual),
+        punct(false, Operator::Exclamation)
+    });
+    testTokens("a< =b", {
+        name(false, "a"),
+        punct(true, Operator::Less),
+        punct(false, Operator::Assign),
+        name(false, "b")
+    });
+    // Dots only belong to numbers when followed by a digit or, in base 16, by a quote.
+    testTokens("1..2 a.b 0xff.'u8.", {
+        number(false, { "1" }, {}, 10),
+        punct(false, Operator::Range),
+        number(true, { "2" }, {}, 10),
+        name(false, "a"),
+        punct(false, Operator::Dot),
+        name(true, "b"),
+        number(false, { "ff" }, { "u8" }, 16),
+        punct(false, Operator::Dot)
+    });
+    // Slashes only start comments when followed by another slash or a star.
+    testTokens("a/b/ /c//d", {
+        name(false, "a"),
+        punct(false, Operator::Slash),
+        name(false, "b"),
+        punct(true, Operator::Slash),
+        punct(false, Operator::Slash),
+        name(false, "c")
+    });
+    testTokens<Exception>("a ' b");
+    testTokens<Exception>("a \\ b");
+    testTokens<Exception>("a $ b");
+    testStreamSpelling("a<=b ( 1 ,2 )  - -c", "a<=b ( 1 ,2 ) - -c");
+
+    Console::printl("[SECTION] Symbols");
+
+    testSymbols(1, 1000);
+    testSymbols(4, 10000);
+
+    Console::printl("[SECTION] Shared - Tokenisation");
+
+    testShared("");
+    testShared("  ");
+    testShared("123");
+    testShared("1 2  3");
+    testShared(" 010 0b10\t0xFF\n");
+    testShared("0xff.'u8 123a'b'c 123.912.0u8 0x1.fF.'u8");
+    testShared("a b1 _c 0 d");
+
+    Console::printl("[SECTION] Streams - Spelling");
+
+    testStreamSpelling("", "");
+    testStreamSpelling("1 2  3", "1 2 3");
+    testStreamSpelling(" 010 0o10\t0xFF\n", "010 010 0xff");
+    testStreamSpelling("0xFF.'a'b 0x1.fF.'u8 123a'b'c", "0xff.'a'b 0x1.ff.'u8 123a'b'c");
+    testStreamSpelling("a /* c */ b1 // d\n_c 0", "a b1 _c 0");
+    testStreamSpelling(
+        "12345678901234567890123456789012345678901234567890 0.5 123.912.0u8",
+        "12345678901234567890123456789012345678901234567890 0.5 123.912.0u8"
+    );
+
+    Console::printl("[SECTION] Parallel - Tokenisation");
+
+    testParallel("");
+    testParallel("1\n2\n3\n4\n5\n6\n7\n8\n9\n10");
+    testParallel("1 2\n\n\n3 4\n   \n5 6\n");
+    testParallel("\n\n\n\n1\n\n\n\n");
+    // Line breaks inside comments are not safe to split at.
+    testParallel(
+        "1 // A \" in a comment does not start a string.\n"
+        "2 /* A multi-line comment\n3\n4\n with numbers inside. */ 5\n"
+        "6 /* \" */ 7\n"
+        "8 // /* does not start a comment here.\n"
+        "9\n0x1.fF.'u8\n123.912.0u8\n123a'b'c"
+    );
+    testParallel("a b\nc 1 d\n// e\nf /* g\n */ h\n");
+    testParallel("f(1,\n2) -> [3]\n{\n    a <<= b;\n}\n");
+    // Nor are line breaks inside strings, even after an escaped quote.
+    testParallel("1\n\"a\nb\n\"\n2\n\"\\\"\n3 // \"\n4\n\"/* \\\\\"\n5");
+    testTokens<Exception>("1\n2\n3\n4\n5\n6\n0b2\n8\n9");
+
+    Console::printl("[SECTION] Incremental - Tokenisation");
+
+    testRetokenise("1 2 3", 2, 1, "4");
+    testRetokenise("1 2 3", 2, 1, "");
+    testRetokenise("1 2 3", 0, 5, "");
+    testRetokenise("", 0, 0, "1 2");
+    testRetokenise("1 2 3", 0, 0, "0 ");
+    testRetokenise("1 2 3", 5, 0, " 4");
+    // Merges and splits tokens.
+    testRetokenise("12 34", 2, 1, "");
+    testRetokenise("1234", 2, 0, " ");
+    testRetokenise("1 2 3", 1, 0, "0");
+    testRetokenise("ab cd 1", 2, 1, "");
+    testRetokenise("abcd 1 e", 2, 0, " 3 ");
+    testRetokenise("a 1 b", 2, 1, "c");
+    // Edits the characters looked at after a token's end.
+    testRetokenise("0xff 2", 4, 0, ".'u8");
+    testRetokenise("1 0xff.'u8 2", 6, 4, "");
+    testRetokenise("1.5 2", 1, 2, "");
+    // Opens and closes comments.
+    testRetokenise("1 2 3 4 //*/ 5", 2, 0, "/*");
+    testRetokenise("1 /* 2 3 */ 4 5 6 /**/", 9, 2, "");
+    testRetokenise("1 2 3\n4 5", 2, 0, "//");
+    testRetokenise("1 // 2 3\n4 5", 2, 2, "");
+    // Merges and splits operators.
+    testRetokenise("a < = b", 3, 1, "");
+    testRetokenise("a<=b", 2, 0, " ");
+    testRetokenise("a.b", 1, 0, ".");
+    // Opens and closes strings, and edits their escape sequences.
+    testRetokenise("\"a\" b \"c\"", 3, 3, "");
+    testRetokenise("x \"a b c\" y", 4, 1, "\" \"");
+    testRetokenise("\"a\\nb\" 1", 2, 2, "\\t");
+    // Changes only the space after a token.
+    testRetokenise("1 2 3", 3, 2, "");
+    testRetokenise("1 2   3", 3, 2, "");
+    testRetokenise(
+        "10 20 30 40 50 60 70 80 90 100 110 120 130 140 150 160 170 180 190 200",
+        40, 3, "12345 0x1.fF.'u8 /* edited */"
+    );
+
+    Console::printl("[SECTION] Numbers - Values");
+
+    using Limbs = std::vector<std::uint32_t>;
+    testValue("123", NumberValue(std::uint64_t(123)), true);
+    testValue("0xFF", NumberValue(std::uint64_t(255)), true);
+    testValue("0b1010", NumberValue(std::uint64_t(10)), true);
+    testValue("017", NumberValue(std::uint64_t(15)), true);
+    testValue("123a'b'c", NumberValue(std::uint64_t(123)), true);
+    testValue("18446744073709551615", NumberValue(std::uint64_t(18446744073709551615u)), true);
+    // Too large for 64 bits.
+    testValue("18446744073709551616", NumberValue(Limbs{ 0, 0, 1 }), true);
+    testValue("0x123456789abcdef0123", NumberValue(Limbs{ 0xcdef0123, 0x456789ab, 0x123 }), true);
+    // Long, but with enough leading zeros to fit.
+    testValue(
+        "0b0000000000000000000000000000000000000000000000000000000000000000000101",
+        NumberValue(std::uint64_t(5)), true
+    );
+    // Suffixes request types, which the values might not fit in.
+    testValue("255u8", NumberValue(std::uint64_t(255), SuffixType::Unsigned, 8), true);
+    testValue("256u8", NumberValue(std::uint64_t(256), SuffixType::Unsigned, 8), false);
+    testValue("0xff.'u8", NumberValue(std::uint64_t(255), SuffixType::Unsigned, 8), true);
+    testValue("123u1", NumberValue(std::uint64_t(123), SuffixType::Unsigned, 1), false);
+    testValue("127i8", NumberValue(std::uint64_t(127), SuffixType::Signed, 8), true);
+    testValue("128i8", NumberValue(std::uint64_t(128), SuffixType::Signed, 8), false);
+    testValue(
+        "18446744073709551616u65",
+        NumberValue(Limbs{ 0, 0, 1 }, SuffixType::Unsigned, 65), true
+    );
+    testValue("1u08", NumberValue(std::uint64_t(1)), true);
+    testValue("1f8", NumberValue(std::uint64_t(1)), true);
+    // Floats are correctly rounded.
+    testValue("0.5", NumberValue(0.5), true);
+    testValue("123.912", NumberValue(123.912), true);
+    testValue("9007199254740993.0", NumberValue(9007199254740992.0), true);
+    testValue("0x1.8", NumberValue(1.5), true);
+    testValue("0b1.01", NumberValue(1.25), true);
+    testValue("0o7.4", NumberValue(7.5), true);
+    testValue("0.1f32", NumberValue(0.1, SuffixType::Float, 32), true);
+    testValue("1.5u8", NumberValue(1.5, SuffixType::Unsigned, 8), false);
+    testValue("70000f16", NumberValue(std::uint64_t(70000), SuffixType::Float, 16), false);
+    // Numbers with more than two parts have no single value.
+    testValue("1.2.3", NumberValue(), true);
+    testValue("1.2.3i32", NumberValue(SuffixType::Signed, 32), false);
+    testValue(Number({ "0" }, {}, 10), NumberValue(std::uint64_t(0)), true);
+    testValue(
+        Number({ "ff" }, { "u8" }, 16),
+        NumberValue(std::uint64_t(255), SuffixType::Unsigned, 8), true
+    );
+    testValue(Number({ "10000000000000000" }, {}, 16), NumberValue(Limbs{ 0, 0, 1 }), true);
+    testValue(Number({ "1", "1" }, {}, 2), NumberValue(1.5), true);
+    testParallel("1 18446744073709551616\n2 0x123456789abcdef0123\n3\n0.5 4");
+    testRetokenise(
+        "1 18446744073709551616 2 0x123456789abcdef0123 3", 2, 0, "18446744073709551617 "
+    );
+    // The kept tokens and the reused ones both have decoded strings and big integers, whose
+    // tables are spliced.
+    testRetokenise(
+        "\"a\\n\" 18446744073709551616 x \"b\\t\" 1 \"c\" \"d\\\\\" 99999999999999999999 e", 27, 1,
+        "\"z\\n\" 18446744073709551618"
+    );
+    testRetokenise(
+        "\"a\\n\" 18446744073709551616 x \"b\\t\" 1 99999999999999999999 e", 0, 0,
+        "\"\\r\" 18446744073709551617 "
+    );
+    // The last byte of a character of four bytes continuing a name.
+    testRetokenise("a\xF0\x9D\x90\x80 b", 4, 1, "\x81");
+
+    Console::printl("[SECTION] Numbers - Storage");
+
+    testElements(Number({ "0" }, {}, 10), { "0" }, {});
+    testElements(Number({ "1", "25" }, { "u8", "x" }, 10), { "1", "25" }, { "u8", "x" });
+    testElements(Number({ "ff", "0" }, { "f32" }, 16), { "ff", "0" }, { "f32" });
+    // Longer than the inline buffer.
+    testElements(
+        Number({ "123456789012345678901234567890", "5" }, { "u128", "abcdefghijklmnop" }, 10),
+        { "123456789012345678901234567890", "5" }, { "u128", "abcdefghijklmnop" }
+    );
+    testRelocation("0 123u8 0xFF.'u8 1.2.3a'b x");
+    testRelocation(
+        "123456789012345678901234567890 0x123456789ABCDEF0123456789.'suffix'another 1.5"
+    );
+
+    Console::printl("[SECTION] Numbers - Errors");
+
+    testTokens<Exception>("0b");
+    testTokens<Exception>("0b102");
+    testTokens<Exception>("09");
+    testTokens<Exception>("0xfg");
+    testTokens<Exception>("0xff.'");
+    testTokens<Exception>("123a'");
+    testTokens<Exception>("123a'1");
+
+    Console::printl("[SECTION] Locations");
+
+    testLines("");
+    testLines("\n");
+    testLines("1 2\n3\n\n4 5 6");
+    testLines("a\r\nb\r\n");
+    // Long enough for the line breaks to be found in chunks.
+    testLines(
+        "1 2 3 4 5 6 7 8 9 10 11 12 13 14 15 16 17 18 19 20\n\n\n"
+        "21 22 23 24 25 26 27 28\n29 30 31 32 33 34 35 36 37 38 39 40 41 42 43 44 45\n"
+    );
+    testErrorOffset("0b2", 2);
+    testErrorOffset("1 2\n3 0xfg", 9);
+    testErrorOffset("1\n2\n3\n4 /* 5\n6", 8);
+    testErrorOffset("1 2\n3\n4\n5\n6\n7 123a'1", 19);
+    testErrorOffset("1\n\"a\\q\"", 4);
+    testErrorOffset("1\n2 \"a\nb", 4);
+
+    Console::printl("[SECTION] Recovery");
+
+    testDiagnostics("1 2 3", {}, { Kind::Number, Kind::Number, Kind::Number });
+    testDiagnostics(
+        "1 0b2 3",
+        { { ErrorCode::InvalidDigit, 4, 1 } },
+        { Kind::Number, Kind::Error, Kind::Number }
+    );
+    testDiagnostics(
+        "1 $$ 2 @ 3",
+        { { ErrorCode::UnexpectedCharacter, 2, 1 }, { ErrorCode::UnexpectedCharacter, 7, 1 } },
+        { Kind::Number, Kind::Error, Kind::Number, Kind::Error, Kind::Number }
+    );
+    testDiagnostics("0x 5", { { ErrorCode::ExpectedDigit, 2, 0 } }, { Kind::Error, Kind::Number });
+    testDiagnostics(
+        "1 /* 2",
+        { { ErrorCode::UnterminatedComment, 2, 2 } },
+        { Kind::Number, Kind::Error }
+    );
+    testDiagnostics(
+        "12abc'1 x",
+        { { ErrorCode::ExpectedSuffix, 6, 0 } },
+        { Kind::Error, Kind::Name }
+    );
+    testDiagnostics(
+        "0xfg 1",
+        { { ErrorCode::UnseparatedSuffix, 3, 1 } },
+        { Kind::Error, Kind::Number }
+    );
+    testDiagnostics(
+        "1 +$$- 2",
+        { { ErrorCode::UnexpectedCharacter, 3, 1 } },
+        { Kind::Number, Kind::Punct, Kind::Error, Kind::Punct, Kind::Number }
+    );
+    testDiagnostics(
+        "1 \"a\\qb\\z\" 2",
+        { { ErrorCode::InvalidEscape, 4, 2 } },
+        { Kind::Number, Kind::Error, Kind::Number }
+    );
+    testDiagnostics(
+        "$$\"a\" \"b",
+        { { ErrorCode::UnexpectedCharacter, 0, 1 }, { ErrorCode::UnterminatedString, 6, 1 } },
+        { Kind::Error, Kind::String, Kind::Error }
+    );
+
+    Console::printl("[SECTION] Cache");
+
+    // Reference values of XXH64 with a zero seed.
+    testHash("", 0xEF46DB3751D8E999);
+    testHash("a", 0xD24EC4F1A98C6E5B);
+    testHash("abc", 0x44BC2CF5AD770999);
+    testHash("Nobody inspects the spammish repetition", 0xFBCEA83C8A378BF1);
+    testCache("");
+    testCache("1 2 3");
+    testCache("a /* b */ c\n// d\na 0x1f.'u8 1.5 1.2.3 18446744073709551616 a");
+    testCache("\"a\" \"b\\nc\" x \"\" \"\\\"d\\\"\"");
+    testCache("f(a, b) -> c <<= 1..2");
+    testCache("07 0o7 0b1");
+    testCacheOrder("11 2 333", 0, 2);
+    testCacheOrder("18446744073709551616 1 36893488147419103232", 0, 2);
+    testCacheOrder("\"a\\n\" 1 \"b\\tc\"", 0, 2);
+    testCacheErrors("1 0x 2");
+    testCacheErrors("a \"b");
+
+    Console::printl("[SECTION] Static");
+
+    // Built at compile time.
+    static_assert(staticTokens<"">.tokens.size() == 0);
+    static_assert(staticTokens<"a 1 b">.tokens.size() == 3);
+    static_assert(staticTokens<"a 1 b">.numbers.size() == 1);
+    static_assert(staticTokens<"0x1F.'u8">.numbers[0].base == 16);
+    static_assert(staticTokens<"a <=> b">.tokens[1].op == Operator::Compare);
+    testStatic(staticTokens<"">);
+    testStatic(staticTokens<"a /* b */ c\n// d\nd">);
+    testStatic(staticTokens<"1 0b101 0o17 017 0x1F.'u8 1.5 1.2.3 12u32'x 0.5f32">);
+    testStatic(staticTokens<"18446744073709551616 0x123456789abcdef0123 x">);
+    testStatic(staticTokens<"\"a\" \"b\\nc\" x\"\"\"\\\\\\\"\"">);
+    testStatic(staticTokens<"f(a, b[1]) <<= c->d... 1..2 #x != y">);
+    // Run at runtime, including the errors.
+    testStatic("");
+    testStatic("  a\tb \n c  ");
+    testStatic("1.5e 1..2 0x1f.5 0b1.1.0");
+    testStatic("0b2");
+    testStatic("0x");
+    testStatic("0xfg");
+    testStatic("0xff.'");
+    testStatic("123a'1");
+    testStatic("1 /* 2");
+    testStatic("\"a\\tb\" \"c");
+    testStatic("\"a\\qb\"");
+    testStatic("1 + 2");
+    testStatic("a <=> b $ c");
+
+    Console::printl("[SECTION] Generated lexer");
+
+    // Built at compile time.
+    constexpr auto _abb = generateLexer<abbGrammar>();
+    static_assert(_abb.stateCount == 5);
+    static_assert(_abb.classCount == 3);
+    static_assert(_abb.Match("abb").length == 3);
+    static_assert(_abb.Match("babbabbx").length == 7);
+    static_assert(_abb.Match("abab").length == 0);
+    constexpr auto _overlap = generateLexer<overlapGrammar>();
+    static_assert(_overlap.Match("if").tag == 1);
+    static_assert(_overlap.Match("if(").tag == 1);
+    static_assert(_overlap.Match("ifs").tag == 2);
+    static_assert(_overlap.Match("ifs").length == 3);
+    static_assert(_overlap.Match("1.5.6").length == 3);
+    static_assert(_overlap.Match("1.x").length == 1);
+    static_assert(_overlap.Match("\xFF").tag == 4);
+    // Same tokens and errors as the hand-written tokeniser.
+    testLexer("");
+    testLexer("  a\tb \n c  ");
+    testLexer("a /* b */ c\n// d\nd // e");
+    testLexer("/**/a/***/b/* * / */c/*/ */d");
+    testLexer("1 0b101 0o17 017 0x1F.'u8 1.5 1.2.3 12u32'x 0.5f32 1..2 1.a");
+    testLexer("18446744073709551616 0x123456789abcdef0123 x");
+    testLexer("\"a\" \"b\\nc\" x\"\"\"\\\\\\\"\" \"\\0\\6\\?\"");
+    testLexer("f(a, b[1]) <<= c->d... 1..2 #x != y <=> z");
+    testLexer("a+++b--->c<<<=d>>>=e....f::g:h");
+    testLexer("x/y/=z//w");
+    testLexer("_a1 a_B Zz9");
+    testLexer("0b2");
+    testLexer("0x");
+    testLexer("0xfg");
+    testLexer("0xff.'");
+    testLexer("123a'1");
+    testLexer("1 /* 2");
+    testLexer("1 /* 2 *");
+    testLexer("\"a\\tb\" \"c");
+    testLexer("\"a\\");
+    testLexer("\"a\\qb\"");
+    testLexer("\"a\\7\"");
+    testLexer("a <=> b $ c");
+    testLexer("a @");
+
+    Console::printl("[SECTION] Unicode");
+
+    // Names with characters outside ASCII: "été naïve", "名前" and "a" with a combining acute 
+    // accent, which can continue a name but not start one.
+    testTokens(
+        "\xC3\xA9t\xC3\xA9 na\xC3\xAFve \xE5\x90\x8D\xE5\x89\x8D a\xCC\x81",
+        {
+            name(true, "\xC3\xA9t\xC3\xA9"),
+            name(true, "na\xC3\xAFve"),
+            name(true, "\xE5\x90\x8D\xE5\x89\x8D"),
+            name(false, "a\xCC\x81")
+        }
+    );
+    // Long enough for the name to be skipped in chunks around the characters outside ASCII.
+    testTokens(
+        "abcdefghijklmnopqrstuvwxyz\xC3\xA9" "abcdefghijklmnopqrstuvwxyz\xC3\xA9+",
+        {
+            name(false, "abcdefghijklmnopqrstuvwxyz\xC3\xA9" "abcdefghijklmnopqrstuvwxyz\xC3\xA9"),
+            punct(false, Operator::Plus)
+        }
+    );
+    // Suffixes are names, so they can have the same characters.
+    testTokens("12\xC3\xA9 0b1\xC3\xA9", {
+        number(true, { "12" }, { "\xC3\xA9" }, 10),
+        number(false, { "1" }, { "\xC3\xA9" }, 2)
+    });
+    testStrings("\"\xC3\xA9\" \"\\t\xE2\x82\xAC\"", { "\xC3\xA9", "\t\xE2\x82\xAC" });
+    // Overlong, surrogate, too large, truncated and stray continuation bytes.
+    testErrorOffset("a \xC0\x80", 2);
+    testErrorOffset("a \xED\xA0\x80", 2);
+    testErrorOffset("a \xF4\x90\x80\x80", 2);
+    testErrorOffset("a \"\xE2\x82\"", 3);
+    testErrorOffset("ab\xC3", 2);
+    testErrorOffset("a // \xC3\xA9\x80", 7);
+    testErrorOffset("a /* \xF5 */", 5);
+    // After runs long enough to be validated in chunks.
+    testErrorOffset(std::string(40, 'a') + "\xC3\xA9" + std::string(40, 'b') + "\xFF", 82);
+    testErrorOffset(std::string(31, 'a') + "\xE2\x82\xAC" + std::string(29, 'b') + "\xE2\x82", 63);
+    // Invalid UTF-8 is reported before the tokens' errors.
+    testDiagnostics(
+        "a \xFF b \"\xC3\" c",
+        {
+            { ErrorCode::InvalidUtf8, 2, 1 },
+            { ErrorCode::InvalidUtf8, 7, 1 },
+            { ErrorCode::UnexpectedCharacter, 2, 1 }
+        },
+        { Kind::Name, Kind::Error, Kind::Name, Kind::String, Kind::Name }
+    );
+    testDiagnostics(
+        "\xE2\x82 x",
+        { { ErrorCode::InvalidUtf8, 0, 2 }, { ErrorCode::UnexpectedCharacter, 0, 2 } },
+        { Kind::Error, Kind::Name }
+    );
+    // A combining accent and an emoji, which cannot start names, are unexpected characters.
+    testDiagnostics(
+        "\xCC\x81" "a \xF0\x9F\x98\x80\xF0\x9F\x98\x80 b",
+        { { ErrorCode::UnexpectedCharacter, 0, 2 }, { ErrorCode::UnexpectedCharacter, 4, 4 } },
+        { Kind::Error, Kind::Name, Kind::Error, Kind::Name }
+    );
+    testDiagnostics(
+        "0x1\xC3\xA9 2",
+        { { ErrorCode::UnseparatedSuffix, 3, 2 } },
+        { Kind::Error, Kind::Number }
+    );
+    testParallel("\xC3\xA9\n\xC3\xA9 \"\xE2\x82\xAC\n\"\n// \xC3\xA9\n\xE5\x90\x8D\n");
+    // Edits which split characters, replacing "é" with "è".
+    testRetokenise("a\xC3\xA9 b", 2, 1, "\xA8");
+    testRetokenise("a\xC3\xA9 b", 1, 1, "\xC3");
+    testCache("\xC3\xA9t\xC3\xA9 \"\xE2\x82\xAC\" 1\xC3\xA9");
+    testStatic(staticTokens<"\xC3\xA9t\xC3\xA9 \xE5\x90\x8D a\xCC\x81 1\xC3\xA9">);
+    testStatic("\xC3\xA9t\xC3\xA9 \"\xE2\x82\xAC\" 12\xC3\xA9'x\xCC\x81");
+    testStatic("a \xC0\x80");
+    testStatic("a \xF0\x9F\x98\x80");
+    testStatic("0x1\xC3\xA9");
+    testLexer("\xC3\xA9t\xC3\xA9 na\xC3\xAFve \xE5\x90\x8D a\xCC\x81 x");
+    testLexer("12\xC3\xA9 \"\xE2\x82\xAC\"");
+    testLexer("a \xF0\x9F\x98\x80");
 }
 // Tests spelling for the specific variation of the token.
 static bool checkSpelling(
@@ -199,7 +1033,19 @@ static bool checkSpelling(
     token.HasSpaceAfter(hasSpaceAfter);
     // Constructs the token variation temporarily and gets its spelling.
     std::string _actual = token.GetSpelling();
-    if (_actual != _expected) {
+    // Also spells it after existing text and through an iterator, which must agree.
+    std::string _appended = "#";
+    token.SpellInto(_appended);
+    std::string _written;
+    token.AppendSpelling(std::back_inserter(_written));
+    if (_appended != "#" + _actual || _written != _actual) {
+        Console::printl("[FAIL] Test {}", testCount - 1);
+        Console::printl("[ACTUAL] SpellInto: {} | AppendSpelling: {}",
+            Text::quote(_appended), Text::quote(_written)
+        );
+        return false;
+    }
+    if (_actual != _expected || token.GetSpellingSize() != _expected.size()) {
         // Prints the zero-based test index.
         Console::printl("[FAIL] Test {}", testCount - 1);
         Console::printl("[INPUT] hasSpaceAfter = {}", hasSpaceAfter? "true" : "false");
@@ -223,11 +1069,32 @@ void testSpelling(Token::VariantType&& innerToken, std::string_view expected) {
         ++failCount;
     }
 }
+void testClassification(
+    std::string_view name,
+    bool (*function)(char),
+    bool (*expected)(char)
+) {
+    ++testCount;
+    bool _fail = false;
+    for (int i = 0; i < 256; ++i) {
+        char _c = static_cast<char>(i);
+        if (function(_c) != expected(_c)) {
+            // Prints the zero-based index of the test.
+            Console::printl("[FAIL] Test {} | Character {}", testCount - 1, i);
+            Console::printl("[ACTUAL] {} = {}", name, function(_c)? "true" : "false");
+            Console::printl("[EXPECTED] {} = {}", name, expected(_c)? "true" : "false");
+            _fail = true;
+        }
+    }
+    if (_fail) {
+        ++failCount;
+    }
+}
 void testTokens(std::string const& input, std::initializer_list<Token> const& expected) {
     ++testCount;
 
     try {
-        std::deque<Token> const _actual = tokenise(input);
+        TokenStream const _actual = tokenise(input);
 
         auto _mismatch = std::mismatch(
             _actual.begin(), _actual.end(),
@@ -278,4 +1145,782 @@ void testTokens(std::string const& input, std::initializer_list<Token> const& ex
     } catch (...) {
         ++failCount;
     }
-}
\ No newline at end of file
+}
+void testShared(std::string_view input) {
+    ++testCount;
+
+    try {
+        TokenStream const _expected = tokenise(input);
+        // The temporary string is destroyed before the tokens are built.
+        TokenStream const _actual = tokenise(std::string(input));
+
+        bool _fail = _actual.Size() != _expected.Size();
+        for (std::size_t i = 0; !_fail && i < _expected.Size(); ++i) {
+            _fail =
+                _actual.GetSpan(i) != _expected.GetSpan(i)
+                || _actual[i] != _expected.MakeToken(i)
+            ;
+        }
+        if (_fail) {
+            Console::printl("[FAIL] Test {}", testCount - 1);
+            Console::printl("[INPUT] {}", Text::quote(std::string(input)));
+            Console::printl("[ACTUAL] {} tokens", _actual.Size());
+            Console::printl("[EXPECTED] {} tokens", _expected.Size());
+            ++failCount;
+        }
+    } catch (std::exception const& e) {
+        // Prints the zero-based index of the test.
+        Console::printl("[FAIL] Test {}", testCount - 1);
+        Console::printl("[INPUT] {}", Text::quote(std::string(input)));
+        Console::printl("[EXCEPTION] {} | {}", typeid(e).name(), e.what());
+        ++failCount;
+    }
+}
+void testStreamSpelling(std::string const& input, std::string_view expected) {
+    ++testCount;
+
+    try {
+        TokenStream const _stream = tokenise(input);
+        std::string const _actual = _stream.GetSpelling();
+        // The spellings of the owning tokens, one after the other.
+        std::string _tokens;
+        for (TokenView _view : _stream) {
+            std::string _spelling = _view.MakeToken().GetSpelling();
+            if (_view.GetSpelling() != _spelling || _view.GetSpellingSize() != _spelling.size()) {
+                _tokens.append("<mismatch>");
+            }
+            _tokens.append(_spelling);
+        }
+        std::string _appended = "#";
+        _stream.SpellInto(_appended);
+        TokenStream const _retokenised = tokenise(_actual);
+        bool _fail =
+            _actual != expected
+            || _tokens != _actual
+            || _appended != "#" + _actual
+            || _stream.GetSpellingSize() != _actual.size()
+            || _retokenised.Size() != _stream.Size()
+        ;
+        for (std::size_t i = 0; !_fail && i < _stream.Size(); ++i) {
+            _fail = _retokenised[i] != _stream.MakeToken(i);
+        }
+        if (_fail) {
+            Console::printl("[FAIL] Test {}", testCount - 1);
+            Console::printl("[INPUT] {}", Text::quote(input));
+            Console::printl("[ACTUAL] {} | tokens: {}", Text::quote(_actual), Text::quote(_tokens));
+            Console::printl("[EXPECTED] {}", Text::quote(std::string(expected)));
+            ++failCount;
+        }
+    } catch (std::exception const& e) {
+        // Prints the zero-based index of the test.
+        Console::printl("[FAIL] Test {}", testCount - 1);
+        Console::printl("[INPUT] {}", Text::quote(input));
+        Console::printl("[EXCEPTION] {} | {}", typeid(e).name(), e.what());
+        ++failCount;
+    }
+}
+void testLines(std::string const& input) {
+    ++testCount;
+
+    LineTable const _table = LineTable(input);
+    TokenStream const _stream = tokenise(input);
+    SourceLocation _expected = { 1, 1 };
+    bool _fail = _table.Size() != std::size_t(std::count(input.begin(), input.end(), '\n')) + 1;
+    for (std::size_t i = 0; !_fail && i <= input.size(); ++i) {
+        SourceLocation _actual = _table.Locate(i);
+        if (_actual != _expected || _stream.Locate(i) != _expected) {
+            Console::printl("[FAIL] Test {}", testCount - 1);
+            Console::printl("[INPUT] {} | offset {}", Text::quote(input), i);
+            Console::printl("[ACTUAL] {}:{}", _actual.line, _actual.column);
+            Console::printl("[EXPECTED] {}:{}", _expected.line, _expected.column);
+            _fail = true;
+        }
+        if (i < input.size() && input[i] == '\n') {
+            _expected = { _expected.line + 1, 1 };
+        } else {
+            ++_expected.column;
+        }
+    }
+    if (_fail) {
+        ++failCount;
+    }
+}
+void testErrorOffset(std::string const& input, std::size_t expected) {
+    ++testCount;
+    std::initializer_list<std::pair<std::string_view, TokenStream (*)(std::string const&)>> const
+    _modes = {
+        { "serial", [](std::string const& s) { return tokenise(s); } },
+        { "parallel", [](std::string const& s) { return tokeniseParallel(s, 4, 1); } },
+        // Replaces the whole source but its first character.
+        { "incremental", [](std::string const& s) {
+            return retokenise(tokenise(s.substr(0, 1)), 1, 0, s.substr(1));
+        } }
+    };
+    bool _fail = false;
+    for (auto const& [_mode, _tokenise] : _modes) {
+        std::size_t _actual = Exception::noOffset;
+        try {
+            _tokenise(input);
+        } catch (Exception const& e) {
+            _actual = e.GetOffset();
+        }
+        if (_actual != expected) {
+            Console::printl("[FAIL] Test {} ({})", testCount - 1, _mode);
+            Console::printl("[INPUT] {}", Text::quote(input));
+            Console::printl("[ACTUAL] {}", _actual);
+            Console::printl("[EXPECTED] {}", expected);
+            _fail = true;
+        }
+    }
+    if (_fail) {
+        ++failCount;
+    }
+}
+void testDiagnostics(
+    std::string const& input,
+    std::vector<Diagnostic> const& expected,
+    std::vector<Kind> const& kinds
+) {
+    ++testCount;
+
+    try {
+        std::vector<Diagnostic> _diagnostics;
+        TokenStream const _stream = tokenise(input, _diagnostics);
+        std::span<Kind const> const _kinds = _stream.GetKinds();
+        bool _fail = false;
+        if (_diagnostics != expected) {
+            Console::printl("[FAIL] Test {}", testCount - 1);
+            Console::printl("[INPUT] {}", Text::quote(input));
+            for (Diagnostic const& _diagnostic : _diagnostics) {
+                Console::printl(
+                    "[ACTUAL] {} at {} ({})", errorMessage(_diagnostic.code),
+                    _diagnostic.offset, _diagnostic.length
+                );
+            }
+            for (Diagnostic const& _diagnostic : expected) {
+                Console::printl(
+                    "[EXPECTED] {} at {} ({})", errorMessage(_diagnostic.code),
+                    _diagnostic.offset, _diagnostic.length
+                );
+            }
+            _fail = true;
+        } else if (!std::equal(_kinds.begin(), _kinds.end(), kinds.begin(), kinds.end())) {
+            Console::printl("[FAIL] Test {}", testCount - 1);
+            Console::printl("[INPUT] {}", Text::quote(input));
+            Console::printl("[ACTUAL] {} tokens", _kinds.size());
+            Console::printl("[EXPECTED] {} tokens", kinds.size());
+            _fail = true;
+        } else if (!expected.empty()) {
+            // The throwing tokeniser stops at the first error.
+            std::size_t _offset = Exception::noOffset;
+            try {
+                tokenise(input);
+            } catch (Exception const& e) {
+                _offset = e.GetOffset();
+            }
+            if (_offset != expected.front().offset) {
+                Console::printl("[FAIL] Test {} (throwing)", testCount - 1);
+                Console::printl("[INPUT] {}", Text::quote(input));
+                Console::printl("[ACTUAL] {}", _offset);
+                Console::printl("[EXPECTED] {}", expected.front().offset);
+                _fail = true;
+            }
+        }
+        if (_fail) {
+            ++failCount;
+        }
+    } catch (std::exception const& e) {
+        // Prints the zero-based index of the test.
+        Console::printl("[FAIL] Test {}", testCount - 1);
+        Console::printl("[INPUT] {}", Text::quote(input));
+        Console::printl("[EXCEPTION] {} | {}", typeid(e).name(), e.what());
+        ++failCount;
+    }
+}
+void testHash(std::string const& input, std::uint64_t expected) {
+    ++testCount;
+
+    std::uint64_t const _actual = hashSource(input);
+    if (_actual != expected) {
+        Console::printl("[FAIL] Test {}", testCount - 1);
+        Console::printl("[INPUT] {}", Text::quote(input));
+        Console::printl("[ACTUAL] {:016x}", _actual);
+        Console::printl("[EXPECTED] {:016x}", expected);
+        ++failCount;
+    }
+}
+void testCache(std::string const& input) {
+    ++testCount;
+
+    std::filesystem::path const _directory =
+        std::filesystem::temp_directory_path() / "fennton_skript_cache_test";
+    std::filesystem::remove_all(_directory);
+    try {
+        TokenCache const _cache = TokenCache(_directory);
+        TokenStream const _expected = tokenise(input);
+        auto const _source = Fennton::Memory::makeStrong<std::string const>(input);
+        std::optional<TokenStream> const _missing = _cache.Load(_source);
+        // A cold cache tokenises and stores, then a warm one loads.
+        TokenStream const _cold = tokenise(_source, _cache);
+        std::optional<TokenStream> const _warm = _cache.Load(_source);
+        bool _fail = false;
+        if (_missing || _cold != _expected || !_warm || *_warm != _expected) {
+            Console::printl("[FAIL] Test {}", testCount - 1);
+            Console::printl("[INPUT] {}", Text::quote(input));
+            Console::printl(
+                "[ACTUAL] missing: {}, cold: {}, warm: {}", !_missing, _cold == _expected,
+                _warm && *_warm == _expected
+            );
+            _fail = true;
+        } else {
+            std::filesystem::path const _path = _cache.GetPath(input);
+            if (corruptFirstBase(_expected, _path) && _cache.Load(_source)) {
+                Console::printl("[FAIL] Test {} (unsupported base)", testCount - 1);
+                Console::printl("[INPUT] {}", Text::quote(input));
+                _fail = true;
+            }
+            // Truncates the file, which must then be ignored.
+            std::filesystem::resize_file(_path, std::filesystem::file_size(_path) - 8);
+            if (_cache.Load(_source)) {
+                Console::printl("[FAIL] Test {} (truncated)", testCount - 1);
+                Console::printl("[INPUT] {}", Text::quote(input));
+                _fail = true;
+            }
+        }
+        if (_fail) {
+            ++failCount;
+        }
+    } catch (std::exception const& e) {
+        // Prints the zero-based index of the test.
+        Console::printl("[FAIL] Test {}", testCount - 1);
+        Console::printl("[INPUT] {}", Text::quote(input));
+        Console::printl("[EXCEPTION] {} | {}", typeid(e).name(), e.what());
+        ++failCount;
+    }
+    std::filesystem::remove_all(_directory);
+}
+void testCacheOrder(std::string const& input, std::size_t first, std::size_t second) {
+    ++testCount;
+
+    std::filesystem::path const _directory =
+        std::filesystem::temp_directory_path() / "fennton_skript_cache_test";
+    std::filesystem::remove_all(_directory);
+    try {
+        TokenCache const _cache = TokenCache(_directory);
+        auto const _source = Fennton::Memory::makeStrong<std::string const>(input);
+        TokenStream const _stream = tokenise(_source);
+        std::filesystem::path const _path = _cache.GetPath(input);
+        // Returns the bytes of the value.
+        auto const _bytes = []<typename T>(T const& value) {
+            return std::string(reinterpret_cast<char const*>(&value), sizeof(T));
+        };
+        std::string _payloads;
+        std::string _swappedPayloads;
+        for (std::size_t i = 0; i < _stream.Size(); ++i) {
+            std::size_t const _index = i == first? second : i == second? first : i;
+            _payloads += _bytes(_stream.GetPayload(i));
+            _swappedPayloads += _bytes(_stream.GetPayload(_index));
+        }
+        bool _fail = false;
+        _cache.Store(_stream);
+        replaceInFile(_path, _payloads, _swappedPayloads);
+        if (_cache.Load(_source)) {
+            Console::printl("[FAIL] Test {} (payloads swapped)", testCount - 1);
+            Console::printl("[INPUT] {}", Text::quote(input));
+            _fail = true;
+        }
+        bool const _isNumber = _stream.GetKinds()[first] == Kind::Number;
+        // Only big integers have an order in their table, through the offsets of their limbs.
+        if (!_isNumber || _stream.GetNumber(first).valueKind == ValueKind::BigInteger) {
+            _cache.Store(_stream);
+            if (_isNumber) {
+                // Swaps the offsets (and counts) of the limbs of the two big integers.
+                NumberPayload const& _first = _stream.GetNumber(first);
+                NumberPayload const& _second = _stream.GetNumber(second);
+                std::string _file;
+                {
+                    std::ifstream _in = std::ifstream(_path, std::ios::binary);
+                    _file.assign(
+                        std::istreambuf_iterator<char>(_in), std::istreambuf_iterator<char>()
+                    );
+                }
+                constexpr std::size_t _valueOffset = offsetof(NumberPayload, value);
+                std::size_t const _firstPosition = findNumber(_file, _first) + _valueOffset;
+                std::size_t const _secondPosition = findNumber(_file, _second) + _valueOffset;
+                std::memcpy(_file.data() + _firstPosition, &_second.value, 8);
+                std::memcpy(_file.data() + _secondPosition, &_first.value, 8);
+                std::ofstream _out = std::ofstream(_path, std::ios::binary | std::ios::trunc);
+                _out.write(_file.data(), static_cast<std::streamsize>(_file.size()));
+            } else {
+                // Swaps the spans of the two decoded strings in the arena.
+                std::uint32_t const _firstLength =
+                    static_cast<std::uint32_t>(_stream.GetString(first).size());
+                std::uint32_t const _secondLength =
+                    static_cast<std::uint32_t>(_stream.GetString(second).size());
+                Span const _firstSpan = Span{ 0, _firstLength };
+                Span const _secondSpan = Span{ _firstLength, _secondLength };
+                replaceInFile(
+                    _path, _bytes(_firstSpan) + _bytes(_secondSpan),
+                    _bytes(_secondSpan) + _bytes(_firstSpan)
+                );
+            }
+            if (_cache.Load(_source)) {
+                Console::printl("[FAIL] Test {} (table swapped)", testCount - 1);
+                Console::printl("[INPUT] {}", Text::quote(input));
+                _fail = true;
+            }
+        }
+        if (_fail) {
+            ++failCount;
+        }
+    } catch (std::exception const& e) {
+        // Prints the zero-based index of the test.
+        Console::printl("[FAIL] Test {}", testCount - 1);
+        Console::printl("[INPUT] {}", Text::quote(input));
+        Console::printl("[EXCEPTION] {} | {}", typeid(e).name(), e.what());
+        ++failCount;
+    }
+    std::filesystem::remove_all(_directory);
+}
+void testCacheErrors(std::string const& input) {
+    ++testCount;
+
+    std::filesystem::path const _directory =
+        std::filesystem::temp_directory_path() / "fennton_skript_cache_test";
+    std::filesystem::remove_all(_directory);
+    try {
+        TokenCache const _cache = TokenCache(_directory);
+        auto const _source = Fennton::Memory::makeStrong<std::string const>(input);
+        std::vector<Diagnostic> _diagnostics;
+        bool const _stored = _cache.Store(tokenise(_source, _diagnostics));
+        bool _threw = false;
+        try {
+            tokenise(_source, _cache);
+        } catch (Exception const&) {
+            _threw = true;
+        }
+        if (_stored || !_threw) {
+            Console::printl("[FAIL] Test {}", testCount - 1);
+            Console::printl("[INPUT] {}", Text::quote(input));
+            Console::printl("[ACTUAL] stored: {}, threw: {}", _stored, _threw);
+            ++failCount;
+        }
+    } catch (std::exception const& e) {
+        // Prints the zero-based index of the test.
+        Console::printl("[FAIL] Test {}", testCount - 1);
+        Console::printl("[INPUT] {}", Text::quote(input));
+        Console::printl("[EXCEPTION] {} | {}", typeid(e).name(), e.what());
+        ++failCount;
+    }
+    std::filesystem::remove_all(_directory);
+}
+bool corruptFirstBase(TokenStream const& stream, std::filesystem::path const& path) {
+    std::span<Kind const> const _kinds = stream.GetKinds();
+    std::size_t const _index = std::find(_kinds.begin(), _kinds.end(), Kind::Number)
+        - _kinds.begin();
+    if (_index == _kinds.size()) {
+        return false;
+    }
+    std::string _file;
+    {
+        std::ifstream _in = std::ifstream(path, std::ios::binary);
+        _file.assign(std::istreambuf_iterator<char>(_in), std::istreambuf_iterator<char>());
+    }
+    std::size_t const _position = findNumber(_file, stream.GetNumber(_index));
+    _file[_position + offsetof(NumberPayload, base)] = 3;
+    std::ofstream _out = std::ofstream(path, std::ios::binary | std::ios::trunc);
+    _out.write(_file.data(), static_cast<std::streamsize>(_file.size()));
+    return true;
+}
+std::size_t findNumber(std::string const& file, NumberPayload const& number) {
+    char const _fields[4] = {
+        static_cast<char>(number.bodyOffset), static_cast<char>(number.base),
+        static_cast<char>(number.flags), static_cast<char>(number.valueKind)
+    };
+    constexpr std::size_t _valueOffset = offsetof(NumberPayload, value);
+    for (std::size_t i = 0; i + sizeof(NumberPayload) <= file.size(); i += 8) {
+        if (
+            std::memcmp(file.data() + i, _fields, sizeof(_fields)) == 0
+            && std::memcmp(file.data() + i + _valueOffset, &number.value, 8) == 0
+        ) {
+            return i;
+        }
+    }
+    throw std::runtime_error("findNumber: Payload of the number not found.");
+}
+void replaceInFile(std::filesystem::path const& path, std::string_view from, std::string_view to) {
+    std::string _file;
+    {
+        std::ifstream _in = std::ifstream(path, std::ios::binary);
+        _file.assign(std::istreambuf_iterator<char>(_in), std::istreambuf_iterator<char>());
+    }
+    for (std::size_t i = 0; i + from.size() <= _file.size(); i += 8) {
+        if (std::string_view(_file).substr(i, from.size()) == from) {
+            _file.replace(i, to.size(), to);
+            std::ofstream _out = std::ofstream(path, std::ios::binary | std::ios::trunc);
+            _out.write(_file.data(), static_cast<std::streamsize>(_file.size()));
+            return;
+        }
+    }
+    throw std::runtime_error("replaceInFile: Bytes not found.");
+}
+void testStatic(std::string const& input) {
+    ++testCount;
+
+    // Collects the tables, as the static tokeniser's compile-time factory would.
+    struct Collector {
+        std::vector<StaticToken> tokens;
+        std::vector<StaticNumber> numbers;
+
+        void Add(Kind kind, Fennton::Skript::Tokeniser::Span span) {
+            tokens.push_back(StaticToken{ kind, span, false });
+        }
+        void AddNumber(Fennton::Skript::Tokeniser::Span span, StaticNumber const& number) {
+            numbers.push_back(number);
+            Add(Kind::Number, span);
+        }
+        void AddPunct(Fennton::Skript::Tokeniser::Span span, Operator op) {
+            tokens.push_back(StaticToken{ Kind::Punct, span, false, op });
+        }
+        void SpaceAfter() {
+            tokens.back().hasSpaceAfter = true;
+        }
+    };
+    std::size_t _expectedOffset = Exception::noOffset;
+    std::size_t _actualOffset = Exception::noOffset;
+    std::optional<TokenStream> _expected;
+    std::optional<TokenStream> _actual;
+    try {
+        _expected = tokenise(input);
+    } catch (Exception const& e) {
+        _expectedOffset = e.GetOffset();
+    }
+    try {
+        Collector _collector;
+        Fennton::Skript::Tokeniser::scanStatic(input, _collector);
+        _actual = Fennton::Skript::Tokeniser::makeStaticStream(
+            input, _collector.tokens, _collector.numbers
+        );
+    } catch (Exception const& e) {
+        _actualOffset = e.GetOffset();
+    }
+    if (_actualOffset != _expectedOffset || _actual.has_value() != _expected.has_value()) {
+        Console::printl("[FAIL] Test {}", testCount - 1);
+        Console::printl("[INPUT] {}", Text::quote(input));
+        Console::printl("[ACTUAL] Error at {}", _actualOffset);
+        Console::printl("[EXPECTED] Error at {}", _expectedOffset);
+        ++failCount;
+    } else if (_actual && *_actual != *_expected) {
+        Console::printl("[FAIL] Test {}", testCount - 1);
+        Console::printl("[INPUT] {}", Text::quote(input));
+        Console::printl("[ACTUAL] {} tokens", _actual->Size());
+        Console::printl("[EXPECTED] {} tokens", _expected->Size());
+        ++failCount;
+    }
+}
+void testLexer(std::string const& input) {
+    ++testCount;
+
+    std::string_view const _input = input;
+    using Iterator = std::string_view::const_iterator;
+    // Tokenises the input with the functions, returning the error's offset and message.
+    auto _lex = [&](
+        Iterator (*space)(Iterator, Iterator),
+        Fennton::Skript::Tokeniser::TokenResult (*next)(Iterator, Iterator),
+        std::vector<Token>& tokens
+    )->std::pair<std::size_t, std::string> {
+        try {
+            Iterator _it = space(_input.begin(), _input.end());
+            while (_it != _input.end()) {
+                auto [_end, _token] = next(_it, _input.end());
+                tokens.push_back(std::move(_token));
+                _it = space(_end, _input.end());
+            }
+        } catch (Exception& e) {
+            e.Locate(_input);
+            return { e.GetOffset(), e.what() };
+        }
+        return { Exception::noOffset, "" };
+    };
+    std::vector<Token> _actual;
+    std::vector<Token> _expected;
+    auto const _actualError = _lex(
+        Fennton::Skript::Tokeniser::lexSpace, Fennton::Skript::Tokeniser::lexNext, _actual
+    );
+    auto const _expectedError = _lex(
+        Fennton::Skript::Tokeniser::consumeSpace,
+        Fennton::Skript::Tokeniser::tokeniseNext,
+        _expected
+    );
+    if (_actualError != _expectedError) {
+        Console::printl("[FAIL] Test {}", testCount - 1);
+        Console::printl("[INPUT] {}", Text::quote(input));
+        Console::printl("[ACTUAL] Error at {} | {}", _actualError.first, _actualError.second);
+        Console::printl("[EXPECTED] Error at {} | {}", _expectedError.first, _expectedError.second);
+        ++failCount;
+    } else if (_actual != _expected) {
+        auto const _mismatch = std::mismatch(
+            _actual.begin(), _actual.end(), _expected.begin(), _expected.end()
+        );
+        Console::printl("[FAIL] Test {} | Token {}",
+            testCount - 1, std::distance(_actual.begin(), _mismatch.first)
+        );
+        Console::printl("[INPUT] {}", Text::quote(input));
+        Console::printl("[ACTUAL] {}",
+            _mismatch.first != _actual.end()? _mismatch.first->GetSpelling() : "end"
+        );
+        Console::printl("[EXPECTED] {}",
+            _mismatch.second != _expected.end()? _mismatch.second->GetSpelling() : "end"
+        );
+        ++failCount;
+    }
+}
+void testElements(
+    Number const& number,
+    std::vector<std::string_view> const& parts,
+    std::vector<std::string_view> const& suffixes
+) {
+    ++testCount;
+
+    std::vector<std::string_view> _parts;
+    for (std::size_t i = 0; i < number.GetPartCount(); ++i) {
+        _parts.push_back(number.GetPart(i));
+    }
+    std::vector<std::string_view> _suffixes;
+    for (std::size_t i = 0; i < number.GetSuffixCount(); ++i) {
+        _suffixes.push_back(number.GetSuffix(i));
+    }
+    if (_parts != parts || _suffixes != suffixes) {
+        Console::printl("[FAIL] Test {}", testCount - 1);
+        Console::printl("[INPUT] {}", Text::quote(number.GetSpelling()));
+        Console::printl("[ACTUAL] {} parts, {} suffixes", _parts.size(), _suffixes.size());
+        Console::printl("[EXPECTED] {} parts, {} suffixes", parts.size(), suffixes.size());
+        ++failCount;
+    }
+}
+void testOperators() {
+    ++testCount;
+
+    bool _fail = false;
+    for (std::size_t i = 0; i < Fennton::Skript::Tokeniser::operatorCount; ++i) {
+        Operator const _op = static_cast<Operator>(i);
+        std::string_view const _spelling = Fennton::Skript::Tokeniser::spellingOf(_op);
+        try {
+            TokenStream const _stream = tokenise(_spelling);
+            Token const _token = std::move(
+                Fennton::Skript::Tokeniser::tokeniseNext(_spelling.begin(), _spelling.end()).second
+            );
+            if (
+                _stream.Size() != 1
+                || _stream.GetKind(0) != Kind::Punct
+                || _stream.GetOperator(0) != _op
+                || _token != punct(false, _op)
+            ) {
+                Console::printl("[FAIL] Test {} | Operator {}", testCount - 1, i);
+                Console::printl("[INPUT] {}", Text::quote(std::string(_spelling)));
+                _fail = true;
+            }
+        } catch (std::exception const& e) {
+            Console::printl("[FAIL] Test {} | Operator {}", testCount - 1, i);
+            Console::printl("[INPUT] {}", Text::quote(std::string(_spelling)));
+            Console::printl("[EXCEPTION] {} | {}", typeid(e).name(), e.what());
+            _fail = true;
+        }
+    }
+    if (_fail) {
+        ++failCount;
+    }
+}
+void testStrings(std::string const& input, std::vector<std::string_view> const& expected) {
+    ++testCount;
+
+    try {
+        TokenStream const _stream = tokenise(input);
+        std::string_view const _source = _stream.GetSource();
+        bool _fail = _stream.Size() != expected.size();
+        for (std::size_t i = 0; !_fail && i < expected.size(); ++i) {
+            std::string_view const _value = _stream.GetString(i);
+            // Strings without escape sequences view the source between their quotes.
+            bool const _isView =
+                _value.data() == _source.data() + _stream.GetSpan(i).offset + 1;
+            bool const _hasEscapes = _stream.GetText(i).find('\\') != std::string_view::npos;
+            _fail =
+                _stream.GetKind(i) != Kind::String
+                || _value != expected[i]
+                || _isView == _hasEscapes
+                || (_stream.GetPayload(i) == TokenStream::noPayload) == _hasEscapes;
+        }
+        if (_fail) {
+            Console::printl("[FAIL] Test {}", testCount - 1);
+            Console::printl("[INPUT] {}", Text::quote(input));
+            ++failCount;
+        }
+    } catch (std::exception const& e) {
+        // Prints the zero-based index of the test.
+        Console::printl("[FAIL] Test {}", testCount - 1);
+        Console::printl("[INPUT] {}", Text::quote(input));
+        Console::printl("[EXCEPTION] {} | {}", typeid(e).name(), e.what());
+        ++failCount;
+    }
+}
+void testRelocation(std::string const& input) {
+    ++testCount;
+
+    try {
+        TokenStream const _stream = tokenise(input);
+        std::vector<Token> _tokens;
+        bool _fail = false;
+        for (TokenView _view : _stream) {
+            Token _token = _view.MakeToken();
+            // Reallocates the vector each time, moving all the previous tokens.
+            _tokens.shrink_to_fit();
+            _tokens.push_back(std::move(_token));
+        }
+        for (std::size_t i = 0; i < _tokens.size(); ++i) {
+            if (_stream[i] != _tokens[i] || _stream[i].GetSpelling() != _tokens[i].GetSpelling()) {
+                _fail = true;
+            }
+        }
+        if (_fail) {
+            Console::printl("[FAIL] Test {}", testCount - 1);
+            Console::printl("[INPUT] {}", Text::quote(input));
+            ++failCount;
+        }
+    } catch (std::exception const& e) {
+        // Prints the zero-based index of the test.
+        Console::printl("[FAIL] Test {}", testCount - 1);
+        Console::printl("[INPUT] {}", Text::quote(input));
+        Console::printl("[EXCEPTION] {} | {}", typeid(e).name(), e.what());
+        ++failCount;
+    }
+}
+void testParallel(std::string const& input) {
+    ++testCount;
+
+    try {
+        TokenStream const _expected = tokenise(input);
+        TokenStream const _actual = tokeniseParallel(input, 4, 1);
+        if (_actual != _expected) {
+            Console::printl("[FAIL] Test {}", testCount - 1);
+            Console::printl("[INPUT] {}", Text::quote(input));
+            Console::printl("[ACTUAL] {} tokens", _actual.Size());
+            Console::printl("[EXPECTED] {} tokens", _expected.Size());
+            ++failCount;
+        }
+    } catch (std::exception const& e) {
+        // Prints the zero-based index of the test.
+        Console::printl("[FAIL] Test {}", testCount - 1);
+        Console::printl("[INPUT] {}", Text::quote(input));
+        Console::printl("[EXCEPTION] {} | {}", typeid(e).name(), e.what());
+        ++failCount;
+    }
+}
+void testRetokenise(
+    std::string const& input,
+    std::size_t offset,
+    std::size_t length,
+    std::string_view replacement
+) {
+    ++testCount;
+
+    std::string _edited = input;
+    _edited.replace(offset, length, replacement);
+    try {
+        TokenStream const _expected = tokenise(_edited);
+        TokenStream const _actual = retokenise(tokenise(input), offset, length, replacement);
+        if (_actual != _expected) {
+            Console::printl("[FAIL] Test {}", testCount - 1);
+            Console::printl("[INPUT] {} -> {}", Text::quote(input), Text::quote(_edited));
+            Console::printl("[ACTUAL] {} tokens", _actual.Size());
+            Console::printl("[EXPECTED] {} tokens", _expected.Size());
+            ++failCount;
+        }
+    } catch (std::exception const& e) {
+        // Prints the zero-based index of the test.
+        Console::printl("[FAIL] Test {}", testCount - 1);
+        Console::printl("[INPUT] {} -> {}", Text::quote(input), Text::quote(_edited));
+        Console::printl("[EXCEPTION] {} | {}", typeid(e).name(), e.what());
+        ++failCount;
+    }
+}
+void testSymbols(std::size_t threadCount, std::size_t stringCount) {
+    ++testCount;
+
+    SymbolTable _table;
+    std::vector<std::string> _strings;
+    for (std::size_t i = 0; i < stringCount; ++i) {
+        _strings.push_back(std::format("symbol{}", i));
+    }
+    // The symbols each thread got for each string, by the index of the string.
+    std::vector<std::vector<Symbol>> _symbols(threadCount, std::vector<Symbol>(stringCount));
+    {
+        std::vector<std::jthread> _threads;
+        for (std::size_t t = 0; t < threadCount; ++t) {
+            _threads.emplace_back([&, t]() {
+                // Odd threads go backwards, so that they race with the others.
+                for (std::size_t i = 0; i < stringCount; ++i) {
+                    std::size_t _index = t % 2 == 0? i : stringCount - 1 - i;
+                    _symbols[t][_index] = _table.Intern(_strings[_index]);
+                }
+            });
+        }
+    }
+    bool _fail = _table.Size() != stringCount + 1 || _table.Intern("") != Symbol();
+    for (std::size_t i = 0; !_fail && i < stringCount; ++i) {
+        Symbol const _symbol = _symbols[0][i];
+        for (std::size_t t = 1; t < threadCount; ++t) {
+            _fail = _fail || _symbols[t][i] != _symbol;
+        }
+        _fail =
+            _fail
+            || _table.GetSpelling(_symbol) != _strings[i]
+            || _table.Find(_strings[i]) != _symbol
+        ;
+    }
+    _fail = _fail || _table.Find("missing").has_value();
+    if (_fail) {
+        Console::printl("[FAIL] Test {}", testCount - 1);
+        Console::printl("[ACTUAL] {} symbols", _table.Size());
+        Console::printl("[EXPECTED] {} symbols", stringCount + 1);
+        ++failCount;
+    }
+}
+// Prints the failure of a value test.
+static void failValue(std::string_view input, NumberValue const& actual, bool fits) {
+    Console::printl("[FAIL] Test {}", testCount - 1);
+    Console::printl("[INPUT] {}", Text::quote(std::string(input)));
+    Console::printl("[ACTUAL] Kind {} | Integer {} | Float {} | Fits {}",
+        static_cast<int>(actual.GetKind()), actual.GetInteger(), actual.GetFloat(), actual.Fits()
+    );
+    Console::printl("[EXPECTED] Fits {}", fits);
+    ++failCount;
+}
+void testValue(std::string const& input, NumberValue const& expected, bool fits) {
+    ++testCount;
+
+    try {
+        TokenStream const _stream = tokenise(input);
+        if (_stream.Size() != 1) {
+            failValue(input, NumberValue(), fits);
+            return;
+        }
+        NumberValue const _actual = _stream.GetValue(0);
+        if (_actual != expected || _actual.Fits() != fits) {
+            failValue(input, _actual, fits);
+        }
+    } catch (std::exception const& e) {
+        // Prints the zero-based index of the test.
+        Console::printl("[FAIL] Test {}", testCount - 1);
+        Console::printl("[INPUT] {}", Text::quote(input));
+        Console::printl("[EXCEPTION] {} | {}", typeid(e).name(), e.what());
+        ++failCount;
+    }
+}
+void testValue(Number const& number, NumberValue const& expected, bool fits) {
+    ++testCount;
+
+    NumberValue const& _actual = number.GetValue();
+    if (_actual != expected || _actual.Fits() != fits) {
+        failValue(number.GetSpelling(), _actual, fits);
+    }
+}